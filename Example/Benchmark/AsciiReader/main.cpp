@@ -0,0 +1,140 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for kvs::AsciiReader.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <kvs/CommandLine>
+#include <kvs/AsciiReader>
+#include <kvs/MersenneTwister>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the text of the lines "id x y z" like the UCD nodes.
+ *  @param  nlines [in] number of lines
+ *  @return text
+ */
+/*===========================================================================*/
+std::string GenerateText( const size_t nlines )
+{
+    kvs::MersenneTwister random;
+    std::string text;
+    char buffer[128];
+    for ( size_t i = 0; i < nlines; i++ )
+    {
+        sprintf( buffer, "%u %f %e %.9g\n",
+                 static_cast<unsigned int>( i + 1 ),
+                 random.rand() * 1000.0 - 500.0,
+                 random.rand() * 1.0e-3,
+                 random.rand() * 2.0 - 1.0 );
+        text += buffer;
+    }
+
+    return text;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the numbers with strtok and atof (reference).
+ *  @param  text [in] text
+ *  @param  values [out] parsed values
+ *  @return number of the parsed values
+ */
+/*===========================================================================*/
+size_t ReferenceParse( const std::string& text, std::vector<double>& values )
+{
+    std::vector<char> buffer( text.begin(), text.end() );
+    buffer.push_back( '\0' );
+
+    size_t counter = 0;
+    const char* delim = " ,\t\n";
+    char* value = strtok( &buffer[0], delim );
+    while ( value && counter < values.size() )
+    {
+        values[ counter++ ] = atof( value );
+        value = strtok( 0, delim );
+    }
+
+    return counter;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of lines (default: 1000000).", 1, false );
+    commandline.addOption( "t", "number of threads (default: 0 = number of processors).", 1, false );
+    commandline.addOption( "l", "number of measurements (default: 5).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nlines = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 1000000;
+    const size_t nthreads = commandline.hasOption("t") ? commandline.optionValue<size_t>("t") : 0;
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 5;
+
+    const std::string text = ::GenerateText( nlines );
+    const size_t nvalues = nlines * 4;
+    std::vector<double> reference( nvalues );
+    std::vector<double> values( nvalues );
+
+    size_t nreference = 0;
+    kvs::Timer timer( kvs::Timer::Start );
+    for ( size_t i = 0; i < nloops; i++ ) { nreference = ::ReferenceParse( text, reference ); }
+    timer.stop();
+    const double reference_time = timer.msec() / nloops;
+
+    size_t nparsed = 0;
+    const char* begin = text.c_str();
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ )
+    {
+        nparsed = kvs::AsciiReader::ParseNumbers( begin, begin + text.size(), &values[0], nvalues, nthreads );
+    }
+    timer.stop();
+    const double time = timer.msec() / nloops;
+
+    size_t nmismatches = 0;
+    for ( size_t i = 0; i < nvalues; i++ )
+    {
+        if ( reference[i] != values[i] ) { nmismatches++; }
+    }
+
+    std::cout << "lines: " << nlines << ", bytes: " << text.size() << std::endl;
+    std::cout << "strtok+atof [msec]: " << std::fixed << std::setprecision( 3 ) << reference_time << std::endl;
+    std::cout << "AsciiReader [msec]: " << time << std::endl;
+    std::cout << "speedup: " << std::setprecision( 2 ) << reference_time / time << "x";
+    if ( nreference != nparsed || nmismatches > 0 ) { std::cout << "  MISMATCH (" << nmismatches << ")"; }
+    std::cout << std::endl;
+
+    return 0;
+}
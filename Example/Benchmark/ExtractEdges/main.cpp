@@ -0,0 +1,223 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for kvs::ExtractEdges.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <kvs/CommandLine>
+#include <kvs/UnstructuredVolumeObject>
+#include <kvs/ExtractEdges>
+#include <kvs/ValueArray>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates a synthetic unstructured volume of the cube.
+ *  @param  n [in] number of the hexahedra along each edge of the cube
+ *  @param  tetrahedra [in] if true, each hexahedron is divided into 6 tetrahedra
+ *  @return pointer to the unstructured volume object
+ */
+/*===========================================================================*/
+kvs::UnstructuredVolumeObject* CreateVolume( const size_t n, const bool tetrahedra )
+{
+    const size_t nn = n + 1;
+    const size_t nnodes = nn * nn * nn;
+    const size_t ncells = n * n * n * ( tetrahedra ? 6 : 1 );
+    const size_t nnodes_per_cell = tetrahedra ? 4 : 8;
+
+    kvs::ValueArray<kvs::Real32> coords( 3 * nnodes );
+    kvs::ValueArray<kvs::Real32> values( nnodes );
+    for ( size_t k = 0, index = 0; k < nn; k++ )
+    {
+        for ( size_t j = 0; j < nn; j++ )
+        {
+            for ( size_t i = 0; i < nn; i++, index++ )
+            {
+                coords[ 3 * index     ] = static_cast<kvs::Real32>( i );
+                coords[ 3 * index + 1 ] = static_cast<kvs::Real32>( j );
+                coords[ 3 * index + 2 ] = static_cast<kvs::Real32>( k );
+                values[ index ] = static_cast<kvs::Real32>( i + j + k );
+            }
+        }
+    }
+
+    // Conforming division of the hexahedron along the diagonal 0-6.
+    const size_t tets[6][4] = {
+        { 0, 1, 2, 6 }, { 0, 2, 3, 6 }, { 0, 3, 7, 6 },
+        { 0, 7, 4, 6 }, { 0, 4, 5, 6 }, { 0, 5, 1, 6 } };
+
+    kvs::ValueArray<kvs::UInt32> connections( ncells * nnodes_per_cell );
+    kvs::UInt32* connection = connections.data();
+    for ( size_t k = 0; k < n; k++ )
+    {
+        for ( size_t j = 0; j < n; j++ )
+        {
+            for ( size_t i = 0; i < n; i++ )
+            {
+                const kvs::UInt32 v0 = static_cast<kvs::UInt32>( i + nn * ( j + nn * k ) );
+                const kvs::UInt32 dy = static_cast<kvs::UInt32>( nn );
+                const kvs::UInt32 dz = static_cast<kvs::UInt32>( nn * nn );
+                const kvs::UInt32 v[8] = {
+                    v0, v0 + 1, v0 + 1 + dy, v0 + dy,
+                    v0 + dz, v0 + 1 + dz, v0 + 1 + dy + dz, v0 + dy + dz };
+                if ( tetrahedra )
+                {
+                    for ( size_t t = 0; t < 6; t++ )
+                    {
+                        for ( size_t l = 0; l < 4; l++ ) { *( connection++ ) = v[ tets[t][l] ]; }
+                    }
+                }
+                else
+                {
+                    for ( size_t l = 0; l < 8; l++ ) { *( connection++ ) = v[l]; }
+                }
+            }
+        }
+    }
+
+    kvs::UnstructuredVolumeObject* volume = new kvs::UnstructuredVolumeObject();
+    volume->setCellType( tetrahedra ? kvs::UnstructuredVolumeObject::Tetrahedra : kvs::UnstructuredVolumeObject::Hexahedra );
+    volume->setVeclen( 1 );
+    volume->setNumberOfNodes( nnodes );
+    volume->setNumberOfCells( ncells );
+    volume->setCoords( coords );
+    volume->setValues( values );
+    volume->setConnections( connections );
+    volume->updateMinMaxCoords();
+    volume->updateMinMaxValues();
+    return volume;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the edges with the multimap (reference).
+ *  @param  volume [in] pointer to the unstructured volume object
+ *  @return sorted edges given by the pair of the smaller and larger vertex IDs
+ */
+/*===========================================================================*/
+std::vector< std::pair<kvs::UInt32,kvs::UInt32> > ReferenceEdges( const kvs::UnstructuredVolumeObject* volume )
+{
+    const size_t tet_edges[6][2] = { { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 2, 3 }, { 3, 1 } };
+    const size_t hex_edges[12][2] = {
+        { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 4, 5 }, { 5, 6 },
+        { 6, 7 }, { 7, 4 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+    const bool tetrahedra = volume->cellType() == kvs::UnstructuredVolumeObject::Tetrahedra;
+    const size_t (*edges)[2] = tetrahedra ? tet_edges : hex_edges;
+    const size_t nedges_per_cell = tetrahedra ? 6 : 12;
+    const size_t nnodes_per_cell = tetrahedra ? 4 : 8;
+
+    typedef std::pair<kvs::UInt32,kvs::UInt32> Edge;
+    typedef std::multimap<kvs::UInt32,Edge> Bucket;
+    Bucket bucket;
+    const kvs::UInt32 nnodes = static_cast<kvs::UInt32>( volume->numberOfNodes() );
+    const kvs::UInt32* connections = volume->connections().data();
+    for ( size_t cell = 0; cell < volume->numberOfCells(); cell++ )
+    {
+        const kvs::UInt32* id = connections + cell * nnodes_per_cell;
+        for ( size_t i = 0; i < nedges_per_cell; i++ )
+        {
+            const kvs::UInt32 v0 = id[ edges[i][0] ];
+            const kvs::UInt32 v1 = id[ edges[i][1] ];
+            const kvs::UInt32 key = ( v0 + v1 ) % nnodes;
+            bool found = false;
+            for ( Bucket::const_iterator e = bucket.lower_bound( key ); e != bucket.upper_bound( key ); e++ )
+            {
+                if ( ( e->second.first == v0 && e->second.second == v1 ) ||
+                     ( e->second.first == v1 && e->second.second == v0 ) ) { found = true; break; }
+            }
+            if ( !found ) { bucket.insert( std::make_pair( key, Edge( v0, v1 ) ) ); }
+        }
+    }
+
+    std::vector<Edge> result;
+    for ( Bucket::const_iterator e = bucket.begin(); e != bucket.end(); e++ )
+    {
+        result.push_back( Edge( std::min( e->second.first, e->second.second ), std::max( e->second.first, e->second.second ) ) );
+    }
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "c", "number of cells (default: 1000000).", 1, false );
+    commandline.addOption( "t", "tetrahedral cells instead of hexahedral cells.", 0, false );
+    commandline.addOption( "p", "number of threads (default: number of processors).", 1, false );
+    commandline.addOption( "r", "verify against the multimap-based reference.", 0, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t ncells = commandline.hasOption("c") ? commandline.optionValue<size_t>("c") : 1000000;
+    const bool tetrahedra = commandline.hasOption("t");
+    const size_t nthreads = commandline.hasOption("p") ? commandline.optionValue<size_t>("p") : 0;
+
+    // Number of the hexahedra along each edge of the cube.
+    const double nhexahedra = static_cast<double>( ncells ) / ( tetrahedra ? 6.0 : 1.0 );
+    const size_t n = std::max( size_t(1), static_cast<size_t>( std::pow( nhexahedra, 1.0 / 3.0 ) + 0.5 ) );
+
+    kvs::UnstructuredVolumeObject* volume = ::CreateVolume( n, tetrahedra );
+    std::cout << ( tetrahedra ? "tetrahedra" : "hexahedra" ) << ": "
+              << volume->numberOfCells() << " cells, "
+              << volume->numberOfNodes() << " nodes" << std::endl;
+
+    kvs::ExtractEdges* mapper = new kvs::ExtractEdges();
+    mapper->setNumberOfThreads( nthreads );
+
+    kvs::Timer timer( kvs::Timer::Start );
+    kvs::LineObject* object = mapper->exec( volume );
+    timer.stop();
+    std::cout << "ExtractEdges: " << std::fixed << std::setprecision( 3 ) << timer.msec() << " [msec], "
+              << object->numberOfConnections() << " edges, "
+              << mapper->numberOfThreads() << " threads" << std::endl;
+
+    if ( commandline.hasOption("r") )
+    {
+        timer.start();
+        const std::vector< std::pair<kvs::UInt32,kvs::UInt32> > reference = ::ReferenceEdges( volume );
+        timer.stop();
+        std::cout << "Reference: " << timer.msec() << " [msec], " << reference.size() << " edges" << std::endl;
+
+        bool matched = reference.size() == object->numberOfConnections();
+        const kvs::UInt32* connection = object->connections().data();
+        for ( size_t i = 0; matched && i < reference.size(); i++ )
+        {
+            matched = reference[i].first == connection[ 2 * i ] && reference[i].second == connection[ 2 * i + 1 ];
+        }
+        std::cout << ( matched ? "matched" : "MISMATCH" ) << std::endl;
+    }
+
+    delete object;
+    delete volume;
+
+    return 0;
+}
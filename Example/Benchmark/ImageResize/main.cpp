@@ -0,0 +1,184 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the image resizing and gray-scaling.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <kvs/CommandLine>
+#include <kvs/ColorImage>
+#include <kvs/GrayImage>
+#include <kvs/RGBColor>
+#include <kvs/ValueArray>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a color image filled with the pseudo random pixels.
+ *  @param  width [in] image width
+ *  @param  height [in] image height
+ *  @return color image
+ */
+/*===========================================================================*/
+kvs::ColorImage GenerateImage( const size_t width, const size_t height )
+{
+    kvs::ValueArray<kvs::UInt8> pixels( width * height * 3 );
+    unsigned int seed = 12345;
+    for ( size_t i = 0; i < pixels.size(); i++ )
+    {
+        seed = seed * 1103515245u + 12345u;
+        pixels[i] = static_cast<kvs::UInt8>( seed >> 16 );
+    }
+
+    return kvs::ColorImage( width, height, pixels );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resizes the image pixel by pixel with the interpolator (reference).
+ *  @param  image [in] source image
+ *  @param  width [in] resized width
+ *  @param  height [in] resized height
+ *  @return resized image
+ */
+/*===========================================================================*/
+kvs::ColorImage ReferenceResize( const kvs::ColorImage& image, const size_t width, const size_t height )
+{
+    kvs::ColorImage resized_image( width, height );
+    kvs::ColorImage::Bilinear interpolator;
+    interpolator.attach( &image );
+
+    const double ratio_width = image.width() / static_cast<double>( width );
+    const double ratio_height = image.height() / static_cast<double>( height );
+    for ( size_t j = 0; j < height; j++ )
+    {
+        interpolator.setV( j * ratio_height );
+        for ( size_t i = 0; i < width; i++ )
+        {
+            interpolator.setU( i * ratio_width );
+            resized_image.setPixel( i, j, interpolator() );
+        }
+    }
+
+    return resized_image;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Gray-scales the image by the NTSC weighted mean (reference).
+ *  @param  image [in] color image
+ *  @return gray image
+ */
+/*===========================================================================*/
+kvs::GrayImage ReferenceGrayScale( const kvs::ColorImage& image )
+{
+    kvs::GrayImage gray_image( image.width(), image.height() );
+    for ( size_t j = 0; j < image.height(); j++ )
+    {
+        for ( size_t i = 0; i < image.width(); i++ )
+        {
+            const kvs::RGBColor color = image.pixel( i, j );
+            const unsigned int value = ( 2 * color.r() + 4 * color.g() + color.b() ) / 7;
+            gray_image.setPixel( i, j, static_cast<kvs::UInt8>( value ) );
+        }
+    }
+
+    return gray_image;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the pixels of the images are equal.
+ */
+/*===========================================================================*/
+bool Equal( const kvs::ImageBase& image1, const kvs::ImageBase& image2 )
+{
+    return image1.width() == image2.width() &&
+           image1.height() == image2.height() &&
+           image1.pixels() == image2.pixels();
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "l", "number of measurements (default: 5).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 5;
+
+    // Source and destination sizes (screenshots to thumbnails, and upscaling).
+    const size_t sizes[][4] = {
+        {  640,  480,  160,  120 },
+        { 1920, 1080,  320,  180 },
+        { 1920, 1080, 3840, 2160 },
+        { 3840, 2160,  960,  540 }
+    };
+
+    std::cout << std::fixed << std::setprecision( 3 );
+    for ( size_t k = 0; k < sizeof( sizes ) / sizeof( sizes[0] ); k++ )
+    {
+        const kvs::ColorImage image = ::GenerateImage( sizes[k][0], sizes[k][1] );
+        const size_t width = sizes[k][2];
+        const size_t height = sizes[k][3];
+
+        kvs::ColorImage reference;
+        kvs::Timer timer( kvs::Timer::Start );
+        for ( size_t i = 0; i < nloops; i++ ) { reference = ::ReferenceResize( image, width, height ); }
+        timer.stop();
+        const double reference_resize_time = timer.msec() / nloops;
+
+        kvs::ColorImage resized;
+        timer.start();
+        for ( size_t i = 0; i < nloops; i++ ) { resized = image; resized.resize( width, height ); }
+        timer.stop();
+        const double resize_time = timer.msec() / nloops;
+
+        kvs::GrayImage reference_gray;
+        timer.start();
+        for ( size_t i = 0; i < nloops; i++ ) { reference_gray = ::ReferenceGrayScale( image ); }
+        timer.stop();
+        const double reference_gray_time = timer.msec() / nloops;
+
+        kvs::GrayImage gray;
+        timer.start();
+        for ( size_t i = 0; i < nloops; i++ ) { gray = kvs::GrayImage( image, kvs::GrayImage::NTSCWeightedMeanValue() ); }
+        timer.stop();
+        const double gray_time = timer.msec() / nloops;
+
+        std::cout << image.width() << "x" << image.height() << " -> " << width << "x" << height << std::endl;
+        std::cout << "  resize    [msec]: " << reference_resize_time << " -> " << resize_time
+                  << " (" << reference_resize_time / resize_time << "x)"
+                  << ( ::Equal( reference, resized ) ? "" : "  MISMATCH" ) << std::endl;
+        std::cout << "  grayscale [msec]: " << reference_gray_time << " -> " << gray_time
+                  << " (" << reference_gray_time / gray_time << "x)"
+                  << ( ::Equal( reference_gray, gray ) ? "" : "  MISMATCH" ) << std::endl;
+    }
+
+    return 0;
+}
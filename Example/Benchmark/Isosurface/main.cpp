@@ -0,0 +1,158 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the isovalue sweep with kvs::MinMaxBlockIndex.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <kvs/CommandLine>
+#include <kvs/StructuredVolumeObject>
+#include <kvs/ValueArray>
+#include <kvs/MarchingCubes>
+#include <kvs/MinMaxBlockIndex>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a test volume of the distance field with ripples.
+ *  @param  n [in] number of nodes along each edge
+ *  @return structured volume object
+ */
+/*===========================================================================*/
+kvs::StructuredVolumeObject* CreateVolume( const size_t n )
+{
+    kvs::ValueArray<kvs::Real32> values( n * n * n );
+    const float c = 0.5f * static_cast<float>( n - 1 );
+    size_t index = 0;
+    for ( size_t z = 0; z < n; z++ )
+    {
+        for ( size_t y = 0; y < n; y++ )
+        {
+            for ( size_t x = 0; x < n; x++, index++ )
+            {
+                const float dx = static_cast<float>( x ) - c;
+                const float dy = static_cast<float>( y ) - c;
+                const float dz = static_cast<float>( z ) - c;
+                values[ index ] = std::sqrt( dx * dx + dy * dy + dz * dz ) / c + 0.05f * std::sin( 0.3f * x );
+            }
+        }
+    }
+
+    const kvs::UInt32 resolution = static_cast<kvs::UInt32>( n );
+    kvs::StructuredVolumeObject* volume = new kvs::StructuredVolumeObject();
+    volume->setGridTypeToUniform();
+    volume->setVeclen( 1 );
+    volume->setResolution( kvs::Vec3ui( resolution, resolution, resolution ) );
+    volume->setValues( values );
+    volume->updateMinMaxValues();
+    return volume;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Extracts the isosurfaces and returns the number of the vertices.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  isolevel [in] isolevel
+ *  @param  index [in] pointer to the min/max block index (NULL: not used)
+ *  @return number of the vertices
+ */
+/*===========================================================================*/
+size_t Extract(
+    const kvs::StructuredVolumeObject* volume,
+    const double isolevel,
+    kvs::MinMaxBlockIndex* index )
+{
+    kvs::MarchingCubes mapper;
+    mapper.setIsolevel( isolevel );
+    mapper.setDuplication( false );
+    mapper.attachBlockIndex( index );
+    mapper.exec( volume );
+    return mapper.numberOfVertices();
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of nodes along each edge (default: 128).", 1, false );
+    commandline.addOption( "b", "number of cells along each edge of the block (default: 8).", 1, false );
+    commandline.addOption( "s", "number of isovalues in the sweep (default: 32).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t n = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 128;
+    const size_t block_size = commandline.hasOption("b") ? commandline.optionValue<size_t>("b") : 8;
+    const size_t nsteps = commandline.hasOption("s") ? commandline.optionValue<size_t>("s") : 32;
+
+    kvs::StructuredVolumeObject* volume = ::CreateVolume( n );
+    const double min_value = volume->minValue();
+    const double max_value = volume->maxValue();
+
+    kvs::MinMaxBlockIndex index;
+    kvs::Timer timer( kvs::Timer::Start );
+    index.build( volume, block_size );
+    timer.stop();
+    std::cout << "nodes: " << n << "^3, blocks: " << index.numberOfBlocks()
+              << ", build: " << std::fixed << std::setprecision( 3 ) << timer.msec() << " [msec]" << std::endl;
+    std::cout << std::setw( 12 ) << "isolevel"
+              << std::setw( 12 ) << "ref [msec]"
+              << std::setw( 12 ) << "new [msec]"
+              << std::setw( 11 ) << "speedup" << std::endl;
+
+    double reference_total = 0.0;
+    double total = 0.0;
+    for ( size_t i = 0; i < nsteps; i++ )
+    {
+        const double isolevel = min_value + ( max_value - min_value ) * ( i + 0.5 ) / nsteps;
+
+        timer.start();
+        const size_t reference = ::Extract( volume, isolevel, NULL );
+        timer.stop();
+        const double reference_time = timer.msec();
+
+        timer.start();
+        const size_t nvertices = ::Extract( volume, isolevel, &index );
+        timer.stop();
+        const double time = timer.msec();
+
+        reference_total += reference_time;
+        total += time;
+        std::cout << std::setw( 12 ) << std::setprecision( 4 ) << isolevel
+                  << std::setw( 12 ) << std::setprecision( 3 ) << reference_time
+                  << std::setw( 12 ) << time
+                  << std::setw( 10 ) << std::setprecision( 2 ) << reference_time / time << "x"
+                  << ( reference == nvertices ? "" : "  MISMATCH" ) << std::endl;
+    }
+
+    std::cout << std::setw( 12 ) << "total"
+              << std::setw( 12 ) << std::setprecision( 3 ) << reference_total
+              << std::setw( 12 ) << total
+              << std::setw( 10 ) << std::setprecision( 2 ) << reference_total / total << "x" << std::endl;
+
+    delete volume;
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the assignment step of the k-means clustering.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <kvs/CommandLine>
+#include <kvs/AnyValueTable>
+#include <kvs/KMeansEngine>
+#include <kvs/ValueArray>
+#include <kvs/Value>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a table filled with the pseudo random values.
+ *  @param  nrows [in] number of rows
+ *  @param  ncolumns [in] number of columns
+ *  @return table data
+ */
+/*===========================================================================*/
+kvs::AnyValueTable GenerateTable( const size_t nrows, const size_t ncolumns )
+{
+    kvs::AnyValueTable table;
+    unsigned int seed = 12345;
+    for ( size_t j = 0; j < ncolumns; j++ )
+    {
+        kvs::ValueArray<kvs::Real32> column( nrows );
+        for ( size_t i = 0; i < nrows; i++ )
+        {
+            seed = seed * 1103515245u + 12345u;
+            column[i] = static_cast<kvs::Real32>( ( seed >> 16 ) & 0x7fff ) / 32768.0f;
+        }
+        table.pushBackColumn( column );
+    }
+
+    return table;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Assigns the rows to the nearest centers through the table (reference).
+ *  @param  table [in] table data
+ *  @param  centers [in] cluster centers
+ *  @param  ncenters [in] number of centers
+ *  @param  ids [out] cluster IDs
+ */
+/*===========================================================================*/
+void ReferenceAssign(
+    const kvs::AnyValueTable& table,
+    const kvs::ValueArray<kvs::Real32>* centers,
+    const size_t ncenters,
+    kvs::ValueArray<kvs::UInt32>& ids )
+{
+    const size_t nrows = table.column(0).size();
+    const size_t ncolumns = table.columnSize();
+    for ( size_t i = 0; i < nrows; i++ )
+    {
+        kvs::UInt32 id = 0;
+        kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
+        for ( size_t j = 0; j < ncenters; j++ )
+        {
+            kvs::Real32 d = 0.0f;
+            for ( size_t k = 0; k < ncolumns; k++ )
+            {
+                const kvs::Real32 x0 = centers[j][k];
+                const kvs::Real32 x1 = table.column(k).at<kvs::Real32>( i );
+                d += ( x1 - x0 ) * ( x1 - x0 );
+            }
+            if ( d < distance ) { distance = d; id = static_cast<kvs::UInt32>( j ); }
+        }
+        ids[i] = id;
+    }
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of rows (default: 1000000).", 1, false );
+    commandline.addOption( "d", "number of columns (default: 8).", 1, false );
+    commandline.addOption( "k", "number of clusters (default: 16).", 1, false );
+    commandline.addOption( "t", "number of threads (default: number of processors).", 1, false );
+    commandline.addOption( "l", "number of measurements (default: 5).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nrows = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 1000000;
+    const size_t ncolumns = commandline.hasOption("d") ? commandline.optionValue<size_t>("d") : 8;
+    const size_t ncenters = commandline.hasOption("k") ? commandline.optionValue<size_t>("k") : 16;
+    const size_t nthreads = commandline.hasOption("t") ? commandline.optionValue<size_t>("t") : 0;
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 5;
+
+    const kvs::AnyValueTable table = ::GenerateTable( nrows, ncolumns );
+
+    kvs::Timer timer( kvs::Timer::Start );
+    kvs::KMeansEngine engine( table, nthreads );
+    timer.stop();
+    const double convert_time = timer.msec();
+
+    // The centers are picked from the rows at regular intervals.
+    kvs::ValueArray<kvs::Real32>* centers = new kvs::ValueArray<kvs::Real32> [ ncenters ];
+    for ( size_t j = 0; j < ncenters; j++ ) { centers[j] = engine.row( nrows * j / ncenters ); }
+    engine.setCenters( centers, ncenters );
+
+    kvs::ValueArray<kvs::UInt32> reference( nrows );
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ ) { ::ReferenceAssign( table, centers, ncenters, reference ); }
+    timer.stop();
+    const double reference_time = timer.msec() / nloops;
+
+    kvs::ValueArray<kvs::UInt32> ids( nrows );
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ ) { engine.assign( ids.data(), NULL ); }
+    timer.stop();
+    const double assign_time = timer.msec() / nloops;
+
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ ) { engine.calculateCenters( ids.data(), ncenters, centers ); }
+    timer.stop();
+    const double center_time = timer.msec() / nloops;
+
+    std::cout << std::fixed << std::setprecision( 3 );
+    std::cout << "rows: " << nrows << ", columns: " << ncolumns << ", clusters: " << ncenters
+              << ", threads: " << engine.numberOfThreads() << std::endl;
+    std::cout << "  convert [msec]: " << convert_time << std::endl;
+    std::cout << "  assign  [msec]: " << reference_time << " -> " << assign_time
+              << " (" << reference_time / assign_time << "x)"
+              << ( reference == ids ? "" : "  MISMATCH" ) << std::endl;
+    std::cout << "  update  [msec]: " << center_time << std::endl;
+
+    delete [] centers;
+
+    return 0;
+}
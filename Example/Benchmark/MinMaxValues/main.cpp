@@ -0,0 +1,168 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for kvs::VolumeObjectBase::updateMinMaxValues.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <kvs/CommandLine>
+#include <kvs/StructuredVolumeObject>
+#include <kvs/ValueArray>
+#include <kvs/MersenneTwister>
+#include <kvs/Value>
+#include <kvs/Math>
+#include <kvs/Range>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the min/max values with the serial scan (reference).
+ *  @param  volume [in] pointer to the volume object
+ *  @return min/max values
+ */
+/*===========================================================================*/
+template <typename T>
+kvs::Range ReferenceMinMaxValues( const kvs::VolumeObjectBase* volume )
+{
+    const T* value = reinterpret_cast<const T*>( volume->values().data() );
+    const T* const end = value + volume->numberOfNodes() * volume->veclen();
+
+    if ( volume->veclen() == 1 )
+    {
+        T min_value = *value;
+        T max_value = *value;
+        while ( value < end )
+        {
+            min_value = kvs::Math::Min( *value, min_value );
+            max_value = kvs::Math::Max( *value, max_value );
+            ++value;
+        }
+
+        return kvs::Range( static_cast<double>( min_value ), static_cast<double>( max_value ) );
+    }
+    else
+    {
+        kvs::Real64 min_value = kvs::Value<kvs::Real64>::Max();
+        kvs::Real64 max_value = kvs::Value<kvs::Real64>::Min();
+        const size_t veclen = volume->veclen();
+        while ( value < end )
+        {
+            kvs::Real64 magnitude = 0.0;
+            for ( size_t i = 0; i < veclen; ++i )
+            {
+                magnitude += static_cast<kvs::Real64>( ( *value ) * ( *value ) );
+                ++value;
+            }
+            min_value = kvs::Math::Min( magnitude, min_value );
+            max_value = kvs::Math::Max( magnitude, max_value );
+        }
+
+        return kvs::Range( std::sqrt( min_value ), std::sqrt( max_value ) );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Measures the reference scan and updateMinMaxValues for the type T.
+ *  @param  name [in] type name
+ *  @param  nnodes [in] number of nodes
+ *  @param  veclen [in] vector length
+ *  @param  nloops [in] number of measurements
+ */
+/*===========================================================================*/
+template <typename T>
+void Measure( const char* name, const size_t nnodes, const size_t veclen, const size_t nloops )
+{
+    // Random values in a small range so that the vector magnitudes are exact.
+    kvs::MersenneTwister random;
+    kvs::ValueArray<T> values( nnodes * veclen );
+    for ( size_t i = 0; i < values.size(); i++ )
+    {
+        values[i] = static_cast<T>( random.randInteger() % 100 );
+    }
+
+    kvs::StructuredVolumeObject volume;
+    volume.setGridTypeToUniform();
+    volume.setVeclen( veclen );
+    volume.setResolution( kvs::Vec3ui( static_cast<kvs::UInt32>( nnodes ), 1, 1 ) );
+    volume.setValues( values );
+
+    kvs::Range reference;
+    kvs::Timer timer( kvs::Timer::Start );
+    for ( size_t i = 0; i < nloops; i++ ) { reference = ReferenceMinMaxValues<T>( &volume ); }
+    timer.stop();
+    const double reference_time = timer.msec() / nloops;
+
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ ) { volume.updateMinMaxValues(); }
+    timer.stop();
+    const double time = timer.msec() / nloops;
+
+    const bool matched =
+        reference.lower() == volume.minValue() &&
+        reference.upper() == volume.maxValue();
+
+    std::cout << std::setw( 8 ) << name
+              << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << reference_time
+              << std::setw( 12 ) << time
+              << std::setw( 10 ) << std::setprecision( 2 ) << reference_time / time << "x"
+              << ( matched ? "" : "  MISMATCH" ) << std::endl;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of nodes (default: 16777216).", 1, false );
+    commandline.addOption( "v", "vector length (default: 1).", 1, false );
+    commandline.addOption( "l", "number of measurements (default: 10).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nnodes = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 16777216;
+    const size_t veclen = commandline.hasOption("v") ? commandline.optionValue<size_t>("v") : 1;
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 10;
+
+    std::cout << "nodes: " << nnodes << ", veclen: " << veclen << std::endl;
+    std::cout << std::setw( 8 ) << "type"
+              << std::setw( 12 ) << "ref [msec]"
+              << std::setw( 12 ) << "new [msec]"
+              << std::setw( 11 ) << "speedup" << std::endl;
+
+    Measure<kvs::Int8>( "Int8", nnodes, veclen, nloops );
+    Measure<kvs::UInt8>( "UInt8", nnodes, veclen, nloops );
+    Measure<kvs::Int16>( "Int16", nnodes, veclen, nloops );
+    Measure<kvs::UInt16>( "UInt16", nnodes, veclen, nloops );
+    Measure<kvs::Int32>( "Int32", nnodes, veclen, nloops );
+    Measure<kvs::UInt32>( "UInt32", nnodes, veclen, nloops );
+    Measure<kvs::Int64>( "Int64", nnodes, veclen, nloops );
+    Measure<kvs::UInt64>( "UInt64", nnodes, veclen, nloops );
+    Measure<kvs::Real32>( "Real32", nnodes, veclen, nloops );
+    Measure<kvs::Real64>( "Real64", nnodes, veclen, nloops );
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the CPU rendering of kvs::ParticleBasedRenderer.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <kvs/CommandLine>
+#include <kvs/ParticleBasedRenderer>
+#include <kvs/PointObject>
+#include <kvs/Camera>
+#include <kvs/Light>
+#include <kvs/ValueArray>
+#include <kvs/MersenneTwister>
+#include <kvs/Timer>
+#include <kvs/glut/GLUT>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Particle based renderer which creates the image without drawing.
+ */
+/*===========================================================================*/
+class Renderer : public kvs::ParticleBasedRenderer
+{
+public:
+
+    void render( const kvs::PointObject* point, kvs::Camera* camera, kvs::Light* light )
+    {
+        if ( point->normals().size() == 0 ) BaseClass::disableShading();
+        this->create_image( point, camera, light );
+        this->cleanParticleBuffer();
+    }
+
+    const kvs::ValueArray<kvs::UInt8>& color() { return BaseClass::colorData(); }
+    const kvs::ValueArray<kvs::Real32>& depth() { return BaseClass::depthData(); }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a point object of the random particles in a sphere.
+ *  @param  nparticles [in] number of particles
+ *  @return point object
+ */
+/*===========================================================================*/
+kvs::PointObject* CreatePoint( const size_t nparticles )
+{
+    kvs::MersenneTwister random;
+    kvs::ValueArray<kvs::Real32> coords( nparticles * 3 );
+    kvs::ValueArray<kvs::Real32> normals( nparticles * 3 );
+    kvs::ValueArray<kvs::UInt8> colors( nparticles * 3 );
+    for ( size_t i = 0; i < nparticles; i++ )
+    {
+        // Particles in the sphere of radius 4 to fill the screen of the default camera.
+        kvs::Vec3 p;
+        do { p = kvs::Vec3( float( random() ), float( random() ), float( random() ) ) * 2.0f - kvs::Vec3::All( 1.0f ); }
+        while ( p.length() > 1.0f || p.length() == 0.0f );
+
+        const kvs::Vec3 n = p.normalized();
+        for ( size_t j = 0; j < 3; j++ )
+        {
+            coords[ 3 * i + j ] = 4.0f * p[j];
+            normals[ 3 * i + j ] = n[j];
+            colors[ 3 * i + j ] = static_cast<kvs::UInt8>( 255.0f * 0.5f * ( n[j] + 1.0f ) );
+        }
+    }
+
+    kvs::PointObject* point = new kvs::PointObject();
+    point->setCoords( coords );
+    point->setNormals( normals );
+    point->setColors( colors );
+    point->setSize( 1.0f );
+    point->updateMinMaxCoords();
+    return point;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the rendering time in msec.
+ *  @param  renderer [in] renderer
+ *  @param  point [in] pointer to the point object
+ *  @param  camera [in] pointer to the camera
+ *  @param  light [in] pointer to the light
+ *  @param  nloops [in] number of measurements
+ *  @return average rendering time [msec]
+ */
+/*===========================================================================*/
+double Measure(
+    Renderer& renderer,
+    const kvs::PointObject* point,
+    kvs::Camera* camera,
+    kvs::Light* light,
+    const size_t nloops )
+{
+    renderer.render( point, camera, light ); // buffer allocation
+    kvs::Timer timer( kvs::Timer::Start );
+    for ( size_t i = 0; i < nloops; i++ ) { renderer.render( point, camera, light ); }
+    timer.stop();
+    return timer.msec() / nloops;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of particles (default: 10000000).", 1, false );
+    commandline.addOption( "s", "screen size (default: 1024).", 1, false );
+    commandline.addOption( "r", "subpixel level (default: 2).", 1, false );
+    commandline.addOption( "p", "number of threads (default: number of processors).", 1, false );
+    commandline.addOption( "l", "number of measurements (default: 5).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nparticles = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 10000000;
+    const size_t size = commandline.hasOption("s") ? commandline.optionValue<size_t>("s") : 1024;
+    const size_t level = commandline.hasOption("r") ? commandline.optionValue<size_t>("r") : 2;
+    const size_t nthreads = commandline.hasOption("p") ? commandline.optionValue<size_t>("p") : 0;
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 5;
+
+    // The camera reads the modelview matrix from OpenGL, so that an OpenGL
+    // context is created with a GLUT window.
+    glutInit( &argc, argv );
+    glutInitWindowSize( int( size ), int( size ) );
+    glutCreateWindow( "ParticleBasedRenderer" );
+
+    kvs::PointObject* point = ::CreatePoint( nparticles );
+    kvs::Camera camera;
+    camera.setWindowSize( size, size );
+    camera.update();
+    kvs::Light light;
+
+    ::Renderer reference;
+    reference.setSubpixelLevel( level );
+    reference.setNumberOfThreads( 1 );
+    const double reference_time = ::Measure( reference, point, &camera, &light, nloops );
+
+    ::Renderer renderer;
+    renderer.setSubpixelLevel( level );
+    renderer.setNumberOfThreads( nthreads );
+    const double time = ::Measure( renderer, point, &camera, &light, nloops );
+
+    const bool matched =
+        std::memcmp( reference.color().data(), renderer.color().data(), reference.color().byteSize() ) == 0 &&
+        std::memcmp( reference.depth().data(), renderer.depth().data(), reference.depth().byteSize() ) == 0;
+
+    std::cout << "particles: " << nparticles << ", screen: " << size << "x" << size
+              << ", subpixel level: " << level << ", threads: " << renderer.numberOfThreads() << std::endl;
+    std::cout << std::setw( 12 ) << ""
+              << std::setw( 12 ) << "[msec]"
+              << std::setw( 16 ) << "[particles/s]" << std::endl;
+    std::cout << std::setw( 12 ) << "serial"
+              << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << reference_time
+              << std::setw( 16 ) << std::setprecision( 0 ) << nparticles / reference_time * 1000.0 << std::endl;
+    std::cout << std::setw( 12 ) << "parallel"
+              << std::setw( 12 ) << std::setprecision( 3 ) << time
+              << std::setw( 16 ) << std::setprecision( 0 ) << nparticles / time * 1000.0 << std::endl;
+    std::cout << "speedup: " << std::setprecision( 2 ) << reference_time / time << "x"
+              << ( matched ? "" : "  MISMATCH" ) << std::endl;
+
+    delete point;
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the shading kernels of kvs::Shader.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <kvs/CommandLine>
+#include <kvs/Shader>
+#include <kvs/RGBColor>
+#include <kvs/Vector3>
+#include <kvs/MersenneTwister>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Samples to be shaded.
+ */
+/*===========================================================================*/
+struct Samples
+{
+    std::vector<kvs::RGBColor> colors; ///< source colors
+    std::vector<kvs::Vec3> vertices; ///< vertex positions
+    std::vector<kvs::Vec3> normals; ///< normal vectors
+
+    explicit Samples( const size_t nsamples )
+    {
+        kvs::MersenneTwister random;
+        for ( size_t i = 0; i < nsamples; i++ )
+        {
+            colors.push_back( kvs::RGBColor(
+                kvs::UInt8( random.randInteger() % 256 ),
+                kvs::UInt8( random.randInteger() % 256 ),
+                kvs::UInt8( random.randInteger() % 256 ) ) );
+            vertices.push_back( kvs::Vec3( float( random() ), float( random() ), float( random() ) ) );
+            normals.push_back( kvs::Vec3( float( random() ), float( random() ), float( random() ) ) - kvs::Vec3::All( 0.5f ) );
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Shades the samples with the shading kernel.
+ *  @param  shade [in] shading kernel
+ *  @param  samples [in] samples
+ *  @param  colors [out] shaded colors
+ */
+/*===========================================================================*/
+template <typename Kernel>
+void Shade( const Kernel& shade, const Samples& samples, std::vector<kvs::RGBColor>& colors )
+{
+    const size_t nsamples = samples.colors.size();
+    for ( size_t i = 0; i < nsamples; i++ )
+    {
+        colors[i] = shade( samples.colors[i], samples.vertices[i], samples.normals[i] );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Measures the virtual call and the kernel for the shading model.
+ *  @param  name [in] name of the shading model
+ *  @param  shader [in] pointer to the shading model
+ *  @param  samples [in] samples
+ *  @param  nloops [in] number of measurements
+ */
+/*===========================================================================*/
+template <typename Model>
+void Measure( const char* name, const kvs::Shader::ShadingModel* shader, const Samples& samples, const size_t nloops )
+{
+    const size_t nsamples = samples.colors.size();
+    std::vector<kvs::RGBColor> reference( nsamples );
+    std::vector<kvs::RGBColor> colors( nsamples );
+
+    kvs::Timer timer( kvs::Timer::Start );
+    for ( size_t i = 0; i < nloops; i++ ) { ::Shade( kvs::Shader::Kernel<kvs::Shader::Base>( *shader ), samples, reference ); }
+    timer.stop();
+    const double reference_time = timer.usec() * 1000.0 / nloops / nsamples;
+
+    timer.start();
+    for ( size_t i = 0; i < nloops; i++ ) { ::Shade( kvs::Shader::Kernel<Model>( *shader ), samples, colors ); }
+    timer.stop();
+    const double time = timer.usec() * 1000.0 / nloops / nsamples;
+
+    bool matched = true;
+    for ( size_t i = 0; i < nsamples; i++ ) { matched = matched && reference[i] == colors[i]; }
+
+    std::cout << std::setw( 12 ) << name
+              << std::setw( 14 ) << std::fixed << std::setprecision( 3 ) << reference_time
+              << std::setw( 14 ) << time
+              << std::setw( 10 ) << std::setprecision( 2 ) << reference_time / time << "x"
+              << ( matched ? "" : "  MISMATCH" ) << std::endl;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "n", "number of samples (default: 1000000).", 1, false );
+    commandline.addOption( "l", "number of measurements (default: 10).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t nsamples = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 1000000;
+    const size_t nloops = commandline.hasOption("l") ? commandline.optionValue<size_t>("l") : 10;
+
+    const Samples samples( nsamples );
+    kvs::Shader::Lambert lambert;
+    kvs::Shader::Phong phong;
+    kvs::Shader::BlinnPhong blinn_phong;
+    lambert.light_position = phong.light_position = blinn_phong.light_position = kvs::Vec3( 2.0f, 3.0f, 4.0f );
+    phong.camera_position = blinn_phong.camera_position = kvs::Vec3( 0.0f, 0.0f, 12.0f );
+
+    std::cout << "samples: " << nsamples << std::endl;
+    std::cout << std::setw( 12 ) << "model"
+              << std::setw( 14 ) << "virtual [ns]"
+              << std::setw( 14 ) << "kernel [ns]"
+              << std::setw( 11 ) << "speedup" << std::endl;
+
+    Measure<kvs::Shader::Lambert>( "Lambert", &lambert, samples, nloops );
+    Measure<kvs::Shader::Phong>( "Phong", &phong, samples, nloops );
+    Measure<kvs::Shader::BlinnPhong>( "BlinnPhong", &blinn_phong, samples, nloops );
+
+    return 0;
+}
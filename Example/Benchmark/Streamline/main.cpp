@@ -0,0 +1,234 @@
+/*****************************************************************************/
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark program for the adaptive integration of kvs::Streamline.
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <limits>
+#include <kvs/CommandLine>
+#include <kvs/Streamline>
+#include <kvs/TornadoVolumeData>
+#include <kvs/TransferFunction>
+#include <kvs/PointObject>
+#include <kvs/ValueArray>
+#include <kvs/Math>
+#include <kvs/Timer>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Streamline class terminated at the given arc length.
+ *
+ *  The lines of the different methods and intervals are compared over the
+ *  same length. The length is accumulated in the mapper, so that the lines
+ *  must be calculated by a single thread.
+ */
+/*===========================================================================*/
+class ArcLengthStreamline : public kvs::Streamline
+{
+private:
+
+    float m_max_length; ///< max. arc length of the lines
+    float m_length; ///< arc length of the current line
+
+public:
+
+    ArcLengthStreamline( const float max_length ): m_max_length( max_length ), m_length( 0.0f ) {}
+
+protected:
+
+    bool check_for_termination(
+        const kvs::Vec3& current_vertex,
+        const kvs::Vec3& direction,
+        const size_t integration_times,
+        const kvs::Vec3& next_vertex )
+    {
+        if ( integration_times == 0 ) { m_length = 0.0f; }
+        m_length += ( next_vertex - current_vertex ).length();
+        if ( m_length > m_max_length ) { return true; }
+
+        return kvs::Streamline::check_for_termination( current_vertex, direction, integration_times, next_vertex );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the seed points at the pseudo random positions.
+ *  @param  npoints [in] number of seed points
+ *  @param  n [in] number of nodes along each edge of the volume
+ *  @return seed points
+ */
+/*===========================================================================*/
+kvs::PointObject* GenerateSeedPoints( const size_t npoints, const size_t n )
+{
+    kvs::ValueArray<kvs::Real32> coords( npoints * 3 );
+    unsigned int seed = 12345;
+    for ( size_t i = 0; i < coords.size(); i++ )
+    {
+        seed = seed * 1103515245u + 12345u;
+        const float r = static_cast<float>( ( seed >> 8 ) & 0xffff ) / 65536.0f;
+        coords[i] = 2.0f + r * static_cast<float>( n - 5 );
+    }
+
+    kvs::PointObject* point = new kvs::PointObject();
+    point->setCoords( coords );
+    return point;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the distance from the point to the line segment.
+ */
+/*===========================================================================*/
+float Distance( const kvs::Vec3& p, const kvs::Vec3& a, const kvs::Vec3& b )
+{
+    const kvs::Vec3 ab = b - a;
+    const float length2 = ab.dot( ab );
+    const float t = length2 > 0.0f ? kvs::Math::Clamp( ( p - a ).dot( ab ) / length2, 0.0f, 1.0f ) : 0.0f;
+    return ( p - ( a + t * ab ) ).length();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the max. distance from the vertices of the lines to the reference lines.
+ *  @param  lines [in] streamlines
+ *  @param  reference [in] reference streamlines of the same seed points
+ *  @return max. distance over the lines
+ */
+/*===========================================================================*/
+float Deviation( const kvs::LineObject* lines, const kvs::LineObject* reference )
+{
+    float deviation = 0.0f;
+    const size_t nlines = kvs::Math::Min( lines->numberOfConnections(), reference->numberOfConnections() );
+    for ( size_t i = 0; i < nlines; i++ )
+    {
+        const size_t begin = lines->connections()[ 2 * i ];
+        const size_t end = lines->connections()[ 2 * i + 1 ];
+        const size_t ref_begin = reference->connections()[ 2 * i ];
+        const size_t ref_end = reference->connections()[ 2 * i + 1 ];
+        if ( ref_end <= ref_begin ) continue;
+
+        // The closest segment of the reference line is searched around the
+        // previous one, since the vertices proceed along the line.
+        size_t segment = ref_begin;
+        for ( size_t j = begin; j <= end; j++ )
+        {
+            const kvs::Vec3 p = lines->coord( j );
+            float min_distance = std::numeric_limits<float>::max();
+            const size_t first = segment > ref_begin + 64 ? segment - 64 : ref_begin;
+            const size_t last = kvs::Math::Min( segment + 1024, ref_end - 1 );
+            for ( size_t k = first; k <= last; k++ )
+            {
+                const float distance = ::Distance( p, reference->coord( k ), reference->coord( k + 1 ) );
+                if ( distance < min_distance ) { min_distance = distance; segment = k; }
+            }
+            deviation = kvs::Math::Max( deviation, min_distance );
+        }
+    }
+
+    return deviation;
+}
+
+} // end of namespace
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Main function.
+ *  @param  argc [i] argument count
+ *  @param  argv [i] argument values
+ */
+/*===========================================================================*/
+int main( int argc, char** argv )
+{
+    kvs::CommandLine commandline( argc, argv );
+    commandline.addHelpOption();
+    commandline.addOption( "r", "resolution of the tornado volume (default: 64).", 1, false );
+    commandline.addOption( "n", "number of seed points (default: 200).", 1, false );
+    commandline.addOption( "l", "arc length of the streamlines (default: 60).", 1, false );
+    if ( !commandline.parse() ) return 1;
+
+    const size_t resolution = commandline.hasOption("r") ? commandline.optionValue<size_t>("r") : 64;
+    const size_t npoints = commandline.hasOption("n") ? commandline.optionValue<size_t>("n") : 200;
+    const float length = commandline.hasOption("l") ? commandline.optionValue<float>("l") : 60.0f;
+
+    const kvs::Vector3ui dims( resolution, resolution, resolution );
+    kvs::TornadoVolumeData* volume = new kvs::TornadoVolumeData( dims );
+    volume->updateMinMaxValues();
+    kvs::PointObject* seed_points = ::GenerateSeedPoints( npoints, resolution );
+    const kvs::TransferFunction transfer_function( 256 );
+    const size_t max_times = std::numeric_limits<size_t>::max();
+
+    // Reference lines by the 4th order Runge-Kutta with a tiny interval.
+    ::ArcLengthStreamline* reference = new ::ArcLengthStreamline( length );
+    reference->setSeedPoints( seed_points );
+    reference->setTransferFunction( transfer_function );
+    reference->setIntegrationMethod( kvs::Streamline::RungeKutta4th );
+    reference->setIntegrationInterval( 0.005f );
+    reference->setIntegrationTimesThreshold( max_times );
+    reference->exec( volume );
+
+    std::cout << "tornado: " << resolution << "^3, seeds: " << npoints << ", length: " << length << std::endl;
+    std::cout << "method               vertices  time [msec]  max. deviation" << std::endl;
+    std::cout << std::fixed;
+
+    const float intervals[] = { 1.0f, 0.5f, 0.25f, 0.1f, 0.05f };
+    const float tolerances[] = { 1.0e-4f, 1.0e-5f, 1.0e-6f, 1.0e-7f, 1.0e-8f };
+    const size_t nintervals = sizeof( intervals ) / sizeof( intervals[0] );
+    const size_t ntolerances = sizeof( tolerances ) / sizeof( tolerances[0] );
+    for ( size_t i = 0; i < nintervals + ntolerances; i++ )
+    {
+        const bool adaptive = i >= nintervals;
+        ::ArcLengthStreamline* lines = new ::ArcLengthStreamline( length );
+        lines->setSeedPoints( seed_points );
+        lines->setTransferFunction( transfer_function );
+        lines->setIntegrationTimesThreshold( max_times );
+        if ( adaptive )
+        {
+            lines->setIntegrationMethod( kvs::Streamline::DormandPrince );
+            lines->setErrorTolerance( tolerances[ i - nintervals ] );
+            lines->setMinIntegrationInterval( 0.01f );
+            lines->setMaxIntegrationInterval( 1.0f );
+        }
+        else
+        {
+            lines->setIntegrationMethod( kvs::Streamline::RungeKutta4th );
+            lines->setIntegrationInterval( intervals[i] );
+        }
+
+        kvs::Timer timer( kvs::Timer::Start );
+        lines->exec( volume );
+        timer.stop();
+
+        std::cout << ( adaptive ? "DormandPrince tol=" : "RungeKutta4th h=  " )
+                  << std::setprecision( adaptive ? 0 : 2 ) << std::setw( 5 ) << std::left;
+        if ( adaptive ) { std::cout << std::scientific << tolerances[ i - nintervals ] << std::fixed; }
+        else { std::cout << intervals[i]; }
+        std::cout << std::right << std::setw( 8 ) << lines->numberOfVertices()
+                  << std::setprecision( 3 ) << std::setw( 13 ) << timer.msec()
+                  << std::setprecision( 5 ) << std::setw( 16 ) << ::Deviation( lines, reference ) << std::endl;
+
+        delete lines;
+    }
+
+    delete reference;
+    delete seed_points;
+    delete volume;
+
+    return 0;
+}
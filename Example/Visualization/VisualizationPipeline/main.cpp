@@ -55,6 +55,8 @@ int main( int argc, char** argv )
      *    mapper.get<kvs::MarchingCubes>()->setTransferFunction( transfer_function );
      *    mapper.get<kvs::MarchingCubes>()->setNormalType( normal );
      *    mapper.get<kvs::MarchingCubes>()->setIsolevel( isolevel );
+     *    // Cache the extracted surfaces for the parameters (optional).
+     *    mapper.setCacheKey( "isolevel=100,normal=polygon" );
      *    // Connect to the pipeline.
      *    pipeline.connect( mapper );
      */
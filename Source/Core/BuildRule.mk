@@ -145,6 +145,7 @@ $(OUTDIR)/./Numeric/EigenDecomposer.o \
 $(OUTDIR)/./Numeric/FastKMeans.o \
 $(OUTDIR)/./Numeric/GaussEliminationSolver.o \
 $(OUTDIR)/./Numeric/KMeans.o \
+$(OUTDIR)/./Numeric/KMeansEngine.o \
 $(OUTDIR)/./Numeric/LUDecomposer.o \
 $(OUTDIR)/./Numeric/LUSolver.o \
 $(OUTDIR)/./Numeric/MersenneTwister.o \
@@ -189,6 +190,7 @@ $(OUTDIR)/./Thread/WriteLocker.o \
 $(OUTDIR)/./Utility/AnyValue.o \
 $(OUTDIR)/./Utility/AnyValueArray.o \
 $(OUTDIR)/./Utility/AnyValueTable.o \
+$(OUTDIR)/./Utility/AsciiReader.o \
 $(OUTDIR)/./Utility/BitArray.o \
 $(OUTDIR)/./Utility/CommandLine.o \
 $(OUTDIR)/./Utility/Date.o \
@@ -196,6 +198,7 @@ $(OUTDIR)/./Utility/Directory.o \
 $(OUTDIR)/./Utility/FastTokenizer.o \
 $(OUTDIR)/./Utility/File.o \
 $(OUTDIR)/./Utility/Indent.o \
+$(OUTDIR)/./Utility/MappedFile.o \
 $(OUTDIR)/./Utility/MemoryTracer.o \
 $(OUTDIR)/./Utility/Message.o \
 $(OUTDIR)/./Utility/Program.o \
@@ -208,6 +211,7 @@ $(OUTDIR)/./Utility/Tokenizer.o \
 $(OUTDIR)/./Utility/Type.o \
 $(OUTDIR)/./Utility/Value.o \
 $(OUTDIR)/./Utility/ValueArray.o \
+$(OUTDIR)/./Utility/ValueArrayAllocator.o \
 $(OUTDIR)/./Utility/ValueTable.o \
 $(OUTDIR)/./Visualization/Data/HydrogenVolumeData.o \
 $(OUTDIR)/./Visualization/Data/TornadoVolumeData.o \
@@ -244,6 +248,7 @@ $(OUTDIR)/./Visualization/Filter/LineIntegralConvolution.o \
 $(OUTDIR)/./Visualization/Filter/StructuredVectorToScalar.o \
 $(OUTDIR)/./Visualization/Filter/TetrahedraToTetrahedra.o \
 $(OUTDIR)/./Visualization/Filter/Tubeline.o \
+$(OUTDIR)/./Visualization/Filter/UnstructuredToStructuredVolume.o \
 $(OUTDIR)/./Visualization/Filter/UnstructuredVectorToScalar.o \
 $(OUTDIR)/./Visualization/Importer/ImageImporter.o \
 $(OUTDIR)/./Visualization/Importer/LineImporter.o \
@@ -281,6 +286,7 @@ $(OUTDIR)/./Visualization/Mapper/MarchingPyramidTable.o \
 $(OUTDIR)/./Visualization/Mapper/MarchingTetrahedra.o \
 $(OUTDIR)/./Visualization/Mapper/MarchingTetrahedraTable.o \
 $(OUTDIR)/./Visualization/Mapper/MetropolisSampling.o \
+$(OUTDIR)/./Visualization/Mapper/MinMaxBlockIndex.o \
 $(OUTDIR)/./Visualization/Mapper/OpacityMap.o \
 $(OUTDIR)/./Visualization/Mapper/OrthoSlice.o \
 $(OUTDIR)/./Visualization/Mapper/PrismaticCell.o \
@@ -303,8 +309,10 @@ $(OUTDIR)/./Visualization/Object/StructuredVolumeObject.o \
 $(OUTDIR)/./Visualization/Object/TableObject.o \
 $(OUTDIR)/./Visualization/Object/UnstructuredVolumeObject.o \
 $(OUTDIR)/./Visualization/Object/VolumeObjectBase.o \
+$(OUTDIR)/./Visualization/Pipeline/AsyncObjectImporter.o \
 $(OUTDIR)/./Visualization/Pipeline/ObjectImporter.o \
 $(OUTDIR)/./Visualization/Pipeline/PipelineModule.o \
+$(OUTDIR)/./Visualization/Pipeline/TimeSeriesImporter.o \
 $(OUTDIR)/./Visualization/Pipeline/VisualizationPipeline.o \
 $(OUTDIR)/./Visualization/Renderer/ArrowGlyph.o \
 $(OUTDIR)/./Visualization/Renderer/Bounds.o \
@@ -315,6 +323,7 @@ $(OUTDIR)/./Visualization/Renderer/HAVSVolumeRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/ImageRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/LineRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/LineRendererGLSL.o \
+$(OUTDIR)/./Visualization/Renderer/MacroCellGrid.o \
 $(OUTDIR)/./Visualization/Renderer/ParallelCoordinatesRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/ParticleBasedRenderer.o \
 $(OUTDIR)/./Visualization/Renderer/ParticleBasedRendererGLSL.o \
@@ -145,6 +145,7 @@ $(OUTDIR)\.\Numeric\EigenDecomposer.obj \
 $(OUTDIR)\.\Numeric\FastKMeans.obj \
 $(OUTDIR)\.\Numeric\GaussEliminationSolver.obj \
 $(OUTDIR)\.\Numeric\KMeans.obj \
+$(OUTDIR)\.\Numeric\KMeansEngine.obj \
 $(OUTDIR)\.\Numeric\LUDecomposer.obj \
 $(OUTDIR)\.\Numeric\LUSolver.obj \
 $(OUTDIR)\.\Numeric\MersenneTwister.obj \
@@ -189,6 +190,7 @@ $(OUTDIR)\.\Thread\WriteLocker.obj \
 $(OUTDIR)\.\Utility\AnyValue.obj \
 $(OUTDIR)\.\Utility\AnyValueArray.obj \
 $(OUTDIR)\.\Utility\AnyValueTable.obj \
+$(OUTDIR)\.\Utility\AsciiReader.obj \
 $(OUTDIR)\.\Utility\BitArray.obj \
 $(OUTDIR)\.\Utility\CommandLine.obj \
 $(OUTDIR)\.\Utility\Date.obj \
@@ -196,6 +198,7 @@ $(OUTDIR)\.\Utility\Directory.obj \
 $(OUTDIR)\.\Utility\FastTokenizer.obj \
 $(OUTDIR)\.\Utility\File.obj \
 $(OUTDIR)\.\Utility\Indent.obj \
+$(OUTDIR)\.\Utility\MappedFile.obj \
 $(OUTDIR)\.\Utility\MemoryTracer.obj \
 $(OUTDIR)\.\Utility\Message.obj \
 $(OUTDIR)\.\Utility\Program.obj \
@@ -208,6 +211,7 @@ $(OUTDIR)\.\Utility\Tokenizer.obj \
 $(OUTDIR)\.\Utility\Type.obj \
 $(OUTDIR)\.\Utility\Value.obj \
 $(OUTDIR)\.\Utility\ValueArray.obj \
+$(OUTDIR)\.\Utility\ValueArrayAllocator.obj \
 $(OUTDIR)\.\Utility\ValueTable.obj \
 $(OUTDIR)\.\Visualization\Data\HydrogenVolumeData.obj \
 $(OUTDIR)\.\Visualization\Data\TornadoVolumeData.obj \
@@ -244,6 +248,7 @@ $(OUTDIR)\.\Visualization\Filter\LineIntegralConvolution.obj \
 $(OUTDIR)\.\Visualization\Filter\StructuredVectorToScalar.obj \
 $(OUTDIR)\.\Visualization\Filter\TetrahedraToTetrahedra.obj \
 $(OUTDIR)\.\Visualization\Filter\Tubeline.obj \
+$(OUTDIR)\.\Visualization\Filter\UnstructuredToStructuredVolume.obj \
 $(OUTDIR)\.\Visualization\Filter\UnstructuredVectorToScalar.obj \
 $(OUTDIR)\.\Visualization\Importer\ImageImporter.obj \
 $(OUTDIR)\.\Visualization\Importer\LineImporter.obj \
@@ -281,6 +286,7 @@ $(OUTDIR)\.\Visualization\Mapper\MarchingPyramidTable.obj \
 $(OUTDIR)\.\Visualization\Mapper\MarchingTetrahedra.obj \
 $(OUTDIR)\.\Visualization\Mapper\MarchingTetrahedraTable.obj \
 $(OUTDIR)\.\Visualization\Mapper\MetropolisSampling.obj \
+$(OUTDIR)\.\Visualization\Mapper\MinMaxBlockIndex.obj \
 $(OUTDIR)\.\Visualization\Mapper\OpacityMap.obj \
 $(OUTDIR)\.\Visualization\Mapper\OrthoSlice.obj \
 $(OUTDIR)\.\Visualization\Mapper\PrismaticCell.obj \
@@ -303,8 +309,10 @@ $(OUTDIR)\.\Visualization\Object\StructuredVolumeObject.obj \
 $(OUTDIR)\.\Visualization\Object\TableObject.obj \
 $(OUTDIR)\.\Visualization\Object\UnstructuredVolumeObject.obj \
 $(OUTDIR)\.\Visualization\Object\VolumeObjectBase.obj \
+$(OUTDIR)\.\Visualization\Pipeline\AsyncObjectImporter.obj \
 $(OUTDIR)\.\Visualization\Pipeline\ObjectImporter.obj \
 $(OUTDIR)\.\Visualization\Pipeline\PipelineModule.obj \
+$(OUTDIR)\.\Visualization\Pipeline\TimeSeriesImporter.obj \
 $(OUTDIR)\.\Visualization\Pipeline\VisualizationPipeline.obj \
 $(OUTDIR)\.\Visualization\Renderer\ArrowGlyph.obj \
 $(OUTDIR)\.\Visualization\Renderer\Bounds.obj \
@@ -315,6 +323,7 @@ $(OUTDIR)\.\Visualization\Renderer\HAVSVolumeRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ImageRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\LineRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\LineRendererGLSL.obj \
+$(OUTDIR)\.\Visualization\Renderer\MacroCellGrid.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParallelCoordinatesRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParticleBasedRenderer.obj \
 $(OUTDIR)\.\Visualization\Renderer\ParticleBasedRendererGLSL.obj \
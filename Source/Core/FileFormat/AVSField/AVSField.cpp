@@ -21,6 +21,7 @@
 #include <kvs/Platform>
 #include <kvs/Version>
 #include <kvs/Endian>
+#include <kvs/AsciiReader>
 
 
 namespace
@@ -91,6 +92,60 @@ void SkipHeader( FILE* ifs )
     }
 }
 
+/*==========================================================================*/
+/**
+ *  Split the line into the tag and the value: "tag = value".
+ *  @param line [in] line
+ *  @param tag [out] tag
+ *  @param value [out] pointer to the head of the value
+ *  @return false, if the line has no '='
+ */
+/*==========================================================================*/
+bool SplitTag( const char* line, std::string* tag, const char** value )
+{
+    const char* head = kvs::AsciiReader::SkipBlanks( line );
+    const char* tail = head;
+    while ( !kvs::AsciiReader::IsEnd( *tail ) && *tail != '=' ) { ++tail; }
+
+    const char* p = kvs::AsciiReader::SkipBlanks( tail );
+    if ( *p != '=' ) return false;
+
+    tag->assign( head, tail );
+    *value = p + 1;
+    return true;
+}
+
+/*==========================================================================*/
+/**
+ *  Parse the next number in the value (0 if not a number like atof).
+ *  @param p [in/out] pointer to the value
+ *  @return parsed number
+ */
+/*==========================================================================*/
+template <typename T>
+T ParseNumber( const char** p )
+{
+    T value = T(0);
+    const char* next = kvs::AsciiReader::Parse( *p, &value );
+    *p = next ? next : kvs::AsciiReader::SkipToken( *p );
+    return next ? value : T(0);
+}
+
+/*==========================================================================*/
+/**
+ *  Return the next token in the value.
+ *  @param p [in/out] pointer to the value
+ *  @return token
+ */
+/*==========================================================================*/
+std::string ParseToken( const char** p )
+{
+    size_t length = 0;
+    const char* head = kvs::AsciiReader::Token( *p, &length );
+    *p = head + length;
+    return std::string( head, length );
+}
+
 }
 
 namespace kvs
@@ -570,65 +625,65 @@ bool AVSField::read_header( FILE* ifs )
         if( buf[0] == '#')   continue; // skip comment line
         if( buf[0] == '\f' ) break;    // detected data separator
 
-        const char* seps = " ,\t\n" ;
-        char* tag   = strtok( buf,  seps ) ;
-        char* equal = strtok( NULL, seps ) ;
-        char* value = strtok( NULL, seps ) ;
-
-        if( strcmp( equal, "=" ) ) continue;
+        std::string tag;
+        const char* value = NULL;
+        if( !::SplitTag( buf, &tag, &value ) ) continue;
 
-        if( !strcmp( tag, "veclen" ) ) m_veclen  = atoi( value );
-        if( !strcmp( tag, "nspace" ) ) m_nspace  = atoi( value );
-        if( !strcmp( tag, "ndim"   ) ) m_ndim    = atoi( value );
-        if( !strcmp( tag, "dim1"   ) ) m_dim.x() = atoi( value );
-        if( !strcmp( tag, "dim2"   ) ) m_dim.y() = atoi( value );
-        if( !strcmp( tag, "dim3"   ) ) m_dim.z() = atoi( value );
+        if( tag == "veclen" ) m_veclen  = ::ParseNumber<int>( &value );
+        if( tag == "nspace" ) m_nspace  = ::ParseNumber<int>( &value );
+        if( tag == "ndim"   ) m_ndim    = ::ParseNumber<int>( &value );
+        if( tag == "dim1"   ) m_dim.x() = ::ParseNumber<kvs::UInt32>( &value );
+        if( tag == "dim2"   ) m_dim.y() = ::ParseNumber<kvs::UInt32>( &value );
+        if( tag == "dim3"   ) m_dim.z() = ::ParseNumber<kvs::UInt32>( &value );
 
-        if( !strcmp( tag, "field"  ) )
+        if( tag == "field" )
         {
+            const std::string field = ::ParseToken( &value );
             m_field =
-                !strcmp( value, "uniform"    ) ? Uniform :
-                !strcmp( value, "rectilinear") ? Rectilinear :
-                !strcmp( value, "irregular"  ) ? Irregular :
+                field == "uniform"     ? Uniform :
+                field == "rectilinear" ? Rectilinear :
+                field == "irregular"   ? Irregular :
                 UnknownFieldType;
         }
 
-        if( !strcmp( tag, "data"  ) )
+        if( tag == "data" )
         {
+            const std::string data = ::ParseToken( &value );
             m_type =
-                !strcmp( value, "byte"     ) ? Byte :
-                !strcmp( value, "short"    ) ? Short :
-                !strcmp( value, "integer"  ) ? Integer :
-                !strcmp( value, "float"    ) ? Float :
-                !strcmp( value, "double"   ) ? Double :
+                data == "byte"    ? Byte :
+                data == "short"   ? Short :
+                data == "integer" ? Integer :
+                data == "float"   ? Float :
+                data == "double"  ? Double :
                 UnknownDataType;
         }
 
-        if( !strcmp( tag, "label" ) )
+        if( tag == "label" )
         {
             m_labels.clear();
 
-            while( value )
+            std::string label = ::ParseToken( &value );
+            while( !label.empty() )
             {
-                m_labels.push_back( value );
-                value = strtok( NULL, seps );
+                m_labels.push_back( label );
+                label = ::ParseToken( &value );
             }
         }
 
-        if( !strcmp( tag, "min_ext" ) )
+        if( tag == "min_ext" )
         {
-            m_min_ext.x() = static_cast<float>( atof( value ) ); value = strtok( NULL, seps );
-            m_min_ext.y() = static_cast<float>( atof( value ) ); value = strtok( NULL, seps );
-            m_min_ext.z() = static_cast<float>( atof( value ) );
+            m_min_ext.x() = ::ParseNumber<float>( &value );
+            m_min_ext.y() = ::ParseNumber<float>( &value );
+            m_min_ext.z() = ::ParseNumber<float>( &value );
 
             m_has_min_max_ext = true;
         }
 
-        if( !strcmp( tag, "max_ext" ) )
+        if( tag == "max_ext" )
         {
-            m_max_ext.x() = static_cast<float>( atof( value ) ); value = strtok( NULL, seps );
-            m_max_ext.y() = static_cast<float>( atof( value ) ); value = strtok( NULL, seps );
-            m_max_ext.z() = static_cast<float>( atof( value ) );
+            m_max_ext.x() = ::ParseNumber<float>( &value );
+            m_max_ext.y() = ::ParseNumber<float>( &value );
+            m_max_ext.z() = ::ParseNumber<float>( &value );
 
             m_has_min_max_ext = true;
         }
@@ -696,14 +751,12 @@ bool AVSField::read_comment( FILE* ifs )
             if( strlen( buf ) < 2   ) continue;
             if( !strstr( buf, "=" ) ) continue;
 
-            const char* seps = " ,\t\n" ;
-            char* tag   = strtok( buf + 1,  seps ) ;
-            char* equal = strtok( NULL, seps ) ;
-            char* value = strtok( NULL, seps ) ;
-            if( strcmp( equal, "=" ) ) continue;
+            std::string tag;
+            const char* value = NULL;
+            if( !::SplitTag( buf + 1, &tag, &value ) ) continue;
 
-            if( !strcmp( tag, "bits"   ) ) m_bits      = atoi( value );
-            if( !strcmp( tag, "signed" ) ) m_is_signed = strcmp( value, "signed" ) == 0;
+            if( tag == "bits"   ) m_bits      = ::ParseNumber<int>( &value );
+            if( tag == "signed" ) m_is_signed = ::ParseToken( &value ) == "signed";
         }
     }
 
@@ -16,6 +16,7 @@
 #include <kvs/Message>
 #include <kvs/ValueArray>
 #include <kvs/IgnoreUnusedVariable>
+#include <kvs/AsciiReader>
 #include <cstdlib>
 #include <cstring>
 
@@ -25,8 +26,6 @@ namespace
 
 const size_t MaxLineLength = 512;
 
-const char* const Delimiter = " \n\r";
-
 const std::string CycleTypeToString[ kvs::AVSUcd::CycleTypeSize ] =
 {
     "unknown",
@@ -71,11 +70,12 @@ kvs::AVSUcd::FormatType CheckFormatType( FILE* const ifs )
         else
         {
             // Skip first token.
-            strtok( buffer, ::Delimiter );
+            const char* const p = kvs::AsciiReader::SkipToken( buffer );
 
-            const char* const second_token = strtok( 0, ::Delimiter );
+            size_t length = 0;
+            kvs::AsciiReader::Token( p, &length );
 
-            if ( second_token != 0 )
+            if ( length > 0 )
             {
                 format_type = kvs::AVSUcd::SingleStep;
             }
@@ -138,6 +138,130 @@ int StepNumber( const std::string& filename )
     return result;
 }
 
+int ParseInt( const char** p )
+{
+    int value = 0;
+    const char* const next = kvs::AsciiReader::Parse( *p, &value );
+    *p = next ? next : kvs::AsciiReader::SkipToken( *p );
+    return next ? value : 0;
+}
+
+const char* ComponentToken( const char* p, size_t* length )
+{
+    while ( *p == ',' || *p == '\n' || *p == '\r' ) { ++p; }
+    const char* tail = p;
+    while ( *tail != '\0' && *tail != ',' && *tail != '\n' && *tail != '\r' ) { ++tail; }
+    *length = static_cast<size_t>( tail - p );
+    return p;
+}
+
+struct ElementName
+{
+    const char* name; ///< element type in the file
+    kvs::AVSUcd::ElementType type; ///< element type
+    size_t nvertices; ///< number of vertices of the element
+};
+
+const ElementName ElementNames[] =
+{
+    { "pt",    kvs::AVSUcd::Point,        1 },
+    { "tet",   kvs::AVSUcd::Tetrahedra,   4 },
+    { "tet2",  kvs::AVSUcd::Tetrahedra2, 10 },
+    { "hex",   kvs::AVSUcd::Hexahedra,    8 },
+    { "hex2",  kvs::AVSUcd::Hexahedra2,  20 },
+    { "pyr",   kvs::AVSUcd::Pyramid,      5 },
+    { "prism", kvs::AVSUcd::Prism,        6 }
+};
+
+const size_t NumberOfElementNames = sizeof( ElementNames ) / sizeof( ElementName );
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses a line of the node coordinates: "id x y z".
+ */
+/*===========================================================================*/
+class CoordTask : public kvs::AsciiReader::LineTask
+{
+    kvs::Real32* m_coords;
+    size_t m_nnodes;
+public:
+    CoordTask( kvs::Real32* coords, const size_t nnodes ): m_coords( coords ), m_nnodes( nnodes ) {}
+    bool parse( const size_t, const char* line )
+    {
+        int id = 0;
+        const char* p = kvs::AsciiReader::Parse( line, &id );
+        if ( !p || id < 1 || static_cast<size_t>( id ) > m_nnodes ) { return false; }
+
+        kvs::Real32* coord = m_coords + ( id - 1 ) * 3;
+        for ( size_t i = 0; i < 3 && p; i++ ) { p = kvs::AsciiReader::Parse( p, coord + i ); }
+        return p != NULL;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses a line of the element connection: "id material type n0 n1 ...".
+ */
+/*===========================================================================*/
+class ConnectionTask : public kvs::AsciiReader::LineTask
+{
+    kvs::UInt32* m_connections;
+    std::string m_element_type;
+    size_t m_nvertices;
+public:
+    ConnectionTask( kvs::UInt32* connections, const std::string& element_type, const size_t nvertices ):
+        m_connections( connections ), m_element_type( element_type ), m_nvertices( nvertices ) {}
+    bool parse( const size_t index, const char* line )
+    {
+        const char* p = kvs::AsciiReader::SkipToken( line ); // Skip element index.
+        p = kvs::AsciiReader::SkipToken( p ); // Skip material index.
+
+        size_t length = 0;
+        const char* const element_type = kvs::AsciiReader::Token( p, &length );
+        if ( !kvs::AsciiReader::Equal( element_type, length, m_element_type.c_str() ) ) { return false; }
+
+        p = element_type + length;
+        kvs::UInt32* connection = m_connections + index * m_nvertices;
+        for ( size_t i = 0; i < m_nvertices; i++ )
+        {
+            int id = 0;
+            p = kvs::AsciiReader::Parse( p, &id );
+            if ( !p ) { return false; }
+            connection[i] = static_cast<kvs::UInt32>( id - 1 );
+        }
+        return true;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses a line of the node values: "id v0 v1 ...".
+ */
+/*===========================================================================*/
+class ValueTask : public kvs::AsciiReader::LineTask
+{
+    kvs::Real32* m_values;
+    size_t m_nnodes;
+    size_t m_veclen;
+    size_t m_nskips;
+public:
+    ValueTask( kvs::Real32* values, const size_t nnodes, const size_t veclen, const size_t nskips ):
+        m_values( values ), m_nnodes( nnodes ), m_veclen( veclen ), m_nskips( nskips ) {}
+    bool parse( const size_t, const char* line )
+    {
+        int id = 0;
+        const char* p = kvs::AsciiReader::Parse( line, &id );
+        if ( !p || id < 1 || static_cast<size_t>( id ) > m_nnodes ) { return false; }
+
+        // Skip other components.
+        for ( size_t i = 0; i < m_nskips; i++ ) { p = kvs::AsciiReader::SkipToken( p ); }
+
+        kvs::Real32* value = m_values + ( id - 1 ) * m_veclen;
+        for ( size_t i = 0; i < m_veclen && p; i++ ) { p = kvs::AsciiReader::Parse( p, value + i ); }
+        return p != NULL;
+    }
+};
+
 }
 
 
@@ -890,9 +1014,10 @@ void AVSUcd::read_single_step_format( FILE* const ifs )
         }
         else
         {
-            m_nnodes           = atoi( strtok( buffer, ::Delimiter ) );
-            m_nelements        = atoi( strtok( 0,      ::Delimiter ) );
-            m_nvalues_per_node = atoi( strtok( 0,      ::Delimiter ) );
+            const char* p = buffer;
+            m_nnodes           = ::ParseInt( &p );
+            m_nelements        = ::ParseInt( &p );
+            m_nvalues_per_node = ::ParseInt( &p );
 
             this->read_coords( ifs );
             this->read_connections( ifs );
@@ -919,11 +1044,13 @@ void AVSUcd::read_multi_step_format( FILE* const ifs )
         }
         else
         {
-            m_nsteps = atoi( strtok( buffer, ::Delimiter ) );
+            const char* p = buffer;
+            m_nsteps = ::ParseInt( &p );
 
             if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
             {
-                const char* const cycle_type = strtok( buffer, ::Delimiter );
+                size_t length = 0;
+                const char* const cycle_type = kvs::AsciiReader::Token( buffer, &length );
 
                 m_cycle_type =
                     !strncmp( cycle_type, "data", 4 )      ? Data     :
@@ -982,8 +1109,9 @@ void AVSUcd::read_multi_step_format_data_geom( FILE* const ifs )
 
     if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
     {
-        m_nnodes    = atoi( strtok( buffer, ::Delimiter ) );
-        m_nelements = atoi( strtok( 0,   ::Delimiter ) );
+        const char* p = buffer;
+        m_nnodes    = ::ParseInt( &p );
+        m_nelements = ::ParseInt( &p );
     }
     else
     {
@@ -995,7 +1123,8 @@ void AVSUcd::read_multi_step_format_data_geom( FILE* const ifs )
 
     if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
     {
-        m_nvalues_per_node = atoi( strtok( buffer, ::Delimiter ) );
+        const char* p = buffer;
+        m_nvalues_per_node = ::ParseInt( &p );
     }
     else
     {
@@ -1015,18 +1144,12 @@ void AVSUcd::seek_target_step( FILE* const ifs )
 
     while ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
     {
-        const char* const first_token = strtok( buffer, ::Delimiter );
-        if ( strcmp( first_token, target_step ) == 0 )
+        size_t length = 0;
+        const char* const first_token = kvs::AsciiReader::Token( buffer, &length );
+        if ( kvs::AsciiReader::Equal( first_token, length, target_step ) )
         {
-            const char* const step_comment = strtok( 0, ::Delimiter );
-            if ( step_comment != 0 )
-            {
-                m_step_comment = std::string( step_comment );
-            }
-            else
-            {
-                m_step_comment = std::string( "" );
-            }
+            const char* const step_comment = kvs::AsciiReader::Token( first_token + length, &length );
+            m_step_comment = std::string( step_comment, length );
 
             return;
         }
@@ -1037,353 +1160,59 @@ void AVSUcd::seek_target_step( FILE* const ifs )
 
 void AVSUcd::read_coords( FILE* const ifs )
 {
-    char buffer[ ::MaxLineLength ];
+    kvs::AsciiReader reader;
+    if ( !reader.readLines( ifs, m_nnodes ) )
+    {
+        throw "Unexpected EOF in reading coordinates.";
+    }
 
     m_coords.allocate( 3 * m_nnodes );
 
-    kvs::Real32* coord = m_coords.data();
-
-    for ( size_t i = 0; i < m_nnodes; i++ )
+    ::CoordTask task( m_coords.data(), m_nnodes );
+    if ( !reader.parseLines( task ) )
     {
-        if ( fgets( buffer, ::MaxLineLength, ifs ) )
-        {
-            // Node index.
-            const int index = atoi( strtok( buffer, ::Delimiter ) ) - 1;
-
-            coord[ index * 3 + 0 ] = static_cast<float>( atof( strtok( 0, ::Delimiter ) ) );
-            coord[ index * 3 + 1 ] = static_cast<float>( atof( strtok( 0, ::Delimiter ) ) );
-            coord[ index * 3 + 2 ] = static_cast<float>( atof( strtok( 0, ::Delimiter ) ) );
-        }
+        throw "Invalid node index or coordinates.";
     }
 }
 
 void AVSUcd::read_connections( FILE* const ifs )
 {
-    char buffer[ ::MaxLineLength ];
-
-    // Read first line.
-    if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
-    {
-        strtok( buffer, ::Delimiter ); // Skip element index.
-        strtok( 0, ::Delimiter ); // Skip material index.
-
-        const char* const element_type = strtok( 0, ::Delimiter );
-
-        m_element_type =
-            !strcmp( element_type, "pt"  ) ? Point :
-            !strcmp( element_type, "tet"  ) ? Tetrahedra :
-            !strcmp( element_type, "tet2" ) ? Tetrahedra2 :
-            !strcmp( element_type, "hex2" ) ? Hexahedra2 :
-            !strcmp( element_type, "hex" ) ? Hexahedra :
-            !strcmp( element_type, "pyr" ) ? Pyramid :
-            !strcmp( element_type, "prism" ) ? Prism : ElementTypeUnknown;
-
-        if ( m_element_type == Point )
-        {
-            m_connections.allocate( 1 * m_nelements );
-        }
-        else if ( m_element_type == Tetrahedra )
-        {
-            m_connections.allocate( 4 * m_nelements );
-        }
-        else if ( m_element_type == Tetrahedra2 )
-        {
-            m_connections.allocate( 10 * m_nelements );
-        }
-        else if ( m_element_type == Hexahedra )
-        {
-            m_connections.allocate( 8 * m_nelements );
-        }
-        else if ( m_element_type == Hexahedra2 )
-        {
-            m_connections.allocate( 20 * m_nelements );
-        }
-        else if ( m_element_type == Pyramid )
-        {
-            m_connections.allocate( 5 * m_nelements );
-        }
-        else if ( m_element_type == Prism )
-        {
-            m_connections.allocate( 6 * m_nelements );
-        }
-        else
-        {
-            throw "Unknown element type.";
-        }
-    }
-    else
+    kvs::AsciiReader reader;
+    if ( !reader.readLines( ifs, m_nelements ) || m_nelements == 0 )
     {
-        throw "Unexpected EOF in reading first line of connections.";
+        throw "Unexpected EOF in reading connections.";
     }
 
-    kvs::UInt32*       connection = m_connections.data();
-    kvs::UInt32* const end        = connection + m_connections.size();
-
-    if ( m_element_type == Point )
-    {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // skip material index.
-                strtok( 0, ::Delimiter );
+    // Element type in the first line.
+    const char* p = kvs::AsciiReader::SkipToken( reader.line(0) ); // Skip element index.
+    p = kvs::AsciiReader::SkipToken( p ); // Skip material index.
 
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "pt" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
+    size_t length = 0;
+    const char* const element_type = kvs::AsciiReader::Token( p, &length );
 
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
-    }
-    else if ( m_element_type == Tetrahedra )
+    size_t nvertices = 0;
+    m_element_type = ElementTypeUnknown;
+    for ( size_t i = 0; i < ::NumberOfElementNames; i++ )
     {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
+        if ( kvs::AsciiReader::Equal( element_type, length, ::ElementNames[i].name ) )
         {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // skip material index.
-                strtok( 0, ::Delimiter );
-
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "tet" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
-
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
-    }
-    else if ( m_element_type == Tetrahedra2 )
-    {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // skip material index.
-                strtok( 0, ::Delimiter );
-
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "tet2" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
-
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
-    }
-    else if ( m_element_type == Hexahedra )
-    {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // Skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // Skip material index.
-                strtok( 0, ::Delimiter );
-
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "hex" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
-
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
+            m_element_type = ::ElementNames[i].type;
+            nvertices = ::ElementNames[i].nvertices;
+            break;
         }
     }
-    else if ( m_element_type == Hexahedra2 )
-    {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // Skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // Skip material index.
-                strtok( 0, ::Delimiter );
-
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "hex2" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
 
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
-    }
-    else if ( m_element_type == Pyramid )
+    if ( m_element_type == ElementTypeUnknown )
     {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // skip material index.
-                strtok( 0, ::Delimiter );
-
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "pyr" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
-
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
+        throw "Unknown element type.";
     }
-    else if ( m_element_type == Prism )
-    {
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-        *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-
-        while ( connection < end )
-        {
-            if ( fgets( buffer, ::MaxLineLength, ifs ) )
-            {
-                // skip element index.
-                strtok( buffer, ::Delimiter );
-
-                // skip material index.
-                strtok( 0, ::Delimiter );
 
-                const char* const element_type = strtok( 0, ::Delimiter );
-                if ( strcmp( element_type, "prism" ) != 0 )
-                {
-                    throw "Multi-element type is not supported.";
-                }
+    m_connections.allocate( nvertices * m_nelements );
 
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-                *( connection++ ) = atoi( strtok( 0, ::Delimiter ) ) - 1;
-            }
-        }
-    }
-    else
+    ::ConnectionTask task( m_connections.data(), std::string( element_type, length ), nvertices );
+    if ( !reader.parseLines( task ) )
     {
-        throw "Unknown element type.";
+        throw "Multi-element type is not supported or connection is invalid.";
     }
 }
 
@@ -1393,11 +1222,12 @@ void AVSUcd::read_components( FILE* const ifs )
 
     if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
     {
-        m_ncomponents_per_node = atoi( strtok( buffer, ::Delimiter ) );
+        const char* p = buffer;
+        m_ncomponents_per_node = ::ParseInt( &p );
 
         for ( size_t i = 0; i < m_ncomponents_per_node; ++i )
         {
-            m_veclens.push_back( atoi( strtok( 0, ::Delimiter ) ) );
+            m_veclens.push_back( ::ParseInt( &p ) );
         }
     }
     else
@@ -1409,25 +1239,12 @@ void AVSUcd::read_components( FILE* const ifs )
     {
         if ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
         {
-            const char* const component_name = strtok( buffer, ",\n\r" );
-            if ( component_name != 0 )
-            {
-                m_component_names.push_back( std::string( component_name ) );
-            }
-            else
-            {
-                m_component_names.push_back( "" );
-            }
+            size_t length = 0;
+            const char* const component_name = ::ComponentToken( buffer, &length );
+            m_component_names.push_back( std::string( component_name, length ) );
 
-            const char* const component_unit = strtok( 0, ",\n\r" );
-            if ( component_unit != 0 )
-            {
-                m_component_units.push_back( std::string( component_unit ) );
-            }
-            else
-            {
-                m_component_units.push_back( "" );
-            }
+            const char* const component_unit = ::ComponentToken( component_name + length, &length );
+            m_component_units.push_back( std::string( component_unit, length ) );
         }
         else
         {
@@ -1438,37 +1255,25 @@ void AVSUcd::read_components( FILE* const ifs )
 
 void AVSUcd::read_values( FILE* const ifs )
 {
-    char buffer[ ::MaxLineLength ];
+    kvs::AsciiReader reader;
+    if ( !reader.readLines( ifs, m_nnodes ) )
+    {
+        throw "Unexpected EOF in reading values.";
+    }
 
     const size_t veclen = m_veclens[ m_component_id ];
     m_values.allocate( veclen * m_nnodes );
 
-    kvs::Real32* value = m_values.data();
-
     size_t nskips = 0;
     for ( size_t i = 0; i < m_component_id; ++i )
     {
         nskips += m_veclens[ i ];
     }
 
-    for ( size_t i = 0; i < m_nnodes; i++ )
+    ::ValueTask task( m_values.data(), m_nnodes, veclen, nskips );
+    if ( !reader.parseLines( task ) )
     {
-        if ( fgets( buffer, ::MaxLineLength, ifs ) )
-        {
-            // Node index
-            const int index = atoi( strtok( buffer, ::Delimiter ) ) - 1;
-
-            // Skip other components
-            for ( size_t j = 0; j < nskips; ++j )
-            {
-                strtok( 0, ::Delimiter );
-            }
-
-            for ( size_t j = 0; j < veclen; ++j )
-            {
-                value[ index * veclen + j ] = static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) );
-            }
-        }
+        throw "Invalid node index or values.";
     }
 }
 
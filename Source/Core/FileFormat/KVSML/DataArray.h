@@ -16,12 +16,18 @@
 
 #include <kvs/File>
 #include <kvs/Tokenizer>
+#include <kvs/AsciiReader>
 #include <kvs/ValueArray>
 #include <kvs/AnyValueArray>
 #include <kvs/IgnoreUnusedVariable>
+#include <kvs/MappedFile>
+#include <kvs/Math>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <typeinfo>
 
 
 namespace kvs
@@ -33,24 +39,6 @@ namespace kvsml
 namespace temporal
 {
 
-template <typename T>
-inline T To( const std::string& value )
-{
-    return static_cast<T>( atof( value.c_str() ) );
-}
-
-template <>
-inline kvs::Int8 To( const std::string& value )
-{
-    return static_cast<kvs::Int8>( atoi( value.c_str() ) );
-}
-
-template <>
-inline kvs::UInt8 To( const std::string& value )
-{
-    return static_cast<kvs::UInt8>( atoi( value.c_str() ) );
-}
-
 inline std::string TypeName( const std::type_info& type )
 {
     if (      type == typeid( kvs::Int8   ) ) return "char";
@@ -66,24 +54,65 @@ inline std::string TypeName( const std::type_info& type )
     else return "unknown";
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Writes the binary data to the file.
+ *  @param  data [in] pointer to the data
+ *  @param  byte_size [in] byte size of the data
+ *  @param  filename [in] output file name
+ *  @return true, if the writting process is done successfully
+ *
+ *  The data is written to a temporary file which then replaces the file, since
+ *  the file can be mapped into memory by the arrays read from it (and the data
+ *  can be one of them). See kvs::MappedFile.
+ */
+/*===========================================================================*/
+inline bool WriteBinaryData( const void* data, const size_t byte_size, const std::string& filename )
+{
+    const std::string temporary = filename + ".tmp";
+    std::ofstream ofs( temporary.c_str(), std::ios::out | std::ios::binary );
+    if ( ofs.fail() )
+    {
+        kvsMessageError("Cannot open file '%s'.", temporary.c_str() );
+        return false;
+    }
+
+    ofs.write( static_cast<const char*>( data ), byte_size );
+    ofs.close();
+    if ( ofs.fail() )
+    {
+        kvsMessageError("Cannot write file '%s'.", temporary.c_str() );
+        std::remove( temporary.c_str() );
+        return false;
+    }
+
+    if ( !kvs::MappedFile::Replace( temporary, filename ) )
+    {
+        kvsMessageError("Cannot replace file '%s'.", filename.c_str() );
+        std::remove( temporary.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Reads the internal data as value array.
  *  @param  nelements  [in] number of elements
- *  @param  tokenizer  [in] tokenizer
- *  @return read data
+ *  @param  text       [in] text of the numbers separated by the delimiters
+ *  @return read data (the missing elements are filled with 0)
  */
 /*===========================================================================*/
 template <typename T>
 inline kvs::ValueArray<T> ReadInternalData(
     const size_t nelements,
-    kvs::Tokenizer& tokenizer )
+    const std::string& text )
 {
     kvs::ValueArray<T> result( nelements );
-    for ( size_t i = 0; i < nelements; i++ )
-    {
-        result[i] = kvs::kvsml::temporal::To<T>( tokenizer.token() );
-    }
+    const char* const begin = text.c_str();
+    const size_t nread = kvs::AsciiReader::ParseNumbers( begin, begin + text.size(), result.data(), nelements );
+    for ( size_t i = nread; i < nelements; i++ ) { result[i] = T(0); }
     return result;
 }
 
@@ -143,7 +172,7 @@ inline std::string GetDataType( const kvs::AnyValueArray& data_array )
  *  @brief  Reads the internal data as any-value array.
  *  @param  data_array [out] pointer to the any-value array
  *  @param  nelements  [in] number of elements
- *  @param  tokenizer  [in] tokenizer
+ *  @param  text       [in] text of the numbers separated by the delimiters
  *  @return true, if the reading process is done successfully
  */
 /*===========================================================================*/
@@ -151,9 +180,9 @@ template <typename T>
 inline bool ReadInternalData(
     kvs::AnyValueArray* data_array,
     const size_t nelements,
-    kvs::Tokenizer& tokenizer )
+    const std::string& text )
 {
-    *data_array = kvs::AnyValueArray( kvs::kvsml::temporal::ReadInternalData<T>( nelements, tokenizer ) );
+    *data_array = kvs::AnyValueArray( kvs::kvsml::temporal::ReadInternalData<T>( nelements, text ) );
     return true;
 }
 
@@ -162,7 +191,7 @@ inline bool ReadInternalData(
  *  @brief  Reads the internal data as value array.
  *  @param  data_array [out] pointer to the value array
  *  @param  nelements  [in] number of elements
- *  @param  tokenizer  [in] tokenizer
+ *  @param  text       [in] text of the numbers separated by the delimiters
  *  @return true, if the reading process is done successfully
  */
 /*===========================================================================*/
@@ -170,9 +199,9 @@ template <typename T>
 inline bool ReadInternalData(
     kvs::ValueArray<T>* data_array,
     const size_t nelements,
-    kvs::Tokenizer& tokenizer )
+    const std::string& text )
 {
-    *data_array = kvs::kvsml::temporal::ReadInternalData<T>( nelements, tokenizer );
+    *data_array = kvs::kvsml::temporal::ReadInternalData<T>( nelements, text );
     return true;
 }
 
@@ -183,6 +212,7 @@ inline bool ReadInternalData(
  *  @param  nelements  [in] number of elements
  *  @param  filename   [in] external file name
  *  @param  format     [in] file format (binary or ascii)
+ *  @param  mapping    [in] if true, the binary data is mapped into memory
  *  @return true, if the reading process is done successfully
  */
 /*===========================================================================*/
@@ -191,8 +221,19 @@ inline bool ReadExternalData(
     kvs::AnyValueArray* data_array,
     const size_t nelements,
     const std::string& filename,
-    const std::string& format )
+    const std::string& format,
+    const bool mapping = false )
 {
+    if ( format == "binary" && mapping )
+    {
+        kvs::ValueArray<T> mapped_array;
+        if ( kvs::MappedFile::Map<T>( filename, nelements, &mapped_array ) )
+        {
+            *data_array = kvs::AnyValueArray( mapped_array );
+            return true;
+        }
+    }
+
     data_array->template allocate<T>( nelements );
 
     if ( format == "binary" )
@@ -216,47 +257,12 @@ inline bool ReadExternalData(
     }
     else if ( format == "ascii" )
     {
-        FILE* ifs = fopen( filename.c_str(), "r" );
-        if( !ifs )
-        {
-            kvsMessageError("Cannot open '%s'.", filename.c_str());
-            return false;
-        }
-
-        fseek( ifs, 0, SEEK_END );
-        const size_t size = ftell( ifs );
-
-        char* buffer = static_cast<char*>( malloc( sizeof(char) * size ) );
-        if ( !buffer )
-        {
-            kvsMessageError("Cannot allocate memory for reading the external data.");
-            fclose( ifs );
-            return false;
-        }
-
-        fseek( ifs, 0, SEEK_SET );
-        if ( size != fread( buffer, 1, size, ifs ) )
-        {
-            kvsMessageError( "Cannot read '%s'.", filename.c_str() );
-            return false;
-        }
+        kvs::AsciiReader reader;
+        if ( !reader.readFile( filename ) ) { return false; }
 
         T* data = static_cast<T*>( data_array->data() );
-
-        const char* delim = " ,\t\n";
-        char* value = strtok( buffer, delim );
-        for ( size_t i = 0; i < nelements; i++ )
-        {
-            if ( value )
-            {
-                *(data++) = static_cast<T>( atof( value ) );
-                value = strtok( 0, delim );
-            }
-        }
-
-        free( buffer );
-
-        fclose( ifs );
+        const size_t nread = reader.parseNumbers( data, nelements );
+        for ( size_t i = nread; i < nelements; i++ ) { data[i] = T(0); }
     }
     else
     {
@@ -274,6 +280,7 @@ inline bool ReadExternalData(
  *  @param  nelements  [in] number of elements
  *  @param  filename   [in] external file name
  *  @param  format     [in] file format (binary or ascii)
+ *  @param  mapping    [in] if true, the binary data of the same type is mapped into memory
  *  @return true, if the reading process is done successfully
  */
 /*===========================================================================*/
@@ -282,8 +289,14 @@ inline bool ReadExternalData(
     kvs::ValueArray<T1>* out_array,
     const size_t nelements,
     const std::string& filename,
-    const std::string& format )
+    const std::string& format,
+    const bool mapping = false )
 {
+    if ( format == "binary" && mapping && typeid( T1 ) == typeid( T2 ) )
+    {
+        if ( kvs::MappedFile::Map<T1>( filename, nelements, out_array ) ) { return true; }
+    }
+
     kvs::ValueArray<T1> data_array( nelements );
 
     if ( format == "binary" )
@@ -307,56 +320,36 @@ inline bool ReadExternalData(
         }
         else
         {
-            const size_t nloops = data_array.size();
-            for ( size_t i = 0; i < nloops; i++ )
+            // Read and convert the data block by block.
+            const size_t block_size = 65536;
+            std::vector<T2> block( kvs::Math::Min( block_size, nelements ) );
+            T1* data = data_array.data();
+            for ( size_t offset = 0; offset < nelements; offset += block_size )
             {
-                T2 data = T2(0);
-                if ( fread( &data, sizeof(T2), 1, ifs ) != 1 )
+                const size_t size = kvs::Math::Min( block_size, nelements - offset );
+                if ( fread( &( block[0] ), sizeof(T2), size, ifs ) != size )
                 {
                     kvsMessageError( "Cannot read '%s'.",filename.c_str() );
                     fclose( ifs );
                     return false;
                 }
-                data_array[i] = static_cast<T1>( data );
+
+                for ( size_t i = 0; i < size; i++ )
+                {
+                    *( data++ ) = static_cast<T1>( block[i] );
+                }
             }
         }
         fclose( ifs );
     }
     else if ( format == "ascii" )
     {
-        FILE* ifs = fopen( filename.c_str(), "r" );
-        if ( !ifs )
-        {
-            kvsMessageError( "Cannot open '%s'.", filename.c_str() );
-            return false;
-        }
-
-        fseek( ifs, 0, SEEK_END );
-        const size_t size = ftell( ifs );
-
-        std::vector<char> buffer( size );
-
-        fseek( ifs, 0, SEEK_SET );
-        if ( size != fread( &( buffer[0] ), 1, size, ifs ) )
-        {
-            kvsMessageError( "Cannot read '%s'.", filename.c_str() );
-            return false;
-        }
+        kvs::AsciiReader reader;
+        if ( !reader.readFile( filename ) ) { return false; }
 
         T1* data = data_array.data();
-
-        const char* delim = " ,\t\n";
-        char* value = strtok( &( buffer[0] ), delim );
-        for ( size_t i = 0; i < nelements; i++ )
-        {
-            if ( value )
-            {
-                *( data++ ) = static_cast<T1>( atof( value ) );
-                value = strtok( 0, delim );
-            }
-        }
-
-        fclose( ifs );
+        const size_t nread = reader.parseNumbers( data, nelements );
+        for ( size_t i = nread; i < nelements; i++ ) { data[i] = T1(0); }
     }
     else
     {
@@ -439,16 +432,9 @@ inline bool WriteExternalData(
     }
     else if ( format == "binary" )
     {
-        std::ofstream ofs( filename.c_str(), std::ios::out | std::ios::binary );
-        if ( ofs.fail() )
-        {
-            kvsMessageError("Cannot open file '%s'.", filename.c_str() );
-            return false;
-        }
         const void* data_pointer = data_array.data();
         const size_t data_byte_size = data_array.byteSize();
-        ofs.write( static_cast<const char*>(data_pointer), data_byte_size );
-        ofs.close();
+        return kvs::kvsml::temporal::WriteBinaryData( data_pointer, data_byte_size, filename );
     }
     else
     {
@@ -498,16 +484,9 @@ inline bool WriteExternalData(
     }
     else if ( format == "binary" )
     {
-        std::ofstream ofs( filename.c_str(), std::ios::out | std::ios::binary );
-        if ( ofs.fail() )
-        {
-            kvsMessageError("Cannot open file '%s'.", filename.c_str() );
-            return false;
-        }
-        const char* data_pointer = reinterpret_cast<const char*>( data_array.data() );
+        const void* data_pointer = data_array.data();
         const size_t data_byte_size = data_array.byteSize();
-        ofs.write( data_pointer, data_byte_size );
-        ofs.close();
+        return kvs::kvsml::temporal::WriteBinaryData( data_pointer, data_byte_size, filename );
     }
 
     return true;
@@ -243,8 +243,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
 
         // <DataArray type="xxx">xxx</DataArray>
-        const std::string delim(" ,\t\n");
-        kvs::Tokenizer t( array_text->Value(), delim );
+        const std::string t( array_text->Value() );
 
         if( m_type == "char" )
         {
@@ -346,7 +345,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
 
         if( m_type == "char" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int8>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int8>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -356,7 +355,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if( m_type == "unsigned char" || m_type == "uchar" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt8>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt8>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -366,7 +365,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "short" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int16>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int16>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -376,7 +375,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "unsigned short" || m_type == "ushort" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt16>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt16>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -386,7 +385,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "int" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Int32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -396,7 +395,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "unsigned int" || m_type == "uint" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::UInt32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -406,7 +405,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "float" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Real32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Real32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -416,7 +415,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::AnyValueArray* data )
         }
         else if ( m_type == "double" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Real64>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<kvs::Real64>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -204,10 +204,8 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
 
         // <DataArray>xxx</DataArray>
-        const std::string delim(" \n");
-        kvs::Tokenizer tokenizer( array_text->Value(), delim );
-
-        if ( !kvs::kvsml::DataArray::ReadInternalData<T>( data, nelements, tokenizer ) )
+        const std::string text( array_text->Value() );
+        if ( !kvs::kvsml::DataArray::ReadInternalData<T>( data, nelements, text ) )
         {
             kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
             return false;
@@ -242,7 +240,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
 
         if( m_type == "char" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int8>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int8>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -250,7 +248,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "unsigned char" || m_type == "uchar" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt8>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt8>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -258,7 +256,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "short" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int16>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int16>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -266,7 +264,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "unsigned short" || m_type == "ushort" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt16>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt16>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -274,7 +272,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "int" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Int32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -282,7 +280,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "unsigned int" || m_type == "uint" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::UInt32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -290,7 +288,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "float" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Real32>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Real32>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
@@ -298,7 +296,7 @@ bool DataArrayTag::read_data( const size_t nelements, kvs::ValueArray<T>* data )
         }
         else if( m_type == "double" )
         {
-            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Real64>( data, nelements, filename, m_format ) )
+            if ( !kvs::kvsml::DataArray::ReadExternalData<T,kvs::Real64>( data, nelements, filename, m_format, !byte_swap ) )
             {
                 kvsMessageError( "Cannot read the data array in <%s>.", tag_name.c_str() );
                 return false;
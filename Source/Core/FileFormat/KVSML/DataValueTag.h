@@ -80,9 +80,8 @@ inline bool DataValueTag::read(
         return false;
     }
 
-    const std::string delim(" \n");
-    kvs::Tokenizer tokenizer( array_text->Value(), delim );
-    if ( !kvs::kvsml::DataArray::ReadInternalData<T>( data, nelements, tokenizer ) )
+    const std::string text( array_text->Value() );
+    if ( !kvs::kvsml::DataArray::ReadInternalData<T>( data, nelements, text ) )
     {
         kvsMessageError( "Cannot read the data in <%s>.", tag_name.c_str() );
         return false;
@@ -15,14 +15,20 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cctype>
 #include <new>
 #include <limits>
+#include <string>
+#include <vector>
 #include <kvs/DebugNew>
 #include <kvs/Math>
 #include <kvs/Message>
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/File>
 #include <kvs/Assert>
+#include <kvs/Endian>
+#include <kvs/MappedFile>
+#include <kvs/Thread>
 #include "Ply.h"
 #include "PlyFile.h"
 
@@ -87,6 +93,328 @@ kvs::ply::PlyProperty FaceProps[1] =
 
 } // end of namespace
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Property described in the header of the PLY file.
+ */
+/*===========================================================================*/
+struct Property
+{
+    std::string name; ///< property name
+    int type; ///< value type (PLY_CHAR, ..., PLY_DOUBLE)
+    int count_type; ///< type of the number of the values (0: scalar)
+    size_t offset; ///< offset in the element in bytes (scalar before the lists only)
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Element described in the header of the PLY file.
+ */
+/*===========================================================================*/
+struct Element
+{
+    std::string name; ///< element name
+    size_t count; ///< number of the elements
+    std::vector<Property> properties; ///< properties
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the value type from the type name.
+ *  @param  name [in] type name
+ *  @return value type (0: unknown)
+ */
+/*===========================================================================*/
+int TypeOf( const std::string& name )
+{
+    if ( name == "char"   || name == "int8"    ) { return PLY_CHAR; }
+    if ( name == "short"  || name == "int16"   ) { return PLY_SHORT; }
+    if ( name == "int"    || name == "int32"   ) { return PLY_INT; }
+    if ( name == "uchar"  || name == "uint8"   ) { return PLY_UCHAR; }
+    if ( name == "ushort" || name == "uint16"  ) { return PLY_USHORT; }
+    if ( name == "uint"   || name == "uint32"  ) { return PLY_UINT; }
+    if ( name == "float"  || name == "float32" ) { return PLY_FLOAT; }
+    if ( name == "double" || name == "float64" ) { return PLY_DOUBLE; }
+    return 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the size of the value type in bytes.
+ *  @param  type [in] value type
+ *  @return size in bytes
+ */
+/*===========================================================================*/
+size_t SizeOf( const int type )
+{
+    switch ( type )
+    {
+    case PLY_CHAR: case PLY_UCHAR: return 1;
+    case PLY_SHORT: case PLY_USHORT: return 2;
+    case PLY_INT: case PLY_UINT: case PLY_FLOAT: return 4;
+    case PLY_DOUBLE: return 8;
+    default: return 0;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Splits the line into the words.
+ *  @param  line [in] line
+ *  @return words
+ */
+/*===========================================================================*/
+std::vector<std::string> Split( const std::string& line )
+{
+    std::vector<std::string> words;
+    size_t i = 0;
+    while ( i < line.size() )
+    {
+        while ( i < line.size() && isspace( static_cast<unsigned char>( line[i] ) ) ) { i++; }
+        const size_t begin = i;
+        while ( i < line.size() && !isspace( static_cast<unsigned char>( line[i] ) ) ) { i++; }
+        if ( i > begin ) { words.push_back( line.substr( begin, i - begin ) ); }
+    }
+
+    return words;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Value read from the binary data, converted like get_binary_item.
+ */
+/*===========================================================================*/
+struct Item
+{
+    int int_val;
+    unsigned int uint_val;
+    double double_val;
+
+    template <typename T>
+    static T Load( const kvs::UInt8* p, const bool swap )
+    {
+        T value;
+        memcpy( &value, p, sizeof( T ) );
+        if ( swap ) { kvs::Endian::Swap( &value ); }
+        return value;
+    }
+
+    Item( const kvs::UInt8* p, const int type, const bool swap )
+    {
+        switch ( type )
+        {
+        case PLY_CHAR:
+            int_val = static_cast<char>( *p );
+            uint_val = int_val;
+            double_val = int_val;
+            break;
+        case PLY_UCHAR:
+            uint_val = *p;
+            int_val = uint_val;
+            double_val = uint_val;
+            break;
+        case PLY_SHORT:
+            int_val = Load<kvs::Int16>( p, swap );
+            uint_val = int_val;
+            double_val = int_val;
+            break;
+        case PLY_USHORT:
+            uint_val = Load<kvs::UInt16>( p, swap );
+            int_val = uint_val;
+            double_val = uint_val;
+            break;
+        case PLY_INT:
+            int_val = Load<kvs::Int32>( p, swap );
+            uint_val = int_val;
+            double_val = int_val;
+            break;
+        case PLY_UINT:
+            uint_val = Load<kvs::UInt32>( p, swap );
+            int_val = uint_val;
+            double_val = uint_val;
+            break;
+        case PLY_FLOAT:
+            double_val = Load<kvs::Real32>( p, swap );
+            int_val = static_cast<int>( double_val );
+            uint_val = static_cast<unsigned int>( double_val );
+            break;
+        default:
+            double_val = Load<kvs::Real64>( p, swap );
+            int_val = static_cast<int>( double_val );
+            uint_val = static_cast<unsigned int>( double_val );
+            break;
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for reading a range of the vertices.
+ *
+ *  The vertices have a fixed size, since all of the properties are scalars.
+ *  The properties 0-2 are the coordinates, 3-5 the colors, and 6-8 the normals
+ *  (NULL if not read).
+ */
+/*===========================================================================*/
+class VertexReader : public kvs::Thread
+{
+private:
+
+    const kvs::UInt8* m_data; ///< pointer to the first vertex
+    size_t m_stride; ///< size of the vertex in bytes
+    bool m_swap; ///< true, if the bytes are swapped
+    const ::Property* m_properties[9]; ///< properties
+    size_t m_begin; ///< first vertex
+    size_t m_end; ///< last vertex + 1
+    kvs::Real32* m_coords; ///< coordinate values
+    kvs::UInt8* m_colors; ///< color values
+    kvs::Real32* m_normals; ///< normal vectors
+
+public:
+
+    VertexReader(): m_data( NULL ), m_stride( 0 ), m_swap( false ), m_begin( 0 ), m_end( 0 ),
+                    m_coords( NULL ), m_colors( NULL ), m_normals( NULL ) {}
+
+    void setup(
+        const kvs::UInt8* data,
+        const size_t stride,
+        const bool swap,
+        const ::Property* const* properties,
+        const size_t begin,
+        const size_t end,
+        kvs::Real32* coords,
+        kvs::UInt8* colors,
+        kvs::Real32* normals )
+    {
+        m_data = data;
+        m_stride = stride;
+        m_swap = swap;
+        for ( size_t i = 0; i < 9; i++ ) { m_properties[i] = properties[i]; }
+        m_begin = begin;
+        m_end = end;
+        m_coords = coords;
+        m_colors = colors;
+        m_normals = normals;
+    }
+
+    void run()
+    {
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt8* vertex = m_data + i * m_stride;
+            for ( size_t j = 0; j < 3; j++ )
+            {
+                const ::Property* coord = m_properties[j];
+                m_coords[ 3 * i + j ] = static_cast<float>( ::Item( vertex + coord->offset, coord->type, m_swap ).double_val );
+            }
+
+            if ( m_colors )
+            {
+                for ( size_t j = 0; j < 3; j++ )
+                {
+                    const ::Property* color = m_properties[ 3 + j ];
+                    m_colors[ 3 * i + j ] = static_cast<unsigned char>( ::Item( vertex + color->offset, color->type, m_swap ).uint_val );
+                }
+            }
+
+            if ( m_normals )
+            {
+                for ( size_t j = 0; j < 3; j++ )
+                {
+                    const ::Property* normal = m_properties[ 6 + j ];
+                    m_normals[ 3 * i + j ] = static_cast<float>( ::Item( vertex + normal->offset, normal->type, m_swap ).double_val );
+                }
+            }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for reading a range of the triangle faces.
+ *
+ *  The faces are assumed to have a fixed size, that is, the vertex indices are
+ *  the only list and have three indices. The reading is stopped if a face has
+ *  a different number of the indices.
+ */
+/*===========================================================================*/
+class FaceReader : public kvs::Thread
+{
+private:
+
+    const kvs::UInt8* m_data; ///< pointer to the first face
+    size_t m_stride; ///< size of the face in bytes
+    bool m_swap; ///< true, if the bytes are swapped
+    const ::Property* m_indices; ///< property of the vertex indices
+    size_t m_begin; ///< first face
+    size_t m_end; ///< last face + 1
+    kvs::UInt32* m_connections; ///< connections
+    bool m_success; ///< true, if all of the faces are triangles
+
+public:
+
+    FaceReader(): m_data( NULL ), m_stride( 0 ), m_swap( false ), m_indices( NULL ),
+                  m_begin( 0 ), m_end( 0 ), m_connections( NULL ), m_success( false ) {}
+
+    bool success() const { return m_success; }
+
+    void setup(
+        const kvs::UInt8* data,
+        const size_t stride,
+        const bool swap,
+        const ::Property* indices,
+        const size_t begin,
+        const size_t end,
+        kvs::UInt32* connections )
+    {
+        m_data = data;
+        m_stride = stride;
+        m_swap = swap;
+        m_indices = indices;
+        m_begin = begin;
+        m_end = end;
+        m_connections = connections;
+    }
+
+    void run()
+    {
+        const size_t count_size = ::SizeOf( m_indices->count_type );
+        const size_t index_size = ::SizeOf( m_indices->type );
+        m_success = false;
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt8* list = m_data + i * m_stride + m_indices->offset;
+            if ( ::Item( list, m_indices->count_type, m_swap ).int_val != 3 ) { return; }
+
+            const kvs::UInt8* index = list + count_size;
+            for ( size_t j = 0; j < 3; j++, index += index_size )
+            {
+                m_connections[ 3 * i + j ] = static_cast<kvs::UInt32>( ::Item( index, m_indices->type, m_swap ).int_val );
+            }
+        }
+        m_success = true;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of threads for the elements.
+ *  @param  nelements [in] number of the elements
+ *  @return number of threads
+ */
+/*===========================================================================*/
+size_t NumberOfThreads( const size_t nelements )
+{
+    const size_t min_elements_per_thread = 64 * 1024;
+    const size_t max_nthreads = nelements / min_elements_per_thread + 1;
+    return kvs::Math::Min( kvs::Thread::DefaultNumberOfThreads(), max_nthreads );
+}
+
+} // end of namespace
+
 namespace kvs
 {
 
@@ -230,6 +558,10 @@ bool Ply::read( const std::string& filename )
     BaseClass::setFilename( filename );
     BaseClass::setSuccess( true );
 
+    // Binary vertices and faces are read from the mapped file directly, and
+    // the other files are read by the PLY library.
+    if ( this->read_binary( filename ) ) { return BaseClass::isSuccess(); }
+
     // Read PLY file.
     kvs::ply::PlyFile* ply;
     int nelems;
@@ -496,6 +828,262 @@ bool Ply::write( const std::string& filename )
     return true;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Reads the binary PLY file mapped into memory.
+ *  @param  filename [in] filename
+ *  @return true, if the file is handled (false: to be read by the PLY library)
+ *
+ *  The file is handled if it is a binary file with a vertex element of scalar
+ *  properties followed by an optional face element. The vertices and the
+ *  triangle faces are converted directly into the arrays by several threads.
+ *  The truncated file is handled as a failure (see isSuccess).
+ */
+/*===========================================================================*/
+bool Ply::read_binary( const std::string& filename )
+{
+    kvs::MappedFile file;
+    if ( !file.open( filename ) ) { return false; }
+
+    const char* const begin = static_cast<const char*>( file.data() );
+    const char* const end = begin + file.size();
+
+    // Header.
+    const char* p = begin;
+    int file_type = 0;
+    std::vector< ::Element> elements;
+    for ( size_t nlines = 0; ; nlines++ )
+    {
+        const char* eol = static_cast<const char*>( memchr( p, '\n', end - p ) );
+        if ( !eol ) { return false; }
+
+        const std::vector<std::string> words = ::Split( std::string( p, eol ) );
+        p = eol + 1;
+
+        if ( nlines == 0 )
+        {
+            if ( words.size() != 1 || words[0] != "ply" ) { return false; }
+            continue;
+        }
+
+        if ( words.empty() || words[0] == "comment" || words[0] == "obj_info" ) { continue; }
+        if ( words[0] == "end_header" ) { break; }
+
+        if ( words[0] == "format" && words.size() == 3 )
+        {
+            if ( words[1] == "binary_little_endian" ) { file_type = PLY_BINARY_LE; }
+            else if ( words[1] == "binary_big_endian" ) { file_type = PLY_BINARY_BE; }
+            else { return false; }
+        }
+        else if ( words[0] == "element" && words.size() == 3 )
+        {
+            ::Element element;
+            element.name = words[1];
+            element.count = static_cast<size_t>( strtoul( words[2].c_str(), NULL, 10 ) );
+            elements.push_back( element );
+        }
+        else if ( words[0] == "property" && words.size() == 3 && !elements.empty() )
+        {
+            ::Property property;
+            property.name = words[2];
+            property.type = ::TypeOf( words[1] );
+            property.count_type = 0;
+            if ( property.type == 0 ) { return false; }
+            elements.back().properties.push_back( property );
+        }
+        else if ( words[0] == "property" && words.size() == 5 && words[1] == "list" && !elements.empty() )
+        {
+            ::Property property;
+            property.name = words[4];
+            property.type = ::TypeOf( words[3] );
+            property.count_type = ::TypeOf( words[2] );
+            if ( property.type == 0 || property.count_type == 0 ) { return false; }
+            elements.back().properties.push_back( property );
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if ( file_type == 0 || elements.empty() || elements[0].name != "vertex" ) { return false; }
+
+    // Offsets of the scalar properties before the first list.
+    for ( size_t i = 0; i < elements.size(); i++ )
+    {
+        size_t offset = 0;
+        std::vector< ::Property>& properties = elements[i].properties;
+        for ( size_t j = 0; j < properties.size(); j++ )
+        {
+            properties[j].offset = offset;
+            offset += properties[j].count_type == 0 ? ::SizeOf( properties[j].type ) : ::SizeOf( properties[j].count_type );
+        }
+    }
+
+    // Vertex properties.
+    const ::Element& vertex = elements[0];
+    const char* names[9] = { "x", "y", "z", "red", "green", "blue", "nx", "ny", "nz" };
+    const ::Property* properties[9] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    size_t vertex_size = 0;
+    for ( size_t i = 0; i < vertex.properties.size(); i++ )
+    {
+        const ::Property& property = vertex.properties[i];
+        if ( property.count_type != 0 ) { return false; }
+        for ( size_t j = 0; j < 9; j++ )
+        {
+            if ( property.name == names[j] && !properties[j] ) { properties[j] = &property; }
+        }
+        vertex_size += ::SizeOf( property.type );
+    }
+
+    if ( !properties[0] || !properties[1] || !properties[2] ) { return false; }
+
+    const bool has_colors = properties[3] && properties[4] && properties[5];
+    const bool has_normals = properties[6] && properties[7] && properties[8];
+
+    // Face properties.
+    const ::Element* face = elements.size() > 1 && elements[1].name == "face" ? &elements[1] : NULL;
+    const ::Property* indices = NULL;
+    bool fixed_face_size = true;
+    if ( face )
+    {
+        for ( size_t i = 0; i < face->properties.size(); i++ )
+        {
+            const ::Property& property = face->properties[i];
+            if ( property.name == "vertex_indices" && property.count_type != 0 && !indices ) { indices = &property; }
+            else if ( property.count_type != 0 ) { fixed_face_size = false; }
+        }
+    }
+
+    const bool swap_bytes =
+        ( kvs::Endian::IsBig() && file_type == PLY_BINARY_LE ) ||
+        ( kvs::Endian::IsLittle() && file_type == PLY_BINARY_BE );
+
+    const kvs::UInt8* data = reinterpret_cast<const kvs::UInt8*>( p );
+    const size_t data_size = static_cast<size_t>( end - p );
+    const size_t nverts = vertex.count;
+    if ( nverts > data_size / vertex_size )
+    {
+        kvsMessageError( "Cannot read vertex element." );
+        BaseClass::setSuccess( false );
+        return true;
+    }
+
+    // Connections.
+    kvs::ValueArray<kvs::UInt32> connections;
+    const kvs::UInt8* face_data = data + nverts * vertex_size;
+    const size_t face_data_size = data_size - nverts * vertex_size;
+    if ( indices )
+    {
+        const size_t nfaces = face->count;
+        connections.allocate( nfaces * 3 );
+
+        bool success = false;
+        size_t face_size = ::SizeOf( indices->count_type ) + 3 * ::SizeOf( indices->type );
+        for ( size_t i = 0; i < face->properties.size(); i++ )
+        {
+            const ::Property& property = face->properties[i];
+            if ( property.count_type == 0 ) { face_size += ::SizeOf( property.type ); }
+        }
+
+        if ( nfaces > 0 && fixed_face_size && nfaces <= face_data_size / face_size )
+        {
+            const size_t nthreads = ::NumberOfThreads( nfaces );
+            std::vector< ::FaceReader> readers( nthreads );
+            for ( size_t i = 0; i < nthreads; i++ )
+            {
+                const size_t first = nfaces * i / nthreads;
+                const size_t last = nfaces * ( i + 1 ) / nthreads;
+                readers[i].setup( face_data, face_size, swap_bytes, indices, first, last, connections.data() );
+            }
+            kvs::Thread::Run( &readers[0], readers.size() );
+
+            success = true;
+            for ( size_t i = 0; i < nthreads; i++ ) { success = success && readers[i].success(); }
+        }
+
+        if ( !success )
+        {
+            // Faces of any size, taking the first three indices.
+            const kvs::UInt8* q = face_data;
+            const kvs::UInt8* const q_end = face_data + face_data_size;
+            bool truncated = false;
+            for ( size_t i = 0; i < nfaces && !truncated; i++ )
+            {
+                for ( size_t j = 0; j < face->properties.size(); j++ )
+                {
+                    const ::Property& property = face->properties[j];
+                    if ( property.count_type == 0 )
+                    {
+                        if ( ::SizeOf( property.type ) > static_cast<size_t>( q_end - q ) ) { truncated = true; break; }
+                        q += ::SizeOf( property.type );
+                        continue;
+                    }
+
+                    const size_t count_size = ::SizeOf( property.count_type );
+                    if ( count_size > static_cast<size_t>( q_end - q ) ) { truncated = true; break; }
+                    const int count = ::Item( q, property.count_type, swap_bytes ).int_val;
+                    q += count_size;
+
+                    const size_t index_size = ::SizeOf( property.type );
+                    if ( count < 0 || static_cast<size_t>( count ) > static_cast<size_t>( q_end - q ) / index_size ) { truncated = true; break; }
+                    if ( &property == indices )
+                    {
+                        for ( size_t k = 0; k < 3; k++ )
+                        {
+                            connections[ 3 * i + k ] = static_cast<int>( k ) < count ?
+                                static_cast<kvs::UInt32>( ::Item( q + k * index_size, property.type, swap_bytes ).int_val ) : 0;
+                        }
+                    }
+                    q += count * index_size;
+                }
+            }
+
+            if ( truncated )
+            {
+                kvsMessageError( "Cannot read face element." );
+                BaseClass::setSuccess( false );
+                return true;
+            }
+        }
+    }
+
+    // Vertices.
+    m_file_type = Ply::FileType( file_type );
+    m_nverts = nverts;
+    m_has_colors = has_colors;
+    m_has_normals = has_normals;
+    m_coords.allocate( m_nverts * 3 );
+    if ( m_has_colors ) { m_colors.allocate( m_nverts * 3 ); }
+    if ( m_has_normals ) { m_normals.allocate( m_nverts * 3 ); }
+
+    const size_t nthreads = ::NumberOfThreads( nverts );
+    std::vector< ::VertexReader> readers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t first = nverts * i / nthreads;
+        const size_t last = nverts * ( i + 1 ) / nthreads;
+        readers[i].setup( data, vertex_size, swap_bytes, properties, first, last,
+                          m_coords.data(),
+                          m_has_colors ? m_colors.data() : NULL,
+                          m_has_normals ? m_normals.data() : NULL );
+    }
+    kvs::Thread::Run( &readers[0], readers.size() );
+
+    if ( indices )
+    {
+        m_has_connections = true;
+        m_nfaces = face->count;
+        m_connections = connections;
+    }
+
+    this->calculate_min_max_coord();
+    if ( !m_has_normals ) this->calculate_normals();
+    if ( !m_has_connections ) m_nfaces = m_nverts / 3;
+
+    return true;
+}
+
 void Ply::calculate_min_max_coord()
 {
     m_min_coord = kvs::Vector3f::All( std::numeric_limits<float>::max() );
@@ -523,6 +1111,7 @@ void Ply::calculate_normals()
     counter.fill( 0 );
 
     m_normals.allocate( m_nverts * 3 );
+    m_normals.fill( 0 );
     const kvs::UInt32* pconnections = m_connections.data();
     const kvs::Real32* pcoords = m_coords.data();
     for ( size_t i = 0; i < m_nfaces; i++ )
@@ -101,6 +101,7 @@ public:
 
 private:
 
+    bool read_binary( const std::string& filename );
     void calculate_min_max_coord();
     void calculate_normals();
 };
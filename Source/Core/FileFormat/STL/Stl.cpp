@@ -14,14 +14,21 @@
 /*****************************************************************************/
 #include "Stl.h"
 #include <cstring>
+#include <cmath>
+#include <vector>
 #include <kvs/File>
 #include <kvs/Assert>
+#include <kvs/Math>
+#include <kvs/AsciiReader>
+#include <kvs/MappedFile>
+#include <kvs/Endian>
+#include <kvs/Platform>
+#include <kvs/Thread>
 
 
 namespace
 {
 const int MaxLineLength = 256;
-const char* const Delimiter = " \t\n\r";
 const std::string FileTypeToString[2] = { "ascii", "binary" };
 }
 
@@ -46,9 +53,10 @@ bool IsAsciiType( FILE* ifs )
     {
         if ( buffer[0] == '\n' ) continue;
 
-        const char* head = strtok( buffer, ::Delimiter );
-        if ( !strcmp( head, "solid" ) ) break;
-        else if ( !strcmp( head, "facet" ) ) return true;
+        size_t length = 0;
+        const char* head = kvs::AsciiReader::Token( buffer, &length );
+        if ( kvs::AsciiReader::Equal( head, length, "solid" ) ) break;
+        else if ( kvs::AsciiReader::Equal( head, length, "facet" ) ) return true;
         else return false;
     }
 
@@ -65,6 +73,164 @@ bool IsAsciiType( FILE* ifs )
     return false;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Reads the keyword.
+ *  @param  p [in/out] pointer to the text (moved to the end of the keyword)
+ *  @param  word [in] keyword
+ *  @return true, if the next token is the keyword
+ */
+/*===========================================================================*/
+bool Keyword( const char** p, const char* word )
+{
+    size_t length = 0;
+    const char* head = kvs::AsciiReader::Token( kvs::AsciiReader::SkipDelimiters( *p ), &length );
+    if ( !kvs::AsciiReader::Equal( head, length, word ) ) return false;
+
+    *p = head + length;
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Reads the three components of the vector.
+ *  @param  p [in/out] pointer to the text (moved to the end of the vector)
+ *  @param  values [out] array that the components are appended to
+ *  @return true, if the components are read successfully
+ */
+/*===========================================================================*/
+bool Vector( const char** p, std::vector<kvs::Real32>* values )
+{
+    for ( int i = 0; i < 3; i++ )
+    {
+        kvs::Real32 value = 0.0f;
+        const char* next = kvs::AsciiReader::Parse( kvs::AsciiReader::SkipDelimiters( *p ), &value );
+        if ( !next ) return false;
+
+        values->push_back( value );
+        *p = next;
+    }
+
+    return true;
+}
+
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for unpacking a range of the binary triangle records.
+ *
+ *  A record consists of a normal vector (12 bytes), three vertices (36 bytes)
+ *  and an unused block (2 bytes).
+ */
+/*===========================================================================*/
+class TriangleReader : public kvs::Thread
+{
+private:
+
+    const kvs::UInt8* m_records; ///< pointer to the first record
+    size_t m_begin; ///< first triangle
+    size_t m_end; ///< last triangle + 1
+    kvs::Real32* m_normals; ///< normal vectors
+    kvs::Real32* m_coords; ///< coordinate values
+
+public:
+
+    TriangleReader(): m_records( NULL ), m_begin( 0 ), m_end( 0 ), m_normals( NULL ), m_coords( NULL ) {}
+
+    void setup( const kvs::UInt8* records, const size_t begin, const size_t end, kvs::Real32* normals, kvs::Real32* coords )
+    {
+        m_records = records;
+        m_begin = begin;
+        m_end = end;
+        m_normals = normals;
+        m_coords = coords;
+    }
+
+    void run()
+    {
+        const size_t RecordSize = 50;
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt8* record = m_records + i * RecordSize;
+            memcpy( m_normals + 3 * i, record, sizeof( kvs::Real32 ) * 3 );
+            memcpy( m_coords + 9 * i, record + 12, sizeof( kvs::Real32 ) * 9 );
+        }
+
+#if defined ( KVS_PLATFORM_BIG_ENDIAN )
+        // The binary STL is written in little endian.
+        kvs::Endian::Swap( m_normals + 3 * m_begin, 3 * ( m_end - m_begin ) );
+        kvs::Endian::Swap( m_coords + 9 * m_begin, 9 * ( m_end - m_begin ) );
+#endif
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Quantized coordinate of the vertex for the vertex merging.
+ *
+ *  The coordinate values are quantized to the grid of the tolerance, or are
+ *  compared by the bit patterns (with -0 and +0 equal) if the tolerance is 0.
+ */
+/*===========================================================================*/
+struct VertexKey
+{
+    kvs::Int64 k[3];
+
+    VertexKey( const kvs::Real32* coord, const kvs::Real32 tolerance )
+    {
+        for ( size_t i = 0; i < 3; i++ )
+        {
+            if ( tolerance > 0.0f )
+            {
+                k[i] = static_cast<kvs::Int64>( std::floor( coord[i] / tolerance ) );
+            }
+            else
+            {
+                const kvs::Real32 value = coord[i] == 0.0f ? 0.0f : coord[i];
+                kvs::UInt32 bits = 0;
+                memcpy( &bits, &value, sizeof( bits ) );
+                k[i] = bits;
+            }
+        }
+    }
+
+    bool operator ==( const VertexKey& other ) const
+    {
+        return k[0] == other.k[0] && k[1] == other.k[1] && k[2] == other.k[2];
+    }
+
+    kvs::UInt64 hash() const
+    {
+        kvs::UInt64 h = 0;
+        for ( size_t i = 0; i < 3; i++ )
+        {
+            h ^= static_cast<kvs::UInt64>( k[i] ) + 0x9e3779b97f4a7c15ULL + ( h << 6 ) + ( h >> 2 );
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the pointer to the coordinate of the vertex of the triangle.
+ *  @param  coords [in] coordinate array
+ *  @param  connections [in] connection array (empty for the triangle soup)
+ *  @param  index [in] vertex index of the triangle soup (3 * triangle + vertex)
+ *  @return pointer to the coordinate
+ */
+/*===========================================================================*/
+inline const kvs::Real32* VertexCoord(
+    const kvs::ValueArray<kvs::Real32>& coords,
+    const kvs::ValueArray<kvs::UInt32>& connections,
+    const size_t index )
+{
+    const size_t id = connections.empty() ? index : connections[ index ];
+    return coords.data() + 3 * id;
+}
+
 } // end of namespace
 
 namespace kvs
@@ -141,6 +307,7 @@ bool Stl::read( const std::string& filename )
 {
     BaseClass::setFilename( filename );
     BaseClass::setSuccess( true );
+    m_connections.release();
 
     FILE* ifs = fopen( filename.c_str(), "r" );
     if ( !ifs )
@@ -159,7 +326,7 @@ bool Stl::read( const std::string& filename )
     else
     {
         m_file_type = Stl::Binary;
-        success = this->read_binary( ifs );
+        success = this->read_binary( filename );
     }
     BaseClass::setSuccess( success );
 
@@ -177,7 +344,7 @@ bool Stl::read( const std::string& filename )
 /*===========================================================================*/
 bool Stl::write( const std::string& filename )
 {
-    KVS_ASSERT( ( m_normals.size() / 3 ) == ( m_coords.size() / 9 ) );
+    KVS_ASSERT( ( m_normals.size() / 3 ) == ( this->hasConnections() ? m_connections.size() / 3 : m_coords.size() / 9 ) );
 
     BaseClass::setFilename( filename );
     BaseClass::setSuccess( true );
@@ -206,6 +373,60 @@ bool Stl::write( const std::string& filename )
     return success;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Merges the vertices shared by the triangles.
+ *  @param  tolerance [in] size of the grid to quantize the coordinates (0: exact)
+ *
+ *  The triangle soup is converted into the unique vertices and the connections
+ *  by the hash table on the quantized coordinates. The normal vectors of the
+ *  triangles are kept.
+ */
+/*===========================================================================*/
+void Stl::mergeVertices( const kvs::Real32 tolerance )
+{
+    if ( this->hasConnections() ) { return; }
+
+    const size_t nvertices = m_coords.size() / 3;
+    if ( nvertices == 0 ) { return; }
+
+    size_t table_size = 1;
+    while ( table_size < nvertices * 2 ) { table_size <<= 1; }
+    const size_t mask = table_size - 1;
+
+    // Unique vertex ID + 1 of each slot (0: empty).
+    std::vector<kvs::UInt32> table( table_size, 0 );
+    kvs::ValueArray<kvs::UInt32> connections( nvertices );
+    kvs::Real32* coords = m_coords.data();
+
+    // The unique vertices are compacted to the front of the coordinate array,
+    // since the vertex i is never written before it is read.
+    size_t nunique = 0;
+    for ( size_t i = 0; i < nvertices; i++ )
+    {
+        const ::VertexKey key( coords + 3 * i, tolerance );
+        size_t slot = static_cast<size_t>( key.hash() ) & mask;
+        while ( table[ slot ] != 0 )
+        {
+            const size_t id = table[ slot ] - 1;
+            if ( ::VertexKey( coords + 3 * id, tolerance ) == key ) { break; }
+            slot = ( slot + 1 ) & mask;
+        }
+
+        if ( table[ slot ] == 0 )
+        {
+            if ( nunique != i ) { memmove( coords + 3 * nunique, coords + 3 * i, sizeof( kvs::Real32 ) * 3 ); }
+            table[ slot ] = static_cast<kvs::UInt32>( ++nunique );
+        }
+
+        connections[i] = table[ slot ] - 1;
+    }
+
+    std::vector<kvs::UInt32>().swap( table );
+    m_coords = kvs::ValueArray<kvs::Real32>( m_coords.data(), nunique * 3 );
+    m_connections = connections;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Check file type whether the ascii or the binary.
@@ -224,9 +445,10 @@ bool Stl::is_ascii_type( FILE* ifs )
     {
         if ( buffer[0] == '\n' ) continue;
 
-        const char* head = strtok( buffer, ::Delimiter );
-        if ( !strcmp( head, "solid" ) ) break;
-        else if ( !strcmp( head, "facet" ) ) return true;
+        size_t length = 0;
+        const char* head = kvs::AsciiReader::Token( buffer, &length );
+        if ( kvs::AsciiReader::Equal( head, length, "solid" ) ) break;
+        else if ( kvs::AsciiReader::Equal( head, length, "facet" ) ) return true;
         else return false;
     }
 
@@ -255,120 +477,70 @@ bool Stl::read_ascii( FILE* ifs )
     // Go back file-pointer to head.
     fseek( ifs, 0, SEEK_SET );
 
-    // Check head line.
-    char buffer[ ::MaxLineLength ];
-    while ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
+    kvs::AsciiReader reader;
+    if ( !reader.readAll( ifs ) )
     {
-        if ( buffer[0] == '\n' ) continue;
-
-        const char* head = strtok( buffer, ::Delimiter );
-        if ( !strcmp( head, "solid" ) ) break;
+        kvsMessageError("Cannot read the file.");
+        return false;
+    }
 
-        if ( !strcmp( head, "facet" ) )
-        {
-            fseek( ifs, 0, SEEK_SET );
-            break;
-        }
+    // Check head line.
+    const char* p = reader.text();
+    if ( ::Keyword( &p, "solid" ) )
+    {
+        // Skip the solid name.
+        while ( *p != '\n' && *p != '\0' ) { ++p; }
     }
 
     std::vector<kvs::Real32> normals;
     std::vector<kvs::Real32> coords;
-    while ( fgets( buffer, ::MaxLineLength, ifs ) != 0 )
+    for ( ;; )
     {
-        if ( buffer[0] == '\n' ) continue;
-        if ( strstr( buffer, "endsolid" ) ) break;
+        size_t length = 0;
+        const char* head = kvs::AsciiReader::Token( kvs::AsciiReader::SkipDelimiters( p ), &length );
+        if ( length == 0 || kvs::AsciiReader::Equal( head, length, "endsolid" ) ) break;
 
         // facet
-        const char* facet = strtok( buffer, ::Delimiter );
-        if ( !strcmp( facet, "facet" ) )
-        {
-            strtok( 0, ::Delimiter ); // 'normal'
-            normals.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            normals.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            normals.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-        }
-        else
+        if ( !::Keyword( &p, "facet" ) || !::Keyword( &p, "normal" ) || !::Vector( &p, &normals ) )
         {
             kvsMessageError("Cannot find 'facet'.");
             return false;
         }
 
         // outer loop
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* outer = strtok( buffer, ::Delimiter );
-        const char* loop = strtok( 0, ::Delimiter );
-        if ( strcmp( outer, "outer" ) || strcmp( loop, "loop" ) )
+        if ( !::Keyword( &p, "outer" ) || !::Keyword( &p, "loop" ) )
         {
             kvsMessageError("Cannot find 'outer loop'.");
             return false;
         }
 
-        // vertex 0
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* vertex0 = strtok( buffer, ::Delimiter );
-        if ( !strcmp( vertex0, "vertex" ) )
-        {
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-        }
-        else
-        {
-            kvsMessageError("Cannot find 'vertex' (0).");
-            return false;
-        }
-
-        // vertex 1
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* vertex1 = strtok( buffer, ::Delimiter );
-        if ( !strcmp( vertex1, "vertex" ) )
-        {
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-        }
-        else
-        {
-            kvsMessageError("Cannot find 'vertex' (1).");
-            return false;
-        }
-
-        // vertex 2
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* vertex2 = strtok( buffer, ::Delimiter );
-        if ( !strcmp( vertex2, "vertex" ) )
+        // vertex 0, 1 and 2
+        for ( int i = 0; i < 3; i++ )
         {
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-            coords.push_back( static_cast<kvs::Real32>( atof( strtok( 0, ::Delimiter ) ) ) );
-        }
-        else
-        {
-            kvsMessageError("Cannot find 'vertex' (2).");
-            return false;
+            if ( !::Keyword( &p, "vertex" ) || !::Vector( &p, &coords ) )
+            {
+                kvsMessageError("Cannot find 'vertex' (%d).", i );
+                return false;
+            }
         }
 
         // endloop
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* endloop = strtok( buffer, ::Delimiter );
-        if ( strcmp( endloop, "endloop" ) )
+        if ( !::Keyword( &p, "endloop" ) )
         {
             kvsMessageError("Cannot find 'endloop'.");
             return false;
         }
 
         // endfacet
-        if ( fgets( buffer, ::MaxLineLength, ifs ) == 0 ) return false;
-        const char* endfacet = strtok( buffer, ::Delimiter );
-        if ( strcmp( endfacet, "endfacet" ) )
+        if ( !::Keyword( &p, "endfacet" ) )
         {
             kvsMessageError("Cannot find 'endfacet'.");
             return false;
         }
     }
 
-    m_normals = kvs::ValueArray<kvs::Real32>( normals );
-    m_coords = kvs::ValueArray<kvs::Real32>( coords );
+    m_normals = kvs::ValueArray<kvs::Real32>::Adopt( normals );
+    m_coords = kvs::ValueArray<kvs::Real32>::Adopt( coords );
 
     return true;
 }
@@ -376,72 +548,65 @@ bool Stl::read_ascii( FILE* ifs )
 /*===========================================================================*/
 /**
  *  @brief  Reads the polygon data as binary format.
- *  @param  ifs [in] file pointer
+ *  @param  filename [in] filename
  *  @return true, if the reading process is done successfully
+ *
+ *  The file is mapped into memory, and the triangle records are unpacked
+ *  directly into the preallocated arrays by several threads.
  */
 /*===========================================================================*/
-bool Stl::read_binary( FILE* ifs )
+bool Stl::read_binary( const std::string& filename )
 {
-    // Go back file-pointer to head.
-    fseek( ifs, 0, SEEK_SET );
-
-    // Read header string (80bytes).
     const size_t HeaderLength = 80;
-    char buffer[ HeaderLength ];
-    if ( fread( buffer, sizeof( char ), HeaderLength, ifs ) != HeaderLength )
+    const size_t RecordSize = 50;
+
+    kvs::MappedFile file;
+    if ( !file.open( filename ) || file.size() < HeaderLength )
     {
         kvsMessageError("Cannot read a header string (80byets).");
         return false;
     }
 
     // Read a number of triangles (4bytes).
+    const kvs::UInt8* data = static_cast<const kvs::UInt8*>( file.data() );
     kvs::UInt32 ntriangles = 0;
-    if ( fread( &ntriangles, sizeof( kvs::UInt32 ), 1, ifs ) != 1 )
+    if ( file.size() < HeaderLength + sizeof( kvs::UInt32 ) )
     {
         kvsMessageError("Cannot read a number of triangles.");
         return false;
     }
+    memcpy( &ntriangles, data + HeaderLength, sizeof( kvs::UInt32 ) );
+#if defined ( KVS_PLATFORM_BIG_ENDIAN )
+    kvs::Endian::Swap( &ntriangles );
+#endif
+
+    const kvs::UInt8* records = data + HeaderLength + sizeof( kvs::UInt32 );
+    const size_t nrecords = ( file.size() - HeaderLength - sizeof( kvs::UInt32 ) ) / RecordSize;
+    if ( nrecords < ntriangles )
+    {
+        kvsMessageError("Cannot read %u triangles (%u triangles in the file).",
+                        ntriangles, static_cast<unsigned int>( nrecords ) );
+        return false;
+    }
 
     // Memory allocation.
-    m_normals.allocate( ntriangles * 3 );
-    m_coords.allocate( ntriangles * 9 );
-
-    // Read trianbles.
-    kvs::Real32* normals = m_normals.data();
-    kvs::Real32* coords = m_coords.data();
-    kvs::UInt32 index3 = 0;
-    kvs::UInt32 index9 = 0;
-    for ( kvs::UInt32 i = 0; i < ntriangles; i++, index3 += 3, index9 += 9 )
+    m_normals.allocate( size_t( ntriangles ) * 3 );
+    m_coords.allocate( size_t( ntriangles ) * 9 );
+
+    // Read triangles.
+    const size_t min_triangles_per_thread = 64 * 1024;
+    const size_t max_nthreads = ntriangles / min_triangles_per_thread + 1;
+    const size_t nthreads = kvs::Math::Min( kvs::Thread::DefaultNumberOfThreads(), max_nthreads );
+    std::vector< ::TriangleReader> readers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
     {
-        // Normal vector (4x3=12byets)
-        if ( fread( normals + index3, sizeof( kvs::Real32 ), 3, ifs ) != 3 )
-        {
-            kvsMessageError("Cannot read a normal vector.");
-            m_normals.release();
-            return false;
-        }
-
-        // Coordinate value (4x3=12bytes)
-        if ( fread( coords + index9, sizeof( kvs::Real32 ), 9, ifs ) != 9 )
-        {
-            kvsMessageError("Cannot read a coordinate value.");
-            m_coords.release();
-            return false;
-        }
-
-        // Unused (2bytes)
-        // NOTE: This block is sometimes used for storing color infomartion,
-        // but we don't currently supported such color STL format.
-        char unused[2];
-        if ( fread( unused, sizeof( char ), 2, ifs ) != 2 )
-        {
-            kvsMessageError("Cannot read unused block (2bytes).");
-            m_normals.release();
-            m_coords.release();
-            return false;
-        }
+        const size_t begin = ntriangles * i / nthreads;
+        const size_t end = ntriangles * ( i + 1 ) / nthreads;
+        readers[i].setup( records, begin, end, m_normals.data(), m_coords.data() );
     }
 
+    kvs::Thread::Run( &readers[0], nthreads );
+
     return true;
 }
 
@@ -459,26 +624,18 @@ bool Stl::write_ascii( FILE* ofs )
 
     const size_t ntriangles = m_normals.size() / 3;
     size_t index3 = 0;
-    size_t index9 = 0;
-    for ( size_t i = 0; i < ntriangles; i++, index3 += 3, index9 += 9 )
+    for ( size_t i = 0; i < ntriangles; i++, index3 += 3 )
     {
         fprintf( ofs, "facet normal %f %f %f\n",
                  m_normals[ index3 + 0 ],
                  m_normals[ index3 + 1 ],
                  m_normals[ index3 + 2 ] );
         fprintf( ofs, "outer loop\n" );
-        fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 0 ],
-                 m_coords[ index9 + 1 ],
-                 m_coords[ index9 + 2 ] );
-        fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 3 ],
-                 m_coords[ index9 + 4 ],
-                 m_coords[ index9 + 5 ] );
-        fprintf( ofs, "vertex %f %f %f\n",
-                 m_coords[ index9 + 6 ],
-                 m_coords[ index9 + 7 ],
-                 m_coords[ index9 + 8 ] );
+        for ( size_t j = 0; j < 3; j++ )
+        {
+            const kvs::Real32* coord = ::VertexCoord( m_coords, m_connections, index3 + j );
+            fprintf( ofs, "vertex %f %f %f\n", coord[0], coord[1], coord[2] );
+        }
         fprintf( ofs, "endloop\n" );
         fprintf( ofs, "endfacet\n" );
     }
@@ -516,10 +673,8 @@ bool Stl::write_binary( FILE* ofs )
 
     // Triangles (50*ntriangles bytes)
     const kvs::Real32* normals = m_normals.data();
-    const kvs::Real32* coords = m_coords.data();
     size_t index3 = 0;
-    size_t index9 = 0;
-    for ( size_t i = 0; i < ntriangles; i++, index3 += 3, index9 += 9 )
+    for ( size_t i = 0; i < ntriangles; i++, index3 += 3 )
     {
         // Normal vector
         if ( fwrite( normals + index3, sizeof( kvs::Real32 ), 3, ofs ) != 3 )
@@ -529,7 +684,13 @@ bool Stl::write_binary( FILE* ofs )
         }
 
         // Coordinate values
-        if ( fwrite( coords + index9, sizeof( kvs::Real32 ), 9, ofs ) != 9 )
+        kvs::Real32 coords[9];
+        for ( size_t j = 0; j < 3; j++ )
+        {
+            memcpy( coords + 3 * j, ::VertexCoord( m_coords, m_connections, index3 + j ), sizeof( kvs::Real32 ) * 3 );
+        }
+
+        if ( fwrite( coords, sizeof( kvs::Real32 ), 9, ofs ) != 9 )
         {
             kvsMessageError("Cannot write a coordinate values (3 vertices = 9 elements).");
             return false;
@@ -50,6 +50,7 @@ protected:
     FileType m_file_type; ///< file type
     kvs::ValueArray<kvs::Real32> m_normals; /// normal vector array
     kvs::ValueArray<kvs::Real32> m_coords; /// coordinate value array
+    kvs::ValueArray<kvs::UInt32> m_connections; /// connection array (empty for the triangle soup)
 
 public:
 
@@ -64,11 +65,15 @@ public:
     FileType fileType() const { return m_file_type; }
     const kvs::ValueArray<kvs::Real32>& normals() const { return m_normals; }
     const kvs::ValueArray<kvs::Real32>& coords() const { return m_coords; }
+    const kvs::ValueArray<kvs::UInt32>& connections() const { return m_connections; }
     size_t numberOfTriangles() const { return m_normals.size() / 3; }
+    bool hasConnections() const { return m_connections.size() > 0; }
 
     void setFileType( const FileType file_type ) { m_file_type = file_type; }
     void setNormals( const kvs::ValueArray<kvs::Real32>& normals ) { m_normals = normals; }
     void setCoords( const kvs::ValueArray<kvs::Real32>& coords ) { m_coords = coords; }
+    void setConnections( const kvs::ValueArray<kvs::UInt32>& connections ) { m_connections = connections; }
+    void mergeVertices( const kvs::Real32 tolerance = 0.0f );
 
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
     bool read( const std::string& filename );
@@ -78,7 +83,7 @@ private:
 
     bool is_ascii_type( FILE* ifs );
     bool read_ascii( FILE* ifs );
-    bool read_binary( FILE* ifs );
+    bool read_binary( const std::string& filename );
     bool write_ascii( FILE* ifs );
     bool write_binary( FILE* ifs );
 
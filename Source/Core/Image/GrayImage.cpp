@@ -24,43 +24,206 @@
 #include <kvs/Pgm>
 #include <kvs/Tiff>
 #include <kvs/Dicom>
+#include <kvs/Thread>
 #include <algorithm>
+#include <vector>
+#include <cmath>
 
 
-namespace kvs
+namespace
 {
 
 /*===========================================================================*/
 /**
- *  @brief  Gray-scaling by the mean-value method.
+ *  @brief  Thread class for gray-scaling a range of the pixels.
+ */
+/*===========================================================================*/
+template <typename Converter>
+class GrayScaler : public kvs::Thread
+{
+private:
+
+    Converter m_converter; ///< gray-scaling kernel
+    const kvs::UInt8* m_src; ///< color pixels
+    kvs::UInt8* m_dst; ///< gray pixels
+    size_t m_npixels; ///< number of pixels
+
+public:
+
+    GrayScaler(): m_src( NULL ), m_dst( NULL ), m_npixels( 0 ) {}
+
+    void setup( const Converter& converter, const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels )
+    {
+        m_converter = converter;
+        m_src = src;
+        m_dst = dst;
+        m_npixels = npixels;
+    }
+
+    void run()
+    {
+        m_converter( m_src, m_dst, m_npixels );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Converts the color pixels to the gray pixels.
  *  @param  image [in] color image
  *  @param  data [out] pixel data array
+ *  @param  converter [in] kernel that converts the contiguous pixels
+ *
+ *  The rows of the color image and the gray image have no padding, so that
+ *  the pixels are processed as a flat array divided among the threads.
  */
 /*===========================================================================*/
-void GrayImage::MeanValue::operator () (
-    const kvs::ColorImage& image,
-    kvs::ValueArray<kvs::UInt8>& data )
+template <typename Converter>
+void GrayScale( const kvs::ColorImage& image, kvs::ValueArray<kvs::UInt8>& data, const Converter& converter )
 {
-    const size_t width = image.width();
-    const size_t height = image.height();
-    const kvs::UInt8* image_data = image.pixels().data();
-    for( size_t j = 0; j < height; j++ )
+    const size_t npixels = image.width() * image.height();
+    if ( npixels == 0 ) { return; }
+
+    const size_t min_pixels_per_thread = 256 * 1024;
+    const size_t max_nthreads = kvs::Math::Max( npixels / min_pixels_per_thread, size_t( 1 ) );
+    const size_t nthreads = kvs::Math::Min( kvs::Thread::DefaultNumberOfThreads(), max_nthreads );
+
+    const kvs::UInt8* src = image.pixels().data();
+    kvs::UInt8* dst = data.data();
+    std::vector< GrayScaler<Converter> > scalers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = npixels * i / nthreads;
+        const size_t end = npixels * ( i + 1 ) / nthreads;
+        scalers[i].setup( converter, src + begin * 3, dst + begin, end - begin );
+    }
+
+    kvs::Thread::Run( &scalers[0], nthreads );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Gray-scaling kernels for the contiguous pixels.
+ *
+ *  The kernels are branchless loops over the pixels, which can be vectorized
+ *  by the compiler.
+ */
+/*===========================================================================*/
+struct MeanValueKernel
+{
+    void operator () ( const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels ) const
+    {
+        for ( size_t i = 0; i < npixels; i++ )
+        {
+            const unsigned int r = src[ 3 * i + 0 ];
+            const unsigned int g = src[ 3 * i + 1 ];
+            const unsigned int b = src[ 3 * i + 2 ];
+            dst[i] = static_cast<kvs::UInt8>( ( r + g + b ) / 3 );
+        }
+    }
+};
+
+struct MiddleValueKernel
+{
+    void operator () ( const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels ) const
+    {
+        for ( size_t i = 0; i < npixels; i++ )
+        {
+            const unsigned int r = src[ 3 * i + 0 ];
+            const unsigned int g = src[ 3 * i + 1 ];
+            const unsigned int b = src[ 3 * i + 2 ];
+            const unsigned int max = kvs::Math::Max( r, g, b );
+            const unsigned int min = kvs::Math::Min( r, g, b );
+            dst[i] = static_cast<kvs::UInt8>( ( max + min ) / 2 );
+        }
+    }
+};
+
+struct MedianValueKernel
+{
+    void operator () ( const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels ) const
+    {
+        for ( size_t i = 0; i < npixels; i++ )
+        {
+            const kvs::UInt8 r = src[ 3 * i + 0 ];
+            const kvs::UInt8 g = src[ 3 * i + 1 ];
+            const kvs::UInt8 b = src[ 3 * i + 2 ];
+            const kvs::UInt8 lower = kvs::Math::Min( r, g );
+            const kvs::UInt8 upper = kvs::Math::Max( r, g );
+            dst[i] = kvs::Math::Max( lower, kvs::Math::Min( upper, b ) );
+        }
+    }
+};
+
+struct NTSCWeightedMeanValueKernel
+{
+    void operator () ( const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels ) const
     {
-        const size_t col_line_index = j * image.bytesPerLine();
-        const size_t gry_line_index = j * image.width();
-        for( size_t i = 0; i < width; i++ )
+        for ( size_t i = 0; i < npixels; i++ )
         {
-            const size_t col_pixel_index = col_line_index + 3 * i;
-            const size_t gry_pixel_index = gry_line_index + i;
+            const unsigned int r = src[ 3 * i + 0 ];
+            const unsigned int g = src[ 3 * i + 1 ];
+            const unsigned int b = src[ 3 * i + 2 ];
 
-            unsigned int value = 0;
-            value += image_data[ col_pixel_index + 0 ];
-            value += image_data[ col_pixel_index + 1 ];
-            value += image_data[ col_pixel_index + 2 ];
+            /* value = ( 0.298912 * R + 0.586611 * G + 0.114478 * B )
+             *       = ( 2 * R + 4 * G + B ) / 7
+             */
+            dst[i] = static_cast<kvs::UInt8>( ( 2 * r + 4 * g + b ) / 7 );
+        }
+    }
+};
+
+struct HDTVWeightedMeanValueKernel
+{
+    double gamma_value; ///< gamma value
+    double r_table[256]; ///< gamma-corrected and weighted red values
+    double g_table[256]; ///< gamma-corrected and weighted green values
+    double b_table[256]; ///< gamma-corrected and weighted blue values
 
-            data[ gry_pixel_index ] = static_cast<kvs::UInt8>(value / 3);
+    HDTVWeightedMeanValueKernel(): gamma_value( 2.2 )
+    {
+        for ( size_t i = 0; i < 256; i++ )
+        {
+            const double v = static_cast<double>( i ) / 255.0;
+            r_table[i] = std::pow( v, gamma_value ) * 0.222015;
+            g_table[i] = std::pow( v, gamma_value ) * 0.706655;
+            b_table[i] = std::pow( v, gamma_value ) * 0.071330;
         }
     }
+
+    void operator () ( const kvs::UInt8* src, kvs::UInt8* dst, const size_t npixels ) const
+    {
+        for ( size_t i = 0; i < npixels; i++ )
+        {
+            const double RR = r_table[ src[ 3 * i + 0 ] ];
+            const double GG = g_table[ src[ 3 * i + 1 ] ];
+            const double BB = b_table[ src[ 3 * i + 2 ] ];
+
+            const double V = std::pow( ( RR + GG + BB ), ( 1.0 / gamma_value ) );
+            const unsigned int value = kvs::Math::Round( V * 255.0 );
+
+            dst[i] = static_cast<kvs::UInt8>( value );
+        }
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Gray-scaling by the mean-value method.
+ *  @param  image [in] color image
+ *  @param  data [out] pixel data array
+ */
+/*===========================================================================*/
+void GrayImage::MeanValue::operator () (
+    const kvs::ColorImage& image,
+    kvs::ValueArray<kvs::UInt8>& data )
+{
+    ::GrayScale( image, data, ::MeanValueKernel() );
 }
 
 /*===========================================================================*/
@@ -74,28 +237,7 @@ void GrayImage::MiddleValue::operator () (
     const kvs::ColorImage& image,
     kvs::ValueArray<kvs::UInt8>& data )
 {
-    const size_t width = image.width();
-    const size_t height = image.height();
-    const kvs::UInt8* image_data = image.pixels().data();
-    for( size_t j = 0; j < height; j++ )
-    {
-        const size_t col_line_index = j * image.bytesPerLine();
-        const size_t gry_line_index = j * image.width();
-        for( size_t i = 0; i < width; i++ )
-        {
-            const size_t col_pixel_index = col_line_index + 3 * i;
-            const size_t gry_pixel_index = gry_line_index + i;
-
-            const unsigned int r = image_data[ col_pixel_index + 0 ];
-            const unsigned int g = image_data[ col_pixel_index + 1 ];
-            const unsigned int b = image_data[ col_pixel_index + 2 ];
-            const unsigned int max = kvs::Math::Max( r, g, b );
-            const unsigned int min = kvs::Math::Min( r, g, b );
-            const unsigned int value = ( max + min ) / 2;
-
-            data[ gry_pixel_index ] = static_cast<kvs::UInt8>(value);
-        }
-    }
+    ::GrayScale( image, data, ::MiddleValueKernel() );
 }
 
 /*===========================================================================*/
@@ -109,27 +251,7 @@ void GrayImage::MedianValue::operator () (
     const kvs::ColorImage& image,
     kvs::ValueArray<kvs::UInt8>& data )
 {
-    const size_t width = image.width();
-    const size_t height = image.height();
-    const kvs::UInt8* image_data = image.pixels().data();
-    for( size_t j = 0; j < height; j++ )
-    {
-        const size_t col_line_index = j * image.bytesPerLine();
-        const size_t gry_line_index = j * image.width();
-        for( size_t i = 0; i < width; i ++ )
-        {
-            const size_t col_pixel_index = col_line_index + 3 * i;
-            const size_t gry_pixel_index = gry_line_index + i;
-
-            unsigned int pixel[3];
-            pixel[0] = image_data[ col_pixel_index + 0 ];
-            pixel[1] = image_data[ col_pixel_index + 1 ];
-            pixel[2] = image_data[ col_pixel_index + 2 ];
-            std::sort( pixel, pixel + 3 );
-
-            data[ gry_pixel_index ] = static_cast<kvs::UInt8>(pixel[1]);
-        }
-    }
+    ::GrayScale( image, data, ::MedianValueKernel() );
 }
 
 /*===========================================================================*/
@@ -143,30 +265,7 @@ void GrayImage::NTSCWeightedMeanValue::operator () (
     const kvs::ColorImage& image,
     kvs::ValueArray<kvs::UInt8>& data )
 {
-    const size_t width = image.width();
-    const size_t height = image.height();
-    const kvs::UInt8* image_data = image.pixels().data();
-    for( size_t j = 0; j < height; j++ )
-    {
-        const size_t col_line_index = j * image.bytesPerLine();
-        const size_t gry_line_index = j * image.width();
-        for( size_t i = 0; i < width; i++ )
-        {
-            const size_t col_pixel_index = col_line_index + 3 * i;
-            const size_t gry_pixel_index = gry_line_index + i;
-
-            const unsigned int r = image_data[ col_pixel_index + 0 ];
-            const unsigned int g = image_data[ col_pixel_index + 1 ];
-            const unsigned int b = image_data[ col_pixel_index + 2 ];
-
-            /* value = ( 0.298912 * R + 0.586611 * G + 0.114478 * B )
-             *       = ( 2 * R + 4 * G + B ) / 7
-             */
-            const unsigned int value = ( 2 * r + 4 * g + b ) / 7;
-
-            data[ gry_pixel_index ] = static_cast<kvs::UInt8>(value);
-        }
-    }
+    ::GrayScale( image, data, ::NTSCWeightedMeanValueKernel() );
 }
 
 /*===========================================================================*/
@@ -174,43 +273,15 @@ void GrayImage::NTSCWeightedMeanValue::operator () (
  *  @brief  Gray-scaling by the HDTV weighted mean-value method.
  *  @param  image [in] color image
  *  @param  data [out] pixel data array
+ *
+ *  The gamma-corrected and weighted components are looked up in the tables.
  */
 /*===========================================================================*/
 void GrayImage::HDTVWeightedMeanValue::operator () (
     const kvs::ColorImage& image,
     kvs::ValueArray<kvs::UInt8>& data )
 {
-    const double gamma_value = 2.2;
-    const size_t width = image.width();
-    const size_t height = image.height();
-    const kvs::UInt8* image_data = image.pixels().data();
-    for( size_t j = 0; j < height; j++ )
-    {
-        const size_t col_line_index = j * image.bytesPerLine();
-        const size_t gry_line_index = j * image.width();
-        for( size_t i = 0; i < width; i++ )
-        {
-            const size_t col_pixel_index = col_line_index + 3 * i;
-            const size_t gry_pixel_index = gry_line_index + i;
-
-            const unsigned int r = image_data[ col_pixel_index + 0 ];
-            const unsigned int g = image_data[ col_pixel_index + 1 ];
-            const unsigned int b = image_data[ col_pixel_index + 2 ];
-
-            const double R = static_cast<double>(r) / 255.0;
-            const double G = static_cast<double>(g) / 255.0;
-            const double B = static_cast<double>(b) / 255.0;
-
-            const double RR = std::pow( R, gamma_value ) * 0.222015;
-            const double GG = std::pow( G, gamma_value ) * 0.706655;
-            const double BB = std::pow( B, gamma_value ) * 0.071330;
-
-            const double V = std::pow( ( RR + GG + BB ), ( 1.0 / gamma_value ) );
-            const unsigned int value = kvs::Math::Round( V * 255.0 );
-
-            data[ gry_pixel_index ] = static_cast<kvs::UInt8>(value);
-        }
-    }
+    ::GrayScale( image, data, ::HDTVWeightedMeanValueKernel() );
 }
 
 /*==========================================================================*/
@@ -16,7 +16,10 @@
 #include "GrayImage.h"
 #include "RGBColor.h"
 #include <kvs/Type>
+#include <kvs/Math>
+#include <kvs/Thread>
 #include <utility>
+#include <vector>
 
 
 namespace
@@ -100,6 +103,221 @@ inline size_t ByteToBit( size_t value )
     return( value << 3 );
 }
 
+
+/*===========================================================================*/
+/**
+ *  @brief  Resampling kernels.
+ */
+/*===========================================================================*/
+enum ResizeKernel
+{
+    NearestNeighborKernel,
+    BilinearKernel
+};
+
+template <typename ImageDataType>
+inline ResizeKernel KernelOf( const kvs::ImageBase::NearestNeighborInterpolator<ImageDataType>* )
+{
+    return NearestNeighborKernel;
+}
+
+template <typename ImageDataType>
+inline ResizeKernel KernelOf( const kvs::ImageBase::BilinearInterpolator<ImageDataType>* )
+{
+    return BilinearKernel;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sampling positions and weights along an axis of the image.
+ *
+ *  The positions are computed in the same way as the interpolators, so that
+ *  the resized image is identical to the one resampled pixel by pixel.
+ */
+/*===========================================================================*/
+struct AxisTable
+{
+    std::vector<size_t> index0; ///< lower source index
+    std::vector<size_t> index1; ///< upper source index
+    std::vector<double> weight0; ///< weight of the lower index (1 - rate)
+    std::vector<double> weight1; ///< weight of the upper index (rate)
+
+    AxisTable( const size_t src_size, const size_t dst_size )
+    {
+        index0.resize( dst_size );
+        index1.resize( dst_size );
+        weight0.resize( dst_size );
+        weight1.resize( dst_size );
+
+        const double ratio = src_size / static_cast<double>( dst_size );
+        for ( size_t i = 0; i < dst_size; i++ )
+        {
+            const double u = i * ratio;
+            const int lower = kvs::Math::Clamp( kvs::Math::Floor( u ), 0, static_cast<int>( src_size ) - 1 );
+            const double rate = u - static_cast<double>( lower );
+            index0[i] = static_cast<size_t>( lower );
+            index1[i] = index0[i] + ( index0[i] + 1 < src_size ? 1 : 0 );
+            weight0[i] = 1.0 - rate;
+            weight1[i] = rate;
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for resizing a range of the rows.
+ *
+ *  The bilinear interpolation is separated into the horizontal pass, which
+ *  interpolates the source rows at the destination columns, and the vertical
+ *  pass, which blends two interpolated rows. The interpolated rows are cached
+ *  since the adjacent destination rows often refer to the same source rows.
+ */
+/*===========================================================================*/
+class Resizer : public kvs::Thread
+{
+private:
+
+    ResizeKernel m_kernel; ///< resampling kernel
+    size_t m_ncomponents; ///< number of components per pixel
+    const kvs::UInt8* m_src; ///< source pixels
+    size_t m_src_width; ///< source width
+    kvs::UInt8* m_dst; ///< destination pixels
+    size_t m_dst_width; ///< destination width
+    const AxisTable* m_columns; ///< sampling table of the columns
+    const AxisTable* m_rows; ///< sampling table of the rows
+    size_t m_begin; ///< first destination row
+    size_t m_end; ///< last destination row + 1
+    std::vector<double> m_cache[2]; ///< horizontally interpolated rows
+    size_t m_cached_row[2]; ///< source rows of the cache
+
+public:
+
+    Resizer():
+        m_kernel( NearestNeighborKernel ),
+        m_ncomponents( 1 ),
+        m_src( NULL ),
+        m_src_width( 0 ),
+        m_dst( NULL ),
+        m_dst_width( 0 ),
+        m_columns( NULL ),
+        m_rows( NULL ),
+        m_begin( 0 ),
+        m_end( 0 ) {}
+
+    void setup(
+        const ResizeKernel kernel,
+        const size_t ncomponents,
+        const kvs::UInt8* src,
+        const size_t src_width,
+        kvs::UInt8* dst,
+        const size_t dst_width,
+        const AxisTable* columns,
+        const AxisTable* rows,
+        const size_t begin,
+        const size_t end )
+    {
+        m_kernel = kernel;
+        m_ncomponents = ncomponents;
+        m_src = src;
+        m_src_width = src_width;
+        m_dst = dst;
+        m_dst_width = dst_width;
+        m_columns = columns;
+        m_rows = rows;
+        m_begin = begin;
+        m_end = end;
+    }
+
+    void run()
+    {
+        if ( m_kernel == NearestNeighborKernel ) { this->resize_nearest(); }
+        else { this->resize_bilinear(); }
+    }
+
+private:
+
+    void resize_nearest()
+    {
+        const size_t nc = m_ncomponents;
+        const size_t* columns = &m_columns->index0[0];
+        for ( size_t j = m_begin; j < m_end; j++ )
+        {
+            const kvs::UInt8* src = m_src + m_rows->index0[j] * m_src_width * nc;
+            kvs::UInt8* dst = m_dst + j * m_dst_width * nc;
+            if ( nc == 1 )
+            {
+                for ( size_t i = 0; i < m_dst_width; i++ ) { dst[i] = src[ columns[i] ]; }
+            }
+            else
+            {
+                for ( size_t i = 0; i < m_dst_width; i++ )
+                {
+                    const kvs::UInt8* s = src + columns[i] * nc;
+                    for ( size_t c = 0; c < nc; c++ ) { dst[ i * nc + c ] = s[c]; }
+                }
+            }
+        }
+    }
+
+    void resize_bilinear()
+    {
+        const size_t n = m_dst_width * m_ncomponents;
+        m_cache[0].resize( n );
+        m_cache[1].resize( n );
+        m_cached_row[0] = m_cached_row[1] = static_cast<size_t>( -1 );
+
+        for ( size_t j = m_begin; j < m_end; j++ )
+        {
+            const double* d = this->interpolated_row( m_rows->index0[j] );
+            const double* e = this->interpolated_row( m_rows->index1[j] );
+            const double w0 = m_rows->weight0[j];
+            const double w1 = m_rows->weight1[j];
+            kvs::UInt8* dst = m_dst + j * n;
+            for ( size_t i = 0; i < n; i++ )
+            {
+                const int f = kvs::Math::Round( d[i] * w0 + e[i] * w1 );
+                dst[i] = static_cast<kvs::UInt8>( kvs::Math::Clamp( f, 0, 255 ) );
+            }
+        }
+    }
+
+    const double* interpolated_row( const size_t y )
+    {
+        const size_t slot = y & 1;
+        double* row = &m_cache[ slot ][0];
+        if ( m_cached_row[ slot ] == y ) { return row; }
+        m_cached_row[ slot ] = y;
+
+        const size_t nc = m_ncomponents;
+        const kvs::UInt8* src = m_src + y * m_src_width * nc;
+        const size_t* x0 = &m_columns->index0[0];
+        const size_t* x1 = &m_columns->index1[0];
+        const double* w0 = &m_columns->weight0[0];
+        const double* w1 = &m_columns->weight1[0];
+        if ( nc == 1 )
+        {
+            for ( size_t i = 0; i < m_dst_width; i++ )
+            {
+                row[i] = src[ x0[i] ] * w0[i] + src[ x1[i] ] * w1[i];
+            }
+        }
+        else
+        {
+            for ( size_t i = 0; i < m_dst_width; i++ )
+            {
+                const kvs::UInt8* s0 = src + x0[i] * nc;
+                const kvs::UInt8* s1 = src + x1[i] * nc;
+                for ( size_t c = 0; c < nc; c++ )
+                {
+                    row[ i * nc + c ] = s0[c] * w0[i] + s1[c] * w1[i];
+                }
+            }
+        }
+
+        return row;
+    }
+};
+
 } // end of namespace
 
 
@@ -332,31 +550,47 @@ bool ImageBase::create(
     return( true );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Resizes the image.
+ *  @param  width [in] resized width
+ *  @param  height [in] resized height
+ *  @param  image [in/out] pointer to the image
+ *
+ *  The sampling positions and weights of the columns are computed once, and
+ *  the rows of the resized image are divided among the threads.
+ */
+/*===========================================================================*/
 template <typename ImageDataType, typename Interpolator>
 void ImageBase::resizeImage( const size_t width, const size_t height, ImageDataType* image )
 {
     // Resized image.
     ImageDataType resized_image( width, height );
 
-    // Interpolator.
-    Interpolator interpolator;
-    interpolator.attach( image );
-
-    const double ratio_width  = m_width / static_cast<double>( width );
-    const double ratio_height = m_height / static_cast<double>( height );
-    for( size_t j = 0; j < height; j++ )
+    if ( width > 0 && height > 0 && m_width > 0 && m_height > 0 )
     {
-        const double v = j * ratio_height;
-        interpolator.setV( v );
+        const ::ResizeKernel kernel = ::KernelOf( static_cast<const Interpolator*>( NULL ) );
+        const size_t ncomponents = ::BitToByte( m_bpp );
+        const ::AxisTable columns( m_width, width );
+        const ::AxisTable rows( m_height, height );
 
-        for( size_t i = 0; i < width; i++ )
-        {
-            const double u = i * ratio_width;
-            interpolator.setU( u );
+        const size_t min_pixels_per_thread = 64 * 1024;
+        const size_t max_nthreads = kvs::Math::Max( ( width * height ) / min_pixels_per_thread, size_t( 1 ) );
+        const size_t nthreads = kvs::Math::Min( kvs::Math::Min( kvs::Thread::DefaultNumberOfThreads(), max_nthreads ), height );
 
-            typename ImageDataType::PixelType pixel = interpolator();
-            resized_image.setPixel( i, j, pixel );
+        std::vector< ::Resizer> resizers( nthreads );
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            const size_t begin = height * i / nthreads;
+            const size_t end = height * ( i + 1 ) / nthreads;
+            resizers[i].setup(
+                kernel, ncomponents,
+                m_pixels.data(), m_width,
+                resized_image.pixelData().data(), width,
+                &columns, &rows, begin, end );
         }
+
+        kvs::Thread::Run( &resizers[0], nthreads );
     }
 
     *image = resized_image;
@@ -20,64 +20,13 @@
  */
 /*****************************************************************************/
 #include "AdaptiveKMeans.h"
+#include <vector>
 #include <kvs/FastKMeans>
-#include <kvs/Matrix>
+#include <kvs/Message>
+#include <kvs/KMeansEngine>
 #include <cmath>
 
 
-namespace
-{
-
-/*===========================================================================*/
-/**
- *  @brief  Returns Mahalanobis distance.
- *  @param  x [in] multivariant vector
- *  @param  u [in] mean values
- *  @return Mahalanobis distance
- */
-/*===========================================================================*/
-kvs::Real32 GetMahalanobisDistance(
-    const kvs::ValueArray<kvs::Real32>& x,
-    const kvs::ValueArray<kvs::Real32>& u )
-{
-    const size_t dim = x.size();
-    kvs::Matrix<kvs::Real32> d( dim, 1 );
-    kvs::Matrix<kvs::Real32> dt( 1, dim );
-    for ( size_t i = 0; i < dim; i++ ) { d[i][0] = dt[0][i] = x[i] - u[i]; }
-
-    // Covariance matrix (identity matrix)
-    kvs::Matrix<kvs::Real32> S( dim, dim );
-    S.identity();
-
-    // In this function, the Mahalanobis distance reduces to the Euclidean
-    // distance since the covariance matrix is the identity matrix.
-    return ( dt * S * d )[0][0];
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns row array.
- *  @param  table [in] table data
- *  @param  row_index [in] index of the row
- *  @return row array
- */
-/*===========================================================================*/
-kvs::ValueArray<kvs::Real32> GetRowArray(
-    const kvs::AnyValueTable& table,
-    const size_t row_index )
-{
-    const size_t ncolumns = table.columnSize();
-    kvs::ValueArray<kvs::Real32> row( ncolumns );
-    for ( size_t i = 0; i < ncolumns; i++ )
-    {
-        row[i] = table.column(i).at<kvs::Real32>( row_index );
-    }
-
-    return row;
-}
-
-}
-
 namespace kvs
 {
 
@@ -91,6 +40,7 @@ AdaptiveKMeans::AdaptiveKMeans():
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
     m_max_nclusters( 10 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
 }
@@ -118,7 +68,6 @@ void AdaptiveKMeans::run()
         return;
     }
 
-    const size_t ncolumns = m_input_table.columnSize();
     const size_t nrows = m_input_table.column(0).size();
     for ( size_t i = 1; i < m_input_table.columnSize(); i++ )
     {
@@ -129,6 +78,11 @@ void AdaptiveKMeans::run()
         }
     }
 
+    // The table data is converted once for all the number of clusters.
+    kvs::KMeansEngine engine( m_input_table, m_number_of_threads );
+    const size_t ncolumns = engine.numberOfColumns();
+    std::vector<kvs::Real32> D( nrows );
+
     const size_t K = m_max_nclusters; // number of clusters
     const size_t p = ncolumns; // p-dimension
     const kvs::Real32 Y = p * 0.5f; // transformation power
@@ -146,24 +100,20 @@ void AdaptiveKMeans::run()
         kmeans.setNumberOfClusters( k );
         kmeans.setMaxIterations( m_max_iterations );
         kmeans.setTolerance( m_tolerance );
-        kmeans.setInputTableData( m_input_table );
-        kmeans.run();
+        kmeans.setNumberOfThreads( m_number_of_threads );
+        kmeans.run( engine );
 
         // Calculate the distortions (averaged Mahalanobis distance per dimension).
-        distortion[k] = 0.0f;
-        for ( size_t i = 0; i < nrows; i++ )
-        {
-            kvs::ValueArray<kvs::Real32> cx = kmeans.clusterCenter(0);
-            kvs::ValueArray<kvs::Real32> x = ::GetRowArray( m_input_table, i );
-            kvs::Real32 distance = ::GetMahalanobisDistance( x, cx );
-            for ( size_t j = 1; j < k; j++ )
-            {
-                cx = kmeans.clusterCenter(j);
-                distance = kvs::Math::Min( distance, ::GetMahalanobisDistance( x, cx ) );
-            }
-            distortion[k] += distance;
-        }
-        distortion[k] = ( 1.0f / p ) * ( ( 1.0f / nrows ) * distortion[k] );
+        // The Mahalanobis distance reduces to the squared Euclidean distance
+        // since the covariance matrix is the identity matrix.
+        std::vector< kvs::ValueArray<kvs::Real32> > cx( k );
+        for ( size_t j = 0; j < k; j++ ) { cx[j] = kmeans.clusterCenter(j); }
+        engine.setCenters( &cx[0], k );
+        engine.assign( NULL, &D[0] );
+
+        kvs::Real64 sum = 0.0;
+        for ( size_t i = 0; i < nrows; i++ ) { sum += D[i]; }
+        distortion[k] = ( 1.0f / p ) * static_cast<kvs::Real32>( sum / nrows );
 
         // Calculate jump in transformed distortion.
         kvs::Real32 Jk = std::pow( distortion[k], -Y ) - std::pow( distortion[k-1], -Y );
@@ -186,6 +136,7 @@ void AdaptiveKMeans::run()
 
     m_nclusters = nclusters;
     m_cluster_ids = IDs;
+    if ( m_cluster_centers ) delete [] m_cluster_centers;
     m_cluster_centers = centers;
     m_distortions = distortion;
 }
@@ -22,9 +22,12 @@
  */
 /*****************************************************************************/
 #include "FastKMeans.h"
+#include <vector>
+#include <cmath>
 #include <kvs/Value>
 #include <kvs/Message>
 #include <kvs/Math>
+#include <kvs/Thread>
 
 
 namespace
@@ -50,86 +53,69 @@ kvs::Real32 GetEuclideanDistance(
         distance += diff * diff;
     }
 
-    return distance;
+    return std::sqrt( distance );
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initializes cluster centers with random seeding.
- *  @param  table [in] table data
+ *  @param  engine [in] distance computation engine
  *  @param  nclusters [in] number of clusters
  *  @param  random [in] random number generator
  *  @param  center [out] cluster centers
  */
 /*===========================================================================*/
 void InitializeCenterWithRandomSeeding(
-    const kvs::AnyValueTable& table,
+    const kvs::KMeansEngine& engine,
     const size_t nclusters,
     kvs::MersenneTwister& random,
     kvs::ValueArray<kvs::Real32>* center )
 {
-    const size_t nrows = table.column(0).size();
+    const size_t nrows = engine.numberOfRows();
     for ( size_t i = 0; i < nclusters; i++ )
     {
         const kvs::UInt32 index = nrows * random.rand();
-        center[i] = table.rowAsValueArray<kvs::Real32>( index );
+        center[i] = engine.row( index );
     }
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initializes cluster centers with smart seeding.
- *  @param  table [in] table data
+ *  @param  engine [in/out] distance computation engine
  *  @param  nclusters [in] number of clusters
  *  @param  random [in] random number generator
  *  @param  center [out] cluster centers
  */
 /*===========================================================================*/
 void InitializeCenterWithSmartSeeding(
-    const kvs::AnyValueTable& table,
+    kvs::KMeansEngine& engine,
     const size_t nclusters,
     kvs::MersenneTwister& random,
     kvs::ValueArray<kvs::Real32>* center )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
+    const size_t nrows = engine.numberOfRows();
     const kvs::UInt32 index = nrows * random.rand();
-    center[0] = table.rowAsValueArray<kvs::Real32>( index );
+    center[0] = engine.row( index );
 
+    std::vector<kvs::Real32> D( nrows );
     for ( size_t i = 1; i < nclusters; i++ )
     {
-        kvs::Real32 S = 0.0;
-        kvs::Real32* D = new kvs::Real32 [ nrows ];
-        for ( size_t j = 0; j < nrows; j++ )
-        {
-            kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
-            for ( size_t k = 0; k < nclusters; k++ )
-            {
-                const kvs::Real32 d = GetEuclideanDistance( table.rowAsValueArray<kvs::Real32>(j), center[k] );
-                if ( d < distance ) { distance = d; }
-            }
-            D[j] = distance;
-            S += distance * distance;
-        }
+        engine.setCenters( center, i );
+        engine.assign( NULL, &D[0] );
 
         size_t index = 0;
-        kvs::Real32 P = 0.0;
+        kvs::Real32 P = 0.0f;
         for ( size_t j = 0; j < nrows; j++ )
         {
-            const kvs::Real32 DD = D[j] * D[j];
-            if ( P < kvs::Math::Max( P, DD / S ) )
+            if ( D[j] > P )
             {
-                P = DD / S;
+                P = D[j];
                 index = j;
             }
         }
 
-        for ( size_t j = 0; j < ncolumns; j++ )
-        {
-            center[i].at(j) = table.column(j).at<kvs::Real32>( index );
-        }
-
-        delete [] D;
+        center[i] = engine.row( index );
     }
 }
 
@@ -140,108 +126,142 @@ namespace
 
 /*===========================================================================*/
 /**
- *  @brief  Updates upper and lower bounds and index of the center over all centers.
- *  @param  nclusters [in] number of clusters
- *  @param  xi [in] data point at i-th row in the table data
- *  @param  c [in] set of centers
- *  @param  ai [out] index of the centers for xi
- *  @param  ui [out] upper bound for xi
- *  @param  li [out] lower bound for xi
+ *  @brief  Thread class for the bound tests and the reassignments of the rows.
  */
 /*===========================================================================*/
-void PointAllCtrs(
-    const size_t nclusters,
-    const kvs::ValueArray<kvs::Real32>& xi,
-    const kvs::ValueArray<kvs::Real32>* c,
-    kvs::UInt32& ai,
-    kvs::Real32& ui,
-    kvs::Real32& li )
+class BoundTester : public kvs::Thread
 {
-    // Algorithm 3: POINT-ALL-CTRS( x(i), c, a(i), u(i), l(i) )
+private:
+
+    const kvs::KMeansEngine* m_engine; ///< distance computation engine
+    const kvs::Real32* m_s; ///< distances from the centers to their closest other centers
+    size_t m_begin; ///< index of the first row
+    size_t m_end; ///< index of the last row + 1
+    bool m_all; ///< true if the bound tests are skipped (initialization)
+    kvs::UInt32* m_a; ///< indices of the centers
+    kvs::Real32* m_u; ///< upper bounds
+    kvs::Real32* m_l; ///< lower bounds
+
+public:
+
+    BoundTester():
+        m_engine( NULL ),
+        m_s( NULL ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_all( false ),
+        m_a( NULL ),
+        m_u( NULL ),
+        m_l( NULL ) {}
+
+    void setup(
+        const kvs::KMeansEngine* engine,
+        const kvs::Real32* s,
+        const size_t begin,
+        const size_t end,
+        const bool all,
+        kvs::UInt32* a,
+        kvs::Real32* u,
+        kvs::Real32* l )
+    {
+        m_engine = engine;
+        m_s = s;
+        m_begin = begin;
+        m_end = end;
+        m_all = all;
+        m_a = a;
+        m_u = u;
+        m_l = l;
+    }
 
-    kvs::UInt32 index = 0;
-    kvs::Real32 dmin = kvs::Value<kvs::Real32>::Max();
-    for ( size_t j = 0; j < nclusters; j++ )
+    void run()
     {
-        const kvs::Real32 d = ::GetEuclideanDistance( xi, c[j] );
-        if ( d < dmin )
+        for ( size_t i = m_begin; i < m_end; i++ )
         {
-            dmin = d;
-            index = static_cast<kvs::UInt32>(j);
+            if ( !m_all )
+            {
+                const kvs::Real32 m = kvs::Math::Max( m_s[ m_a[i] ] * 0.5f, m_l[i] );
+                if ( !( m_u[i] > m ) ) continue; // First bound test.
+
+                // Tighten upper bound.
+                m_u[i] = std::sqrt( m_engine->distance( i, m_a[i] ) );
+                if ( !( m_u[i] > m ) ) continue; // Second bound test.
+            }
+
+            // Algorithm 3: POINT-ALL-CTRS( x(i), c, a(i), u(i), l(i) )
+            kvs::Real32 d1 = 0.0f;
+            kvs::Real32 d2 = 0.0f;
+            m_engine->nearestCenters( i, &m_a[i], &d1, &d2 );
+            m_u[i] = std::sqrt( d1 );
+            m_l[i] = std::sqrt( d2 );
         }
     }
-    ai = index;
+};
 
-    ui = ::GetEuclideanDistance( xi, c[ai] );
-
-    dmin = kvs::Value<kvs::Real32>::Max();
-    for ( size_t j = 0; j < nclusters; j++ )
+/*===========================================================================*/
+/**
+ *  @brief  Updates the assignments and the bounds of all the rows.
+ *  @param  engine [in] distance computation engine with the current centers
+ *  @param  s [in] distances from the centers to their closest other centers
+ *  @param  all [in] true if all the rows are assigned without the bound tests
+ *  @param  a [in/out] array of index of the center
+ *  @param  u [in/out] upper bound
+ *  @param  l [in/out] lower bound
+ */
+/*===========================================================================*/
+void AssignPoints(
+    const kvs::KMeansEngine& engine,
+    const kvs::ValueArray<kvs::Real32>& s,
+    const bool all,
+    kvs::ValueArray<kvs::UInt32>& a,
+    kvs::ValueArray<kvs::Real32>& u,
+    kvs::ValueArray<kvs::Real32>& l )
+{
+    const size_t nrows = engine.numberOfRows();
+    const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( engine.numberOfThreads(), nrows / 1024 ) );
+    std::vector< ::BoundTester> testers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
     {
-        if ( j != ai )
-        {
-            const kvs::Real32 d = ::GetEuclideanDistance( xi, c[j] );
-            dmin = kvs::Math::Min( dmin, d );
-        }
+        const size_t begin = nrows * i / nthreads;
+        const size_t end = nrows * ( i + 1 ) / nthreads;
+        testers[i].setup( &engine, s.data(), begin, end, all, a.data(), u.data(), l.data() );
     }
-    li = dmin;
+
+    kvs::Thread::Run( &testers[0], nthreads );
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Initializes the upper and lower bounds and the assignments.
- *  @param  nclusters [in] number of clusters
- *  @param  table [in] table data
- *  @param  c [in] set of cluster centers
+ *  @brief  Calculates the vector sums and the numbers of points of the clusters.
+ *  @param  engine [in] distance computation engine
+ *  @param  a [in] array of index of the center
  *  @param  q [out] number of points
  *  @param  cp [out] vector sum of all points
- *  @param  u [out] upper bound
- *  @param  l [out] lower bound
- *  @param  a [out] index of the center
  */
 /*===========================================================================*/
-void Initialize(
-    const size_t nclusters,
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::Real32>* c,
+void SumPoints(
+    const kvs::KMeansEngine& engine,
+    const kvs::ValueArray<kvs::UInt32>& a,
     kvs::ValueArray<kvs::UInt32>& q,
-    kvs::ValueArray<kvs::Real32>* cp,
-    kvs::ValueArray<kvs::Real32>& u,
-    kvs::ValueArray<kvs::Real32>& l,
-    kvs::ValueArray<kvs::UInt32>& a )
+    kvs::ValueArray<kvs::Real64>& cp )
 {
-    // Algorithm 2: INITIALIZE( c, x, q, c', u, l, a )
-
-    for ( size_t j = 0; j < nclusters; j++ )
-    {
-        q[j] = 0;
-        cp[j].fill( 0x00 );
-    }
-
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-    for ( size_t i = 0; i < nrows; i++ )
-    {
-        const kvs::ValueArray<kvs::Real32> xi = table.rowAsValueArray<kvs::Real32>(i);
-        PointAllCtrs( nclusters, xi, c, a[i], u[i], l[i] );
-        q[a[i]] += 1;
-        for ( size_t k = 0; k < ncolumns; k++ )
-        {
-            cp[a[i]][k] += xi[k];
-        }
-    }
+    const size_t nclusters = q.size();
+    std::vector<size_t> counts( nclusters );
+    engine.sum( a.data(), nclusters, cp.data(), &counts[0] );
+    for ( size_t j = 0; j < nclusters; j++ ) { q[j] = static_cast<kvs::UInt32>( counts[j] ); }
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Updates the center locations.
- *  @param  cp [in] set of the vector sum of all points
+ *  @param  cp [in] vector sum of all points (nclusters x ncolumns)
  *  @param  q [in] array of the number of points
  *  @param  c [out] updated cluster centers
  *  @param  p [out] array of the distance that the cluster center moved
  */
 /*===========================================================================*/
 void MoveCenters(
-    const kvs::ValueArray<kvs::Real32>* cp,
+    const kvs::ValueArray<kvs::Real64>& cp,
     const kvs::ValueArray<kvs::UInt32>& q,
     kvs::ValueArray<kvs::Real32>* c,
     kvs::ValueArray<kvs::Real32>& p )
@@ -251,13 +271,16 @@ void MoveCenters(
     const size_t nclusters = q.size();
     for ( size_t j = 0; j < nclusters; j++ )
     {
+        // The center of the empty cluster is not moved.
+        if ( q[j] == 0 ) { p[j] = 0.0f; continue; }
+
         kvs::ValueArray<kvs::Real32> cs = c[j].clone();
 
-        const size_t nrows = cp[j].size();
-        const kvs::Real32 qj = static_cast<kvs::Real32>( q[j] );
-        for ( size_t k = 0; k < nrows; k++ )
+        const size_t ncolumns = c[j].size();
+        const kvs::Real64 qj = static_cast<kvs::Real64>( q[j] );
+        for ( size_t k = 0; k < ncolumns; k++ )
         {
-            c[j][k] = cp[j][k] / qj;
+            c[j][k] = static_cast<kvs::Real32>( cp[ j * ncolumns + k ] / qj );
         }
         p[j] = ::GetEuclideanDistance( cs, c[j] );
     }
@@ -280,10 +303,10 @@ void UpdateBounds(
 {
     // Algorithm 5: UPDATE-BOUNDS( p, a, u, l )
 
-    kvs::Real32 r = 0.0f;
-    kvs::Real32 rp = 0.0f;
+    size_t r = 0;
+    size_t rp = 0;
 
-    kvs::Real32 pmax = kvs::Value<kvs::Real32>::Min();
+    kvs::Real32 pmax = -1.0f;
     const size_t nclusters = p.size();
     for ( size_t j = 0; j < nclusters; j++ )
     {
@@ -294,7 +317,7 @@ void UpdateBounds(
         }
     }
 
-    pmax = kvs::Value<kvs::Real32>::Min();
+    pmax = -1.0f;
     for ( size_t j = 0; j < nclusters; j++ )
     {
         if ( j != r )
@@ -315,60 +338,6 @@ void UpdateBounds(
     }
 }
 
-/*===========================================================================*/
-/**
- *  @brief  Updates the number of points specified by the given index.
- *  @param  m [in] index of the center
- *  @param  a [in] array of index of the center
- *  @param  q [in/out] updated the array of the number of points
- */
-/*===========================================================================*/
-void Update(
-    const size_t m,
-    const kvs::ValueArray<kvs::UInt32>& a,
-    kvs::ValueArray<kvs::UInt32>& q )
-{
-    size_t counter = 0;
-    const size_t nrows = a.size();
-    for ( size_t i = 0; i < nrows; i++ )
-    {
-        if ( a[i] == m ) counter++;
-    }
-
-    q[m] = counter;
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Updates the vector sum of all points specified by the given index.
- *  @param  m [in] index of the center
- *  @param  table [in] table data
- *  @param  a [in] array of index of the center
- *  @param  cp [out] set of the vector sum of all points
- */
-/*===========================================================================*/
-void Update(
-    const size_t m,
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::UInt32>& a,
-    kvs::ValueArray<kvs::Real32>* cp )
-{
-    const size_t nrows = a.size();
-    const size_t ncolumns = table.columnSize();
-
-    cp[m].fill( 0x00 );
-    for ( size_t i = 0; i < nrows; i++ )
-    {
-        if ( a[i] == m )
-        {
-            for ( size_t k = 0; k < ncolumns; k++ )
-            {
-                cp[m][k] += table.column(k).at<kvs::Real32>(i);
-            }
-        }
-    }
-}
-
 }
 
 
@@ -385,6 +354,7 @@ FastKMeans::FastKMeans():
     m_nclusters( 10 ),
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
 }
@@ -412,7 +382,6 @@ void FastKMeans::run()
         return;
     }
 
-    const size_t ncolumns = m_input_table.columnSize();
     const size_t nrows = m_input_table.column(0).size();
     for ( size_t i = 1; i < m_input_table.columnSize(); i++ )
     {
@@ -423,6 +392,31 @@ void FastKMeans::run()
         }
     }
 
+    this->run( kvs::KMeansEngine( m_input_table, m_number_of_threads ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Executes Hamerly's k-means clustering for the converted table data.
+ *  @param  engine [in] distance computation engine for the table data
+ *
+ *  The engine can be shared by the several runs for the same table data, for
+ *  example with the different number of clusters.
+ */
+/*===========================================================================*/
+void FastKMeans::run( const kvs::KMeansEngine& engine )
+{
+    const size_t nrows = engine.numberOfRows();
+    const size_t ncolumns = engine.numberOfColumns();
+    if ( nrows == 0 )
+    {
+        kvsMessageError("Input table data is not assigned.");
+        return;
+    }
+
+    // The centers of the engine are replaced in the clustering.
+    kvs::KMeansEngine e( engine );
+
     // Parameters that relate to cluster centers.
     /*   c:  cluster center
      *   cp: vector sum of all points in the cluster
@@ -431,7 +425,7 @@ void FastKMeans::run()
      *   s:  distance from c to its closest other center
      */
     kvs::ValueArray<kvs::Real32>* c = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
-    kvs::ValueArray<kvs::Real32>* cp = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
+    kvs::ValueArray<kvs::Real64> cp( m_nclusters * ncolumns );
     kvs::ValueArray<kvs::UInt32> q( m_nclusters );
     kvs::ValueArray<kvs::Real32> p( m_nclusters );
     kvs::ValueArray<kvs::Real32> s( m_nclusters );
@@ -439,7 +433,6 @@ void FastKMeans::run()
     for ( size_t j = 0; j < m_nclusters; j++ )
     {
         c[j].allocate( ncolumns );
-        cp[j].allocate( ncolumns );
     }
 
     // Parameters that relate to data points.
@@ -458,21 +451,21 @@ void FastKMeans::run()
     switch ( m_seeding_method )
     {
     case RandomSeeding:
-        ::InitializeCenterWithRandomSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithRandomSeeding( e, m_nclusters, m_random, c );
         break;
     case SmartSeeding:
-        ::InitializeCenterWithSmartSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithSmartSeeding( e, m_nclusters, m_random, c );
         break;
     default:
-        ::InitializeCenterWithRandomSeeding( m_input_table, m_nclusters, m_random, c );
+        ::InitializeCenterWithRandomSeeding( e, m_nclusters, m_random, c );
         break;
     }
 
     // Initialize.
-    ::Initialize( m_nclusters, m_input_table, c, q, cp, u, l, a );
-
-    // Cluster IDs.
-    kvs::ValueArray<kvs::UInt32> IDs;
+    // Algorithm 2: INITIALIZE( c, x, q, c', u, l, a )
+    e.setCenters( c, m_nclusters );
+    ::AssignPoints( e, s, true, a, u, l );
+    ::SumPoints( e, a, q, cp );
 
     // Clustering.
     bool converged = false;
@@ -494,40 +487,20 @@ void FastKMeans::run()
             s[j] = dmin;
         }
 
-        for ( size_t i = 0; i < nrows; i++ )
-        {
-            const kvs::Real32 m = kvs::Math::Max( s[a[i]] * 0.5f, l[i] );
-            if ( u[i] > m ) // First bound test.
-            {
-                // Tighten upper bound.
-                const kvs::ValueArray<kvs::Real32> xi = m_input_table.rowAsValueArray<kvs::Real32>(i);
-                u[i] = ::GetEuclideanDistance( xi, c[a[i]] );
-                if ( u[i] > m ) // Second bound test.
-                {
-                    const kvs::UInt32 ap = a[i];
-                    ::PointAllCtrs( m_nclusters, xi, c, a[i], u[i], l[i] );
-                    if ( ap != a[i] )
-                    {
-                        ::Update( ap, a, q );
-                        ::Update( a[i], a, q );
-                        ::Update( ap, m_input_table, a, cp );
-                        ::Update( a[i], m_input_table, a, cp );
-                    }
-                }
-            }
-        }
+        // Reassign the points that fail the bound tests, and recalculate the
+        // vector sums and the numbers of points of the clusters.
+        e.setCenters( c, m_nclusters );
+        ::AssignPoints( e, s, false, a, u, l );
+        ::SumPoints( e, a, q, cp );
 
         ::MoveCenters( cp, q, c, p );
         ::UpdateBounds( p, a, u, l );
 
-        // Update cluster IDs.
-        IDs = a;
-
-        // Convergence test.
+        // Convergence test (squared moving distance).
         converged = true;
         for ( size_t j = 0; j < m_nclusters; j++ )
         {
-            if ( !( p[j] < m_tolerance ) ) { converged = false; break; }
+            if ( !( p[j] * p[j] < m_tolerance ) ) { converged = false; break; }
         }
 
         if ( counter++ > m_max_iterations ) break;
@@ -536,9 +509,7 @@ void FastKMeans::run()
     if ( m_cluster_centers ) delete [] m_cluster_centers;
     m_cluster_centers = c;
 
-    delete [] cp;
-
-    m_cluster_ids = IDs;
+    m_cluster_ids = a;
 }
 
 } // end of namespace kvs
@@ -20,162 +20,96 @@
  */
 /*****************************************************************************/
 #include "KMeans.h"
+#include <vector>
 #include <kvs/Value>
 #include <kvs/Message>
 #include <kvs/Math>
+#include <kvs/KMeansEngine>
 
 
-namespace
-{
-
-kvs::Real32 GetEuclideanDistance(
-    const kvs::AnyValueTable& table,
-    const kvs::UInt32 row_index,
-    const kvs::ValueArray<kvs::Real32>& center )
-{
-    kvs::Real32 distance = 0.0;
-    for ( size_t i = 0; i < table.columnSize(); i++ )
-    {
-        const kvs::Real32 x0 = center[i];
-        const kvs::Real32 x1 = table.column(i).at<kvs::Real32>( row_index );
-        distance += ( x1 - x0 ) * ( x1 - x0 );
-    }
-
-    return distance;
-}
-
-kvs::Real32 GetEuclideanDistance(
-    const kvs::AnyValueTable& table,
-    const kvs::ValueArray<kvs::Real32>& center_old,
-    const kvs::ValueArray<kvs::Real32>& center_new )
-{
-    kvs::Real32 distance = 0.0;
-    for ( size_t i = 0; i < table.columnSize(); i++ )
-    {
-        const kvs::Real32 x0 = center_old[i];
-        const kvs::Real32 x1 = center_new[i];
-        distance += ( x1 - x0 ) * ( x1 - x0 );
-    }
-
-    return distance;
-}
-}
-
 namespace
 {
 
 /*===========================================================================*/
 /**
- *  @brief  Calculates the cluster centroid.
- *  @param  table [in] table data
- *  @param  cluster_id [in] target cluster ID
- *  @param  ids [in] cluster ID array
- *  @param  center [out] cluster centroid
+ *  @brief  Returns the squared distance between the given points.
+ *  @param  x0 [in] point 0
+ *  @param  x1 [in] point 1
+ *  @return squared distance
  */
 /*===========================================================================*/
-void CalculateCenter(
-    const kvs::AnyValueTable& table,
-    const kvs::UInt32 cluster_id,
-    const kvs::ValueArray<kvs::UInt32>& ids,
-    kvs::ValueArray<kvs::Real32>* center )
+kvs::Real32 GetEuclideanDistance(
+    const kvs::ValueArray<kvs::Real32>& x0,
+    const kvs::ValueArray<kvs::Real32>& x1 )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
-
-    for ( size_t j = 0; j < ncolumns; j++ ) { center->at(j) = 0.0; }
-
-    size_t counter = 0;
-    for ( size_t j = 0; j < nrows; j++ )
+    kvs::Real32 distance = 0.0f;
+    const size_t n = x0.size();
+    for ( size_t i = 0; i < n; i++ )
     {
-        if ( ids[j] == cluster_id )
-        {
-            for ( size_t k = 0; k < ncolumns; k++ )
-            {
-                center->at(k) += table.column(k).at<kvs::Real32>(j);
-            }
-            counter++;
-        }
-    }
-    if ( counter != 0 )
-    {
-        for ( size_t k = 0; k < ncolumns; k++ ) { center->at(k) /= counter; }
+        const kvs::Real32 diff = x1[i] - x0[i];
+        distance += diff * diff;
     }
+
+    return distance;
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initialize centers of clusters with random seeding method.
- *  @param  table [in] pointer to table
+ *  @param  engine [in] distance computation engine
  *  @param  nclusters [in] number of clusters
- *  @param  ids [i]
+ *  @param  ids [in] initial cluster IDs
  *  @param  centers [in/out] pointer to center array
  */
 /*===========================================================================*/
 void InitializeCentersWithRandomSeeding(
-    const kvs::AnyValueTable& table,
+    const kvs::KMeansEngine& engine,
     const size_t nclusters,
     const kvs::ValueArray<kvs::UInt32>& ids,
     kvs::ValueArray<kvs::Real32>* centers )
 {
-    for ( size_t i = 0; i < nclusters; i++ )
-    {
-        CalculateCenter( table, i, ids, &centers[i] );
-    }
+    engine.calculateCenters( ids.data(), nclusters, centers );
 }
 
 /*===========================================================================*/
 /**
  *  @brief  Initialize centers of clusters with k-means++.
- *  @param  table [in] table data
+ *  @param  engine [in/out] distance computation engine
  *  @param  nclusters [in] number of clusters
- *  @param  ids [i]
+ *  @param  ids [in] initial cluster IDs
  *  @param  centers [in/out] pointer to center array
+ *
+ *  The next center is the row farthest from the centers selected so far.
  */
 /*===========================================================================*/
 void InitializeCentersWithSmartSeeding(
-    const kvs::AnyValueTable& table,
+    kvs::KMeansEngine& engine,
     const size_t nclusters,
     const kvs::ValueArray<kvs::UInt32>& ids,
     kvs::ValueArray<kvs::Real32>* centers )
 {
-    const size_t nrows = table.column(0).size();
-    const size_t ncolumns = table.columnSize();
+    const size_t nrows = engine.numberOfRows();
 
-    CalculateCenter( table, 0, ids, &(centers[0]) );
+    engine.calculateCenters( ids.data(), nclusters, centers );
 
+    std::vector<kvs::Real32> D( nrows );
     for ( size_t i = 1; i < nclusters; i++ )
     {
-        kvs::Real32 S = 0.0;
-        kvs::Real32* D = new kvs::Real32 [ nrows ];
-        for ( size_t j = 0; j < nrows; j++ )
-        {
-            kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
-            for ( size_t k = 0; k < nclusters; k++ )
-            {
-                const kvs::Real32 d = ::GetEuclideanDistance( table, j, centers[k] );
-                if ( d < distance ) { distance = d; }
-            }
-            D[j] = distance;
-            S += distance * distance;
-        }
+        engine.setCenters( centers, i );
+        engine.assign( NULL, &D[0] );
 
         size_t index = 0;
-        kvs::Real32 P = 0.0;
+        kvs::Real32 P = 0.0f;
         for ( size_t j = 0; j < nrows; j++ )
         {
-            const kvs::Real32 DD = D[j] * D[j];
-            if ( P < kvs::Math::Max( P, DD / S ) )
+            if ( D[j] > P )
             {
-                P = DD / S;
+                P = D[j];
                 index = j;
             }
         }
 
-        for ( size_t j = 0; j < ncolumns; j++ )
-        {
-            centers[i].at(j) = table.column(j).at<kvs::Real32>(index);
-        }
-        delete [] D;
+        centers[i] = engine.row( index );
     }
 }
 
@@ -195,6 +129,7 @@ KMeans::KMeans():
     m_nclusters( 1 ),
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
 }
@@ -233,7 +168,11 @@ void KMeans::run()
         }
     }
 
+    // Convert the table data for the distance computation.
+    kvs::KMeansEngine engine( m_input_table, m_number_of_threads );
+
     // Allocate memory for the cluster center.
+    if ( m_cluster_centers ) delete [] m_cluster_centers;
     m_cluster_centers = new kvs::ValueArray<kvs::Real32> [ m_nclusters ];
     for ( size_t i = 0; i < m_nclusters; i++ ) { m_cluster_centers[i].allocate( ncolumns ); }
 
@@ -245,18 +184,18 @@ void KMeans::run()
     switch ( m_seeding_method )
     {
     case RandomSeeding:
-        ::InitializeCentersWithRandomSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::InitializeCentersWithRandomSeeding( engine, m_nclusters, IDs, m_cluster_centers );
         break;
     case SmartSeeding:
-        ::InitializeCentersWithSmartSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::InitializeCentersWithSmartSeeding( engine, m_nclusters, IDs, m_cluster_centers );
         break;
     default:
-        ::InitializeCentersWithRandomSeeding( m_input_table, m_nclusters, IDs, m_cluster_centers );
+        ::InitializeCentersWithRandomSeeding( engine, m_nclusters, IDs, m_cluster_centers );
         break;
     }
 
-    // Cluster center used for convergence test.
-    kvs::ValueArray<kvs::Real32> center_new( ncolumns );
+    // Cluster centers used for convergence test.
+    std::vector< kvs::ValueArray<kvs::Real32> > centers_new( m_nclusters );
 
     // Clustering.
     bool converged = false;
@@ -264,25 +203,15 @@ void KMeans::run()
     while ( !converged )
     {
         // Calculate euclidean distance between the center of cluster and the point, and update the IDs.
-        for ( size_t i = 0; i < nrows; i++ )
-        {
-            size_t id = 0;
-            kvs::Real32 distance = kvs::Value<kvs::Real32>::Max();
-            for ( size_t j = 0; j < m_nclusters; j++ )
-            {
-                const kvs::Real32 d = ::GetEuclideanDistance( m_input_table, i, m_cluster_centers[j] );
-                if ( d < distance ) { distance = d; id = j; }
-            }
-            IDs[i] = id;
-        }
+        engine.setCenters( m_cluster_centers, m_nclusters );
+        engine.assign( IDs.data(), NULL );
 
         // Convergence test.
+        engine.calculateCenters( IDs.data(), m_nclusters, &centers_new[0] );
         converged = true;
         for ( size_t i = 0; i < m_nclusters; i++ )
         {
-            ::CalculateCenter( m_input_table, i, IDs, &center_new );
-
-            const kvs::Real32 distance = ::GetEuclideanDistance( m_input_table, m_cluster_centers[i], center_new );
+            const kvs::Real32 distance = ::GetEuclideanDistance( m_cluster_centers[i], centers_new[i] );
             if ( !( distance < m_tolerance ) )
             {
                 converged = false;
@@ -292,12 +221,12 @@ void KMeans::run()
 
         if ( counter++ > m_max_iterations ) break;
 
-        // Calculate the center of cluster.
+        // Update the center of cluster.
         if ( !converged )
         {
             for ( size_t i = 0; i < m_nclusters; i++ )
             {
-                ::CalculateCenter( m_input_table, i, IDs, &(m_cluster_centers[i]) );
+                m_cluster_centers[i] = centers_new[i].clone();
             }
         }
 
@@ -52,6 +52,7 @@ private:
     size_t m_nclusters; ///< number of clusters
     size_t m_max_iterations; ///< maximum number of interations
     float m_tolerance; ///< tolerance of distance
+    size_t m_number_of_threads; ///< number of threads (0: number of processors)
     kvs::AnyValueTable m_input_table; ///< input table data
     kvs::ValueArray<kvs::UInt32> m_cluster_ids; ///< cluster IDs
     kvs::ValueArray<kvs::Real32>* m_cluster_centers; ///< cluster centers
@@ -66,12 +67,14 @@ public:
     void setNumberOfClusters( const size_t nclusters ) { m_nclusters = nclusters; }
     void setMaxIterations( const size_t max_iterations ) { m_max_iterations = max_iterations; }
     void setTolerance( const float tolerance ) { m_tolerance = tolerance; }
+    void setNumberOfThreads( const size_t nthreads ) { m_number_of_threads = nthreads; }
     void setInputTableData( const kvs::AnyValueTable& table ) { m_input_table = table; }
 
     SeedingMethod seedingMethod() const { return m_seeding_method; }
     size_t numberOfClusters() const { return m_nclusters; }
     size_t maxIterations() const { return m_max_iterations; }
     float tolerance() const { return m_tolerance; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
 
     void run();
     const kvs::ValueArray<kvs::UInt32>& clusterIDs() const { return m_cluster_ids; }
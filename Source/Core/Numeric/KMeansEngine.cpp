@@ -0,0 +1,545 @@
+/*****************************************************************************/
+/**
+ *  @file   KMeansEngine.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include "KMeansEngine.h"
+#include <vector>
+#include <algorithm>
+#include <kvs/Value>
+#include <kvs/Math>
+#include <kvs/Thread>
+
+
+namespace
+{
+
+const size_t BlockSize = kvs::KMeansEngine::BlockSize;
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of threads for the items.
+ *  @param  nthreads [in] specified number of threads
+ *  @param  nitems [in] number of items processed by the threads
+ *  @param  min_items [in] min. number of items per thread
+ *  @return number of threads
+ */
+/*===========================================================================*/
+size_t NumberOfThreads( const size_t nthreads, const size_t nitems, const size_t min_items )
+{
+    return kvs::Math::Max( size_t(1), kvs::Math::Min( nthreads, nitems / min_items ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for converting the columns into the blocked buffer.
+ */
+/*===========================================================================*/
+class TableConverter : public kvs::Thread
+{
+private:
+
+    const kvs::AnyValueTable* m_table; ///< input table
+    size_t m_nrows; ///< number of rows
+    size_t m_begin; ///< index of the first block
+    size_t m_end; ///< index of the last block + 1
+    kvs::Real32* m_data; ///< column-blocked buffer
+
+public:
+
+    TableConverter(): m_table( NULL ), m_nrows( 0 ), m_begin( 0 ), m_end( 0 ), m_data( NULL ) {}
+
+    void setup(
+        const kvs::AnyValueTable* table,
+        const size_t nrows,
+        const size_t begin,
+        const size_t end,
+        kvs::Real32* data )
+    {
+        m_table = table;
+        m_nrows = nrows;
+        m_begin = begin;
+        m_end = end;
+        m_data = data;
+    }
+
+    void run()
+    {
+        const size_t ncolumns = m_table->columnSize();
+        const size_t nblocks_per_chunk = 256;
+        std::vector<kvs::Real32> buffer( nblocks_per_chunk * ::BlockSize, 0.0f );
+        for ( size_t b0 = m_begin; b0 < m_end; b0 += nblocks_per_chunk )
+        {
+            const size_t b1 = kvs::Math::Min( b0 + nblocks_per_chunk, m_end );
+            const size_t row0 = b0 * ::BlockSize;
+            const size_t row1 = kvs::Math::Min( b1 * ::BlockSize, m_nrows );
+            for ( size_t c = 0; c < ncolumns; c++ )
+            {
+                // The type of the column is dispatched once for the chunk.
+                std::fill( buffer.begin(), buffer.end(), 0.0f );
+                ( *m_table )[c].copyTo( &buffer[0], row0, row1 - row0 );
+                for ( size_t b = b0; b < b1; b++ )
+                {
+                    const kvs::Real32* src = &buffer[0] + ( b - b0 ) * ::BlockSize;
+                    kvs::Real32* dst = m_data + ( b * ncolumns + c ) * ::BlockSize;
+                    for ( size_t r = 0; r < ::BlockSize; r++ ) { dst[r] = src[r]; }
+                }
+            }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for assigning the rows to the nearest centers.
+ */
+/*===========================================================================*/
+class RowAssigner : public kvs::Thread
+{
+private:
+
+    const kvs::Real32* m_data; ///< column-blocked table data
+    const kvs::Real32* m_centers; ///< transposed centers
+    size_t m_nrows; ///< number of rows
+    size_t m_ncolumns; ///< number of columns
+    size_t m_ncenters; ///< number of centers
+    size_t m_stride; ///< stride of the transposed centers
+    size_t m_begin; ///< index of the first block
+    size_t m_end; ///< index of the last block + 1
+    kvs::UInt32* m_ids; ///< indices of the nearest centers (can be NULL)
+    kvs::Real32* m_distances; ///< squared distances to the nearest centers (can be NULL)
+
+public:
+
+    RowAssigner():
+        m_data( NULL ),
+        m_centers( NULL ),
+        m_nrows( 0 ),
+        m_ncolumns( 0 ),
+        m_ncenters( 0 ),
+        m_stride( 0 ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_ids( NULL ),
+        m_distances( NULL ) {}
+
+    void setup(
+        const kvs::Real32* data,
+        const kvs::Real32* centers,
+        const size_t nrows,
+        const size_t ncolumns,
+        const size_t ncenters,
+        const size_t stride,
+        const size_t begin,
+        const size_t end,
+        kvs::UInt32* ids,
+        kvs::Real32* distances )
+    {
+        m_data = data;
+        m_centers = centers;
+        m_nrows = nrows;
+        m_ncolumns = ncolumns;
+        m_ncenters = ncenters;
+        m_stride = stride;
+        m_begin = begin;
+        m_end = end;
+        m_ids = ids;
+        m_distances = distances;
+    }
+
+    void run()
+    {
+        kvs::Real32 dmin[ ::BlockSize ];
+        kvs::UInt32 index[ ::BlockSize ];
+        kvs::Real32 d[ ::BlockSize ];
+        for ( size_t b = m_begin; b < m_end; b++ )
+        {
+            for ( size_t r = 0; r < ::BlockSize; r++ )
+            {
+                dmin[r] = kvs::Value<kvs::Real32>::Max();
+                index[r] = 0;
+            }
+
+            const kvs::Real32* block = m_data + b * m_ncolumns * ::BlockSize;
+            for ( size_t j = 0; j < m_ncenters; j++ )
+            {
+                for ( size_t r = 0; r < ::BlockSize; r++ ) { d[r] = 0.0f; }
+                for ( size_t c = 0; c < m_ncolumns; c++ )
+                {
+                    const kvs::Real32 x0 = m_centers[ c * m_stride + j ];
+                    const kvs::Real32* x1 = block + c * ::BlockSize;
+                    for ( size_t r = 0; r < ::BlockSize; r++ )
+                    {
+                        const kvs::Real32 diff = x1[r] - x0;
+                        d[r] += diff * diff;
+                    }
+                }
+
+                const kvs::UInt32 id = static_cast<kvs::UInt32>( j );
+                for ( size_t r = 0; r < ::BlockSize; r++ )
+                {
+                    const bool nearer = d[r] < dmin[r];
+                    dmin[r] = nearer ? d[r] : dmin[r];
+                    index[r] = nearer ? id : index[r];
+                }
+            }
+
+            const size_t row0 = b * ::BlockSize;
+            const size_t nlanes = kvs::Math::Min( size_t( ::BlockSize ), m_nrows - row0 );
+            for ( size_t r = 0; r < nlanes; r++ )
+            {
+                if ( m_ids ) { m_ids[ row0 + r ] = index[r]; }
+                if ( m_distances ) { m_distances[ row0 + r ] = dmin[r]; }
+            }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for summing the rows of each cluster.
+ */
+/*===========================================================================*/
+class ClusterSummer : public kvs::Thread
+{
+private:
+
+    const kvs::KMeansEngine* m_engine; ///< engine
+    const kvs::UInt32* m_ids; ///< cluster IDs
+    size_t m_nclusters; ///< number of clusters
+    size_t m_begin; ///< index of the first row
+    size_t m_end; ///< index of the last row + 1
+    std::vector<kvs::Real64> m_sums; ///< partial sums of the clusters
+    std::vector<size_t> m_counts; ///< partial numbers of rows of the clusters
+
+public:
+
+    ClusterSummer(): m_engine( NULL ), m_ids( NULL ), m_nclusters( 0 ), m_begin( 0 ), m_end( 0 ) {}
+
+    const std::vector<kvs::Real64>& sums() const { return m_sums; }
+    const std::vector<size_t>& counts() const { return m_counts; }
+
+    void setup(
+        const kvs::KMeansEngine* engine,
+        const kvs::UInt32* ids,
+        const size_t nclusters,
+        const size_t begin,
+        const size_t end )
+    {
+        m_engine = engine;
+        m_ids = ids;
+        m_nclusters = nclusters;
+        m_begin = begin;
+        m_end = end;
+    }
+
+    void run()
+    {
+        const size_t ncolumns = m_engine->numberOfColumns();
+        m_sums.assign( m_nclusters * ncolumns, 0.0 );
+        m_counts.assign( m_nclusters, 0 );
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt32 id = m_ids[i];
+            kvs::Real64* sum = &m_sums[0] + id * ncolumns;
+            for ( size_t c = 0; c < ncolumns; c++ ) { sum[c] += m_engine->at( i, c ); }
+            m_counts[id]++;
+        }
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new KMeansEngine class.
+ */
+/*===========================================================================*/
+KMeansEngine::KMeansEngine():
+    m_nrows( 0 ),
+    m_ncolumns( 0 ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_ncenters( 0 ),
+    m_stride( 0 )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new KMeansEngine class.
+ *  @param  table [in] table data
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+KMeansEngine::KMeansEngine( const kvs::AnyValueTable& table, const size_t nthreads ):
+    m_nrows( 0 ),
+    m_ncolumns( 0 ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_ncenters( 0 ),
+    m_stride( 0 )
+{
+    this->setNumberOfThreads( nthreads );
+    this->setTable( table );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void KMeansEngine::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the table data, which is converted into the blocked buffer.
+ *  @param  table [in] table data (all the columns have the same number of rows)
+ */
+/*===========================================================================*/
+void KMeansEngine::setTable( const kvs::AnyValueTable& table )
+{
+    m_ncolumns = table.columnSize();
+    m_nrows = m_ncolumns > 0 ? table[0].size() : 0;
+
+    const size_t nblocks = ( m_nrows + BlockSize - 1 ) / BlockSize;
+    m_data.allocate( nblocks * m_ncolumns * BlockSize );
+    if ( m_data.empty() ) { return; }
+
+    const size_t nthreads = ::NumberOfThreads( m_number_of_threads, nblocks, 256 );
+    std::vector< ::TableConverter> converters( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = nblocks * i / nthreads;
+        const size_t end = nblocks * ( i + 1 ) / nthreads;
+        converters[i].setup( &table, m_nrows, begin, end, m_data.data() );
+    }
+
+    kvs::Thread::Run( &converters[0], nthreads );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the centers used for the distance computation.
+ *  @param  centers [in] array of the centers (each has the number of columns)
+ *  @param  ncenters [in] number of the centers
+ */
+/*===========================================================================*/
+void KMeansEngine::setCenters( const kvs::ValueArray<kvs::Real32>* centers, const size_t ncenters )
+{
+    m_ncenters = ncenters;
+    m_stride = ( ncenters + BlockSize - 1 ) / BlockSize * BlockSize;
+    m_centers.allocate( m_ncolumns * m_stride );
+    m_centers.fill( 0 );
+    for ( size_t j = 0; j < ncenters; j++ )
+    {
+        for ( size_t c = 0; c < m_ncolumns; c++ )
+        {
+            m_centers[ c * m_stride + j ] = centers[j][c];
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the values of the row.
+ *  @param  index [in] index of the row
+ *  @return values of the row
+ */
+/*===========================================================================*/
+kvs::ValueArray<kvs::Real32> KMeansEngine::row( const size_t index ) const
+{
+    kvs::ValueArray<kvs::Real32> values( m_ncolumns );
+    for ( size_t c = 0; c < m_ncolumns; c++ ) { values[c] = this->at( index, c ); }
+    return values;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the squared distance between the row and the center.
+ *  @param  row [in] index of the row
+ *  @param  center [in] index of the center
+ *  @return squared Euclidean distance
+ */
+/*===========================================================================*/
+kvs::Real32 KMeansEngine::distance( const size_t row, const size_t center ) const
+{
+    kvs::Real32 distance = 0.0f;
+    for ( size_t c = 0; c < m_ncolumns; c++ )
+    {
+        const kvs::Real32 diff = this->at( row, c ) - m_centers[ c * m_stride + center ];
+        distance += diff * diff;
+    }
+
+    return distance;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Finds the nearest and the second nearest centers of the row.
+ *  @param  row [in] index of the row
+ *  @param  nearest [out] index of the nearest center
+ *  @param  d1 [out] squared distance to the nearest center
+ *  @param  d2 [out] squared distance to the second nearest center
+ */
+/*===========================================================================*/
+void KMeansEngine::nearestCenters(
+    const size_t row,
+    kvs::UInt32* nearest,
+    kvs::Real32* d1,
+    kvs::Real32* d2 ) const
+{
+    kvs::UInt32 index = 0;
+    kvs::Real32 dmin1 = kvs::Value<kvs::Real32>::Max();
+    kvs::Real32 dmin2 = kvs::Value<kvs::Real32>::Max();
+    kvs::Real32 d[ BlockSize ];
+    for ( size_t j0 = 0; j0 < m_ncenters; j0 += BlockSize )
+    {
+        for ( size_t r = 0; r < BlockSize; r++ ) { d[r] = 0.0f; }
+        for ( size_t c = 0; c < m_ncolumns; c++ )
+        {
+            const kvs::Real32 x = this->at( row, c );
+            const kvs::Real32* centers = m_centers.data() + c * m_stride + j0;
+            for ( size_t r = 0; r < BlockSize; r++ )
+            {
+                const kvs::Real32 diff = x - centers[r];
+                d[r] += diff * diff;
+            }
+        }
+
+        const size_t n = kvs::Math::Min( size_t( BlockSize ), m_ncenters - j0 );
+        for ( size_t r = 0; r < n; r++ )
+        {
+            if ( d[r] < dmin1 )
+            {
+                dmin2 = dmin1;
+                dmin1 = d[r];
+                index = static_cast<kvs::UInt32>( j0 + r );
+            }
+            else if ( d[r] < dmin2 )
+            {
+                dmin2 = d[r];
+            }
+        }
+    }
+
+    *nearest = index;
+    *d1 = dmin1;
+    *d2 = dmin2;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Assigns all the rows to the nearest centers.
+ *  @param  ids [out] indices of the nearest centers (NULL: not required)
+ *  @param  distances [out] squared distances to the nearest centers (NULL: not required)
+ *
+ *  If several centers have the same distance, the one of the smallest index
+ *  is selected.
+ */
+/*===========================================================================*/
+void KMeansEngine::assign( kvs::UInt32* ids, kvs::Real32* distances ) const
+{
+    const size_t nblocks = ( m_nrows + BlockSize - 1 ) / BlockSize;
+    if ( nblocks == 0 ) { return; }
+
+    const size_t nthreads = ::NumberOfThreads( m_number_of_threads, nblocks, 64 );
+    std::vector< ::RowAssigner> assigners( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = nblocks * i / nthreads;
+        const size_t end = nblocks * ( i + 1 ) / nthreads;
+        assigners[i].setup(
+            m_data.data(), m_centers.data(), m_nrows, m_ncolumns, m_ncenters, m_stride,
+            begin, end, ids, distances );
+    }
+
+    kvs::Thread::Run( &assigners[0], nthreads );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the sums and the numbers of the rows of the clusters.
+ *  @param  ids [in] cluster IDs of the rows
+ *  @param  nclusters [in] number of clusters
+ *  @param  sums [out] sums of the rows (nclusters x number of columns)
+ *  @param  counts [out] numbers of the rows (nclusters)
+ */
+/*===========================================================================*/
+void KMeansEngine::sum(
+    const kvs::UInt32* ids,
+    const size_t nclusters,
+    kvs::Real64* sums,
+    size_t* counts ) const
+{
+    for ( size_t i = 0; i < nclusters * m_ncolumns; i++ ) { sums[i] = 0.0; }
+    for ( size_t i = 0; i < nclusters; i++ ) { counts[i] = 0; }
+    if ( m_nrows == 0 ) { return; }
+
+    const size_t nthreads = ::NumberOfThreads( m_number_of_threads, m_nrows, 1024 );
+    std::vector< ::ClusterSummer> summers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = m_nrows * i / nthreads;
+        const size_t end = m_nrows * ( i + 1 ) / nthreads;
+        summers[i].setup( this, ids, nclusters, begin, end );
+    }
+
+    kvs::Thread::Run( &summers[0], nthreads );
+
+    // The partial sums are reduced in the order of the threads.
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const std::vector<kvs::Real64>& partial_sums = summers[i].sums();
+        const std::vector<size_t>& partial_counts = summers[i].counts();
+        for ( size_t j = 0; j < nclusters * m_ncolumns; j++ ) { sums[j] += partial_sums[j]; }
+        for ( size_t j = 0; j < nclusters; j++ ) { counts[j] += partial_counts[j]; }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the centroids of the clusters.
+ *  @param  ids [in] cluster IDs of the rows
+ *  @param  nclusters [in] number of clusters
+ *  @param  centers [out] centroids (zero for the empty clusters)
+ */
+/*===========================================================================*/
+void KMeansEngine::calculateCenters(
+    const kvs::UInt32* ids,
+    const size_t nclusters,
+    kvs::ValueArray<kvs::Real32>* centers ) const
+{
+    if ( nclusters == 0 ) { return; }
+
+    std::vector<kvs::Real64> sums( nclusters * m_ncolumns );
+    std::vector<size_t> counts( nclusters );
+    this->sum( ids, nclusters, &sums[0], &counts[0] );
+
+    for ( size_t j = 0; j < nclusters; j++ )
+    {
+        if ( centers[j].size() != m_ncolumns ) { centers[j].allocate( m_ncolumns ); }
+        for ( size_t c = 0; c < m_ncolumns; c++ )
+        {
+            const kvs::Real64 sum = sums[ j * m_ncolumns + c ];
+            centers[j][c] = static_cast<kvs::Real32>( counts[j] > 0 ? sum / counts[j] : 0.0 );
+        }
+    }
+}
+
+} // end of namespace kvs
@@ -0,0 +1,87 @@
+/*****************************************************************************/
+/**
+ *  @file   KMeansEngine.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#ifndef KVS__K_MEANS_ENGINE_H_INCLUDE
+#define KVS__K_MEANS_ENGINE_H_INCLUDE
+
+#include <kvs/ValueArray>
+#include <kvs/AnyValueTable>
+#include <kvs/Type>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Distance computation engine for the k-means clustering classes.
+ *
+ *  The table data is converted once into a column-blocked float buffer, where
+ *  each block stores BlockSize rows column by column. The distances of the
+ *  rows in a block to a center are then computed over the contiguous lanes,
+ *  which the compiler vectorizes. The centers are stored transposed, so that
+ *  the distances of a row to the centers are vectorized as well.
+ *
+ *  The squared Euclidean distances are summed in the column order, so that
+ *  they are equal to the ones computed row by row. The assignment of all the
+ *  rows and the sums of the clusters are computed by the threads over the
+ *  ranges of the rows, with per-thread partial sums.
+ */
+/*===========================================================================*/
+class KMeansEngine
+{
+public:
+
+    enum { BlockSize = 16 }; ///< number of rows in a block
+
+private:
+
+    size_t m_nrows; ///< number of rows
+    size_t m_ncolumns; ///< number of columns
+    size_t m_number_of_threads; ///< number of threads
+    kvs::ValueArray<kvs::Real32> m_data; ///< column-blocked table data
+    size_t m_ncenters; ///< number of centers
+    size_t m_stride; ///< number of centers rounded up to the block size
+    kvs::ValueArray<kvs::Real32> m_centers; ///< transposed centers (column x stride)
+
+public:
+
+    KMeansEngine();
+    explicit KMeansEngine( const kvs::AnyValueTable& table, const size_t nthreads = 0 );
+
+    size_t numberOfRows() const { return m_nrows; }
+    size_t numberOfColumns() const { return m_ncolumns; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    size_t numberOfCenters() const { return m_ncenters; }
+
+    void setNumberOfThreads( const size_t nthreads );
+    void setTable( const kvs::AnyValueTable& table );
+    void setCenters( const kvs::ValueArray<kvs::Real32>* centers, const size_t ncenters );
+
+    kvs::Real32 at( const size_t row, const size_t column ) const
+    {
+        return m_data[ ( row / BlockSize * m_ncolumns + column ) * BlockSize + row % BlockSize ];
+    }
+
+    kvs::ValueArray<kvs::Real32> row( const size_t index ) const;
+    kvs::Real32 distance( const size_t row, const size_t center ) const;
+    void nearestCenters( const size_t row, kvs::UInt32* nearest, kvs::Real32* d1, kvs::Real32* d2 ) const;
+    void assign( kvs::UInt32* ids, kvs::Real32* distances ) const;
+    void sum( const kvs::UInt32* ids, const size_t nclusters, kvs::Real64* sums, size_t* counts ) const;
+    void calculateCenters( const kvs::UInt32* ids, const size_t nclusters, kvs::ValueArray<kvs::Real32>* centers ) const;
+};
+
+} // end of namespace kvs
+
+#endif // KVS__K_MEANS_ENGINE_H_INCLUDE
@@ -13,6 +13,7 @@
 /****************************************************************************/
 #include "Thread.h"
 #include <kvs/Message>
+#include <kvs/SystemInformation>
 #if defined ( KVS_PLATFORM_WINDOWS )
 #include <windows.h>
 #include <errno.h>
@@ -130,6 +131,18 @@ void Thread::MicroSleep( const int usec )
 #endif
 }
 
+/*==========================================================================*/
+/**
+ *  @brief  Returns the default number of threads.
+ *  @return number of processors (1 if it cannot be obtained)
+ */
+/*==========================================================================*/
+size_t Thread::DefaultNumberOfThreads()
+{
+    const long nprocessors = static_cast<long>( kvs::SystemInformation::NumberOfProcessors() );
+    return nprocessors > 0 ? static_cast<size_t>( nprocessors ) : 1;
+}
+
 /*==========================================================================*/
 /**
  *  @brief  Constructs a new Thread class.
@@ -14,6 +14,7 @@
 #ifndef KVS__THREAD_H_INCLUDE
 #define KVS__THREAD_H_INCLUDE
 
+#include <cstddef>
 #include <kvs/Platform>
 
 #if defined ( KVS_PLATFORM_WINDOWS )
@@ -55,6 +56,9 @@ public:
     static void Sleep( const int sec );
     static void MilliSleep( const int msec );
     static void MicroSleep( const int usec );
+    static size_t DefaultNumberOfThreads();
+    template <typename T>
+    static void Run( T* threads, const size_t nthreads );
 
 public:
 
@@ -84,6 +88,35 @@ public:
 #endif
 };
 
+/*===========================================================================*/
+/**
+ *  @brief  Runs the threads and waits for them.
+ *  @param  threads [in] pointer to the threads
+ *  @param  nthreads [in] number of threads
+ *
+ *  The first thread runs in the calling thread. A thread that cannot be
+ *  started runs in the calling thread as well, so that none of the work
+ *  assigned to the threads is skipped.
+ */
+/*===========================================================================*/
+template <typename T>
+inline void Thread::Run( T* threads, const size_t nthreads )
+{
+    if ( nthreads == 0 ) { return; }
+
+    for ( size_t i = 1; i < nthreads; i++ )
+    {
+        if ( !threads[i].start() ) { threads[i].run(); }
+    }
+
+    threads[0].run();
+
+    for ( size_t i = 1; i < nthreads; i++ )
+    {
+        if ( threads[i].isRunning() ) { threads[i].wait(); }
+    }
+}
+
 } // end of namespace kvs
 
 #endif // KVS__THREAD_H_INCLUDE
@@ -16,6 +16,7 @@
 
 #include <typeinfo>
 #include <utility>
+#include <cstring>
 #if KVS_ENABLE_DEPRECATED
 #include <string>
 #include <sstream>
@@ -142,6 +143,30 @@ inline std::string ValueGetter::Get<std::string>( const void* ptr, kvs::Type::Ty
 }
 #endif
 
+/*===========================================================================*/
+/**
+ *  @brief  Converts the values of the type SrcT to the type DstT.
+ */
+/*===========================================================================*/
+template <typename DstT, typename SrcT>
+struct ValueConverter
+{
+    static void Convert( const SrcT* src, DstT* dst, const size_t size )
+    {
+        // Simple loop that can be vectorized by the compiler.
+        for ( size_t i = 0; i < size; i++ ) { dst[i] = static_cast<DstT>( src[i] ); }
+    }
+};
+
+template <typename T>
+struct ValueConverter<T,T>
+{
+    static void Convert( const T* src, T* dst, const size_t size )
+    {
+        if ( size > 0 ) { memcpy( dst, src, sizeof(T) * size ); }
+    }
+};
+
 class AnyValueArrayElement
 {
 private:
@@ -386,6 +411,90 @@ public:
         return ( *this )[ index ].to<T>();
     }
 
+    /*=======================================================================*/
+    /**
+     *  @brief  Copies the values into the buffer with the conversion to T.
+     *  @param  buffer [out] pointer to the buffer of the size() values
+     */
+    /*=======================================================================*/
+    template <typename T>
+    void copyTo( T* buffer ) const
+    {
+        this->copyTo( buffer, 0, this->size() );
+    }
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Copies the values in the range into the buffer with the conversion to T.
+     *  @param  buffer [out] pointer to the buffer of the count values
+     *  @param  offset [in] index of the first value
+     *  @param  count [in] number of the values
+     *
+     *  The type of the values is dispatched once for the range, instead of
+     *  each element as at() and the iterator do.
+     */
+    /*=======================================================================*/
+    template <typename T>
+    void copyTo( T* buffer, const size_t offset, const size_t count ) const
+    {
+        KVS_STATIC_ASSERT( is_supported<T>::value, "not supported" );
+        KVS_ASSERT( offset + count <= this->size() );
+        switch ( m_type_id )
+        {
+        case kvs::Type::TypeInt8:   this->convert_to<T,kvs::Int8>  ( buffer, offset, count ); break;
+        case kvs::Type::TypeInt16:  this->convert_to<T,kvs::Int16> ( buffer, offset, count ); break;
+        case kvs::Type::TypeInt32:  this->convert_to<T,kvs::Int32> ( buffer, offset, count ); break;
+        case kvs::Type::TypeInt64:  this->convert_to<T,kvs::Int64> ( buffer, offset, count ); break;
+        case kvs::Type::TypeUInt8:  this->convert_to<T,kvs::UInt8> ( buffer, offset, count ); break;
+        case kvs::Type::TypeUInt16: this->convert_to<T,kvs::UInt16>( buffer, offset, count ); break;
+        case kvs::Type::TypeUInt32: this->convert_to<T,kvs::UInt32>( buffer, offset, count ); break;
+        case kvs::Type::TypeUInt64: this->convert_to<T,kvs::UInt64>( buffer, offset, count ); break;
+        case kvs::Type::TypeReal32: this->convert_to<T,kvs::Real32>( buffer, offset, count ); break;
+        case kvs::Type::TypeReal64: this->convert_to<T,kvs::Real64>( buffer, offset, count ); break;
+        default: break;
+        }
+    }
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Returns the values as the value array of the type T.
+     *  @return value array (shared if the type is T, converted copy otherwise)
+     */
+    /*=======================================================================*/
+    template <typename T>
+    kvs::ValueArray<T> toValueArray() const
+    {
+        KVS_STATIC_ASSERT( is_supported<T>::value, "not supported" );
+        if ( this->check_type<T>() ) { return this->asValueArray<T>(); }
+
+        kvs::ValueArray<T> result( this->size() );
+        this->copyTo( result.data() );
+        return result;
+    }
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Calls the function with the value array of the concrete type.
+     *  @param  function [in] function object
+     *  @return false, if the type is unknown
+     *
+     *  The function object has a template operator such as
+     *  'template <typename T> void operator ()( const kvs::ValueArray<T>& values )',
+     *  which is instantiated for each type and called once.
+     */
+    /*=======================================================================*/
+    template <typename Function>
+    bool dispatch( Function& function ) const
+    {
+        return Dispatch<Function&>( *this, function );
+    }
+
+    template <typename Function>
+    bool dispatch( const Function& function ) const
+    {
+        return Dispatch<const Function&>( *this, function );
+    }
+
     // for compatibility.
 
     const TypeInfo* typeInfo() const
@@ -530,6 +639,33 @@ private:
         return m_type_id == kvs::Type::GetID<T>();
     }
 
+    template <typename DstT, typename SrcT>
+    void convert_to( DstT* buffer, const size_t offset, const size_t count ) const
+    {
+        const SrcT* values = static_cast<const SrcT*>( this->data() ) + offset;
+        kvs::detail::ValueConverter<DstT,SrcT>::Convert( values, buffer, count );
+    }
+
+    template <typename Function>
+    static bool Dispatch( const AnyValueArray& array, Function function )
+    {
+        switch ( array.typeID() )
+        {
+        case kvs::Type::TypeInt8:   function( array.asValueArray<kvs::Int8>()   ); break;
+        case kvs::Type::TypeInt16:  function( array.asValueArray<kvs::Int16>()  ); break;
+        case kvs::Type::TypeInt32:  function( array.asValueArray<kvs::Int32>()  ); break;
+        case kvs::Type::TypeInt64:  function( array.asValueArray<kvs::Int64>()  ); break;
+        case kvs::Type::TypeUInt8:  function( array.asValueArray<kvs::UInt8>()  ); break;
+        case kvs::Type::TypeUInt16: function( array.asValueArray<kvs::UInt16>() ); break;
+        case kvs::Type::TypeUInt32: function( array.asValueArray<kvs::UInt32>() ); break;
+        case kvs::Type::TypeUInt64: function( array.asValueArray<kvs::UInt64>() ); break;
+        case kvs::Type::TypeReal32: function( array.asValueArray<kvs::Real32>() ); break;
+        case kvs::Type::TypeReal64: function( array.asValueArray<kvs::Real64>() ); break;
+        default: return false;
+        }
+        return true;
+    }
+
     template <typename T>
     struct is_supported : kvs::temporal::false_type {};
 };
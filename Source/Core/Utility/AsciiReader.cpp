@@ -0,0 +1,402 @@
+/****************************************************************************/
+/**
+ *  @file   AsciiReader.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#include "AsciiReader.h"
+#include <kvs/Math>
+#include <kvs/Thread>
+#include <kvs/Message>
+
+
+namespace
+{
+
+const size_t BlockSize = 1 << 20; // bytes read at once
+const size_t MinLinesPerThread = 1 << 12;
+const size_t MinBytesPerThread = 1 << 18;
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread that parses the lines or the numbers in a range.
+ */
+/*===========================================================================*/
+class ParseWorker : public kvs::Thread
+{
+public:
+
+    enum Task
+    {
+        ParseLines = 0, ///< parse the lines [line_begin,line_end)
+        CountNumbers, ///< count the tokens in [begin,end)
+        ParseNumbers ///< parse the tokens in [begin,end)
+    };
+
+private:
+
+    Task m_task; ///< task
+    const kvs::AsciiReader* m_reader; ///< reader for ParseLines
+    kvs::AsciiReader::LineTask* m_line_task; ///< line task for ParseLines
+    kvs::AsciiReader::NumberTask* m_number_task; ///< number task for ParseNumbers
+    size_t m_line_begin; ///< first line
+    size_t m_line_end; ///< last line + 1
+    const char* m_begin; ///< head of the range
+    const char* m_end; ///< end of the range
+    size_t m_offset; ///< index of the first number in the range
+    size_t m_count; ///< number of the tokens in the range
+    bool m_result; ///< false if a line task failed
+
+public:
+
+    ParseWorker():
+        m_task( ParseLines ),
+        m_reader( NULL ),
+        m_line_task( NULL ),
+        m_number_task( NULL ),
+        m_line_begin( 0 ),
+        m_line_end( 0 ),
+        m_begin( NULL ),
+        m_end( NULL ),
+        m_offset( 0 ),
+        m_count( 0 ),
+        m_result( true ) {}
+
+    void setLines( const kvs::AsciiReader* reader, kvs::AsciiReader::LineTask* task, const size_t begin, const size_t end )
+    {
+        m_reader = reader;
+        m_line_task = task;
+        m_line_begin = begin;
+        m_line_end = end;
+    }
+
+    void setRange( kvs::AsciiReader::NumberTask* task, const char* begin, const char* end )
+    {
+        m_number_task = task;
+        m_begin = begin;
+        m_end = end;
+    }
+
+    void setTask( const Task task ) { m_task = task; }
+    void setOffset( const size_t offset ) { m_offset = offset; }
+    size_t count() const { return m_count; }
+    bool result() const { return m_result; }
+
+    void run()
+    {
+        switch ( m_task )
+        {
+        case ParseLines:
+        {
+            for ( size_t i = m_line_begin; i < m_line_end; i++ )
+            {
+                if ( !m_line_task->parse( i, m_reader->line(i) ) ) { m_result = false; }
+            }
+            break;
+        }
+        case CountNumbers:
+        {
+            m_count = 0;
+            const char* p = kvs::AsciiReader::SkipDelimiters( m_begin );
+            while ( p < m_end )
+            {
+                while ( !kvs::AsciiReader::IsEnd( *p ) ) { ++p; }
+                p = kvs::AsciiReader::SkipDelimiters( p );
+                m_count++;
+            }
+            break;
+        }
+        case ParseNumbers:
+        {
+            m_number_task->parse( m_begin, m_end, m_offset );
+            break;
+        }
+        default: break;
+        }
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new AsciiReader class.
+ */
+/*===========================================================================*/
+AsciiReader::AsciiReader():
+    m_buffer( 1, '\0' ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for parsing.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void AsciiReader::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Reads the lines from the current position of the file.
+ *  @param  ifs [in] file pointer (opened in binary mode)
+ *  @param  nlines [in] number of lines
+ *  @return true, if the lines are read successfully
+ *
+ *  The file position is moved to the head of the next line, so that the rest
+ *  of the file can be read by the other functions such as fgets.
+ */
+/*===========================================================================*/
+bool AsciiReader::readLines( FILE* ifs, const size_t nlines )
+{
+    m_buffer.clear();
+    m_lines.clear();
+    if ( nlines == 0 ) { m_buffer.push_back( '\0' ); return true; }
+
+    size_t nfound = 0; // number of the line ends
+    size_t size = 0;
+    for ( ;; )
+    {
+        m_buffer.resize( size + ::BlockSize );
+        const size_t nread = fread( &m_buffer[0] + size, 1, ::BlockSize, ifs );
+        const char* const head = &m_buffer[0];
+        const char* p = head + size;
+        const char* const end = p + nread;
+        size += nread;
+
+        while ( p < end )
+        {
+            p = static_cast<const char*>( memchr( p, '\n', end - p ) );
+            if ( !p ) { break; }
+            if ( ++nfound == nlines )
+            {
+                // Move back the file position to the next line.
+                const size_t used = static_cast<size_t>( p + 1 - head );
+                fseek( ifs, -static_cast<long>( size - used ), SEEK_CUR );
+                size = used;
+                break;
+            }
+            ++p;
+        }
+
+        if ( nfound == nlines || nread < ::BlockSize ) { break; }
+    }
+
+    // The last line may not be terminated by the line end.
+    if ( nfound < nlines && size > 0 && m_buffer[ size - 1 ] != '\n' ) { nfound++; }
+
+    m_buffer.resize( size );
+    m_buffer.push_back( '\0' );
+    this->build_lines( 0 );
+
+    return nfound == nlines;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Reads the rest of the file from the current position.
+ *  @param  ifs [in] file pointer
+ *  @return true, if the file is read successfully
+ */
+/*===========================================================================*/
+bool AsciiReader::readAll( FILE* ifs )
+{
+    m_buffer.clear();
+    m_lines.clear();
+
+    size_t size = 0;
+    for ( ;; )
+    {
+        m_buffer.resize( size + ::BlockSize );
+        const size_t nread = fread( &m_buffer[0] + size, 1, ::BlockSize, ifs );
+        size += nread;
+        if ( nread < ::BlockSize ) { break; }
+    }
+
+    m_buffer.resize( size );
+    m_buffer.push_back( '\0' );
+    this->build_lines( 0 );
+
+    return ferror( ifs ) == 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Reads the whole of the file.
+ *  @param  filename [in] filename
+ *  @return true, if the file is read successfully
+ */
+/*===========================================================================*/
+bool AsciiReader::readFile( const std::string& filename )
+{
+    FILE* ifs = fopen( filename.c_str(), "rb" );
+    if ( !ifs )
+    {
+        kvsMessageError( "Cannot open '%s'.", filename.c_str() );
+        return false;
+    }
+
+    const bool result = this->readAll( ifs );
+    fclose( ifs );
+    if ( !result )
+    {
+        kvsMessageError( "Cannot read '%s'.", filename.c_str() );
+    }
+
+    return result;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the lines with the task.
+ *  @param  task [in] line task (called from several threads)
+ *  @return true, if the task returns true for all of the lines
+ */
+/*===========================================================================*/
+bool AsciiReader::parseLines( LineTask& task ) const
+{
+    const size_t nlines = m_lines.size();
+    if ( nlines == 0 ) { return true; }
+
+    const size_t max_nthreads = kvs::Math::Max( nlines / ::MinLinesPerThread, size_t( 1 ) );
+    const size_t nthreads = kvs::Math::Min( m_number_of_threads, max_nthreads );
+
+    std::vector< ::ParseWorker> workers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = nlines * i / nthreads;
+        const size_t end = nlines * ( i + 1 ) / nthreads;
+        workers[i].setTask( ::ParseWorker::ParseLines );
+        workers[i].setLines( this, &task, begin, end );
+    }
+    kvs::Thread::Run( &workers[0], workers.size() );
+
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        if ( !workers[i].result() ) { return false; }
+    }
+
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the real number with strtod.
+ *  @param  p [in] pointer to the head of the token
+ *  @param  value [out] parsed value
+ *  @return pointer to the end of the token (NULL if the token is not a number)
+ */
+/*===========================================================================*/
+const char* AsciiReader::ParseByLibrary( const char* p, kvs::Real64* value )
+{
+    const char* tail = p;
+    while ( !IsEnd( *tail ) ) { ++tail; }
+    if ( tail == p ) { return NULL; }
+
+    // Copy the token so that strtod never reads beyond the token.
+    const std::string token( p, tail );
+    char* end = NULL;
+    const double v = strtod( token.c_str(), &end );
+    if ( end == token.c_str() ) { return NULL; }
+
+    *value = v;
+    return p + ( end - token.c_str() );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the numbers in the text split into the ranges.
+ *  @param  begin [in] pointer to the head of the text
+ *  @param  end [in] pointer to the end of the text
+ *  @param  nvalues [in] max. number of the values
+ *  @param  task [in] number task
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ *  @return number of the parsed values
+ *
+ *  The text is split at the delimiters into the ranges for the threads. The
+ *  tokens in each range are counted first, and then the ranges are parsed in
+ *  parallel into the values from the offsets given by the counts.
+ */
+/*===========================================================================*/
+size_t AsciiReader::ParseRanges(
+    const char* begin,
+    const char* end,
+    const size_t nvalues,
+    NumberTask& task,
+    const size_t nthreads )
+{
+    const size_t length = static_cast<size_t>( end - begin );
+    const size_t max_nthreads = kvs::Math::Max( length / ::MinBytesPerThread, size_t( 1 ) );
+    const size_t nranges = kvs::Math::Min( nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads(), max_nthreads );
+
+    std::vector< ::ParseWorker> workers( nranges );
+    const char* head = begin;
+    for ( size_t i = 0; i < nranges; i++ )
+    {
+        const char* tail = ( i == nranges - 1 ) ? end : kvs::Math::Max( begin + length * ( i + 1 ) / nranges, head );
+        while ( tail < end && !IsEnd( *tail ) ) { ++tail; }
+        workers[i].setRange( &task, head, tail );
+        head = tail;
+    }
+
+    if ( nranges == 1 )
+    {
+        workers[0].setTask( ::ParseWorker::CountNumbers );
+        workers[0].run();
+        workers[0].setTask( ::ParseWorker::ParseNumbers );
+        workers[0].run();
+        return kvs::Math::Min( workers[0].count(), nvalues );
+    }
+
+    for ( size_t i = 0; i < nranges; i++ ) { workers[i].setTask( ::ParseWorker::CountNumbers ); }
+    kvs::Thread::Run( &workers[0], workers.size() );
+
+    size_t offset = 0;
+    for ( size_t i = 0; i < nranges; i++ )
+    {
+        workers[i].setTask( ::ParseWorker::ParseNumbers );
+        workers[i].setOffset( kvs::Math::Min( offset, nvalues ) );
+        offset += workers[i].count();
+    }
+    kvs::Thread::Run( &workers[0], workers.size() );
+
+    return kvs::Math::Min( offset, nvalues );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Builds the offsets to the heads of the lines.
+ *  @param  offset [in] offset to the head of the first line
+ */
+/*===========================================================================*/
+void AsciiReader::build_lines( const size_t offset )
+{
+    const char* const head = &m_buffer[0];
+    const char* const end = head + m_buffer.size() - 1;
+    const char* p = head + offset;
+    while ( p < end )
+    {
+        m_lines.push_back( static_cast<size_t>( p - head ) );
+        p = static_cast<const char*>( memchr( p, '\n', end - p ) );
+        if ( !p ) { break; }
+        ++p;
+    }
+}
+
+} // end of namespace kvs
@@ -0,0 +1,387 @@
+/****************************************************************************/
+/**
+ *  @file   AsciiReader.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#ifndef KVS__ASCII_READER_H_INCLUDE
+#define KVS__ASCII_READER_H_INCLUDE
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <kvs/Type>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Reader for the numbers written in ASCII.
+ *
+ *  The lines of the file are read into a buffer in large blocks, and the
+ *  numbers are parsed from the buffer without the locale and the memory
+ *  allocation. Blanks (' ', '\\t', '\\r') and commas separate the tokens in a
+ *  line. The lines or the numbers can be parsed with several threads, since
+ *  the buffer is split at the line boundaries.
+ */
+/*===========================================================================*/
+class AsciiReader
+{
+public:
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Task that parses a line (called from several threads).
+     */
+    /*=======================================================================*/
+    class LineTask
+    {
+    public:
+        virtual ~LineTask() {}
+        virtual bool parse( const size_t index, const char* line ) = 0;
+    };
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Task that parses the numbers in a range of the text.
+     */
+    /*=======================================================================*/
+    class NumberTask
+    {
+    public:
+        virtual ~NumberTask() {}
+        virtual void parse( const char* begin, const char* end, const size_t offset ) = 0;
+    };
+
+private:
+
+    std::vector<char> m_buffer; ///< text buffer terminated by '\\0'
+    std::vector<size_t> m_lines; ///< offsets to the heads of the lines
+    size_t m_number_of_threads; ///< number of threads
+
+public:
+
+    AsciiReader();
+
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    void setNumberOfThreads( const size_t nthreads );
+
+    bool readLines( FILE* ifs, const size_t nlines );
+    bool readAll( FILE* ifs );
+    bool readFile( const std::string& filename );
+
+    const char* text() const { return &m_buffer[0]; }
+    size_t numberOfLines() const { return m_lines.size(); }
+    const char* line( const size_t index ) const { return &m_buffer[0] + m_lines[ index ]; }
+
+    bool parseLines( LineTask& task ) const;
+
+    template <typename T>
+    size_t parseNumbers( T* values, const size_t nvalues ) const
+    {
+        const char* begin = &m_buffer[0];
+        return ParseNumbers( begin, begin + m_buffer.size() - 1, values, nvalues, m_number_of_threads );
+    }
+
+public:
+
+    static bool IsBlank( const char c ) { return c == ' ' || c == '\t' || c == '\r' || c == ','; }
+    static bool IsDelimiter( const char c ) { return IsBlank( c ) || c == '\n'; }
+    static bool IsEnd( const char c ) { return IsDelimiter( c ) || c == '\0'; }
+    static bool IsDigit( const char c ) { return c >= '0' && c <= '9'; }
+
+    static const char* SkipBlanks( const char* p );
+    static const char* SkipDelimiters( const char* p );
+    static const char* SkipToken( const char* p );
+    static const char* Token( const char* p, size_t* length );
+    static bool Equal( const char* token, const size_t length, const char* word );
+
+    static const char* Parse( const char* p, kvs::Real64* value );
+    static const char* Parse( const char* p, kvs::Real32* value );
+    template <typename T>
+    static const char* Parse( const char* p, T* value );
+
+    template <typename T>
+    static size_t ParseNumbers(
+        const char* begin,
+        const char* end,
+        T* values,
+        const size_t nvalues,
+        const size_t nthreads = 0 );
+
+private:
+
+    static const char* ParseByLibrary( const char* p, kvs::Real64* value );
+    static size_t ParseRanges(
+        const char* begin,
+        const char* end,
+        const size_t nvalues,
+        NumberTask& task,
+        const size_t nthreads );
+
+    void build_lines( const size_t offset );
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Skips the blanks in the line.
+ *  @param  p [in] pointer to the text
+ *  @return pointer to the next token, the line end or the text end
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::SkipBlanks( const char* p )
+{
+    while ( IsBlank( *p ) ) { ++p; }
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Skips the blanks and the line ends.
+ *  @param  p [in] pointer to the text
+ *  @return pointer to the next token or the text end
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::SkipDelimiters( const char* p )
+{
+    while ( IsDelimiter( *p ) ) { ++p; }
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Skips the next token in the line.
+ *  @param  p [in] pointer to the text
+ *  @return pointer to the end of the token
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::SkipToken( const char* p )
+{
+    p = SkipBlanks( p );
+    while ( !IsEnd( *p ) ) { ++p; }
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the next token in the line.
+ *  @param  p [in] pointer to the text
+ *  @param  length [out] length of the token (0 if no token in the line)
+ *  @return pointer to the head of the token
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::Token( const char* p, size_t* length )
+{
+    const char* head = SkipBlanks( p );
+    const char* tail = head;
+    while ( !IsEnd( *tail ) ) { ++tail; }
+    *length = static_cast<size_t>( tail - head );
+    return head;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Compares the token with the word.
+ *  @param  token [in] pointer to the head of the token
+ *  @param  length [in] length of the token
+ *  @param  word [in] word
+ *  @return true, if the token is equal to the word
+ */
+/*===========================================================================*/
+inline bool AsciiReader::Equal( const char* token, const size_t length, const char* word )
+{
+    return strlen( word ) == length && strncmp( token, word, length ) == 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the real number in the line.
+ *  @param  p [in] pointer to the text
+ *  @param  value [out] parsed value
+ *  @return pointer to the end of the token (NULL if no number in the line)
+ *
+ *  The numbers of up to 15 significant digits with an exponent in [-22,22]
+ *  are converted exactly as strtod does, since both of the mantissa and the
+ *  power of 10 are exactly represented in double. The other numbers are
+ *  converted by strtod.
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::Parse( const char* p, kvs::Real64* value )
+{
+    static const double Power[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    p = SkipBlanks( p );
+    const char* head = p;
+
+    const bool negative = ( *p == '-' );
+    if ( *p == '-' || *p == '+' ) { ++p; }
+
+    kvs::UInt64 mantissa = 0;
+    int ndigits = 0; // number of the significant digits
+    int exponent = 0;
+    bool has_digits = false;
+    while ( IsDigit( *p ) )
+    {
+        if ( mantissa < 100000000000000000ULL ) { mantissa = mantissa * 10 + ( *p - '0' ); }
+        else { exponent++; }
+        if ( mantissa > 0 ) { ndigits++; }
+        has_digits = true;
+        ++p;
+    }
+
+    if ( *p == '.' )
+    {
+        ++p;
+        while ( IsDigit( *p ) )
+        {
+            if ( mantissa < 100000000000000000ULL ) { mantissa = mantissa * 10 + ( *p - '0' ); exponent--; }
+            if ( mantissa > 0 ) { ndigits++; }
+            has_digits = true;
+            ++p;
+        }
+    }
+
+    if ( has_digits && ( *p == 'e' || *p == 'E' ) )
+    {
+        const char* q = p + 1;
+        const bool negative_exponent = ( *q == '-' );
+        if ( *q == '-' || *q == '+' ) { ++q; }
+        if ( IsDigit( *q ) )
+        {
+            int e = 0;
+            while ( IsDigit( *q ) ) { if ( e < 10000 ) { e = e * 10 + ( *q - '0' ); } ++q; }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    if ( !has_digits || !IsEnd( *p ) || ndigits > 15 || exponent < -22 || exponent > 22 )
+    {
+        return ParseByLibrary( head, value );
+    }
+
+    double v = static_cast<double>( mantissa );
+    v = exponent < 0 ? v / Power[ -exponent ] : v * Power[ exponent ];
+    *value = negative ? -v : v;
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the real number in the line as single precision.
+ *  @param  p [in] pointer to the text
+ *  @param  value [out] parsed value
+ *  @return pointer to the end of the token (NULL if no number in the line)
+ */
+/*===========================================================================*/
+inline const char* AsciiReader::Parse( const char* p, kvs::Real32* value )
+{
+    kvs::Real64 v = 0.0;
+    p = Parse( p, &v );
+    if ( p ) { *value = static_cast<kvs::Real32>( v ); }
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the integer number in the line.
+ *  @param  p [in] pointer to the text
+ *  @param  value [out] parsed value
+ *  @return pointer to the end of the token (NULL if no number in the line)
+ *
+ *  A token with a fraction or an exponent is parsed as a real number and cast
+ *  to the type T.
+ */
+/*===========================================================================*/
+template <typename T>
+inline const char* AsciiReader::Parse( const char* p, T* value )
+{
+    p = SkipBlanks( p );
+    const char* head = p;
+
+    const bool negative = ( *p == '-' );
+    if ( *p == '-' || *p == '+' ) { ++p; }
+
+    kvs::UInt64 v = 0;
+    const char* digits = p;
+    while ( IsDigit( *p ) ) { v = v * 10 + ( *p - '0' ); ++p; }
+
+    if ( p == digits || !IsEnd( *p ) || p - digits > 18 )
+    {
+        kvs::Real64 real = 0.0;
+        p = Parse( head, &real );
+        if ( p ) { *value = static_cast<T>( real ); }
+        return p;
+    }
+
+    *value = static_cast<T>( negative ? -static_cast<kvs::Int64>( v ) : static_cast<kvs::Int64>( v ) );
+    return p;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Parses the numbers separated by the delimiters.
+ *  @param  begin [in] pointer to the head of the text
+ *  @param  end [in] pointer to the end of the text
+ *  @param  values [out] pointer to the parsed values
+ *  @param  nvalues [in] max. number of the values
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ *  @return number of the parsed values
+ *
+ *  The text must be terminated by a delimiter or '\\0' at the end. A token
+ *  that is not a number is parsed as 0 like atof.
+ */
+/*===========================================================================*/
+template <typename T>
+inline size_t AsciiReader::ParseNumbers(
+    const char* begin,
+    const char* end,
+    T* values,
+    const size_t nvalues,
+    const size_t nthreads )
+{
+    class Task : public NumberTask
+    {
+        T* m_values;
+        size_t m_nvalues;
+    public:
+        Task( T* values, const size_t nvalues ): m_values( values ), m_nvalues( nvalues ) {}
+        void parse( const char* begin, const char* end, const size_t offset )
+        {
+            T* value = m_values + offset;
+            T* const last = m_values + m_nvalues;
+            const char* p = SkipDelimiters( begin );
+            while ( p < end && value < last )
+            {
+                const char* next = Parse( p, value );
+                if ( next ) { p = next; }
+                else { *value = T(0); p = SkipToken( p ); }
+                ++value;
+                p = SkipDelimiters( p );
+            }
+        }
+    };
+
+    Task task( values, nvalues );
+    return ParseRanges( begin, end, nvalues, task, nthreads );
+}
+
+} // end of namespace kvs
+
+#endif // KVS__ASCII_READER_H_INCLUDE
@@ -0,0 +1,170 @@
+/*****************************************************************************/
+/**
+ *  @file   MappedFile.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include "MappedFile.h"
+#include <kvs/Platform>
+#if defined ( KVS_PLATFORM_WINDOWS )
+#include <windows.h>
+#else
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new MappedFile class.
+ */
+/*===========================================================================*/
+MappedFile::MappedFile():
+    m_data( NULL ),
+    m_size( 0 )
+#if defined ( KVS_PLATFORM_WINDOWS )
+    ,
+    m_file( INVALID_HANDLE_VALUE ),
+    m_mapping( NULL )
+#endif
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Destroys the MappedFile class.
+ */
+/*===========================================================================*/
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Maps the file into memory.
+ *  @param  filename [in] filename
+ *  @return true, if the file is mapped successfully
+ */
+/*===========================================================================*/
+bool MappedFile::open( const std::string& filename )
+{
+    this->close();
+
+#if defined ( KVS_PLATFORM_WINDOWS )
+    HANDLE file = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( file == INVALID_HANDLE_VALUE ) { return false; }
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+    if ( !mapping )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    void* data = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+    if ( !data )
+    {
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = data;
+    m_size = static_cast<size_t>( size.QuadPart );
+#else
+    const int fd = ::open( filename.c_str(), O_RDONLY );
+    if ( fd < 0 ) { return false; }
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || st.st_size <= 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>( st.st_size );
+    void* data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    ::close( fd ); // the mapping is kept after closing the descriptor
+    if ( data == MAP_FAILED ) { return false; }
+
+#if defined ( MADV_SEQUENTIAL )
+    madvise( data, size, MADV_SEQUENTIAL );
+#endif
+
+    m_data = data;
+    m_size = size;
+#endif
+
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Unmaps the file.
+ */
+/*===========================================================================*/
+void MappedFile::close()
+{
+#if defined ( KVS_PLATFORM_WINDOWS )
+    if ( m_data ) { UnmapViewOfFile( m_data ); }
+    if ( m_mapping ) { CloseHandle( m_mapping ); }
+    if ( m_file != INVALID_HANDLE_VALUE ) { CloseHandle( m_file ); }
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    if ( m_data ) { munmap( m_data, m_size ); }
+#endif
+
+    m_data = NULL;
+    m_size = 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Replaces the file with the source file.
+ *  @param  source [in] source filename (renamed to the filename)
+ *  @param  filename [in] filename
+ *  @return true, if the file is replaced successfully
+ *
+ *  The file is replaced without rewriting its contents, so that the memory
+ *  mapped from the old file is still valid. On Windows, the file mapped into
+ *  memory cannot be replaced and false is returned.
+ */
+/*===========================================================================*/
+bool MappedFile::Replace( const std::string& source, const std::string& filename )
+{
+#if defined ( KVS_PLATFORM_WINDOWS )
+    return MoveFileExA( source.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+    return std::rename( source.c_str(), filename.c_str() ) == 0;
+#endif
+}
+
+} // end of namespace kvs
@@ -0,0 +1,99 @@
+/*****************************************************************************/
+/**
+ *  @file   MappedFile.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#ifndef KVS__MAPPED_FILE_H_INCLUDE
+#define KVS__MAPPED_FILE_H_INCLUDE
+
+#include <string>
+#include <cstddef>
+#include <kvs/Platform>
+#include <kvs/Noncopyable>
+#include <kvs/SharedPointer>
+#include <kvs/ValueArray>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Read-only file mapped into memory.
+ *
+ *  The file is mapped with copy-on-write pages, so that the mapped data can be
+ *  modified in memory without changing the file.
+ *
+ *  The mapped file must not be truncated or rewritten in place while it is
+ *  mapped, since the access to the pages beyond the new end of the file
+ *  raises SIGBUS. A file that can be mapped is written to another file which
+ *  then replaces it with Replace(). The mapping keeps the replaced file alive.
+ */
+/*===========================================================================*/
+class MappedFile : public kvs::Noncopyable
+{
+private:
+
+    void* m_data; ///< pointer to the mapped data
+    size_t m_size; ///< size of the mapped data in bytes
+#if defined ( KVS_PLATFORM_WINDOWS )
+    void* m_file; ///< file handle
+    void* m_mapping; ///< file mapping handle
+#endif
+
+public:
+
+    MappedFile();
+    ~MappedFile();
+
+    bool isOpen() const { return m_data != NULL; }
+    size_t size() const { return m_size; }
+    void* data() { return m_data; }
+    const void* data() const { return m_data; }
+
+    bool open( const std::string& filename );
+    void close();
+
+public:
+
+    template <typename T>
+    static bool Map( const std::string& filename, const size_t nelements, kvs::ValueArray<T>* data_array );
+    static bool Replace( const std::string& source, const std::string& filename );
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Maps the file into memory as a value array.
+ *  @param  filename [in] filename
+ *  @param  nelements [in] number of elements
+ *  @param  data_array [out] pointer to the value array sharing the mapped data
+ *  @return true, if the file is mapped successfully
+ *
+ *  The file is unmapped when the last value array sharing the data is released.
+ */
+/*===========================================================================*/
+template <typename T>
+inline bool MappedFile::Map( const std::string& filename, const size_t nelements, kvs::ValueArray<T>* data_array )
+{
+    kvs::SharedPointer<kvs::MappedFile> file( new kvs::MappedFile() );
+    if ( !file->open( filename ) ) { return false; }
+    if ( nelements == 0 || file->size() < nelements * sizeof( T ) ) { return false; }
+
+    // The value array shares the ownership of the mapped file.
+    const kvs::SharedPointer<T> data( file, static_cast<T*>( file->data() ) );
+    *data_array = kvs::ValueArray<T>( data, nelements );
+    return true;
+}
+
+} // end of namespace kvs
+
+#endif // KVS__MAPPED_FILE_H_INCLUDE
@@ -24,6 +24,8 @@
 #include <kvs/DebugNew>
 #include <kvs/Assert>
 #include <kvs/SharedPointer>
+#include <kvs/ValueArrayAllocator>
+#include <kvs/Type>
 #if KVS_ENABLE_DEPRECATED
 #include <kvs/Endian>
 #endif
@@ -43,6 +45,81 @@ struct ArrayDeleter
     }
 };
 
+template <typename T>
+struct AllocatorDeleter
+{
+    kvs::ValueArrayAllocator* allocator;
+    size_t bytes;
+
+    AllocatorDeleter( kvs::ValueArrayAllocator* a, const size_t b ): allocator( a ), bytes( b ) {}
+
+    void operator ()( T* ptr )
+    {
+        allocator->deallocate( ptr, bytes );
+    }
+};
+
+template <typename T>
+struct VectorDeleter
+{
+    std::vector<T>* vector;
+
+    explicit VectorDeleter( std::vector<T>* v ): vector( v ) {}
+
+    void operator ()( T* )
+    {
+        delete vector;
+    }
+};
+
+/*==========================================================================*/
+/**
+ *  Array allocator. The arrays of the types with the constructors are
+ *  allocated by new[], and the arrays of the fundamental types are allocated
+ *  by kvs::ValueArrayAllocator without the initialization (like new[]).
+ */
+/*==========================================================================*/
+template <typename T>
+struct ArrayAllocator
+{
+    static kvs::SharedPointer<T> Allocate( const size_t size )
+    {
+        return kvs::SharedPointer<T>( new T[ size ], ArrayDeleter<T>() );
+    }
+};
+
+template <typename T>
+struct FundamentalArrayAllocator
+{
+    static kvs::SharedPointer<T> Allocate( const size_t size )
+    {
+        kvs::ValueArrayAllocator* allocator = kvs::ValueArrayAllocator::Instance();
+        const size_t bytes = size * sizeof( T );
+        T* ptr = static_cast<T*>( allocator->allocate( bytes ) );
+        return kvs::SharedPointer<T>( ptr, AllocatorDeleter<T>( allocator, bytes ) );
+    }
+};
+
+// The buffers are allocated by new[] when the memory debugging is enabled, so
+// that they are traced by kvs::MemoryTracer through kvs/DebugNew.
+#if !defined ( KVS_ENABLE_MEM_DEBUG )
+template <> struct ArrayAllocator<char> : FundamentalArrayAllocator<char> {};
+template <> struct ArrayAllocator<signed char> : FundamentalArrayAllocator<signed char> {};
+template <> struct ArrayAllocator<unsigned char> : FundamentalArrayAllocator<unsigned char> {};
+template <> struct ArrayAllocator<short> : FundamentalArrayAllocator<short> {};
+template <> struct ArrayAllocator<unsigned short> : FundamentalArrayAllocator<unsigned short> {};
+template <> struct ArrayAllocator<int> : FundamentalArrayAllocator<int> {};
+template <> struct ArrayAllocator<unsigned int> : FundamentalArrayAllocator<unsigned int> {};
+template <> struct ArrayAllocator<long> : FundamentalArrayAllocator<long> {};
+template <> struct ArrayAllocator<unsigned long> : FundamentalArrayAllocator<unsigned long> {};
+#if defined ( KVS_COMPILER_VC ) || !defined ( KVS_PLATFORM_CPU_64 )
+template <> struct ArrayAllocator<kvs::Int64> : FundamentalArrayAllocator<kvs::Int64> {};
+template <> struct ArrayAllocator<kvs::UInt64> : FundamentalArrayAllocator<kvs::UInt64> {};
+#endif
+template <> struct ArrayAllocator<float> : FundamentalArrayAllocator<float> {};
+template <> struct ArrayAllocator<double> : FundamentalArrayAllocator<double> {};
+#endif
+
 }
 
 /*==========================================================================*/
@@ -75,6 +152,12 @@ public:
         m_size = 0;
     }
 
+    /*======================================================================*/
+    /**
+     *  Allocates the array without initializing the values of the fundamental
+     *  types (like new[]). The values must be filled by the caller.
+     */
+    /*======================================================================*/
     explicit ValueArray( const size_t size )
     {
         this->allocate( size );
@@ -105,6 +188,45 @@ public:
         m_size = size;
     }
 
+    /*======================================================================*/
+    /**
+     *  Adopts the buffer without copying. The buffer is freed by the deleter
+     *  when the last array sharing it is destroyed.
+     */
+    /*======================================================================*/
+    template <typename Deleter>
+    ValueArray( value_type* values, const size_t size, Deleter deleter ):
+        m_values( values, deleter )
+    {
+        m_size = size;
+    }
+
+public:
+    /*======================================================================*/
+    /**
+     *  Returns the array that takes over the buffer of the vector. The vector
+     *  is left empty. The buffer is taken over without copying only if its
+     *  unused capacity is at most 1/8 of the size, since the whole capacity
+     *  is kept as long as the array is alive. Otherwise, the values are
+     *  copied to a buffer of the exact size and the vector is released.
+     */
+    /*======================================================================*/
+    static ValueArray Adopt( std::vector<T>& values )
+    {
+        if ( values.empty() ) { std::vector<T>().swap( values ); return ValueArray(); }
+
+        if ( values.capacity() - values.size() > values.size() / 8 )
+        {
+            const ValueArray array( &values[0], values.size() );
+            std::vector<T>().swap( values );
+            return array;
+        }
+
+        std::vector<T>* owner = new std::vector<T>();
+        owner->swap( values );
+        return ValueArray( &( *owner )[0], owner->size(), kvs::temporal::VectorDeleter<T>( owner ) );
+    }
+
 public:
     void assign( const value_type* values, const size_t size )
     {
@@ -301,7 +423,7 @@ public:
     value_type* allocate( const size_t size )
     {
         this->release();
-        m_values.reset( new value_type[ size ], kvs::temporal::ArrayDeleter<value_type>() );
+        m_values = kvs::temporal::ArrayAllocator<value_type>::Allocate( size );
         m_size = size;
         return this->data();
     }
@@ -339,7 +461,7 @@ public:
 #else
     void allocate( const size_t size )
     {
-        m_values.reset( new value_type[ size ], kvs::temporal::ArrayDeleter<value_type>() );
+        m_values = kvs::temporal::ArrayAllocator<value_type>::Allocate( size );
         m_size = size;
     }
 #endif
@@ -0,0 +1,534 @@
+/*****************************************************************************/
+/**
+ *  @file   ValueArrayAllocator.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include "ValueArrayAllocator.h"
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <kvs/Platform>
+#include <kvs/Compiler>
+#include <kvs/Mutex>
+#include <kvs/MutexLocker>
+#include <kvs/Assert>
+#if defined ( KVS_PLATFORM_WINDOWS )
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+#if defined ( KVS_PLATFORM_LINUX )
+#include <sys/mman.h>
+#endif
+#if defined ( KVS_COMPILER_VC )
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+
+const size_t MaxPooledSize = 64 * 1024 * 1024;
+const size_t HugePageSize = 2 * 1024 * 1024;
+const size_t SmallSize = 4096;
+const size_t SmallStep = 64;
+
+// Size classes: the multiples of 64 bytes up to 4 KiB, eight steps for each
+// power of two up to MaxPooledSize, and the multiples of the huge page size
+// up to MaxPooledSize.
+const size_t NumberOfSmallClasses = SmallSize / SmallStep;
+const size_t NumberOfLargeClasses = 14 * 8; // 4 KiB x 2^14 = MaxPooledSize
+const size_t NumberOfHugeClasses = MaxPooledSize / HugePageSize;
+const size_t NumberOfClasses = NumberOfSmallClasses + NumberOfLargeClasses + NumberOfHugeClasses;
+
+kvs::ValueArrayAllocator* Current = NULL;
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the default allocator.
+ *  @return pointer to the default allocator
+ *
+ *  The default allocator is never destroyed, since the arrays in the static
+ *  objects can be freed after the exit of the main function.
+ */
+/*===========================================================================*/
+kvs::ValueArrayAllocator* DefaultInstance()
+{
+    static kvs::ValueArrayAllocator* instance = new kvs::ValueArrayAllocator();
+    return instance;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the value rounded up to the multiple of the unit.
+ *  @param  value [in] value
+ *  @param  unit [in] unit (power of two)
+ *  @return rounded value
+ */
+/*===========================================================================*/
+inline size_t RoundUp( const size_t value, const size_t unit )
+{
+    return ( value + unit - 1 ) & ~( unit - 1 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds the value to the counter atomically.
+ *  @param  counter [in/out] counter
+ *  @param  value [in] value (the two's complement for the subtraction)
+ *  @return counter after the addition
+ */
+/*===========================================================================*/
+inline size_t AtomicAdd( size_t* counter, const size_t value )
+{
+#if defined ( KVS_COMPILER_VC )
+#if defined ( KVS_PLATFORM_CPU_64 )
+    return static_cast<size_t>( _InterlockedExchangeAdd64( reinterpret_cast<volatile __int64*>( counter ), value ) ) + value;
+#else
+    return static_cast<size_t>( _InterlockedExchangeAdd( reinterpret_cast<volatile long*>( counter ), value ) ) + value;
+#endif
+#else
+    return __sync_add_and_fetch( counter, value );
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Replaces the counter with the new value if it equals the old value.
+ *  @param  counter [in/out] counter
+ *  @param  old_value [in] expected value
+ *  @param  new_value [in] new value
+ *  @return true, if the counter is replaced
+ */
+/*===========================================================================*/
+inline bool AtomicCompareSwap( size_t* counter, const size_t old_value, const size_t new_value )
+{
+#if defined ( KVS_COMPILER_VC )
+#if defined ( KVS_PLATFORM_CPU_64 )
+    return static_cast<size_t>( _InterlockedCompareExchange64( reinterpret_cast<volatile __int64*>( counter ), new_value, old_value ) ) == old_value;
+#else
+    return static_cast<size_t>( _InterlockedCompareExchange( reinterpret_cast<volatile long*>( counter ), new_value, old_value ) ) == old_value;
+#endif
+#else
+    return __sync_bool_compare_and_swap( counter, old_value, new_value );
+#endif
+}
+
+inline size_t AtomicLoad( size_t* counter ) { return ::AtomicAdd( counter, 0 ); }
+inline void AtomicSubtract( size_t* counter, const size_t value ) { ::AtomicAdd( counter, ~value + 1 ); }
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the value to the counter atomically.
+ *  @param  counter [in/out] counter
+ *  @param  value [in] value
+ */
+/*===========================================================================*/
+inline void AtomicStore( size_t* counter, const size_t value )
+{
+    size_t old_value = ::AtomicLoad( counter );
+    while ( !::AtomicCompareSwap( counter, old_value, value ) ) { old_value = ::AtomicLoad( counter ); }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Raises the counter to the value atomically.
+ *  @param  counter [in/out] counter
+ *  @param  value [in] value
+ */
+/*===========================================================================*/
+inline void AtomicMax( size_t* counter, const size_t value )
+{
+    size_t old_value = ::AtomicLoad( counter );
+    while ( old_value < value && !::AtomicCompareSwap( counter, old_value, value ) ) { old_value = ::AtomicLoad( counter ); }
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new Statistics class.
+ */
+/*===========================================================================*/
+ValueArrayAllocator::Statistics::Statistics():
+    allocations( 0 ),
+    deallocations( 0 ),
+    pool_hits( 0 ),
+    allocated_bytes( 0 ),
+    used_bytes( 0 ),
+    peak_used_bytes( 0 ),
+    pooled_bytes( 0 ),
+    system_bytes( 0 )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the allocator used by kvs::ValueArray.
+ *  @return pointer to the allocator
+ */
+/*===========================================================================*/
+ValueArrayAllocator* ValueArrayAllocator::Instance()
+{
+    return ::Current ? ::Current : ::DefaultInstance();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the allocator used by kvs::ValueArray.
+ *  @param  allocator [in] pointer to the allocator (NULL: default allocator)
+ *
+ *  The buffers are freed by the allocator that allocated them, so that the
+ *  allocator must not be destroyed while the arrays allocated by it are alive.
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::SetInstance( ValueArrayAllocator* allocator )
+{
+    ::Current = allocator;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Free list of the buffers of a size class.
+ */
+/*===========================================================================*/
+struct ValueArrayAllocator::Bucket
+{
+    kvs::Mutex mutex; ///< mutex for the buffers
+    size_t size; ///< size of the buffers in bytes
+    std::vector<void*> buffers; ///< freed buffers
+
+    Bucket(): size( 0 ) {}
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new ValueArrayAllocator class.
+ *  @param  alignment [in] alignment of the buffers in bytes (power of two)
+ *  @param  huge_page_threshold [in] min. bytes backed by huge pages (0: disabled)
+ */
+/*===========================================================================*/
+ValueArrayAllocator::ValueArrayAllocator( const size_t alignment, const size_t huge_page_threshold ):
+    m_alignment( alignment < sizeof( void* ) ? sizeof( void* ) : alignment ),
+    m_huge_page_threshold( huge_page_threshold ),
+    m_pool_capacity( 0 ),
+    m_buckets( new Bucket [ ::NumberOfClasses ] )
+{
+    KVS_ASSERT( ( alignment & ( alignment - 1 ) ) == 0 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Destroys the ValueArrayAllocator class.
+ */
+/*===========================================================================*/
+ValueArrayAllocator::~ValueArrayAllocator()
+{
+    this->releasePool();
+    delete [] m_buckets;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets the max. bytes of the buffers kept in the pool.
+ *  @param  bytes [in] capacity in bytes (0: no pooling)
+ *
+ *  The pool is disabled by default, so that the freed buffers are returned to
+ *  the system immediately.
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::setPoolCapacity( const size_t bytes )
+{
+    ::AtomicStore( &m_pool_capacity, bytes );
+    this->trim_pool( bytes );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Allocates a buffer.
+ *  @param  bytes [in] size of the buffer in bytes
+ *  @return pointer to the aligned buffer
+ *
+ *  std::bad_alloc is thrown if the memory cannot be allocated, like new[].
+ */
+/*===========================================================================*/
+void* ValueArrayAllocator::allocate( const size_t bytes )
+{
+    size_t index = 0;
+    const size_t size = this->size_class( bytes, &index );
+
+    ::AtomicAdd( &m_statistics.allocations, 1 );
+    ::AtomicAdd( &m_statistics.allocated_bytes, bytes );
+    ::AtomicMax( &m_statistics.peak_used_bytes, ::AtomicAdd( &m_statistics.used_bytes, size ) );
+
+    if ( index < ::NumberOfClasses )
+    {
+        void* pointer = NULL;
+        {
+            Bucket& bucket = m_buckets[ index ];
+            kvs::MutexLocker locker( &bucket.mutex );
+            if ( !bucket.buffers.empty() )
+            {
+                pointer = bucket.buffers.back();
+                bucket.buffers.pop_back();
+            }
+        }
+
+        if ( pointer )
+        {
+            ::AtomicAdd( &m_statistics.pool_hits, 1 );
+            ::AtomicSubtract( &m_statistics.pooled_bytes, size );
+            return pointer;
+        }
+    }
+
+    ::AtomicAdd( &m_statistics.system_bytes, size );
+    void* pointer = this->allocate_memory( size, this->alignment_of( size ) );
+    if ( !pointer )
+    {
+        ::AtomicSubtract( &m_statistics.allocations, 1 );
+        ::AtomicSubtract( &m_statistics.allocated_bytes, bytes );
+        ::AtomicSubtract( &m_statistics.used_bytes, size );
+        ::AtomicSubtract( &m_statistics.system_bytes, size );
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Deallocates the buffer.
+ *  @param  pointer [in] pointer to the buffer allocated by this allocator
+ *  @param  bytes [in] size of the buffer in bytes specified at allocation
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::deallocate( void* pointer, const size_t bytes )
+{
+    if ( !pointer ) { return; }
+
+    size_t index = 0;
+    const size_t size = this->size_class( bytes, &index );
+
+    ::AtomicAdd( &m_statistics.deallocations, 1 );
+    ::AtomicSubtract( &m_statistics.used_bytes, size );
+
+    if ( index < ::NumberOfClasses )
+    {
+        // Reserve the room in the pool before the buffer is pushed.
+        const size_t capacity = ::AtomicLoad( &m_pool_capacity );
+        size_t pooled_bytes = ::AtomicLoad( &m_statistics.pooled_bytes );
+        while ( pooled_bytes + size <= capacity )
+        {
+            if ( ::AtomicCompareSwap( &m_statistics.pooled_bytes, pooled_bytes, pooled_bytes + size ) )
+            {
+                Bucket& bucket = m_buckets[ index ];
+                kvs::MutexLocker locker( &bucket.mutex );
+                bucket.size = size;
+                bucket.buffers.push_back( pointer );
+                return;
+            }
+            pooled_bytes = ::AtomicLoad( &m_statistics.pooled_bytes );
+        }
+    }
+
+    ::AtomicSubtract( &m_statistics.system_bytes, size );
+    this->free_memory( pointer, size );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the buffers kept in the pool to the system.
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::releasePool()
+{
+    this->trim_pool( 0 );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the allocation counters.
+ *  @return allocation counters
+ *
+ *  The counters are read one by one while the other threads can update them.
+ */
+/*===========================================================================*/
+ValueArrayAllocator::Statistics ValueArrayAllocator::statistics() const
+{
+    Statistics* counters = const_cast<Statistics*>( &m_statistics );
+    Statistics statistics;
+    statistics.allocations = ::AtomicLoad( &counters->allocations );
+    statistics.deallocations = ::AtomicLoad( &counters->deallocations );
+    statistics.pool_hits = ::AtomicLoad( &counters->pool_hits );
+    statistics.allocated_bytes = ::AtomicLoad( &counters->allocated_bytes );
+    statistics.used_bytes = ::AtomicLoad( &counters->used_bytes );
+    statistics.peak_used_bytes = ::AtomicLoad( &counters->peak_used_bytes );
+    statistics.pooled_bytes = ::AtomicLoad( &counters->pooled_bytes );
+    statistics.system_bytes = ::AtomicLoad( &counters->system_bytes );
+    return statistics;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resets the cumulative counters.
+ *
+ *  The bytes in use, in the pool and from the system are kept, and the peak
+ *  is reset to the bytes in use.
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::resetStatistics()
+{
+    ::AtomicStore( &m_statistics.allocations, 0 );
+    ::AtomicStore( &m_statistics.deallocations, 0 );
+    ::AtomicStore( &m_statistics.pool_hits, 0 );
+    ::AtomicStore( &m_statistics.allocated_bytes, 0 );
+    ::AtomicStore( &m_statistics.peak_used_bytes, ::AtomicLoad( &m_statistics.used_bytes ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Allocates an aligned memory from the system.
+ *  @param  bytes [in] size in bytes (multiple of the alignment)
+ *  @param  alignment [in] alignment in bytes
+ *  @return pointer to the memory (NULL if failed)
+ */
+/*===========================================================================*/
+void* ValueArrayAllocator::allocate_memory( const size_t bytes, const size_t alignment )
+{
+    void* pointer = NULL;
+#if defined ( KVS_PLATFORM_WINDOWS )
+    pointer = _aligned_malloc( bytes, alignment );
+#else
+    if ( posix_memalign( &pointer, alignment, bytes ) != 0 ) { return NULL; }
+#endif
+
+#if defined ( KVS_PLATFORM_LINUX ) && defined ( MADV_HUGEPAGE )
+    if ( alignment >= ::HugePageSize ) { madvise( pointer, bytes, MADV_HUGEPAGE ); }
+#endif
+
+    return pointer;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Frees the memory allocated by allocate_memory.
+ *  @param  pointer [in] pointer to the memory
+ *  @param  bytes [in] size in bytes
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::free_memory( void* pointer, const size_t bytes )
+{
+    (void)bytes;
+#if defined ( KVS_PLATFORM_WINDOWS )
+    _aligned_free( pointer );
+#else
+    free( pointer );
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the size class of the buffer.
+ *  @param  bytes [in] size of the buffer in bytes
+ *  @param  index [out] index of the size class (NumberOfClasses: not pooled)
+ *  @return size of the buffer actually allocated in bytes
+ *
+ *  The small buffers are rounded up to the multiple of 64 bytes, and the large
+ *  buffers to one of eight steps between the powers of two (at most 12.5%
+ *  larger). The buffers backed by huge pages are rounded up to the multiple of
+ *  the huge page size. The buffers larger than MaxPooledSize are not rounded,
+ *  since they are never pooled.
+ */
+/*===========================================================================*/
+size_t ValueArrayAllocator::size_class( const size_t bytes, size_t* index ) const
+{
+    if ( bytes > ::MaxPooledSize )
+    {
+        *index = ::NumberOfClasses;
+        return bytes;
+    }
+
+    if ( m_huge_page_threshold > 0 && bytes >= m_huge_page_threshold )
+    {
+        const size_t size = ::RoundUp( bytes, ::HugePageSize );
+        *index = ::NumberOfSmallClasses + ::NumberOfLargeClasses + size / ::HugePageSize - 1;
+        return size;
+    }
+
+    const size_t size = ::RoundUp( bytes > 0 ? bytes : 1, m_alignment > ::SmallStep ? m_alignment : ::SmallStep );
+    if ( size <= ::SmallSize )
+    {
+        *index = size / ::SmallStep - 1;
+        return size;
+    }
+
+    size_t power = ::SmallSize;
+    size_t level = 0;
+    while ( power <= size / 2 ) { power *= 2; level++; }
+
+    const size_t step = power / 8;
+    const size_t rounded = ::RoundUp( size, step );
+    *index = rounded > ::MaxPooledSize ? ::NumberOfClasses :
+        ::NumberOfSmallClasses + level * 8 + ( rounded - power ) / step - 1;
+    return rounded;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the alignment of the buffer of the size class.
+ *  @param  size [in] size class in bytes
+ *  @return alignment in bytes
+ */
+/*===========================================================================*/
+size_t ValueArrayAllocator::alignment_of( const size_t size ) const
+{
+    if ( m_huge_page_threshold > 0 && size >= m_huge_page_threshold )
+    {
+        return m_alignment > ::HugePageSize ? m_alignment : ::HugePageSize;
+    }
+
+    return m_alignment;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Frees the pooled buffers until the pooled bytes fit the capacity.
+ *  @param  capacity [in] capacity in bytes
+ *
+ *  The buffers are freed from the size class of the largest index, that is,
+ *  the buffers of the large size classes are freed first.
+ */
+/*===========================================================================*/
+void ValueArrayAllocator::trim_pool( const size_t capacity )
+{
+    for ( size_t i = ::NumberOfClasses; i > 0; i-- )
+    {
+        if ( ::AtomicLoad( &m_statistics.pooled_bytes ) <= capacity ) { break; }
+
+        Bucket& bucket = m_buckets[ i - 1 ];
+        kvs::MutexLocker locker( &bucket.mutex );
+        while ( !bucket.buffers.empty() && ::AtomicLoad( &m_statistics.pooled_bytes ) > capacity )
+        {
+            this->free_memory( bucket.buffers.back(), bucket.size );
+            bucket.buffers.pop_back();
+            ::AtomicSubtract( &m_statistics.pooled_bytes, bucket.size );
+            ::AtomicSubtract( &m_statistics.system_bytes, bucket.size );
+        }
+    }
+}
+
+} // end of namespace kvs
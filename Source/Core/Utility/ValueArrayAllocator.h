@@ -0,0 +1,122 @@
+/*****************************************************************************/
+/**
+ *  @file   ValueArrayAllocator.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#ifndef KVS__VALUE_ARRAY_ALLOCATOR_H_INCLUDE
+#define KVS__VALUE_ARRAY_ALLOCATOR_H_INCLUDE
+
+#include <cstddef>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Memory allocator for the buffers of kvs::ValueArray.
+ *
+ *  The buffers of the arrays of the fundamental types are aligned to 64 bytes
+ *  (a cache line, and the width of the widest SIMD registers). When a pool
+ *  capacity is given by setPoolCapacity, the freed buffers are kept in a pool
+ *  by size class and recycled for the following allocations of the same size
+ *  class, so that the buffers allocated and freed every frame are not returned
+ *  to the system. The pool is disabled by default. Each size class has its own
+ *  free list and lock, so that the threads allocating the buffers of different
+ *  sizes do not contend, and the counters are updated atomically. The buffers
+ *  larger than 64 MiB are neither rounded up nor pooled. The buffers larger
+ *  than the huge page threshold can be backed by huge pages (Linux only).
+ *
+ *  The alignment and the huge page threshold are fixed at construction, since
+ *  the size class of a buffer must not change between its allocation and its
+ *  deallocation.
+ *
+ *  The allocator used by kvs::ValueArray can be replaced by SetInstance with
+ *  a derived class that overrides allocate_memory and free_memory.
+ */
+/*===========================================================================*/
+class ValueArrayAllocator
+{
+public:
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Allocation counters.
+     */
+    /*=======================================================================*/
+    struct Statistics
+    {
+        size_t allocations; ///< number of the allocations
+        size_t deallocations; ///< number of the deallocations
+        size_t pool_hits; ///< number of the allocations served from the pool
+        size_t allocated_bytes; ///< total bytes requested by the allocations
+        size_t used_bytes; ///< bytes of the buffers in use
+        size_t peak_used_bytes; ///< max. bytes of the buffers in use
+        size_t pooled_bytes; ///< bytes of the buffers kept in the pool
+        size_t system_bytes; ///< bytes allocated from the system
+
+        Statistics();
+    };
+
+private:
+
+    struct Bucket;
+
+    const size_t m_alignment; ///< alignment in bytes (power of two)
+    const size_t m_huge_page_threshold; ///< min. bytes backed by huge pages (0: disabled)
+    size_t m_pool_capacity; ///< max. bytes kept in the pool (0: no pooling)
+    Bucket* m_buckets; ///< freed buffers by size class
+    Statistics m_statistics; ///< allocation counters (updated atomically)
+
+public:
+
+    static ValueArrayAllocator* Instance();
+    static void SetInstance( ValueArrayAllocator* allocator );
+
+public:
+
+    explicit ValueArrayAllocator( const size_t alignment = 64, const size_t huge_page_threshold = 0 );
+    virtual ~ValueArrayAllocator();
+
+    size_t alignment() const { return m_alignment; }
+    size_t poolCapacity() const { return m_pool_capacity; }
+    size_t hugePageThreshold() const { return m_huge_page_threshold; }
+
+    void setPoolCapacity( const size_t bytes );
+
+    void* allocate( const size_t bytes );
+    void deallocate( void* pointer, const size_t bytes );
+    void releasePool();
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+protected:
+
+    virtual void* allocate_memory( const size_t bytes, const size_t alignment );
+    virtual void free_memory( void* pointer, const size_t bytes );
+
+private:
+
+    size_t size_class( const size_t bytes, size_t* index ) const;
+    size_t alignment_of( const size_t size ) const;
+    void trim_pool( const size_t capacity );
+
+private:
+
+    ValueArrayAllocator( const ValueArrayAllocator& );
+    ValueArrayAllocator& operator =( const ValueArrayAllocator& );
+};
+
+} // end of namespace kvs
+
+#endif // KVS__VALUE_ARRAY_ALLOCATOR_H_INCLUDE
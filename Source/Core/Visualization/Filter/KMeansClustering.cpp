@@ -33,6 +33,7 @@ KMeansClustering::KMeansClustering():
     m_nclusters( 0 ),
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
 }
@@ -50,6 +51,7 @@ KMeansClustering::KMeansClustering( const kvs::TableObject* table ):
     m_nclusters( 0 ),
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
     this->exec( table );
@@ -75,6 +77,7 @@ KMeansClustering::KMeansClustering(
     m_nclusters( nclusters ),
     m_max_iterations( 100 ),
     m_tolerance( 1.e-6 ),
+    m_number_of_threads( 0 ),
     m_cluster_centers( NULL )
 {
     this->exec( table );
@@ -146,6 +149,7 @@ void KMeansClustering::simple_kmeans( const kvs::TableObject* object )
     kmeans.setNumberOfClusters( m_nclusters );
     kmeans.setMaxIterations( m_max_iterations );
     kmeans.setTolerance( m_tolerance );
+    kmeans.setNumberOfThreads( m_number_of_threads );
     kmeans.setInputTableData( object->table() );
     kmeans.run();
 
@@ -174,6 +178,7 @@ void KMeansClustering::fast_kmeans( const kvs::TableObject* object )
     kmeans.setNumberOfClusters( m_nclusters );
     kmeans.setMaxIterations( m_max_iterations );
     kmeans.setTolerance( m_tolerance );
+    kmeans.setNumberOfThreads( m_number_of_threads );
     kmeans.setInputTableData( object->table() );
     kmeans.run();
 
@@ -204,6 +209,7 @@ void KMeansClustering::adaptive_kmeans( const kvs::TableObject* object )
     kmeans.setMaxNumberOfClusters( max_nclusters );
     kmeans.setMaxIterations( m_max_iterations );
     kmeans.setTolerance( m_tolerance );
+    kmeans.setNumberOfThreads( m_number_of_threads );
     kmeans.setInputTableData( object->table() );
     kmeans.run();
 
@@ -57,6 +57,7 @@ private:
     size_t m_nclusters; ///< number of clusters
     size_t m_max_iterations; ///< maximum number of interations
     float m_tolerance; ///< tolerance of distance
+    size_t m_number_of_threads; ///< number of threads (0: number of processors)
     kvs::ValueArray<kvs::Real32>* m_cluster_centers; ///< cluster centers
 
 public:
@@ -77,6 +78,9 @@ public:
     void setNumberOfClusters( const size_t nclusters ) { m_nclusters = nclusters; }
     void setMaxInterations( const size_t max_iterations ) { m_max_iterations = max_iterations; }
     void setTolerance( const float tolerance ) { m_tolerance = tolerance; }
+    void setNumberOfThreads( const size_t nthreads ) { m_number_of_threads = nthreads; }
+
+    size_t numberOfThreads() const { return m_number_of_threads; }
 
     const kvs::ValueArray<kvs::Real32>& clusterCenter( const size_t index ) { return m_cluster_centers[index]; }
 
@@ -513,10 +513,10 @@ void Tubeline::filtering_strip( const kvs::LineObject* line )
         nvertices,
         color_type );
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertices ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( vertices ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
+    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connections ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setColorType( color_type );
@@ -552,10 +552,10 @@ void Tubeline::filtering_uniline( const kvs::LineObject* line )
         nvertices,
         color_type );
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertices ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( vertices ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
+    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connections ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setColorType( color_type );
@@ -627,10 +627,10 @@ void Tubeline::filtering_polyline( const kvs::LineObject* line )
         }
     }
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertices ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( vertices ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
+    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connections ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setColorType( color_type );
@@ -725,10 +725,10 @@ void Tubeline::filtering_segment( const kvs::LineObject* line )
         }
     }
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertices ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( vertices ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
+    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connections ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setColorType( ::GetColorType( line ) );
@@ -0,0 +1,586 @@
+/*****************************************************************************/
+/**
+ *  @file   UnstructuredToStructuredVolume.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#include "UnstructuredToStructuredVolume.h"
+#include <cmath>
+#include <vector>
+#include <kvs/Math>
+#include <kvs/Thread>
+#include <kvs/CellBase>
+#include <kvs/TetrahedralCell>
+#include <kvs/HexahedralCell>
+#include <kvs/QuadraticTetrahedralCell>
+#include <kvs/QuadraticHexahedralCell>
+#include <kvs/PyramidalCell>
+#include <kvs/PrismaticCell>
+#include <kvs/CellTreeLocator>
+
+
+namespace
+{
+
+const float Epsilon = 1.0e-4f; // tolerance of the inside test in the local coordinate
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a new cell interpolator for the volume.
+ *  @param  volume [in] pointer to the unstructured volume object
+ *  @return pointer to the cell interpolator (NULL if not supported)
+ */
+/*===========================================================================*/
+kvs::CellBase* CreateCell( const kvs::UnstructuredVolumeObject* volume )
+{
+    switch ( volume->cellType() )
+    {
+    case kvs::UnstructuredVolumeObject::Tetrahedra: return new kvs::TetrahedralCell( volume );
+    case kvs::UnstructuredVolumeObject::Hexahedra: return new kvs::HexahedralCell( volume );
+    case kvs::UnstructuredVolumeObject::QuadraticTetrahedra: return new kvs::QuadraticTetrahedralCell( volume );
+    case kvs::UnstructuredVolumeObject::QuadraticHexahedra: return new kvs::QuadraticHexahedralCell( volume );
+    case kvs::UnstructuredVolumeObject::Pyramid: return new kvs::PyramidalCell( volume );
+    case kvs::UnstructuredVolumeObject::Prism: return new kvs::PrismaticCell( volume );
+    default: break;
+    }
+
+    return NULL;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns true if the local point is inside the cell.
+ *  @param  type [in] cell type
+ *  @param  local [in] point in the local coordinate
+ *  @return true if the point is inside the cell
+ */
+/*===========================================================================*/
+bool Inside( const kvs::UnstructuredVolumeObject::CellType type, const kvs::Vec3& local )
+{
+    const float x = local.x();
+    const float y = local.y();
+    const float z = local.z();
+    switch ( type )
+    {
+    case kvs::UnstructuredVolumeObject::Tetrahedra:
+    case kvs::UnstructuredVolumeObject::QuadraticTetrahedra:
+    {
+        return x >= -::Epsilon && y >= -::Epsilon && z >= -::Epsilon && x + y + z <= 1 + ::Epsilon;
+    }
+    case kvs::UnstructuredVolumeObject::Hexahedra:
+    case kvs::UnstructuredVolumeObject::QuadraticHexahedra:
+    {
+        return x >= -::Epsilon && y >= -::Epsilon && z >= -::Epsilon &&
+               x <= 1 + ::Epsilon && y <= 1 + ::Epsilon && z <= 1 + ::Epsilon;
+    }
+    case kvs::UnstructuredVolumeObject::Prism:
+    {
+        return x >= -::Epsilon && y >= -::Epsilon && z >= -::Epsilon &&
+               x + y <= 1 + ::Epsilon && z <= 1 + ::Epsilon;
+    }
+    case kvs::UnstructuredVolumeObject::Pyramid:
+    {
+        const float half = 0.5f * ( 1 - z ) + ::Epsilon;
+        return z >= -::Epsilon && z <= 1 + ::Epsilon &&
+               kvs::Math::Abs( x ) <= half && kvs::Math::Abs( y ) <= half;
+    }
+    default: break;
+    }
+
+    return false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Grid of the resampled volume.
+ */
+/*===========================================================================*/
+struct Grid
+{
+    kvs::Vec3ui resolution; ///< number of the nodes along each axis
+    kvs::Vec3 min_coord; ///< coordinate of the first node
+    kvs::Vec3 spacing; ///< distance between the nodes
+    kvs::Vec3 scale; ///< reciprocal of the spacing (0 for the flat axis)
+
+    size_t index( const int i, const int j, const int k ) const
+    {
+        return i + resolution.x() * ( j + resolution.y() * static_cast<size_t>( k ) );
+    }
+
+    kvs::Vec3 coord( const int i, const int j, const int k ) const
+    {
+        return kvs::Vec3(
+            min_coord.x() + spacing.x() * i,
+            min_coord.y() + spacing.y() * j,
+            min_coord.z() + spacing.z() * k );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for calculating the ranges of the grid nodes in the cells.
+ */
+/*===========================================================================*/
+class BoundsCalculator : public kvs::Thread
+{
+private:
+
+    const kvs::UnstructuredVolumeObject* m_volume; ///< input volume
+    const ::Grid* m_grid; ///< output grid
+    size_t m_begin; ///< index of the first cell
+    size_t m_end; ///< index of the last cell + 1
+    kvs::Int32* m_bounds; ///< node ranges of the cells (imin, jmin, kmin, imax, jmax, kmax)
+
+public:
+
+    BoundsCalculator(): m_volume( NULL ), m_grid( NULL ), m_begin( 0 ), m_end( 0 ), m_bounds( NULL ) {}
+
+    void setup(
+        const kvs::UnstructuredVolumeObject* volume,
+        const ::Grid* grid,
+        const size_t begin,
+        const size_t end,
+        kvs::Int32* bounds )
+    {
+        m_volume = volume;
+        m_grid = grid;
+        m_begin = begin;
+        m_end = end;
+        m_bounds = bounds;
+    }
+
+    void run()
+    {
+        const kvs::Real32* coords = m_volume->coords().data();
+        const kvs::UInt32* connections = m_volume->connections().data();
+        const size_t nnodes = m_volume->numberOfCellNodes();
+        for ( size_t index = m_begin; index < m_end; index++ )
+        {
+            const kvs::UInt32* cell = connections + nnodes * index;
+            kvs::Vec3 min_coord( coords + 3 * cell[0] );
+            kvs::Vec3 max_coord( min_coord );
+            for ( size_t i = 1; i < nnodes; i++ )
+            {
+                const kvs::Vec3 v( coords + 3 * cell[i] );
+                for ( int j = 0; j < 3; j++ )
+                {
+                    min_coord[j] = kvs::Math::Min( min_coord[j], v[j] );
+                    max_coord[j] = kvs::Math::Max( max_coord[j], v[j] );
+                }
+            }
+
+            kvs::Int32* bounds = m_bounds + 6 * index;
+            for ( int j = 0; j < 3; j++ )
+            {
+                // The range is widened by the tolerance, so that the nodes on
+                // the faces are not missed due to the rounding errors.
+                const float lower = std::ceil( ( min_coord[j] - m_grid->min_coord[j] ) * m_grid->scale[j] - ::Epsilon );
+                const float upper = std::floor( ( max_coord[j] - m_grid->min_coord[j] ) * m_grid->scale[j] + ::Epsilon );
+                const float last = static_cast<float>( m_grid->resolution[j] - 1 );
+                bounds[j] = static_cast<kvs::Int32>( kvs::Math::Clamp( lower, 0.0f, last ) );
+                bounds[j+3] = static_cast<kvs::Int32>( kvs::Math::Clamp( upper, 0.0f, last ) );
+                if ( upper < 0.0f || lower > last ) { bounds[j+3] = bounds[j] - 1; }
+            }
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for rasterizing the cells into a range of the slices.
+ *
+ *  The cells are visited in the order of the cell ID, and a node is written by
+ *  the first cell containing it, so that the result does not depend on the
+ *  number of threads.
+ */
+/*===========================================================================*/
+class CellRasterizer : public kvs::Thread
+{
+private:
+
+    const kvs::UnstructuredVolumeObject* m_volume; ///< input volume
+    const kvs::Real32* m_values; ///< node values of the input volume
+    const ::Grid* m_grid; ///< output grid
+    const kvs::Int32* m_bounds; ///< node ranges of the cells
+    int m_begin; ///< index of the first slice
+    int m_end; ///< index of the last slice + 1
+    kvs::Real32* m_resampled_values; ///< node values of the output grid
+    kvs::UInt8* m_mask; ///< validity of the output nodes
+
+public:
+
+    CellRasterizer():
+        m_volume( NULL ),
+        m_values( NULL ),
+        m_grid( NULL ),
+        m_bounds( NULL ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_resampled_values( NULL ),
+        m_mask( NULL ) {}
+
+    void setup(
+        const kvs::UnstructuredVolumeObject* volume,
+        const kvs::Real32* values,
+        const ::Grid* grid,
+        const kvs::Int32* bounds,
+        const int begin,
+        const int end,
+        kvs::Real32* resampled_values,
+        kvs::UInt8* mask )
+    {
+        m_volume = volume;
+        m_values = values;
+        m_grid = grid;
+        m_bounds = bounds;
+        m_begin = begin;
+        m_end = end;
+        m_resampled_values = resampled_values;
+        m_mask = mask;
+    }
+
+    void run()
+    {
+        kvs::CellBase* cell = ::CreateCell( m_volume );
+        if ( !cell ) { return; }
+
+        const kvs::UnstructuredVolumeObject::CellType type = m_volume->cellType();
+        const kvs::UInt32* connections = m_volume->connections().data();
+        const size_t nnodes = m_volume->numberOfCellNodes();
+        const size_t veclen = m_volume->veclen();
+        const size_t ncells = m_volume->numberOfCells();
+        for ( size_t index = 0; index < ncells; index++ )
+        {
+            const kvs::Int32* bounds = m_bounds + 6 * index;
+            const int kmin = kvs::Math::Max( bounds[2], m_begin );
+            const int kmax = kvs::Math::Min( bounds[5], m_end - 1 );
+            if ( kmin > kmax || bounds[0] > bounds[3] || bounds[1] > bounds[4] ) { continue; }
+
+            bool bound = false;
+            const kvs::UInt32* cell_nodes = connections + nnodes * index;
+            for ( int k = kmin; k <= kmax; k++ )
+            {
+                for ( int j = bounds[1]; j <= bounds[4]; j++ )
+                {
+                    for ( int i = bounds[0]; i <= bounds[3]; i++ )
+                    {
+                        const size_t node = m_grid->index( i, j, k );
+                        if ( m_mask[ node ] ) { continue; }
+
+                        if ( !bound ) { cell->bindCell( static_cast<kvs::UInt32>( index ) ); bound = true; }
+                        cell->setGlobalPoint( m_grid->coord( i, j, k ) );
+                        if ( !::Inside( type, cell->localPoint() ) ) { continue; }
+
+                        const kvs::Real32* weights = cell->interpolationFunctions();
+                        kvs::Real32* value = m_resampled_values + veclen * node;
+                        for ( size_t c = 0; c < veclen; c++ )
+                        {
+                            kvs::Real32 sum = 0.0f;
+                            for ( size_t n = 0; n < nnodes; n++ )
+                            {
+                                sum += weights[n] * m_values[ veclen * cell_nodes[n] + c ];
+                            }
+                            value[c] = sum;
+                        }
+                        m_mask[ node ] = 1;
+                    }
+                }
+            }
+        }
+
+        delete cell;
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new UnstructuredToStructuredVolume class.
+ */
+/*===========================================================================*/
+UnstructuredToStructuredVolume::UnstructuredToStructuredVolume():
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_enable_locator_fallback( false )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new UnstructuredToStructuredVolume class.
+ *  @param  volume [in] pointer to the unstructured volume object
+ *  @param  resolution [in] number of the grid nodes along each axis
+ */
+/*===========================================================================*/
+UnstructuredToStructuredVolume::UnstructuredToStructuredVolume(
+    const kvs::UnstructuredVolumeObject* volume,
+    const kvs::Vec3ui& resolution ):
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_enable_locator_fallback( false )
+{
+    SuperClass::setResolution( resolution );
+    this->exec( volume );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Destroys the UnstructuredToStructuredVolume class.
+ */
+/*===========================================================================*/
+UnstructuredToStructuredVolume::~UnstructuredToStructuredVolume()
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void UnstructuredToStructuredVolume::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Main routine.
+ *  @param  object [in] pointer to the unstructured volume object
+ *  @return pointer to the resampled structured volume object
+ *
+ *  The resolution of the grid must be specified by setResolution in advance.
+ */
+/*===========================================================================*/
+UnstructuredToStructuredVolume::SuperClass* UnstructuredToStructuredVolume::exec( const kvs::ObjectBase* object )
+{
+    if ( !object )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Input object is NULL.");
+        return NULL;
+    }
+
+    const kvs::UnstructuredVolumeObject* volume = kvs::UnstructuredVolumeObject::DownCast( object );
+    if ( !volume )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Input object is not supported.");
+        return NULL;
+    }
+
+    kvs::CellBase* cell = ::CreateCell( volume );
+    if ( !cell )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Not supported cell type.");
+        return NULL;
+    }
+    delete cell;
+
+    const kvs::Vec3ui resolution = SuperClass::resolution();
+    if ( resolution.x() < 2 || resolution.y() < 2 || resolution.z() < 2 )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Resolution must be two or more along each axis.");
+        return NULL;
+    }
+
+    this->resample( volume );
+
+    BaseClass::setSuccess( true );
+    return this;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resamples the values of the volume on the grid.
+ *  @param  volume [in] pointer to the unstructured volume object
+ */
+/*===========================================================================*/
+void UnstructuredToStructuredVolume::resample( const kvs::UnstructuredVolumeObject* volume )
+{
+    const kvs::Real32* coords = volume->coords().data();
+    const size_t nnodes = volume->numberOfNodes();
+    kvs::Vec3 min_coord( coords );
+    kvs::Vec3 max_coord( coords );
+    for ( size_t i = 1; i < nnodes; i++ )
+    {
+        const kvs::Vec3 v( coords + 3 * i );
+        for ( int j = 0; j < 3; j++ )
+        {
+            min_coord[j] = kvs::Math::Min( min_coord[j], v[j] );
+            max_coord[j] = kvs::Math::Max( max_coord[j], v[j] );
+        }
+    }
+
+    ::Grid grid;
+    grid.resolution = SuperClass::resolution();
+    grid.min_coord = min_coord;
+    for ( int j = 0; j < 3; j++ )
+    {
+        grid.spacing[j] = ( max_coord[j] - min_coord[j] ) / ( grid.resolution[j] - 1 );
+        grid.scale[j] = grid.spacing[j] > 0.0f ? 1.0f / grid.spacing[j] : 0.0f;
+    }
+
+    const size_t veclen = volume->veclen();
+    const size_t ngrid_nodes = size_t( grid.resolution.x() ) * grid.resolution.y() * grid.resolution.z();
+    const kvs::ValueArray<kvs::Real32> values = volume->values().toValueArray<kvs::Real32>();
+    kvs::ValueArray<kvs::Real32> resampled_values( ngrid_nodes * veclen );
+    resampled_values.fill( 0 );
+    m_mask.allocate( ngrid_nodes );
+    m_mask.fill( 0 );
+
+    // Node ranges of the cells.
+    const size_t ncells = volume->numberOfCells();
+    std::vector<kvs::Int32> bounds( 6 * ncells );
+    {
+        const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, ncells ) );
+        std::vector< ::BoundsCalculator> calculators( nthreads );
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            const size_t begin = ncells * i / nthreads;
+            const size_t end = ncells * ( i + 1 ) / nthreads;
+            calculators[i].setup( volume, &grid, begin, end, &bounds[0] );
+        }
+
+        kvs::Thread::Run( &calculators[0], nthreads );
+    }
+
+    // Rasterization of the cells. Each thread writes the nodes of its slices.
+    {
+        const size_t nslices = grid.resolution.z();
+        const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, nslices ) );
+        std::vector< ::CellRasterizer> rasterizers( nthreads );
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            const int begin = static_cast<int>( nslices * i / nthreads );
+            const int end = static_cast<int>( nslices * ( i + 1 ) / nthreads );
+            rasterizers[i].setup(
+                volume, values.data(), &grid, &bounds[0], begin, end,
+                resampled_values.data(), m_mask.data() );
+        }
+
+        kvs::Thread::Run( &rasterizers[0], nthreads );
+    }
+
+    if ( m_enable_locator_fallback )
+    {
+        this->locate_missed_nodes( volume, grid.min_coord, grid.spacing, resampled_values );
+    }
+
+    // Min/max values of the valid nodes.
+    kvs::Real64 min_value = 0.0;
+    kvs::Real64 max_value = 0.0;
+    bool first = true;
+    for ( size_t i = 0; i < ngrid_nodes; i++ )
+    {
+        if ( !m_mask[i] ) { continue; }
+
+        const kvs::Real32* value = resampled_values.data() + veclen * i;
+        kvs::Real64 v = value[0];
+        if ( veclen > 1 )
+        {
+            kvs::Real64 magnitude = 0.0;
+            for ( size_t c = 0; c < veclen; c++ ) { magnitude += kvs::Math::Square( kvs::Real64( value[c] ) ); }
+            v = std::sqrt( magnitude );
+        }
+
+        if ( first ) { min_value = max_value = v; first = false; }
+        min_value = kvs::Math::Min( min_value, v );
+        max_value = kvs::Math::Max( max_value, v );
+    }
+
+    SuperClass::setGridTypeToUniform();
+    SuperClass::setVeclen( veclen );
+    SuperClass::setValues( kvs::AnyValueArray( resampled_values ) );
+    SuperClass::setLabel( volume->label() );
+    SuperClass::setUnit( volume->unit() );
+    SuperClass::setMinMaxValues( min_value, max_value );
+    SuperClass::setMinMaxExternalCoords( min_coord, max_coord );
+    SuperClass::updateMinMaxCoords();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Locates the nodes missed by the rasterization with the cell tree.
+ *  @param  volume [in] pointer to the unstructured volume object
+ *  @param  min_coord [in] coordinate of the first grid node
+ *  @param  spacing [in] distance between the grid nodes
+ *  @param  values [in/out] node values of the grid
+ */
+/*===========================================================================*/
+void UnstructuredToStructuredVolume::locate_missed_nodes(
+    const kvs::UnstructuredVolumeObject* volume,
+    const kvs::Vec3& min_coord,
+    const kvs::Vec3& spacing,
+    kvs::ValueArray<kvs::Real32>& values )
+{
+    const kvs::Vec3ui resolution = SuperClass::resolution();
+    std::vector<size_t> nodes;
+    std::vector<kvs::Real32> points;
+    size_t node = 0;
+    for ( size_t k = 0; k < resolution.z(); k++ )
+    {
+        for ( size_t j = 0; j < resolution.y(); j++ )
+        {
+            for ( size_t i = 0; i < resolution.x(); i++, node++ )
+            {
+                if ( m_mask[ node ] ) { continue; }
+
+                nodes.push_back( node );
+                points.push_back( min_coord.x() + spacing.x() * i );
+                points.push_back( min_coord.y() + spacing.y() * j );
+                points.push_back( min_coord.z() + spacing.z() * k );
+            }
+        }
+    }
+
+    if ( nodes.empty() ) { return; }
+
+    kvs::CellTreeLocator locator( volume, m_number_of_threads > 1 );
+    locator.setCacheModeToHalf();
+    locator.setNumberOfThreads( m_number_of_threads );
+    std::vector<int> cell_ids( nodes.size() );
+    locator.findCells( &points[0], nodes.size(), &cell_ids[0] );
+
+    const kvs::ValueArray<kvs::Real32> input_values = volume->values().toValueArray<kvs::Real32>();
+    const kvs::UInt32* connections = volume->connections().data();
+    const size_t nnodes = volume->numberOfCellNodes();
+    const size_t veclen = volume->veclen();
+    kvs::CellBase* cell = locator.cell();
+    for ( size_t i = 0; i < nodes.size(); i++ )
+    {
+        if ( cell_ids[i] < 0 ) { continue; }
+
+        cell->bindCell( static_cast<kvs::UInt32>( cell_ids[i] ) );
+        cell->setGlobalPoint( kvs::Vec3( &points[ 3 * i ] ) );
+
+        const kvs::Real32* weights = cell->interpolationFunctions();
+        const kvs::UInt32* cell_nodes = connections + nnodes * cell_ids[i];
+        kvs::Real32* value = values.data() + veclen * nodes[i];
+        for ( size_t c = 0; c < veclen; c++ )
+        {
+            kvs::Real32 sum = 0.0f;
+            for ( size_t n = 0; n < nnodes; n++ )
+            {
+                sum += weights[n] * input_values[ veclen * cell_nodes[n] + c ];
+            }
+            value[c] = sum;
+        }
+        m_mask[ nodes[i] ] = 1;
+    }
+}
+
+} // end of namespace kvs
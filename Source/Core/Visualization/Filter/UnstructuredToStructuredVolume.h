@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/**
+ *  @file   UnstructuredToStructuredVolume.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/*****************************************************************************/
+#ifndef KVS__UNSTRUCTURED_TO_STRUCTURED_VOLUME_H_INCLUDE
+#define KVS__UNSTRUCTURED_TO_STRUCTURED_VOLUME_H_INCLUDE
+
+#include <kvs/StructuredVolumeObject>
+#include <kvs/UnstructuredVolumeObject>
+#include <kvs/ValueArray>
+#include <kvs/Vector3>
+#include <kvs/FilterBase>
+#include <kvs/Module>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Resampling class from unstructured volume to uniform structured volume.
+ *
+ *  The grid covers the bounding box of the input volume. Each cell is
+ *  rasterized into the grid nodes within its bounding box, and the values of
+ *  the nodes inside the cell are interpolated with the interpolation functions
+ *  of the cell. The nodes outside the volume have zero values and they are
+ *  marked as invalid in the mask. The cells are rasterized in parallel, where
+ *  each thread writes the nodes of its own range of slices.
+ */
+/*===========================================================================*/
+class UnstructuredToStructuredVolume : public kvs::FilterBase, public kvs::StructuredVolumeObject
+{
+    kvsModule( kvs::UnstructuredToStructuredVolume, Filter );
+    kvsModuleBaseClass( kvs::FilterBase );
+    kvsModuleSuperClass( kvs::StructuredVolumeObject );
+
+private:
+
+    size_t m_number_of_threads; ///< number of threads
+    bool m_enable_locator_fallback; ///< flag for locating the missed nodes with the cell tree
+    kvs::ValueArray<kvs::UInt8> m_mask; ///< validity of the grid nodes (1: inside the volume)
+
+public:
+
+    UnstructuredToStructuredVolume();
+    UnstructuredToStructuredVolume(
+        const kvs::UnstructuredVolumeObject* volume,
+        const kvs::Vec3ui& resolution );
+    virtual ~UnstructuredToStructuredVolume();
+
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    bool isEnabledLocatorFallback() const { return m_enable_locator_fallback; }
+    const kvs::ValueArray<kvs::UInt8>& mask() const { return m_mask; }
+
+    void setNumberOfThreads( const size_t nthreads );
+    void setEnabledLocatorFallback( const bool enable ) { m_enable_locator_fallback = enable; }
+    void enableLocatorFallback() { this->setEnabledLocatorFallback( true ); }
+    void disableLocatorFallback() { this->setEnabledLocatorFallback( false ); }
+
+    SuperClass* exec( const kvs::ObjectBase* object );
+
+private:
+
+    void resample( const kvs::UnstructuredVolumeObject* volume );
+    void locate_missed_nodes(
+        const kvs::UnstructuredVolumeObject* volume,
+        const kvs::Vec3& min_coord,
+        const kvs::Vec3& spacing,
+        kvs::ValueArray<kvs::Real32>& values );
+};
+
+} // end of namespace kvs
+
+#endif // KVS__UNSTRUCTURED_TO_STRUCTURED_VOLUME_H_INCLUDE
@@ -17,6 +17,7 @@
 #include <kvs/KVSMLObjectPolygon>
 #include <kvs/Math>
 #include <kvs/Vector3>
+#include <cmath>
 
 
 namespace
@@ -76,6 +77,48 @@ const kvs::PolygonObject::NormalType StringToNormalType( const std::string& norm
     }
 }
 
+/*==========================================================================*/
+/**
+ *  @brief  Returns the normal vectors of the vertices of the STL data.
+ *  @param  stl [in] pointer to the STL format file with the connections
+ *  @return normal vectors averaged over the triangles sharing the vertices
+ */
+/*==========================================================================*/
+kvs::ValueArray<kvs::Real32> VertexNormals( const kvs::Stl* stl )
+{
+    const kvs::ValueArray<kvs::Real32>& facet_normals = stl->normals();
+    const kvs::ValueArray<kvs::UInt32>& connections = stl->connections();
+    const size_t nvertices = stl->coords().size() / 3;
+    const size_t ntriangles = connections.size() / 3;
+
+    kvs::ValueArray<kvs::Real32> normals( nvertices * 3 );
+    normals.fill( 0 );
+    for ( size_t i = 0; i < ntriangles; i++ )
+    {
+        for ( size_t j = 0; j < 3; j++ )
+        {
+            kvs::Real32* normal = normals.data() + 3 * connections[ 3 * i + j ];
+            normal[0] += facet_normals[ 3 * i + 0 ];
+            normal[1] += facet_normals[ 3 * i + 1 ];
+            normal[2] += facet_normals[ 3 * i + 2 ];
+        }
+    }
+
+    for ( size_t i = 0; i < nvertices; i++ )
+    {
+        kvs::Real32* normal = normals.data() + 3 * i;
+        const kvs::Real32 length = std::sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+        if ( length > 0.0f )
+        {
+            normal[0] /= length;
+            normal[1] /= length;
+            normal[2] /= length;
+        }
+    }
+
+    return normals;
+}
+
 } // end of namespace
 
 
@@ -272,11 +315,23 @@ void PolygonImporter::import( const kvs::Stl* stl )
 {
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
-    SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal );
     SuperClass::setCoords( stl->coords() );
     SuperClass::setColor( kvs::RGBColor( 255, 255, 255 ) );
-    SuperClass::setNormals( stl->normals() );
     SuperClass::setOpacity( 255 );
+
+    if ( stl->hasConnections() )
+    {
+        // The vertices are shared by the triangles (kvs::Stl::mergeVertices).
+        SuperClass::setNormalType( kvs::PolygonObject::VertexNormal );
+        SuperClass::setNormals( ::VertexNormals( stl ) );
+        SuperClass::setConnections( stl->connections() );
+    }
+    else
+    {
+        SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal );
+        SuperClass::setNormals( stl->normals() );
+    }
+
     this->set_min_max_coord();
 }
 
@@ -22,17 +22,13 @@
  */
 /*****************************************************************************/
 #include "CellAdjacencyGraphLocator.h"
-#include <kvs/MersenneTwister>
+#include <limits>
 
 
 namespace
 {
 
-size_t RandomCellIndex( const kvs::UnstructuredVolumeObject* volume )
-{
-    kvs::MersenneTwister r( time(0) );
-    return r() * ( volume->numberOfCells() - 1 );
-}
+const size_t MaxRestarts = 16;
 
 kvs::Vec3 CellCenter( const kvs::CellBase* cell )
 {
@@ -110,6 +106,26 @@ bool CellContains( const kvs::CellBase* cell, const kvs::Vec3& p )
     }
 }
 
+kvs::Vec3 RandomPoint( const kvs::CellBase* cell, kvs::MersenneTwister* random )
+{
+    // Barycentric combination of the four corner vertices of the tetrahedron.
+    float weights[4];
+    float sum = 0.0f;
+    for ( size_t i = 0; i < 4; i++ )
+    {
+        weights[i] = static_cast<float>( random->rand() ) + std::numeric_limits<float>::epsilon();
+        sum += weights[i];
+    }
+
+    kvs::Vec3 point( 0, 0, 0 );
+    for ( size_t i = 0; i < 4; i++ )
+    {
+        point += cell->vertices()[i] * ( weights[i] / sum );
+    }
+
+    return point;
+}
+
 struct Line
 {
     kvs::Vec3 start;
@@ -213,6 +229,7 @@ CellAdjacencyGraphLocator::~CellAdjacencyGraphLocator()
 void CellAdjacencyGraphLocator::build()
 {
     KVS_ASSERT( BaseClass::volume() );
+    if ( m_adjacency_graph ) { delete m_adjacency_graph; }
     m_adjacency_graph = new kvs::CellAdjacencyGraph( BaseClass::volume() );
 }
 
@@ -222,54 +239,19 @@ int CellAdjacencyGraphLocator::findCell( const kvs::Vec3 p )
     {
     case CacheOff:
     {
-        // 1 bind some random cell indices, get their center,
-        // find the one closest to the target point
-        unsigned int startindex, temp_startindex;
-        float min = std::numeric_limits<float>::max();
-        float distance;
-        kvs::Vec3 center;
-        for ( size_t i = 0; i < m_nrandtests; i++ )
-        {
-            temp_startindex = ::RandomCellIndex( BaseClass::volume() );
-            BaseClass::cell()->bindCell( temp_startindex );
-            center = ::CellCenter( BaseClass::cell() );
-            distance = ( center - p ).length();
-            if ( distance < min )
-            {
-                min = distance;
-                startindex = temp_startindex;
-            }
-        }
-
-        return this->find_cell( p, startindex );
+        const int start_cellid = this->start_cell( p, BaseClass::cell(), &m_random );
+        return this->find_cell( p, start_cellid, BaseClass::cell(), &m_random );
     }
     case CacheHalf:
     {
         if ( m_hint_cellid == -1 )
         {
-            // 1 bind some random cell indices, get their center,
-            // find the one closest to the target point
-            unsigned int startindex, temp_startindex;
-            float min = std::numeric_limits<float>::max();
-            float distance;
-            kvs::Vec3 center;
-            for ( size_t i = 0; i < m_nrandtests; i ++ )
-            {
-                temp_startindex = ::RandomCellIndex( BaseClass::volume() );
-                BaseClass::cell()->bindCell( temp_startindex );
-                center = ::CellCenter( BaseClass::cell() );
-                distance = ( center - p ).length();
-                if ( distance < min )
-                {
-                    min = distance;
-                    startindex = temp_startindex;
-                }
-            }
-
-            m_hint_cellid = startindex;
+            m_hint_cellid = this->start_cell( p, BaseClass::cell(), &m_random );
         }
 
-        return this->find_cell( p, m_hint_cellid );
+        const int cellid = this->find_cell( p, m_hint_cellid, BaseClass::cell(), &m_random );
+        if ( cellid >= 0 ) { m_hint_cellid = cellid; }
+        return cellid;
     }
     default:
     {
@@ -281,67 +263,167 @@ int CellAdjacencyGraphLocator::findCell( const kvs::Vec3 p )
     return -1;
 }
 
-int CellAdjacencyGraphLocator::find_cell( const kvs::Vec3 p, const int start_cellid )
+/*===========================================================================*/
+/**
+ *  @brief  Finds the cells containing the points without modifying the locator.
+ *  @param  points [in] coordinates of the points
+ *  @param  indices [in] indices of the points to be located in this order
+ *  @param  nindices [in] number of the indices
+ *  @param  cell_ids [out] cell IDs of the points
+ *
+ *  The cell interpolator, the random number generator and the hint cell are
+ *  local to this call. In CacheHalf mode, the walk starts from the cell of the
+ *  previous point.
+ */
+/*===========================================================================*/
+void CellAdjacencyGraphLocator::find_cells(
+    const kvs::Real32* points,
+    const kvs::UInt32* indices,
+    const size_t nindices,
+    int* cell_ids ) const
+{
+    KVS_ASSERT( m_adjacency_graph );
+
+    const CacheMode mode = BaseClass::cacheMode();
+    kvs::CellBase* cell = ( mode == CacheOff || mode == CacheHalf ) ? BaseClass::createCell() : NULL;
+    if ( !cell )
+    {
+        if ( mode != CacheOff && mode != CacheHalf ) { kvsMessageError("Not supported cache mode."); }
+        for ( size_t i = 0; i < nindices; i++ ) { cell_ids[ indices[i] ] = -1; }
+        return;
+    }
+
+    // The seed is the index of the first point of the range. The ranges depend
+    // on the number of threads, and so do the random start cells and restarts.
+    // The result is reproducible for the same points and number of threads.
+    kvs::MersenneTwister random( indices[0] );
+    int hint_cellid = -1;
+    for ( size_t i = 0; i < nindices; i++ )
+    {
+        const kvs::UInt32 index = indices[i];
+        const kvs::Vec3 p( points + 3 * index );
+        if ( mode == CacheOff || hint_cellid == -1 )
+        {
+            hint_cellid = this->start_cell( p, cell, &random );
+        }
+
+        const int cellid = this->find_cell( p, hint_cellid, cell, &random );
+        if ( cellid >= 0 ) { hint_cellid = cellid; }
+        cell_ids[ index ] = cellid;
+    }
+
+    delete cell;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cell closest to the point among the random cells.
+ *  @param  p [in] point
+ *  @param  cell [in] cell interpolator used for binding the cells
+ *  @param  random [in] random number generator
+ *  @return cell ID
+ */
+/*===========================================================================*/
+int CellAdjacencyGraphLocator::start_cell(
+    const kvs::Vec3& p,
+    kvs::CellBase* cell,
+    kvs::MersenneTwister* random ) const
+{
+    // Bind some random cells, and find the one whose center is closest to
+    // the target point.
+    const unsigned long ncells = BaseClass::volume()->numberOfCells();
+    int start_cellid = 0;
+    float min = std::numeric_limits<float>::max();
+    for ( size_t i = 0; i < m_nrandtests; i++ )
+    {
+        const int cellid = static_cast<int>( random->randInteger( ncells - 1 ) );
+        cell->bindCell( cellid );
+        const float distance = ( ::CellCenter( cell ) - p ).length();
+        if ( distance < min )
+        {
+            min = distance;
+            start_cellid = cellid;
+        }
+    }
+
+    return start_cellid;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cell containing the point by walking on the graph.
+ *  @param  p [in] point
+ *  @param  start_cellid [in] cell ID where the walk starts
+ *  @param  cell [in] cell interpolator used for binding the cells
+ *  @param  random [in] random number generator used for degenerate cases
+ *  @return cell ID (-1 if not found)
+ */
+/*===========================================================================*/
+int CellAdjacencyGraphLocator::find_cell(
+    const kvs::Vec3& p,
+    const int start_cellid,
+    kvs::CellBase* cell,
+    kvs::MersenneTwister* random ) const
 {
     switch ( BaseClass::volume()->cellType() )
     {
     case kvs::UnstructuredVolumeObject::QuadraticTetrahedra:
     case kvs::UnstructuredVolumeObject::Tetrahedra:
     {
-        ::Weights w;
-        unsigned int current_faceid;
-        float step = 0;
-        bool found = false;
-
         // 1 starting from the center, find the intersection of the line and polygon
         // 2 from adjacency graph, find which cell to go next
         // 3 go to the next cell, find the outgoing intersection
         // repeat from 2 to 3 util reach the pos
 
-        BaseClass::cell()->bindCell( start_cellid );
-        kvs::Vec3 center = ::CellCenter( BaseClass::cell() );
-        kvs::Vec3 end = p;
+        const kvs::ValueArray<kvs::UInt32>& graph = m_adjacency_graph->graph();
+        const kvs::BitArray& mask = m_adjacency_graph->mask();
+        const size_t ncells = BaseClass::volume()->numberOfCells();
 
-        ::Line line( center, end, 0 ); //initialize the line
+        cell->bindCell( start_cellid );
+        ::Line line( ::CellCenter( cell ), p, 0 ); //initialize the line
+        float step = 0;
+        size_t nrestarts = 0;
         int current_cellid = start_cellid;
-        while (1)
+        for ( size_t nsteps = 0; nsteps <= ncells; nsteps++ )
         {
-            if ( found ) { return current_cellid; }
-
-            if ( ::CellContains( BaseClass::cell(), p ) )
+            cell->bindCell( current_cellid );
+            if ( ::CellContains( cell, p ) ) { return current_cellid; }
+
+            // The line leaves the cell through the face intersected farthest,
+            // since the entering face can also be intersected after the step
+            // due to the rounding errors.
+            int current_faceid = -1;
+            float next_step = step;
+            for ( size_t i = 0; i < 4; i++ )
             {
-                found = true;
-                m_hint_cellid = current_cellid;
-                return current_cellid;
-            }
+                ::Plane plane(
+                    cell->vertices()[ TetCellFaces[ 3*i+0 ] ],
+                    cell->vertices()[ TetCellFaces[ 3*i+1 ] ],
+                    cell->vertices()[ TetCellFaces[ 3*i+2 ] ] );
 
-            BaseClass::cell()->bindCell( current_cellid );
-            for ( size_t i = 0; i < 4; i ++ )
-            {
-                ::Plane p(
-                    BaseClass::cell()->vertices()[TetCellFaces[ 3*i+0 ]],
-                    BaseClass::cell()->vertices()[TetCellFaces[ 3*i+1 ]],
-                    BaseClass::cell()->vertices()[TetCellFaces[ 3*i+2 ]]);
-
-                w = ::LinePlaneIntersection( line, p );
-                if ( w.u >= 0 && w.v >= 0 && w.u + w.v <= 1 && w.t > step )
+                const ::Weights w = ::LinePlaneIntersection( line, plane );
+                if ( w.u >= 0 && w.v >= 0 && w.u + w.v <= 1 && w.t > next_step )
                 {
-                    current_faceid = i;
-                    step = w.t;
-                    break;
+                    current_faceid = static_cast<int>( i );
+                    next_step = w.t;
                 }
+            }
+            step = next_step;
 
-                if ( i == 3 )
-                {
-                    step = 0;
-                    line.start = BaseClass::cell()->randomSampling();
-                    i = 0;
-                }
+            if ( current_faceid < 0 )
+            {
+                // The line passes through an edge or a vertex of the cell,
+                // so restart the line from a random point in the cell.
+                if ( ++nrestarts > ::MaxRestarts ) { return -1; }
+                line.start = ::RandomPoint( cell, random );
+                step = 0;
+                continue;
             }
 
-            if ( m_adjacency_graph->mask()[ 4*current_cellid+current_faceid ] == 1 )
+            const size_t index = 4 * current_cellid + current_faceid;
+            if ( mask[ index ] == 1 )
             {
-                current_cellid = m_adjacency_graph->graph()[ 4*current_cellid+current_faceid ];
+                current_cellid = graph[ index ];
             }
             else // the ray goes out of the volume object
             {
@@ -349,20 +431,20 @@ int CellAdjacencyGraphLocator::find_cell( const kvs::Vec3 p, const int start_cel
                 // do a brute force search along all the external face
                 // find out the step that satisfies
                 // step < 1 and step = max of all the step found
-                // and then set the current index 
-                float step_save = step;
-                for ( size_t i = 0; i < m_adjacency_graph->mask().size(); i++ )
+                // and then set the current index
+                const float step_save = step;
+                for ( size_t i = 0; i < mask.size(); i++ )
                 {
-                    if ( m_adjacency_graph->mask()[i] == 0 )
+                    if ( mask[i] == 0 )
                     {
-                        current_faceid = i % 4;
-                        BaseClass::cell()->bindCell( i / 4 ); //current_cellid = i / 4;
-                        ::Plane p(
-                            BaseClass::cell()->vertices()[TetCellFaces[ 3*current_faceid]],
-                            BaseClass::cell()->vertices()[TetCellFaces[ 3*current_faceid+1 ] ],
-                            BaseClass::cell()->vertices()[TetCellFaces[ 3*current_faceid+2 ] ]);
-                        w = ::LinePlaneIntersection( line, p );
-
+                        const size_t faceid = i % 4;
+                        cell->bindCell( i / 4 );
+                        ::Plane plane(
+                            cell->vertices()[ TetCellFaces[ 3*faceid+0 ] ],
+                            cell->vertices()[ TetCellFaces[ 3*faceid+1 ] ],
+                            cell->vertices()[ TetCellFaces[ 3*faceid+2 ] ] );
+
+                        const ::Weights w = ::LinePlaneIntersection( line, plane );
                         if ( w.u >= 0 && w.v >= 0 && w.u + w.v <= 1 && w.t > step && w.t < 1 )
                         {
                             current_cellid = i / 4;
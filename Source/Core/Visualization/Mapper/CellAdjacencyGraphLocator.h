@@ -23,6 +23,7 @@
 /*****************************************************************************/
 #pragma once
 #include <kvs/CellAdjacencyGraph>
+#include <kvs/MersenneTwister>
 #include "CellLocator.h"
 
 
@@ -40,6 +41,7 @@ private:
     kvs::CellAdjacencyGraph* m_adjacency_graph;
     unsigned int m_nrandtests;
     int m_hint_cellid; // used for cache
+    kvs::MersenneTwister m_random; // used for selecting the start cell
 
 public:
 
@@ -53,9 +55,22 @@ public:
     int findCell( const kvs::Vec3 p );
     void clearCache();
 
+protected:
+
+    void find_cells(
+        const kvs::Real32* points,
+        const kvs::UInt32* indices,
+        const size_t nindices,
+        int* cell_ids ) const;
+
 private:
 
-    int find_cell( const kvs::Vec3 p, const int start_cellid );
+    int start_cell( const kvs::Vec3& p, kvs::CellBase* cell, kvs::MersenneTwister* random ) const;
+    int find_cell(
+        const kvs::Vec3& p,
+        const int start_cellid,
+        kvs::CellBase* cell,
+        kvs::MersenneTwister* random ) const;
 };
 
 } // end of namespace kvs
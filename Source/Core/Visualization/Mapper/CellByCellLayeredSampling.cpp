@@ -36,7 +36,8 @@ CellByCellLayeredSampling::CellByCellLayeredSampling():
     kvs::MapperBase(),
     kvs::PointObject(),
     m_camera( 0 ),
-    m_pregenerated_particles( 0 )
+    m_pregenerated_particles( 0 ),
+    m_seed( 0 )
 {
 }
 
@@ -59,7 +60,8 @@ CellByCellLayeredSampling::CellByCellLayeredSampling(
     kvs::MapperBase( transfer_function ),
     kvs::PointObject(),
     m_camera( 0 ),
-    m_pregenerated_particles( 0 )
+    m_pregenerated_particles( 0 ),
+    m_seed( 0 )
 {
     this->setSubpixelLevel( subpixel_level );
     this->setSamplingStep( sampling_step );
@@ -88,7 +90,8 @@ CellByCellLayeredSampling::CellByCellLayeredSampling(
     kvs::MapperBase( transfer_function ),
     kvs::PointObject(),
     m_camera( 0 ),
-    m_pregenerated_particles( 0 )
+    m_pregenerated_particles( 0 ),
+    m_seed( 0 )
 {
     this->attachCamera( camera );
     this->setSubpixelLevel( subpixel_level );
@@ -141,6 +144,17 @@ float CellByCellLayeredSampling::objectDepth() const
     return m_object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the seed of the random number generator for counting.
+ *  @return seed
+ */
+/*===========================================================================*/
+kvs::UInt32 CellByCellLayeredSampling::seed() const
+{
+    return m_seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Attaches a camera.
@@ -185,6 +199,20 @@ void CellByCellLayeredSampling::setObjectDepth( const float object_depth )
     m_object_depth = object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a seed of the random number generator for counting.
+ *  @param  seed [in] seed
+ *
+ *  The seed is used for rounding the number of particles in each cell, in the
+ *  same way as CellByCellUniformSampling::setSeed.
+ */
+/*===========================================================================*/
+void CellByCellLayeredSampling::setSeed( const kvs::UInt32 seed )
+{
+    m_seed = seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the mapper process.
@@ -277,83 +305,125 @@ void CellByCellLayeredSampling::generate_particles( const kvs::UnstructuredVolum
     this->pregenerate_particles( 800000 );
 
     // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
 
     // Set a tetrahedral cell interpolator.
     kvs::TetrahedralCell* cell = new kvs::TetrahedralCell( volume );
 
-    // Generate particles for each cell.
+    // The particles are generated in two passes. The counting pass calculates
+    // the total number of particles, and the filling pass writes the particles
+    // into the arrays allocated with the exact size. The random number stream
+    // for rounding the number of particles is reseeded at each pass, so that
+    // both passes give the same number of particles in each cell.
+    kvs::Xorshift128 count_random;
+    size_t total_nparticles = 0;
     const size_t ncells = volume->numberOfCells();
-    for ( size_t index = 0; index < ncells; ++index )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        // Bind the cell which is indicated by 'index'.
-        cell->bindCell( index );
-
-        const kvs::Real32* S = cell->scalars();
-        const kvs::Real32 S_min = kvs::Math::Min( S[0], S[1], S[2], S[3] );
-        const kvs::Real32 S_max = kvs::Math::Max( S[0], S[1], S[2], S[3] );
-
-        // Uniform sampling.
-        if ( kvs::Math::Equal( S[0], S[1] ) &&
-             kvs::Math::Equal( S[1], S[2] ) &&
-             kvs::Math::Equal( S[2], S[3] ) )
+        const bool counting = ( pass == 0 );
+        if ( !counting )
         {
-            const float scalar = cell->averagedScalar();
-            const float density = this->calculate_density( scalar );
-            const size_t nparticles = this->calculate_number_of_particles( density, cell );
-
-            this->uniform_sampling(
-                cell, BaseClass::transferFunction(), nparticles,
-                &vertex_coords, &vertex_colors, &vertex_normals );
+            vertex_coords.allocate( total_nparticles * 3 );
+            vertex_colors.allocate( total_nparticles * 3 );
+            vertex_normals.allocate( total_nparticles * 3 );
         }
 
-        // Rejection sampling.
-        else if ( S_max - S_min < TinyValue )
-        {
-            const float scalar = cell->averagedScalar();
-            const float density = this->calculate_density( scalar );
-            const size_t nparticles = this->calculate_number_of_particles( density, cell );
+        kvs::Real32* coords = vertex_coords.data();
+        kvs::UInt8* colors = vertex_colors.data();
+        kvs::Real32* normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
 
-            this->rejection_sampling(
-                cell, BaseClass::transferFunction(), nparticles,
-                &vertex_coords, &vertex_colors, &vertex_normals );
-        }
-
-        // Roulette selection or rejection sampling.
-        else
+        // Generate particles for each cell.
+        for ( size_t index = 0; index < ncells; ++index )
         {
-            this->calculate_particles_in_cell( cell );
+            // Bind the cell which is indicated by 'index'.
+            cell->bindCell( index );
 
-            const size_t N_in = m_selected_particles.nparticles;
-            const size_t N_tet = this->calculate_number_of_particles( N_in );
+            const kvs::Real32* S = cell->scalars();
+            const kvs::Real32 S_min = kvs::Math::Min( S[0], S[1], S[2], S[3] );
+            const kvs::Real32 S_max = kvs::Math::Max( S[0], S[1], S[2], S[3] );
 
-            // All particles are selected from pregenerated particles.
-            if ( N_in > N_tet )
+            // Uniform sampling.
+            if ( kvs::Math::Equal( S[0], S[1] ) &&
+                 kvs::Math::Equal( S[1], S[2] ) &&
+                 kvs::Math::Equal( S[2], S[3] ) )
             {
-                this->roulette_selection(
-                    cell, BaseClass::transferFunction(), N_tet,
-                    &vertex_coords, &vertex_colors, &vertex_normals );
+                const float scalar = cell->averagedScalar();
+                const float density = this->calculate_density( scalar );
+                const size_t nparticles = this->calculate_number_of_particles( density, cell, count_random );
+
+                if ( counting ) { total_nparticles += nparticles; continue; }
+
+                this->uniform_sampling(
+                    cell, BaseClass::transferFunction(), nparticles,
+                    coords, colors, normals );
+
+                coords += nparticles * 3;
+                colors += nparticles * 3;
+                normals += nparticles * 3;
             }
-            else
+
+            // Rejection sampling.
+            else if ( S_max - S_min < TinyValue )
             {
-                this->roulette_selection(
-                    cell, BaseClass::transferFunction(), N_in,
-                    &vertex_coords, &vertex_colors, &vertex_normals );
+                const float scalar = cell->averagedScalar();
+                const float density = this->calculate_density( scalar );
+                const size_t nparticles = this->calculate_number_of_particles( density, cell, count_random );
+
+                if ( counting ) { total_nparticles += nparticles; continue; }
 
                 this->rejection_sampling(
-                    cell, BaseClass::transferFunction(), N_tet - N_in,
-                    &vertex_coords, &vertex_colors, &vertex_normals );
+                    cell, BaseClass::transferFunction(), nparticles,
+                    coords, colors, normals );
+
+                coords += nparticles * 3;
+                colors += nparticles * 3;
+                normals += nparticles * 3;
             }
-        } // end of Roulette selection
-    } // end of for
+
+            // Roulette selection or rejection sampling.
+            else
+            {
+                this->calculate_particles_in_cell( cell );
+
+                const size_t N_in = m_selected_particles.nparticles;
+                const size_t N_tet = this->calculate_number_of_particles( N_in, count_random );
+
+                if ( counting ) { total_nparticles += N_tet; continue; }
+
+                // All particles are selected from pregenerated particles.
+                if ( N_in > N_tet )
+                {
+                    this->roulette_selection(
+                        cell, BaseClass::transferFunction(), N_tet,
+                        coords, colors, normals );
+                }
+                else
+                {
+                    this->roulette_selection(
+                        cell, BaseClass::transferFunction(), N_in,
+                        coords, colors, normals );
+
+                    const size_t offset = N_in * 3;
+                    this->rejection_sampling(
+                        cell, BaseClass::transferFunction(), N_tet - N_in,
+                        coords + offset, colors + offset, normals + offset );
+                }
+
+                coords += N_tet * 3;
+                colors += N_tet * 3;
+                normals += N_tet * 3;
+            } // end of Roulette selection
+        } // end of for
+    } // end of 'pass' for-loop
 
     delete cell;
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 }
 
@@ -456,18 +526,18 @@ void CellByCellLayeredSampling::pregenerate_particles( const size_t nparticles )
  *  @param  cell [in] tetrahedral cell
  *  @param  tfunc [in] transfer function
  *  @param  nparticles [in] number of particles
- *  @param  coords [out] pointer to the coordinate value array
- *  @param  colors [out] pointer to the color value array
- *  @param  normals [out] pointer to the normal vector array
+ *  @param  coords [out] pointer to the coordinate values to be written
+ *  @param  colors [out] pointer to the color values to be written
+ *  @param  normals [out] pointer to the normal vectors to be written
  */
 /*===========================================================================*/
 void CellByCellLayeredSampling::uniform_sampling(
     const kvs::TetrahedralCell* cell,
     const kvs::TransferFunction& tfunc,
     const size_t nparticles,
-    std::vector<kvs::Real32>* coords,
-    std::vector<kvs::UInt8>*  colors,
-    std::vector<kvs::Real32>* normals )
+    kvs::Real32* coords,
+    kvs::UInt8*  colors,
+    kvs::Real32* normals )
 {
     for ( size_t particle = 0; particle < nparticles; ++particle )
     {
@@ -482,17 +552,17 @@ void CellByCellLayeredSampling::uniform_sampling(
         const Vector3f normal( -cell->gradient() );
 
         // set coord, color, and normal to point object( this ).
-        coords->push_back( coord.x() );
-        coords->push_back( coord.y() );
-        coords->push_back( coord.z() );
+        *(coords++) = coord.x();
+        *(coords++) = coord.y();
+        *(coords++) = coord.z();
 
-        colors->push_back( color.r() );
-        colors->push_back( color.g() );
-        colors->push_back( color.b() );
+        *(colors++) = color.r();
+        *(colors++) = color.g();
+        *(colors++) = color.b();
 
-        normals->push_back( normal.x() );
-        normals->push_back( normal.y() );
-        normals->push_back( normal.z() );
+        *(normals++) = normal.x();
+        *(normals++) = normal.y();
+        *(normals++) = normal.z();
     }
 }
 
@@ -502,18 +572,18 @@ void CellByCellLayeredSampling::uniform_sampling(
  *  @param  cell [in] tetrahedral cell
  *  @param  tfunc [in] transfer function
  *  @param  nparticles [in] number of particles
- *  @param  coords [out] pointer to the coordinate value array
- *  @param  colors [out] pointer to the color value array
- *  @param  normals [out] pointer to the normal vector array
+ *  @param  coords [out] pointer to the coordinate values to be written
+ *  @param  colors [out] pointer to the color values to be written
+ *  @param  normals [out] pointer to the normal vectors to be written
  */
 /*===========================================================================*/
 void CellByCellLayeredSampling::rejection_sampling(
     const kvs::TetrahedralCell* cell,
     const kvs::TransferFunction& tfunc,
     const size_t nparticles,
-    std::vector<kvs::Real32>* coords,
-    std::vector<kvs::UInt8>*  colors,
-    std::vector<kvs::Real32>* normals )
+    kvs::Real32* coords,
+    kvs::UInt8*  colors,
+    kvs::Real32* normals )
 {
     const float* S = cell->scalars();
     const float S_min = static_cast<float>( kvs::Math::Min( S[0], S[1], S[2], S[3] ) );
@@ -538,17 +608,17 @@ void CellByCellLayeredSampling::rejection_sampling(
             const Vector3f normal( -cell->gradient() );
 
             // set coord, color, and normal to point object( this ).
-            coords->push_back( coord.x() );
-            coords->push_back( coord.y() );
-            coords->push_back( coord.z() );
+            *(coords++) = coord.x();
+            *(coords++) = coord.y();
+            *(coords++) = coord.z();
 
-            colors->push_back( color.r() );
-            colors->push_back( color.g() );
-            colors->push_back( color.b() );
+            *(colors++) = color.r();
+            *(colors++) = color.g();
+            *(colors++) = color.b();
 
-            normals->push_back( normal.x() );
-            normals->push_back( normal.y() );
-            normals->push_back( normal.z() );
+            *(normals++) = normal.x();
+            *(normals++) = normal.y();
+            *(normals++) = normal.z();
 
             count++;
         }
@@ -561,18 +631,18 @@ void CellByCellLayeredSampling::rejection_sampling(
  *  @param  cell [in] tetrahedral cell
  *  @param  tfunc [in] transfer function
  *  @param  nparticles [in] number of particles
- *  @param  coords [out] pointer to the coordinate value array
- *  @param  colors [out] pointer to the color value array
- *  @param  normals [out] pointer to the normal vector array
+ *  @param  coords [out] pointer to the coordinate values to be written
+ *  @param  colors [out] pointer to the color values to be written
+ *  @param  normals [out] pointer to the normal vectors to be written
  */
 /*===========================================================================*/
 void CellByCellLayeredSampling::roulette_selection(
     const kvs::TetrahedralCell* cell,
     const kvs::TransferFunction& tfunc,
     const size_t nparticles,
-    std::vector<kvs::Real32>* coords,
-    std::vector<kvs::UInt8>*  colors,
-    std::vector<kvs::Real32>* normals )
+    kvs::Real32* coords,
+    kvs::UInt8*  colors,
+    kvs::Real32* normals )
 {
     const float a1 = m_A_matrix[0][0];
     const float a2 = m_A_matrix[1][1];
@@ -611,17 +681,17 @@ void CellByCellLayeredSampling::roulette_selection(
         const kvs::RGBColor color( tfunc.colorMap()[index] );
 
         // Set coord, color, and normal to the point object.
-        coords->push_back( coord.x() );
-        coords->push_back( coord.y() );
-        coords->push_back( coord.z() );
+        *(coords++) = coord.x();
+        *(coords++) = coord.y();
+        *(coords++) = coord.z();
 
-        colors->push_back( color.r() );
-        colors->push_back( color.g() );
-        colors->push_back( color.b() );
+        *(colors++) = color.r();
+        *(colors++) = color.g();
+        *(colors++) = color.b();
 
-        normals->push_back( -g.x() );
-        normals->push_back( -g.y() );
-        normals->push_back( -g.z() );
+        *(normals++) = -g.x();
+        *(normals++) = -g.y();
+        *(normals++) = -g.z();
     }
 }
 
@@ -705,16 +775,18 @@ float CellByCellLayeredSampling::calculate_maximum_density( const float scalar0,
  *  @brief  Calculate number of particles.
  *  @param  density [in] density value
  *  @param  cell [in] pointer to cell
+ *  @param  random [in] random number generator for rounding the number
  *  @return number of particles
  */
 /*===========================================================================*/
 size_t CellByCellLayeredSampling::calculate_number_of_particles(
     const float density,
-    const kvs::TetrahedralCell* cell )
+    const kvs::TetrahedralCell* cell,
+    kvs::Xorshift128& random )
 {
     const float volume_of_cell = cell->volume();
     const float N = density * volume_of_cell;
-    const float R = Generator::GetRandomNumber();
+    const float R = random.rand();
 
     size_t n = static_cast<size_t>( N );
     if ( N - n > R ) { ++n; }
@@ -726,11 +798,13 @@ size_t CellByCellLayeredSampling::calculate_number_of_particles(
 /**
  *  @brief  Calculate required number of particles.
  *  @param  nparticles_in_cell [in] number of particles in cell
+ *  @param  random [in] random number generator for rounding the number
  *  @return required number of particles
  */
 /*===========================================================================*/
 size_t CellByCellLayeredSampling::calculate_number_of_particles(
-    const size_t nparticles_in_cell )
+    const size_t nparticles_in_cell,
+    kvs::Xorshift128& random )
 {
     const size_t N_in = nparticles_in_cell;
     const size_t N_all = m_pregenerated_particles->numberOfVertices();
@@ -740,7 +814,7 @@ size_t CellByCellLayeredSampling::calculate_number_of_particles(
     const float a3 = m_A_matrix[2][2];
     const float detA_inv = 1.0f / kvs::Math::Abs( a1 * a2 * a3 );
     const float N = detA_inv * m_M_value * N_in / N_all;
-    const float R = Generator::GetRandomNumber();
+    const float R = random.rand();
 
     size_t n = static_cast<size_t>( N );
     if ( N - n > R ) { ++n; }
@@ -22,6 +22,7 @@
 #include <kvs/UnstructuredVolumeObject>
 #include <kvs/TetrahedralCell>
 #include <kvs/Module>
+#include <kvs/Xorshift128>
 
 
 namespace kvs
@@ -54,6 +55,7 @@ private:
     float m_object_depth; ///< object depth
     kvs::ValueArray<float> m_density_map; ///< density map
     kvs::PointObject* m_pregenerated_particles; ///< pregenerated particles
+    kvs::UInt32 m_seed; ///< seed of the random number generator for counting
     SelectedParticles m_selected_particles; ///< particles selected from the pregenerated particles
     kvs::Real32 m_M_value;  ///< numerical integration value of density distribution
     kvs::Matrix44f m_L_matrix; ///< conversion matrix
@@ -82,11 +84,13 @@ public:
     size_t subpixelLevel() const;
     float samplingStep() const;
     float objectDepth() const;
+    kvs::UInt32 seed() const;
 
     void attachCamera( const kvs::Camera* camera );
     void setSubpixelLevel( const size_t subpixel_level );
     void setSamplingStep( const float sampling_step );
     void setObjectDepth( const float object_depth );
+    void setSeed( const kvs::UInt32 seed );
 
 private:
 
@@ -97,27 +101,27 @@ private:
         const kvs::TetrahedralCell* cell,
         const kvs::TransferFunction& tfunc,
         const size_t nparticles,
-        std::vector<kvs::Real32>* coords,
-        std::vector<kvs::UInt8>* colors,
-        std::vector<kvs::Real32>* normals );
+        kvs::Real32* coords,
+        kvs::UInt8* colors,
+        kvs::Real32* normals );
     void rejection_sampling(
         const kvs::TetrahedralCell* cell,
         const kvs::TransferFunction& tfunc,
         const size_t nparticles,
-        std::vector<kvs::Real32>* coords,
-        std::vector<kvs::UInt8>* colors,
-        std::vector<kvs::Real32>* normals );
+        kvs::Real32* coords,
+        kvs::UInt8* colors,
+        kvs::Real32* normals );
     void roulette_selection(
         const kvs::TetrahedralCell* cell,
         const kvs::TransferFunction& tfunc,
         const size_t nparticles,
-        std::vector<kvs::Real32>* coords,
-        std::vector<kvs::UInt8>* colors,
-        std::vector<kvs::Real32>* normals );
+        kvs::Real32* coords,
+        kvs::UInt8* colors,
+        kvs::Real32* normals );
     float calculate_density( const float scalar );
     float calculate_maximum_density( const float scalar0, const float scalar1 );
-    size_t calculate_number_of_particles( const float density, const kvs::TetrahedralCell* cell );
-    size_t calculate_number_of_particles( const size_t nparticles_in_cell );
+    size_t calculate_number_of_particles( const float density, const kvs::TetrahedralCell* cell, kvs::Xorshift128& random );
+    size_t calculate_number_of_particles( const size_t nparticles_in_cell, kvs::Xorshift128& random );
     void calculate_particles_in_cell( const kvs::TetrahedralCell* cell );
 };
 
@@ -24,6 +24,7 @@
 #include <kvs/QuadraticHexahedralCell>
 #include <kvs/PyramidalCell>
 #include <kvs/PrismaticCell>
+#include <kvs/Xorshift128>
 
 
 namespace Generator = kvs::CellByCellParticleGenerator;
@@ -40,7 +41,8 @@ namespace kvs
 CellByCellMetropolisSampling::CellByCellMetropolisSampling():
     kvs::MapperBase(),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_seed( 0 )
 {
 }
 
@@ -62,7 +64,8 @@ CellByCellMetropolisSampling::CellByCellMetropolisSampling(
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_seed( 0 )
 {
     this->setSubpixelLevel( subpixel_level );
     this->setSamplingStep( sampling_step );
@@ -89,7 +92,8 @@ CellByCellMetropolisSampling::CellByCellMetropolisSampling(
     const kvs::TransferFunction& transfer_function,
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
-    kvs::PointObject()
+    kvs::PointObject(),
+    m_seed( 0 )
 {
     this->attachCamera( camera );
     this->setSubpixelLevel( subpixel_level );
@@ -141,6 +145,17 @@ float CellByCellMetropolisSampling::objectDepth() const
     return m_object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the seed of the random number generator for counting.
+ *  @return seed
+ */
+/*===========================================================================*/
+kvs::UInt32 CellByCellMetropolisSampling::seed() const
+{
+    return m_seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Attaches a camera.
@@ -185,6 +200,20 @@ void CellByCellMetropolisSampling::setObjectDepth( const float object_depth )
     m_object_depth = object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a seed of the random number generator for counting.
+ *  @param  seed [in] seed
+ *
+ *  The seed is used for rounding the number of particles in each cell, in the
+ *  same way as CellByCellUniformSampling::setSeed.
+ */
+/*===========================================================================*/
+void CellByCellMetropolisSampling::setSeed( const kvs::UInt32 seed )
+{
+    m_seed = seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the mapper process.
@@ -317,9 +346,9 @@ template <typename T>
 void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolumeObject* volume )
 {
     // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
 
     // Set a trilinear interpolator.
     kvs::TrilinearInterpolator interpolator( volume );
@@ -333,110 +362,107 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
     const float* const  density_map = m_density_map.data();
     const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
 
-    // Generate particles for each cell.
+    // The particles are generated in two passes. The counting pass calculates
+    // the total number of particles, and the filling pass writes the particles
+    // into the arrays allocated with the exact size. The random number stream
+    // for rounding the number of particles is reseeded at each pass, so that
+    // both passes give the same number of particles in each cell.
+    kvs::Xorshift128 count_random;
+    size_t total_nparticles = 0;
+    kvs::Real32* coords = NULL;
+    kvs::UInt8* colors = NULL;
+    kvs::Real32* normals = NULL;
     const kvs::Vector3ui ncells( volume->resolution() - kvs::Vector3ui::All(1) );
-    for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
+        const bool counting = ( pass == 0 );
+        if ( !counting )
         {
-            for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
-            {
-                // Calculate a volume of cell.
-                const float volume_of_cell = 1.0f;
+            vertex_coords.allocate( total_nparticles * 3 );
+            vertex_colors.allocate( total_nparticles * 3 );
+            vertex_normals.allocate( total_nparticles * 3 );
+        }
 
-                // Interpolate at the center of gravity of this cell.
-                const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
-                interpolator.attachPoint( cog );
+        coords = vertex_coords.data();
+        colors = vertex_colors.data();
+        normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
 
-                // Calculate a density.
-                const float  average_scalar = interpolator.template scalar<T>();
-                size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
-                average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
-                const float  average_density = density_map[ average_degree ];
+        // Generate particles for each cell.
+        for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+        {
+            for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
+            {
+                for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
+                {
+                    // Calculate a volume of cell.
+                    const float volume_of_cell = 1.0f;
 
-                // Calculate a number of particles in this cell.
-                const float p = average_density * volume_of_cell;
-                size_t nparticles_in_cell = static_cast<size_t>( p );
-                if ( p - nparticles_in_cell > Generator::GetRandomNumber() ) { ++nparticles_in_cell; }
+                    // Interpolate at the center of gravity of this cell.
+                    const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
+                    interpolator.attachPoint( cog );
 
-                if( nparticles_in_cell == 0 ) continue;
+                    // Calculate a density.
+                    const float  average_scalar = interpolator.template scalar<T>();
+                    size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
+                    average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
+                    const float  average_density = density_map[ average_degree ];
 
-                const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
+                    // Calculate a number of particles in this cell.
+                    const float p = average_density * volume_of_cell;
+                    size_t nparticles_in_cell = static_cast<size_t>( p );
+                    if ( p - nparticles_in_cell > count_random.rand() ) { ++nparticles_in_cell; }
 
-                // Calculate itnitial value
-                kvs::Vector3f point( Generator::RandomSamplingInCube( v ) );
-                interpolator.attachPoint( point );
-                float scalar = interpolator.template scalar<T>();
-                size_t degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
-                degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
-                float density = density_map[ degree ];
+                    if ( counting ) { total_nparticles += nparticles_in_cell; continue; }
 
-                kvs::Vector3f point_trial( Generator::RandomSamplingInCube( v ) );
-                interpolator.attachPoint( point_trial );
-                float scalar_trial = interpolator.template scalar<T>();
-                size_t degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
-                degree_trial = kvs::Math::Clamp<size_t>( degree_trial, 0, max_range );
-                float density_trial = density_map[ degree_trial ];
+                    if( nparticles_in_cell == 0 ) continue;
 
-                const size_t max_loop = nparticles_in_cell * 10;
-                for ( size_t i = 0; i < max_loop; i++ )
-                {
-                    point= Generator::RandomSamplingInCube( v );
+                    const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
+
+                    // Calculate itnitial value
+                    kvs::Vector3f point( Generator::RandomSamplingInCube( v ) );
                     interpolator.attachPoint( point );
-                    scalar = interpolator.template scalar<T>();
-                    degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
+                    float scalar = interpolator.template scalar<T>();
+                    size_t degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
                     degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
-                    density = density_map[ degree ];
-                    if ( !kvs::Math::IsZero( density ) ) break;
-                }
+                    float density = density_map[ degree ];
 
-                // Generate N particles.
-                size_t nduplications = 0; // number of duplications
-                size_t counter = 0;
-                while( counter < nparticles_in_cell )
-                {
-                    // Set a trial position and density.
-                    point_trial = Generator::RandomSamplingInCube( v );
+                    kvs::Vector3f point_trial( Generator::RandomSamplingInCube( v ) );
                     interpolator.attachPoint( point_trial );
-                    scalar_trial = interpolator.template scalar<T>();
-                    degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
+                    float scalar_trial = interpolator.template scalar<T>();
+                    size_t degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
                     degree_trial = kvs::Math::Clamp<size_t>( degree_trial, 0, max_range );
-                    density_trial = density_map[ degree_trial ];
+                    float density_trial = density_map[ degree_trial ];
 
-                    // Calculate ratio.
-                    const double ratio = density_trial / density;
+                    const size_t max_loop = nparticles_in_cell * 10;
+                    for ( size_t i = 0; i < max_loop; i++ )
+                    {
+                        point= Generator::RandomSamplingInCube( v );
+                        interpolator.attachPoint( point );
+                        scalar = interpolator.template scalar<T>();
+                        degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
+                        degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
+                        density = density_map[ degree ];
+                        if ( !kvs::Math::IsZero( density ) ) break;
+                    }
 
-                    if( ratio >= 1.0 )
+                    // Generate N particles.
+                    size_t nduplications = 0; // number of duplications
+                    size_t counter = 0;
+                    while( counter < nparticles_in_cell )
                     {
-                        // Accept the trial point.
+                        // Set a trial position and density.
+                        point_trial = Generator::RandomSamplingInCube( v );
                         interpolator.attachPoint( point_trial );
                         scalar_trial = interpolator.template scalar<T>();
+                        degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
+                        degree_trial = kvs::Math::Clamp<size_t>( degree_trial, 0, max_range );
+                        density_trial = density_map[ degree_trial ];
 
-                        // Calculate a color and normal vector of the particle.
-                        const kvs::RGBColor color( color_map.at( scalar_trial ) );
-                        const kvs::Vector3f normal( interpolator.template gradient<T>() );
-
-                        vertex_coords.push_back( point_trial.x() );
-                        vertex_coords.push_back( point_trial.y() );
-                        vertex_coords.push_back( point_trial.z() );
-
-                        vertex_colors.push_back( color.r() );
-                        vertex_colors.push_back( color.g() );
-                        vertex_colors.push_back( color.b() );
-
-                        vertex_normals.push_back( normal.x() );
-                        vertex_normals.push_back( normal.y() );
-                        vertex_normals.push_back( normal.z() );
+                        // Calculate ratio.
+                        const double ratio = density_trial / density;
 
-                        // Update the trial point and density.
-                        point = point_trial;
-                        density = density_trial;
-
-                        counter++;
-                    }
-                    else
-                    {
-                        if( ratio >= Generator::GetRandomNumber() )
+                        if( ratio >= 1.0 )
                         {
                             // Accept the trial point.
                             interpolator.attachPoint( point_trial );
@@ -446,17 +472,17 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
                             const kvs::RGBColor color( color_map.at( scalar_trial ) );
                             const kvs::Vector3f normal( interpolator.template gradient<T>() );
 
-                            vertex_coords.push_back( point_trial.x() );
-                            vertex_coords.push_back( point_trial.y() );
-                            vertex_coords.push_back( point_trial.z() );
+                            *(coords++) = point_trial.x();
+                            *(coords++) = point_trial.y();
+                            *(coords++) = point_trial.z();
 
-                            vertex_colors.push_back( color.r() );
-                            vertex_colors.push_back( color.g() );
-                            vertex_colors.push_back( color.b() );
+                            *(colors++) = color.r();
+                            *(colors++) = color.g();
+                            *(colors++) = color.b();
 
-                            vertex_normals.push_back( normal.x() );
-                            vertex_normals.push_back( normal.y() );
-                            vertex_normals.push_back( normal.z() );
+                            *(normals++) = normal.x();
+                            *(normals++) = normal.y();
+                            *(normals++) = normal.z();
 
                             // Update the trial point and density.
                             point = point_trial;
@@ -466,43 +492,86 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
                         }
                         else
                         {
-#ifdef DUPLICATION
-                            // Accept the current point.
-                            interpolator.attachPoint( point );
-                            scalar = interpolator.template scalar<T>();
-
-                            // Calculate a color and normal vector of the particle.
-                            const kvs::RGBColor color( color_map.at( scalar ) );
-                            const kvs::Vector3f normal( interpolator.template gradient<T>() );
-
-                            vertex_coords.push_back( point_trial.x() );
-                            vertex_coords.push_back( point_trial.y() );
-                            vertex_coords.push_back( point_trial.z() );
-
-                            vertex_colors.push_back( color.r() );
-                            vertex_colors.push_back( color.g() );
-                            vertex_colors.push_back( color.b() );
-
-                            vertex_normals.push_back( normal.x() );
-                            vertex_normals.push_back( normal.y() );
-                            vertex_normals.push_back( normal.z() );
-
-                            counter++;
-#else
-                            nduplications++;
-                            if ( nduplications > max_loop ) break;
-                            continue;
-#endif
+                            if( ratio >= Generator::GetRandomNumber() )
+                            {
+                                // Accept the trial point.
+                                interpolator.attachPoint( point_trial );
+                                scalar_trial = interpolator.template scalar<T>();
+
+                                // Calculate a color and normal vector of the particle.
+                                const kvs::RGBColor color( color_map.at( scalar_trial ) );
+                                const kvs::Vector3f normal( interpolator.template gradient<T>() );
+
+                                *(coords++) = point_trial.x();
+                                *(coords++) = point_trial.y();
+                                *(coords++) = point_trial.z();
+
+                                *(colors++) = color.r();
+                                *(colors++) = color.g();
+                                *(colors++) = color.b();
+
+                                *(normals++) = normal.x();
+                                *(normals++) = normal.y();
+                                *(normals++) = normal.z();
+
+                                // Update the trial point and density.
+                                point = point_trial;
+                                density = density_trial;
+
+                                counter++;
+                            }
+                            else
+                            {
+    #ifdef DUPLICATION
+                                // Accept the current point.
+                                interpolator.attachPoint( point );
+                                scalar = interpolator.template scalar<T>();
+
+                                // Calculate a color and normal vector of the particle.
+                                const kvs::RGBColor color( color_map.at( scalar ) );
+                                const kvs::Vector3f normal( interpolator.template gradient<T>() );
+
+                                *(coords++) = point_trial.x();
+                                *(coords++) = point_trial.y();
+                                *(coords++) = point_trial.z();
+
+                                *(colors++) = color.r();
+                                *(colors++) = color.g();
+                                *(colors++) = color.b();
+
+                                *(normals++) = normal.x();
+                                *(normals++) = normal.y();
+                                *(normals++) = normal.z();
+
+                                counter++;
+    #else
+                                nduplications++;
+                                if ( nduplications > max_loop ) break;
+                                continue;
+    #endif
+                            }
                         }
-                    }
-                } // end of 'paricle' while-loop
-            } // end of 'x' loop
-        } // end of 'y' loop
-    } // end of 'z' loop
-
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+                    } // end of 'paricle' while-loop
+                } // end of 'x' loop
+            } // end of 'y' loop
+        } // end of 'z' loop
+    } // end of 'pass' loop
+
+    // The number of particles can be less than the counted number when the
+    // random walk in the cell is terminated. The particles are copied into the
+    // arrays with the exact size in that case, so that the over-allocated
+    // buffers are released.
+    const size_t nparticles = static_cast<size_t>( coords - vertex_coords.data() ) / 3;
+    if ( nparticles < total_nparticles )
+    {
+        vertex_coords = kvs::ValueArray<kvs::Real32>( vertex_coords.data(), nparticles * 3 );
+        vertex_colors = kvs::ValueArray<kvs::UInt8>( vertex_colors.data(), nparticles * 3 );
+        vertex_normals = kvs::ValueArray<kvs::Real32>( vertex_normals.data(), nparticles * 3 );
+    }
+
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 }
 
@@ -514,11 +583,6 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::StructuredVolu
 /*===========================================================================*/
 void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVolumeObject* volume )
 {
-    // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
-
     // Set a tetrahedral cell interpolator.
     kvs::CellBase* cell = NULL;
     switch ( volume->cellType() )
@@ -569,101 +633,100 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVo
     const float* const  density_map = m_density_map.data();
     const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
 
-    // Generate particles for each cell.
+    // Vertex data arrays. (output)
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
+
+    // The particles are generated in two passes in the same way as the
+    // structured volume.
+    kvs::Xorshift128 count_random;
+    size_t total_nparticles = 0;
+    kvs::Real32* coords = NULL;
+    kvs::UInt8* colors = NULL;
+    kvs::Real32* normals = NULL;
     const size_t ncells = volume->numberOfCells();
-    for ( size_t index = 0; index < ncells; ++index )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        // Bind the cell which is indicated by 'index'.
-        cell->bindCell( index );
-
-        // Calculate a density.
-        const float  average_scalar = cell->averagedScalar();
-        size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
-        average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
-        const float  average_density = density_map[ average_degree ];
-
-        // Calculate a number of particles in this cell.
-        const float volume_of_cell = cell->volume();
-        const float p = average_density * volume_of_cell;
-        size_t nparticles_in_cell = static_cast<size_t>( p );
-
-        if ( p - nparticles_in_cell > Generator::GetRandomNumber() ) { ++nparticles_in_cell; }
-        if( nparticles_in_cell == 0 ) continue;
-
-        // Calculate itnitial value
-        /* NOTE: The gradient vector of the cell is reversed for shading on the rendering process.
-         */
-        kvs::Vector3f point = cell->randomSampling();
-        float         scalar = cell->scalar();
-        size_t        degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
-        degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
-        float         density = density_map[ degree ];
-        kvs::Vector3f g = -cell->gradient();
-
-        kvs::Vector3f point_trial;
-        float         scalar_trial;
-        size_t        degree_trial;
-        float         density_trial;
-        kvs::Vector3f g_trial;
-
-        const size_t max_loop = nparticles_in_cell * 10;
-        for ( size_t i = 0; i < max_loop; i++ )
+        const bool counting = ( pass == 0 );
+        if ( !counting )
         {
-            point = cell->randomSampling();
-            degree = static_cast< size_t >( ( cell->scalar() - min_value ) * normalize_factor );
-            degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
-            density = density_map[ degree ];
-            g = -cell->gradient();
-            if ( !kvs::Math::IsZero( density ) ) break;
+            vertex_coords.allocate( total_nparticles * 3 );
+            vertex_colors.allocate( total_nparticles * 3 );
+            vertex_normals.allocate( total_nparticles * 3 );
         }
 
-        //Generate N particles
-        size_t nduplications = 0; // number of duplications
-        size_t counter = 0;
-        while ( counter < nparticles_in_cell )
-        {
-            //set trial position and density
-            point_trial = cell->randomSampling();
-            scalar_trial = cell->scalar();
-            degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
-            degree_trial = kvs::Math::Clamp<size_t>( degree_trial, 0, max_range );
-            density_trial = density_map[ degree_trial ];
-            g_trial = -cell->gradient();
-
-            //calculate ratio
-            double ratio = density_trial / density;
-
-            if ( ratio >= 1.0 ) // accept trial point
-            {
-                // calculate color
-                const kvs::RGBColor color( color_map.at( scalar_trial ) );
+        coords = vertex_coords.data();
+        colors = vertex_colors.data();
+        normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
 
-                // calculate normal
-                const kvs::Vector3f normal( g_trial );
+        // Generate particles for each cell.
+        for ( size_t index = 0; index < ncells; ++index )
+        {
+            // Bind the cell which is indicated by 'index'.
+            cell->bindCell( index );
+
+            // Calculate a density.
+            const float  average_scalar = cell->averagedScalar();
+            size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
+            average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
+            const float  average_density = density_map[ average_degree ];
+
+            // Calculate a number of particles in this cell.
+            const float volume_of_cell = cell->volume();
+            const float p = average_density * volume_of_cell;
+            size_t nparticles_in_cell = static_cast<size_t>( p );
+
+            if ( p - nparticles_in_cell > count_random.rand() ) { ++nparticles_in_cell; }
+
+            if ( counting ) { total_nparticles += nparticles_in_cell; continue; }
+            if( nparticles_in_cell == 0 ) continue;
+
+            // Calculate itnitial value
+            /* NOTE: The gradient vector of the cell is reversed for shading on the rendering process.
+             */
+            kvs::Vector3f point = cell->randomSampling();
+            float         scalar = cell->scalar();
+            size_t        degree = static_cast< size_t >( ( scalar - min_value ) * normalize_factor );
+            degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
+            float         density = density_map[ degree ];
+            kvs::Vector3f g = -cell->gradient();
 
-                vertex_coords.push_back( point_trial.x() );
-                vertex_coords.push_back( point_trial.y() );
-                vertex_coords.push_back( point_trial.z() );
+            kvs::Vector3f point_trial;
+            float         scalar_trial;
+            size_t        degree_trial;
+            float         density_trial;
+            kvs::Vector3f g_trial;
 
-                vertex_colors.push_back( color.r() );
-                vertex_colors.push_back( color.g() );
-                vertex_colors.push_back( color.b() );
+            const size_t max_loop = nparticles_in_cell * 10;
+            for ( size_t i = 0; i < max_loop; i++ )
+            {
+                point = cell->randomSampling();
+                degree = static_cast< size_t >( ( cell->scalar() - min_value ) * normalize_factor );
+                degree = kvs::Math::Clamp<size_t>( degree, 0, max_range );
+                density = density_map[ degree ];
+                g = -cell->gradient();
+                if ( !kvs::Math::IsZero( density ) ) break;
+            }
 
-                vertex_normals.push_back( normal.x() );
-                vertex_normals.push_back( normal.y() );
-                vertex_normals.push_back( normal.z() );
+            //Generate N particles
+            size_t nduplications = 0; // number of duplications
+            size_t counter = 0;
+            while ( counter < nparticles_in_cell )
+            {
+                //set trial position and density
+                point_trial = cell->randomSampling();
+                scalar_trial = cell->scalar();
+                degree_trial = static_cast< size_t >( ( scalar_trial - min_value ) * normalize_factor );
+                degree_trial = kvs::Math::Clamp<size_t>( degree_trial, 0, max_range );
+                density_trial = density_map[ degree_trial ];
+                g_trial = -cell->gradient();
 
-                // update point
-                point = point_trial;
-                degree = degree_trial;
-                density = density_trial;
-                g = g_trial;
+                //calculate ratio
+                double ratio = density_trial / density;
 
-                counter++;
-            }
-            else
-            {
-                if ( ratio >= Generator::GetRandomNumber() ) // accept point trial
+                if ( ratio >= 1.0 ) // accept trial point
                 {
                     // calculate color
                     const kvs::RGBColor color( color_map.at( scalar_trial ) );
@@ -671,17 +734,17 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVo
                     // calculate normal
                     const kvs::Vector3f normal( g_trial );
 
-                    vertex_coords.push_back( point_trial.x() );
-                    vertex_coords.push_back( point_trial.y() );
-                    vertex_coords.push_back( point_trial.z() );
+                    *(coords++) = point_trial.x();
+                    *(coords++) = point_trial.y();
+                    *(coords++) = point_trial.z();
 
-                    vertex_colors.push_back( color.r() );
-                    vertex_colors.push_back( color.g() );
-                    vertex_colors.push_back( color.b() );
+                    *(colors++) = color.r();
+                    *(colors++) = color.g();
+                    *(colors++) = color.b();
 
-                    vertex_normals.push_back( normal.x() );
-                    vertex_normals.push_back( normal.y() );
-                    vertex_normals.push_back( normal.z() );
+                    *(normals++) = normal.x();
+                    *(normals++) = normal.y();
+                    *(normals++) = normal.z();
 
                     // update point
                     point = point_trial;
@@ -691,41 +754,84 @@ void CellByCellMetropolisSampling::generate_particles( const kvs::UnstructuredVo
 
                     counter++;
                 }
-                else // accept current point
+                else
                 {
-#ifdef DUPLICATION
-                    // calculate color
-                    const kvs::RGBColor color( color_map.scalar( degree ) );
+                    if ( ratio >= Generator::GetRandomNumber() ) // accept point trial
+                    {
+                        // calculate color
+                        const kvs::RGBColor color( color_map.at( scalar_trial ) );
 
-                    //calculate normal
-                    const kvs::Vector3f normal( g );
+                        // calculate normal
+                        const kvs::Vector3f normal( g_trial );
 
-                    vertex_coords.push_back( point_trial.x() );
-                    vertex_coords.push_back( point_trial.y() );
-                    vertex_coords.push_back( point_trial.z() );
+                        *(coords++) = point_trial.x();
+                        *(coords++) = point_trial.y();
+                        *(coords++) = point_trial.z();
 
-                    vertex_colors.push_back( color.r() );
-                    vertex_colors.push_back( color.g() );
-                    vertex_colors.push_back( color.b() );
+                        *(colors++) = color.r();
+                        *(colors++) = color.g();
+                        *(colors++) = color.b();
 
-                    vertex_normals.push_back( normal.x() );
-                    vertex_normals.push_back( normal.y() );
-                    vertex_normals.push_back( normal.z() );
+                        *(normals++) = normal.x();
+                        *(normals++) = normal.y();
+                        *(normals++) = normal.z();
 
-                    counter++;
-#else
-                    nduplications++;
-                    if ( nduplications > max_loop ) break;
-                    else continue;
-#endif
+                        // update point
+                        point = point_trial;
+                        degree = degree_trial;
+                        density = density_trial;
+                        g = g_trial;
+
+                        counter++;
+                    }
+                    else // accept current point
+                    {
+    #ifdef DUPLICATION
+                        // calculate color
+                        const kvs::RGBColor color( color_map.scalar( degree ) );
+
+                        //calculate normal
+                        const kvs::Vector3f normal( g );
+
+                        *(coords++) = point_trial.x();
+                        *(coords++) = point_trial.y();
+                        *(coords++) = point_trial.z();
+
+                        *(colors++) = color.r();
+                        *(colors++) = color.g();
+                        *(colors++) = color.b();
+
+                        *(normals++) = normal.x();
+                        *(normals++) = normal.y();
+                        *(normals++) = normal.z();
+
+                        counter++;
+    #else
+                        nduplications++;
+                        if ( nduplications > max_loop ) break;
+                        else continue;
+    #endif
+                    }
                 }
-            }
-        } // end of 'paricle' while-loop
-    } // end of 'cell' for-loop
+            } // end of 'paricle' while-loop
+        } // end of 'cell' for-loop
+    } // end of 'pass' loop
+
+    // The number of particles can be less than the counted number when the
+    // random walk in the cell is terminated. The particles are copied into the
+    // arrays with the exact size in that case, so that the over-allocated
+    // buffers are released.
+    const size_t nparticles = static_cast<size_t>( coords - vertex_coords.data() ) / 3;
+    if ( nparticles < total_nparticles )
+    {
+        vertex_coords = kvs::ValueArray<kvs::Real32>( vertex_coords.data(), nparticles * 3 );
+        vertex_colors = kvs::ValueArray<kvs::UInt8>( vertex_colors.data(), nparticles * 3 );
+        vertex_normals = kvs::ValueArray<kvs::Real32>( vertex_normals.data(), nparticles * 3 );
+    }
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 
     delete cell;
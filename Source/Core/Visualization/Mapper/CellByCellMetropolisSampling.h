@@ -46,6 +46,7 @@ private:
     float m_sampling_step; ///< sampling step in the object coordinate
     float m_object_depth; ///< object depth
     kvs::ValueArray<float> m_density_map; ///< density map
+    kvs::UInt32 m_seed; ///< seed of the random number generator for counting
 
 public:
 
@@ -70,11 +71,13 @@ public:
     size_t subpixelLevel() const;
     float samplingStep() const;
     float objectDepth() const;
+    kvs::UInt32 seed() const;
 
     void attachCamera( const kvs::Camera* camera );
     void setSubpixelLevel( const size_t subpixel_level );
     void setSamplingStep( const float sampling_step );
     void setObjectDepth( const float object_depth );
+    void setSeed( const kvs::UInt32 seed );
 
 private:
 
@@ -20,6 +20,7 @@
 #include <kvs/Vector3>
 #include <kvs/Math>
 #include <kvs/Camera>
+#include <kvs/Xorshift128>
 
 
 namespace kvs
@@ -271,6 +272,17 @@ inline const kvs::Vector3f RandomSamplingInCube( const kvs::Vector3f& v )
     return v + d;
 }
 
+inline const kvs::Vector3f RandomSamplingInCube( const kvs::Vector3f& v, kvs::Xorshift128& random )
+{
+    // The random number stream is given by the caller so that each thread can
+    // draw the particles from its own stream.
+    const float x = random.rand();
+    const float y = random.rand();
+    const float z = random.rand();
+    const kvs::Vector3f d( x, y, z );
+    return v + d;
+}
+
 inline float CalculateObjectDepth( 
     const kvs::Camera& camera, 
     const kvs::ObjectBase& object )
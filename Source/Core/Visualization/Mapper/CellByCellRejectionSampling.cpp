@@ -41,7 +41,8 @@ namespace kvs
 CellByCellRejectionSampling::CellByCellRejectionSampling():
     kvs::MapperBase(),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_seed( 0 )
 {
 }
 
@@ -63,7 +64,8 @@ CellByCellRejectionSampling::CellByCellRejectionSampling(
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_seed( 0 )
 {
     this->setSubpixelLevel( subpixel_level );
     this->setSamplingStep( sampling_step );
@@ -90,7 +92,8 @@ CellByCellRejectionSampling::CellByCellRejectionSampling(
     const kvs::TransferFunction& transfer_function,
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
-    kvs::PointObject()
+    kvs::PointObject(),
+    m_seed( 0 )
 {
     this->attachCamera( camera ),
     this->setSubpixelLevel( subpixel_level );
@@ -142,6 +145,17 @@ float CellByCellRejectionSampling::objectDepth() const
     return m_object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the seed of the random number generator for counting.
+ *  @return seed
+ */
+/*===========================================================================*/
+kvs::UInt32 CellByCellRejectionSampling::seed() const
+{
+    return m_seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Attaches a camera.
@@ -186,6 +200,20 @@ void CellByCellRejectionSampling::setObjectDepth( const float object_depth )
     m_object_depth = object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a seed of the random number generator for counting.
+ *  @param  seed [in] seed
+ *
+ *  The seed is used for rounding the number of particles in each cell, in the
+ *  same way as CellByCellUniformSampling::setSeed.
+ */
+/*===========================================================================*/
+void CellByCellRejectionSampling::setSeed( const kvs::UInt32 seed )
+{
+    m_seed = seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the mapper process.
@@ -315,9 +343,9 @@ template <typename T>
 void CellByCellRejectionSampling::generate_particles( const kvs::StructuredVolumeObject* volume )
 {
     // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
 
     // Set a trilinear interpolator.
     kvs::TrilinearInterpolator interpolator( volume );
@@ -325,84 +353,109 @@ void CellByCellRejectionSampling::generate_particles( const kvs::StructuredVolum
     const T* const pvalues = reinterpret_cast<const T*>( volume->values().data() );
     const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
 
-    // Generate particles for each cell.
+    // The particles are generated in two passes. The counting pass calculates
+    // the total number of particles, and the filling pass writes the particles
+    // into the arrays allocated with the exact size. The random number stream
+    // for rounding the number of particles is reseeded at each pass, so that
+    // both passes give the same number of particles in each cell.
+    kvs::Xorshift128 count_random;
+    size_t total_nparticles = 0;
     const kvs::Vector3ui ncells( volume->resolution() - kvs::Vector3ui::All(1) );
     const size_t ncellnodes = 8;
-    for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
+        const bool counting = ( pass == 0 );
+        if ( !counting )
         {
-            for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
-            {
-                // Interpolate at the center of gravity of this cell.
-                const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
-                interpolator.attachPoint( cog );
-
-                // Calculate a number of particles in this cell.
-                const float volume_of_cell = 1.0f;
-                const float averaged_scalar = interpolator.template scalar<T>();
-                const float density = this->calculate_density( averaged_scalar );
-                const size_t nparticles = this->calculate_number_of_particles( density, volume_of_cell );
-
-                const kvs::UInt32* const index =interpolator.indices();
-                const T S[8] = {
-                    pvalues[index[0]], pvalues[index[1]], pvalues[index[2]], pvalues[index[3]],
-                    pvalues[index[4]], pvalues[index[5]], pvalues[index[6]], pvalues[index[7]] };
-                T S_min = S[0];
-                T S_max = S[0];
-                for ( size_t i = 1; i < ncellnodes; i++ )
-                {
-                    S_min = kvs::Math::Min( S_min, S[i] );
-                    S_max = kvs::Math::Max( S_max, S[i] );
-                }
-                const float s_min = static_cast<float>( S_min );
-                const float s_max = static_cast<float>( S_max );
-                const float p_max = this->calculate_maximum_density( s_min, s_max ) / nparticles;
-
-                // Generate a set of particles in this cell.
-                const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
-                size_t count = 0;
-                while ( count < nparticles )
-                {
-                    const kvs::Vector3f coord( Generator::RandomSamplingInCube( v ) );
-                    interpolator.attachPoint( coord );
+            vertex_coords.allocate( total_nparticles * 3 );
+            vertex_colors.allocate( total_nparticles * 3 );
+            vertex_normals.allocate( total_nparticles * 3 );
+        }
 
-                    const float scalar = interpolator.template scalar<T>();
-                    const float density = this->calculate_density( scalar );
+        kvs::Real32* coords = vertex_coords.data();
+        kvs::UInt8* colors = vertex_colors.data();
+        kvs::Real32* normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
 
-                    const float p = density / nparticles;
-                    const float R = Generator::GetRandomNumber();
-                    if ( p > p_max * R )
+        // Generate particles for each cell.
+        for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+        {
+            for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
+            {
+                for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
+                {
+                    // Interpolate at the center of gravity of this cell.
+                    const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
+                    interpolator.attachPoint( cog );
+
+                    // Calculate a number of particles in this cell.
+                    const float volume_of_cell = 1.0f;
+                    const float averaged_scalar = interpolator.template scalar<T>();
+                    const float density = this->calculate_density( averaged_scalar );
+                    const size_t nparticles = this->calculate_number_of_particles( density, volume_of_cell, count_random );
+
+                    if ( counting ) { total_nparticles += nparticles; continue; }
+
+                    const kvs::UInt32* const index =interpolator.indices();
+                    const T S[8] = {
+                        pvalues[index[0]], pvalues[index[1]], pvalues[index[2]], pvalues[index[3]],
+                        pvalues[index[4]], pvalues[index[5]], pvalues[index[6]], pvalues[index[7]] };
+                    T S_min = S[0];
+                    T S_max = S[0];
+                    for ( size_t i = 1; i < ncellnodes; i++ )
                     {
-                        // Calculate a color.
-                        const kvs::RGBColor color( color_map.at( scalar ) );
-
-                        // Calculate a normal.
-                        const Vector3f normal( interpolator.template gradient<T>() );
-
-                        // set coord, color, and normal to point object( this ).
-                        vertex_coords.push_back( coord.x() );
-                        vertex_coords.push_back( coord.y() );
-                        vertex_coords.push_back( coord.z() );
-
-                        vertex_colors.push_back( color.r() );
-                        vertex_colors.push_back( color.g() );
-                        vertex_colors.push_back( color.b() );
-
-                        vertex_normals.push_back( normal.x() );
-                        vertex_normals.push_back( normal.y() );
-                        vertex_normals.push_back( normal.z() );
-
-                        count++;
+                        S_min = kvs::Math::Min( S_min, S[i] );
+                        S_max = kvs::Math::Max( S_max, S[i] );
                     }
-                } // end of 'paricle' while-loop
-            } // end of 'x' loop
-        } // end of 'y' loop
-    } // end of 'z' loop
-
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+                    const float s_min = static_cast<float>( S_min );
+                    const float s_max = static_cast<float>( S_max );
+                    const float p_max = this->calculate_maximum_density( s_min, s_max ) / nparticles;
+
+                    // Generate a set of particles in this cell.
+                    const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
+                    size_t count = 0;
+                    while ( count < nparticles )
+                    {
+                        const kvs::Vector3f coord( Generator::RandomSamplingInCube( v ) );
+                        interpolator.attachPoint( coord );
+
+                        const float scalar = interpolator.template scalar<T>();
+                        const float density = this->calculate_density( scalar );
+
+                        const float p = density / nparticles;
+                        const float R = Generator::GetRandomNumber();
+                        if ( p > p_max * R )
+                        {
+                            // Calculate a color.
+                            const kvs::RGBColor color( color_map.at( scalar ) );
+
+                            // Calculate a normal.
+                            const Vector3f normal( interpolator.template gradient<T>() );
+
+                            // set coord, color, and normal to point object( this ).
+                            *(coords++) = coord.x();
+                            *(coords++) = coord.y();
+                            *(coords++) = coord.z();
+
+                            *(colors++) = color.r();
+                            *(colors++) = color.g();
+                            *(colors++) = color.b();
+
+                            *(normals++) = normal.x();
+                            *(normals++) = normal.y();
+                            *(normals++) = normal.z();
+
+                            count++;
+                        }
+                    } // end of 'paricle' while-loop
+                } // end of 'x' loop
+            } // end of 'y' loop
+        } // end of 'z' loop
+    } // end of 'pass' loop
+
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 }
 
@@ -414,11 +467,6 @@ void CellByCellRejectionSampling::generate_particles( const kvs::StructuredVolum
 /*===========================================================================*/
 void CellByCellRejectionSampling::generate_particles( const kvs::UnstructuredVolumeObject* volume )
 {
-    // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
-
     // Set a tetrahedral cell interpolator.
     kvs::CellBase* cell = NULL;
     switch ( volume->cellType() )
@@ -463,70 +511,97 @@ void CellByCellRejectionSampling::generate_particles( const kvs::UnstructuredVol
 
     const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
 
-    // Generate particles for each cell.
+    // Vertex data arrays. (output)
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
+
+    // The particles are generated in two passes in the same way as the
+    // structured volume.
+    kvs::Xorshift128 count_random;
+    size_t total_nparticles = 0;
     const size_t ncells = volume->numberOfCells();
     const size_t ncellnodes = volume->numberOfCellNodes();
-    for ( size_t index = 0; index < ncells; ++index )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        // Bind the cell which is indicated by 'index'.
-        cell->bindCell( index );
-
-        // Calculate a number of particles in this cell.
-        const float averaged_scalar = cell->averagedScalar();
-        const float density = this->calculate_density( averaged_scalar );
-        const size_t nparticles = this->calculate_number_of_particles( density, cell->volume() );
-
-        const float* S = cell->scalars();
-        float S_min = S[0];
-        float S_max = S[0];
-        for ( size_t i = 1; i < ncellnodes; i++ )
+        const bool counting = ( pass == 0 );
+        if ( !counting )
         {
-            S_min = kvs::Math::Min( S_min, S[i] );
-            S_max = kvs::Math::Max( S_max, S[i] );
+            vertex_coords.allocate( total_nparticles * 3 );
+            vertex_colors.allocate( total_nparticles * 3 );
+            vertex_normals.allocate( total_nparticles * 3 );
         }
-        const float s_min = static_cast<float>( S_min );
-        const float s_max = static_cast<float>( S_max );
-        const float p_max = this->calculate_maximum_density( s_min, s_max ) / nparticles;
 
-        // Generate a set of particles in this cell represented by v0,...,v3 and s0,...,s3.
-        size_t count = 0;
-        while ( count < nparticles )
+        kvs::Real32* coords = vertex_coords.data();
+        kvs::UInt8* colors = vertex_colors.data();
+        kvs::Real32* normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
+
+        // Generate particles for each cell.
+        for ( size_t index = 0; index < ncells; ++index )
         {
-            const kvs::Vector3f coord = cell->randomSampling();
-            const float scalar = cell->scalar();
-            const float density = this->calculate_density( scalar );
+            // Bind the cell which is indicated by 'index'.
+            cell->bindCell( index );
+
+            // Calculate a number of particles in this cell.
+            const float averaged_scalar = cell->averagedScalar();
+            const float density = this->calculate_density( averaged_scalar );
+            const size_t nparticles = this->calculate_number_of_particles( density, cell->volume(), count_random );
+
+            if ( counting ) { total_nparticles += nparticles; continue; }
+
+            const float* S = cell->scalars();
+            float S_min = S[0];
+            float S_max = S[0];
+            for ( size_t i = 1; i < ncellnodes; i++ )
+            {
+                S_min = kvs::Math::Min( S_min, S[i] );
+                S_max = kvs::Math::Max( S_max, S[i] );
+            }
+            const float s_min = static_cast<float>( S_min );
+            const float s_max = static_cast<float>( S_max );
+            const float p_max = this->calculate_maximum_density( s_min, s_max ) / nparticles;
 
-            const float p = density / nparticles;
-            const float R = Generator::GetRandomNumber();
-            if ( p > p_max * R )
+            // Generate a set of particles in this cell represented by v0,...,v3 and s0,...,s3.
+            size_t count = 0;
+            while ( count < nparticles )
             {
-                // Calculate a color.
-                const kvs::RGBColor color( color_map.at( scalar ) );
+                const kvs::Vector3f coord = cell->randomSampling();
+                const float scalar = cell->scalar();
+                const float density = this->calculate_density( scalar );
 
-                // Calculate a normal.
-                const Vector3f normal( cell->gradient() );
+                const float p = density / nparticles;
+                const float R = Generator::GetRandomNumber();
+                if ( p > p_max * R )
+                {
+                    // Calculate a color.
+                    const kvs::RGBColor color( color_map.at( scalar ) );
 
-                // set coord, color, and normal to point object( this ).
-                vertex_coords.push_back( coord.x() );
-                vertex_coords.push_back( coord.y() );
-                vertex_coords.push_back( coord.z() );
+                    // Calculate a normal.
+                    const Vector3f normal( cell->gradient() );
 
-                vertex_colors.push_back( color.r() );
-                vertex_colors.push_back( color.g() );
-                vertex_colors.push_back( color.b() );
+                    // set coord, color, and normal to point object( this ).
+                    *(coords++) = coord.x();
+                    *(coords++) = coord.y();
+                    *(coords++) = coord.z();
 
-                vertex_normals.push_back( normal.x() );
-                vertex_normals.push_back( normal.y() );
-                vertex_normals.push_back( normal.z() );
+                    *(colors++) = color.r();
+                    *(colors++) = color.g();
+                    *(colors++) = color.b();
 
-                count++;
-            }
-        } // end of 'paricle' while-loop
-    } // end of 'cell' for-loop
+                    *(normals++) = normal.x();
+                    *(normals++) = normal.y();
+                    *(normals++) = normal.z();
+
+                    count++;
+                }
+            } // end of 'paricle' while-loop
+        } // end of 'cell' for-loop
+    } // end of 'pass' for-loop
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 
     delete cell;
@@ -571,15 +646,17 @@ float CellByCellRejectionSampling::calculate_density( const float scalar )
  *  @brief  Calculate number of particles.
  *  @param  density [in] density value
  *  @param  volume_of_cell [in] volume of cell
+ *  @param  random [in] random number generator for rounding the number
  *  @return number of particles
  */
 /*===========================================================================*/
 size_t CellByCellRejectionSampling::calculate_number_of_particles(
     const float density,
-    const float volume_of_cell )
+    const float volume_of_cell,
+    kvs::Xorshift128& random )
 {
     const float N = density * volume_of_cell;
-    const float R = Generator::GetRandomNumber();
+    const float R = random.rand();
 
     size_t n = static_cast<size_t>( N );
     if ( N - n > R ) { ++n; }
@@ -23,6 +23,7 @@
 #include <kvs/UnstructuredVolumeObject>
 #include <kvs/ClassName>
 #include <kvs/Module>
+#include <kvs/Xorshift128>
 #include <kvs/CellByCellParticleGenerator>
 
 
@@ -47,6 +48,7 @@ private:
     float m_sampling_step; ///< sampling step in the object coordinate
     float m_object_depth; ///< object depth
     kvs::ValueArray<float> m_density_map; ///< density map
+    kvs::UInt32 m_seed; ///< seed of the random number generator for counting
 
 public:
 
@@ -71,11 +73,13 @@ public:
     size_t subpixelLevel() const;
     float samplingStep() const;
     float objectDepth() const;
+    kvs::UInt32 seed() const;
 
     void attachCamera( const kvs::Camera* camera );
     void setSubpixelLevel( const size_t subpixel_level );
     void setSamplingStep( const float sampling_step );
     void setObjectDepth( const float object_depth );
+    void setSeed( const kvs::UInt32 seed );
 
 private:
 
@@ -84,7 +88,7 @@ private:
     template <typename T> void generate_particles( const kvs::StructuredVolumeObject* volume );
     void generate_particles( const kvs::UnstructuredVolumeObject* volume );
     float calculate_density( const float scalar );
-    size_t calculate_number_of_particles( const float density, const float volume_of_cell );
+    size_t calculate_number_of_particles( const float density, const float volume_of_cell, kvs::Xorshift128& random );
     float calculate_maximum_density( const float scalar0, const float scalar1 );
 };
 
@@ -25,11 +25,266 @@
 #include <kvs/QuadraticHexahedralCell>
 #include <kvs/PyramidalCell>
 #include <kvs/PrismaticCell>
+#include <kvs/Thread>
+#include <kvs/Xorshift128>
 
 
 namespace Generator = kvs::CellByCellParticleGenerator;
 
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Particle generation thread for a range of cells in the structured volume.
+ *
+ *  The particles are generated in two passes. The counting pass calculates the
+ *  number of particles in the range, and the filling pass writes the particles
+ *  directly into the output arrays allocated with the exact size. The random
+ *  numbers for rounding the number of particles in each cell are drawn from a
+ *  separate stream that is reseeded at each pass, so that both passes give the
+ *  same number of particles.
+ */
+/*===========================================================================*/
+template <typename T>
+class StructuredParticleGenerator : public kvs::Thread
+{
+private:
+
+    const kvs::StructuredVolumeObject* m_volume; ///< input volume
+    const kvs::TransferFunction* m_transfer_function; ///< transfer function
+    const float* m_density_map; ///< density map
+    size_t m_begin; ///< first cell index
+    size_t m_end; ///< last cell index + 1
+    kvs::UInt32 m_seed; ///< seed of the random number generators
+    kvs::Xorshift128 m_random; ///< random number generator for sampling
+    kvs::Xorshift128 m_count_random; ///< random number generator for counting
+    size_t m_nparticles; ///< number of particles in the range
+    kvs::Real32* m_coords; ///< output coordinates (NULL: counting pass)
+    kvs::UInt8* m_colors; ///< output colors
+    kvs::Real32* m_normals; ///< output normals
+
+public:
+
+    StructuredParticleGenerator() {}
+    ~StructuredParticleGenerator() {}
+
+public:
+
+    void init(
+        const kvs::StructuredVolumeObject* volume,
+        const kvs::TransferFunction* transfer_function,
+        const float* density_map,
+        const size_t begin,
+        const size_t end,
+        const kvs::UInt32 seed )
+    {
+        m_volume = volume;
+        m_transfer_function = transfer_function;
+        m_density_map = density_map;
+        m_begin = begin;
+        m_end = end;
+        m_seed = seed;
+        m_nparticles = 0;
+        m_coords = NULL;
+        m_colors = NULL;
+        m_normals = NULL;
+    }
+
+    void attachOutputs( kvs::Real32* coords, kvs::UInt8* colors, kvs::Real32* normals )
+    {
+        m_coords = coords;
+        m_colors = colors;
+        m_normals = normals;
+    }
+
+    size_t numberOfParticles() const { return m_nparticles; }
+
+    void run()
+    {
+        // Set a trilinear interpolator.
+        kvs::TrilinearInterpolator interpolator( m_volume );
+
+        // Set parameters for normalization of the node values.
+        const size_t max_range = m_transfer_function->resolution() - 1;
+        const float min_value = m_transfer_function->colorMap().minValue();
+        const float max_value = m_transfer_function->colorMap().maxValue();
+        const float normalize_factor = m_transfer_function->resolution() / ( max_value - min_value );
+
+        const kvs::ColorMap& color_map = m_transfer_function->colorMap();
+
+        // Reset the random number streams, so that the filling pass replays the
+        // counting pass.
+        const bool counting = ( m_coords == NULL );
+        m_random.setSeed( m_seed );
+        m_count_random.setSeed( ~m_seed );
+
+        kvs::Real32* coords = m_coords;
+        kvs::UInt8* colors = m_colors;
+        kvs::Real32* normals = m_normals;
+        size_t nparticles = 0;
+
+        // Generate particles for each cell in [m_begin, m_end).
+        const kvs::Vector3ui ncells( m_volume->resolution() - kvs::Vector3ui::All(1) );
+        const size_t line_size = ncells.x();
+        const size_t slice_size = ncells.x() * ncells.y();
+        for ( size_t index = m_begin; index < m_end; ++index )
+        {
+            const kvs::UInt32 x = static_cast<kvs::UInt32>( index % line_size );
+            const kvs::UInt32 y = static_cast<kvs::UInt32>( ( index % slice_size ) / line_size );
+            const kvs::UInt32 z = static_cast<kvs::UInt32>( index / slice_size );
+
+            // Calculate a volume of cell.
+            const float volume_of_cell = 1.0f;
+
+            // Interpolate at the center of gravity of this cell.
+            const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
+            interpolator.attachPoint( cog );
+
+            // Calculate a density.
+            const float average_scalar = interpolator.template scalar<T>();
+            size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
+            average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
+            const float density = m_density_map[ average_degree ];
+
+            // Calculate a number of particles in this cell.
+            const float p = density * volume_of_cell;
+            size_t nparticles_in_cell = static_cast<size_t>( p );
+            if ( p - nparticles_in_cell > m_count_random.rand() ) { ++nparticles_in_cell; }
+
+            nparticles += nparticles_in_cell;
+            if ( counting ) { continue; }
+
+            const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
+            for ( size_t particle = 0; particle < nparticles_in_cell; ++particle )
+            {
+                // Calculate a coord.
+                const kvs::Vector3f coord( Generator::RandomSamplingInCube( v, m_random ) );
+
+                // Calculate a color.
+                interpolator.attachPoint( coord );
+                const float scalar = interpolator.template scalar<T>();
+                const kvs::RGBColor color( color_map.at( scalar ) );
+
+                // Calculate a normal.
+                const kvs::Vector3f normal( interpolator.template gradient<T>() );
+
+                *(coords++) = coord.x();
+                *(coords++) = coord.y();
+                *(coords++) = coord.z();
+
+                *(colors++) = color.r();
+                *(colors++) = color.g();
+                *(colors++) = color.b();
+
+                *(normals++) = normal.x();
+                *(normals++) = normal.y();
+                *(normals++) = normal.z();
+            } // end of 'paricle' for-loop
+        } // end of 'cell' for-loop
+
+        m_nparticles = nparticles;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Generates particles for the structured volume object.
+ *  @param  mapper [in] pointer to the mapper (output point object)
+ *  @param  volume [in] pointer to the input volume object
+ *  @param  density_map [in] density map
+ */
+/*===========================================================================*/
+template <typename T>
+void GenerateParticles(
+    kvs::CellByCellUniformSampling* mapper,
+    const kvs::StructuredVolumeObject* volume,
+    const kvs::ValueArray<float>& density_map )
+{
+    // Partition the cells into contiguous ranges, one for each thread.
+    const kvs::Vector3ui ncells( volume->resolution() - kvs::Vector3ui::All(1) );
+    const size_t total_ncells = size_t( ncells.x() ) * ncells.y() * ncells.z();
+    const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( mapper->numberOfThreads(), total_ncells ) );
+
+    // Each thread has its own random number stream. The stream is seeded from
+    // the mapper seed and the thread index, so that the result is reproducible
+    // for the same seed and the same number of threads.
+    std::vector< StructuredParticleGenerator<T> > generators( nthreads );
+    for ( size_t i = 0; i < nthreads; ++i )
+    {
+        const size_t begin = total_ncells * i / nthreads;
+        const size_t end = total_ncells * ( i + 1 ) / nthreads;
+        const kvs::UInt32 seed = mapper->seed() + static_cast<kvs::UInt32>( i ) * 2654435761U;
+        generators[i].init( volume, &mapper->transferFunction(), density_map.data(), begin, end, seed );
+    }
+
+    // Counting pass. The first range is processed on the calling thread.
+    kvs::Thread::Run( &generators[0], nthreads );
+
+    // Calculate the offset of each range by using the prefix sum of the number
+    // of particles, and allocate the output arrays with the exact size.
+    std::vector<size_t> offsets( nthreads + 1, 0 );
+    for ( size_t i = 0; i < nthreads; ++i )
+    {
+        offsets[i+1] = offsets[i] + generators[i].numberOfParticles();
+    }
+
+    const size_t nparticles = offsets[ nthreads ];
+    kvs::ValueArray<kvs::Real32> vertex_coords( nparticles * 3 );
+    kvs::ValueArray<kvs::UInt8>  vertex_colors( nparticles * 3 );
+    kvs::ValueArray<kvs::Real32> vertex_normals( nparticles * 3 );
+    for ( size_t i = 0; i < nthreads; ++i )
+    {
+        const size_t offset = offsets[i] * 3;
+        generators[i].attachOutputs(
+            vertex_coords.data() + offset,
+            vertex_colors.data() + offset,
+            vertex_normals.data() + offset );
+    }
+
+    // Filling pass. Each thread writes its particles in place.
+    kvs::Thread::Run( &generators[0], nthreads );
+
+    mapper->setCoords( vertex_coords );
+    mapper->setColors( vertex_colors );
+    mapper->setNormals( vertex_normals );
+    mapper->setSize( 1.0f );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Function object that generates the particles for the value type.
+ */
+/*===========================================================================*/
+class StructuredGenerator
+{
+private:
+
+    kvs::CellByCellUniformSampling* m_mapper; ///< pointer to the mapper
+    const kvs::StructuredVolumeObject* m_volume; ///< pointer to the input volume
+    const kvs::ValueArray<float>* m_density_map; ///< pointer to the density map
+
+public:
+
+    StructuredGenerator(
+        kvs::CellByCellUniformSampling* mapper,
+        const kvs::StructuredVolumeObject* volume,
+        const kvs::ValueArray<float>* density_map ):
+        m_mapper( mapper ),
+        m_volume( volume ),
+        m_density_map( density_map ) {}
+
+    template <typename T>
+    void operator ()( const kvs::ValueArray<T>& ) const
+    {
+        GenerateParticles<T>( m_mapper, m_volume, *m_density_map );
+    }
+};
+
+} // end of namespace
+
+
 namespace kvs
 {
 
@@ -41,7 +296,9 @@ namespace kvs
 CellByCellUniformSampling::CellByCellUniformSampling():
     kvs::MapperBase(),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_seed( 0 )
 {
 }
 
@@ -63,7 +320,9 @@ CellByCellUniformSampling::CellByCellUniformSampling(
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
     kvs::PointObject(),
-    m_camera( 0 )
+    m_camera( 0 ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_seed( 0 )
 {
     this->setSubpixelLevel( subpixel_level );
     this->setSamplingStep( sampling_step );
@@ -90,7 +349,9 @@ CellByCellUniformSampling::CellByCellUniformSampling(
     const kvs::TransferFunction& transfer_function,
     const float                  object_depth ):
     kvs::MapperBase( transfer_function ),
-    kvs::PointObject()
+    kvs::PointObject(),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_seed( 0 )
 {
     this->attachCamera( camera ),
     this->setSubpixelLevel( subpixel_level );
@@ -142,6 +403,28 @@ float CellByCellUniformSampling::objectDepth() const
     return m_object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of threads used for the particle generation.
+ *  @return number of threads
+ */
+/*===========================================================================*/
+size_t CellByCellUniformSampling::numberOfThreads() const
+{
+    return m_number_of_threads;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the seed of the random number generators.
+ *  @return seed
+ */
+/*===========================================================================*/
+kvs::UInt32 CellByCellUniformSampling::seed() const
+{
+    return m_seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Attaches a camera.
@@ -186,6 +469,31 @@ void CellByCellUniformSampling::setObjectDepth( const float object_depth )
     m_object_depth = object_depth;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads used for the particle generation.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void CellByCellUniformSampling::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a seed of the random number generators.
+ *  @param  seed [in] seed
+ *
+ *  The particles generated for the structured volume object are reproducible
+ *  for the same seed and the same number of threads.
+ */
+/*===========================================================================*/
+void CellByCellUniformSampling::setSeed( const kvs::UInt32 seed )
+{
+    m_seed = seed;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the mapper process.
@@ -266,16 +574,7 @@ void CellByCellUniformSampling::mapping( const kvs::Camera* camera, const kvs::S
         BaseClass::transferFunction().opacityMap() );
 
     // Generate the particles.
-    const std::type_info& type = volume->values().typeInfo()->type();
-    if (      type == typeid( kvs::Int8   ) ) this->generate_particles<kvs::Int8>( volume );
-    else if ( type == typeid( kvs::Int16  ) ) this->generate_particles<kvs::Int16>( volume );
-    else if ( type == typeid( kvs::Int32  ) ) this->generate_particles<kvs::Int32>( volume );
-    else if ( type == typeid( kvs::UInt8  ) ) this->generate_particles<kvs::UInt8>( volume );
-    else if ( type == typeid( kvs::UInt16 ) ) this->generate_particles<kvs::UInt16>( volume );
-    else if ( type == typeid( kvs::UInt32 ) ) this->generate_particles<kvs::UInt32>( volume );
-    else if ( type == typeid( kvs::Real32 ) ) this->generate_particles<kvs::Real32>( volume );
-    else if ( type == typeid( kvs::Real64 ) ) this->generate_particles<kvs::Real64>( volume );
-    else
+    if ( !volume->values().dispatch( ::StructuredGenerator( this, volume, &m_density_map ) ) )
     {
         BaseClass::setSuccess( false );
         kvsMessageError("Unsupported data type '%s'.", volume->values().typeInfo()->typeName() );
@@ -308,95 +607,6 @@ void CellByCellUniformSampling::mapping( const kvs::Camera* camera, const kvs::U
     this->generate_particles( volume );
 }
 
-/*===========================================================================*/
-/**
- *  @brief  Generates particles for the structured volume object.
- *  @param  volume [in] pointer to the input volume object
- */
-/*===========================================================================*/
-template <typename T>
-void CellByCellUniformSampling::generate_particles( const kvs::StructuredVolumeObject* volume )
-{
-    // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
-
-    // Set a trilinear interpolator.
-    kvs::TrilinearInterpolator interpolator( volume );
-
-    // Set parameters for normalization of the node values.
-    const size_t max_range = BaseClass::transferFunction().resolution() - 1;
-    const float min_value = BaseClass::transferFunction().colorMap().minValue();
-    const float max_value = BaseClass::transferFunction().colorMap().maxValue();
-    const float normalize_factor = BaseClass::transferFunction().resolution() / ( max_value - min_value );
-
-    const float* const  density_map = m_density_map.data();
-    const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
-
-    // Generate particles for each cell.
-    const kvs::Vector3ui ncells( volume->resolution() - kvs::Vector3ui::All(1) );
-    for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
-    {
-        for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
-        {
-            for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
-            {
-                // Calculate a volume of cell.
-                const float volume_of_cell = 1.0f;
-
-                // Interpolate at the center of gravity of this cell.
-                const kvs::Vector3f cog( x + 0.5f, y + 0.5f, z + 0.5f );
-                interpolator.attachPoint( cog );
-
-                // Calculate a density.
-                const float  average_scalar = interpolator.scalar<T>();
-                size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
-                average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
-                const float  density = density_map[ average_degree ];
-
-                // Calculate a number of particles in this cell.
-                const float p = density * volume_of_cell;
-                size_t nparticles_in_cell = static_cast<size_t>( p );
-                if ( p - nparticles_in_cell > Generator::GetRandomNumber() ) { ++nparticles_in_cell; }
-
-                const kvs::Vector3f v( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
-                for ( size_t particle = 0; particle < nparticles_in_cell; ++particle )
-                {
-                    // Calculate a coord.
-                    const kvs::Vector3f coord( Generator::RandomSamplingInCube( v ) );
-
-                    // Calculate a color.
-                    interpolator.attachPoint( coord );
-                    const float scalar = interpolator.scalar<T>();
-                    const kvs::RGBColor color( color_map.at( scalar ) );
-
-                    // Calculate a normal.
-                    const Vector3f normal( interpolator.gradient<T>() );
-
-                    // set coord, color, and normal to point object( this ).
-                    vertex_coords.push_back( coord.x() );
-                    vertex_coords.push_back( coord.y() );
-                    vertex_coords.push_back( coord.z() );
-
-                    vertex_colors.push_back( color.r() );
-                    vertex_colors.push_back( color.g() );
-                    vertex_colors.push_back( color.b() );
-
-                    vertex_normals.push_back( normal.x() );
-                    vertex_normals.push_back( normal.y() );
-                    vertex_normals.push_back( normal.z() );
-                } // end of 'paricle' for-loop
-            } // end of 'x' loop
-        } // end of 'y' loop
-    } // end of 'z' loop
-
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
-    SuperClass::setSize( 1.0f );
-}
-
 /*===========================================================================*/
 /**
  *  @brief  Generates particles for the unstructured volume object.
@@ -405,11 +615,6 @@ void CellByCellUniformSampling::generate_particles( const kvs::StructuredVolumeO
 /*===========================================================================*/
 void CellByCellUniformSampling::generate_particles( const kvs::UnstructuredVolumeObject* volume )
 {
-    // Vertex data arrays. (output)
-    std::vector<kvs::Real32> vertex_coords;
-    std::vector<kvs::UInt8>  vertex_colors;
-    std::vector<kvs::Real32> vertex_normals;
-
     // Set a tetrahedral cell interpolator.
     kvs::CellBase* cell = NULL;
     switch ( volume->cellType() )
@@ -462,59 +667,89 @@ void CellByCellUniformSampling::generate_particles( const kvs::UnstructuredVolum
     const float* const  density_map = m_density_map.data();
     const kvs::ColorMap color_map( BaseClass::transferFunction().colorMap() );
 
-    // Generate particles for each cell.
+    // Vertex data arrays. (output)
+    kvs::ValueArray<kvs::Real32> vertex_coords;
+    kvs::ValueArray<kvs::UInt8>  vertex_colors;
+    kvs::ValueArray<kvs::Real32> vertex_normals;
+
+    // The particles are generated in two passes. The counting pass calculates
+    // the total number of particles, and the filling pass writes the particles
+    // into the arrays allocated with the exact size. The random number stream
+    // for rounding the number of particles is reseeded at each pass, so that
+    // both passes give the same number of particles in each cell.
+    kvs::Xorshift128 count_random;
+    size_t nparticles = 0;
     const size_t ncells = volume->numberOfCells();
-    for ( size_t index = 0; index < ncells; ++index )
+    for ( size_t pass = 0; pass < 2; ++pass )
     {
-        // Bind the cell which is indicated by 'index'.
-        cell->bindCell( index );
+        const bool counting = ( pass == 0 );
+        if ( !counting )
+        {
+            vertex_coords.allocate( nparticles * 3 );
+            vertex_colors.allocate( nparticles * 3 );
+            vertex_normals.allocate( nparticles * 3 );
+        }
 
-        // Calculate a density.
-        const float  average_scalar = cell->averagedScalar();
-        size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
-        average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
-        const float  density = density_map[ average_degree ];
+        kvs::Real32* coords = vertex_coords.data();
+        kvs::UInt8* colors = vertex_colors.data();
+        kvs::Real32* normals = vertex_normals.data();
+        count_random.setSeed( m_seed );
 
-        // Calculate a number of particles in this cell.
-        const float volume_of_cell = cell->volume();
-        const float p = density * volume_of_cell;
-        size_t nparticles_in_cell = static_cast<size_t>( p );
+        // Generate particles for each cell.
+        for ( size_t index = 0; index < ncells; ++index )
+        {
+            // Bind the cell which is indicated by 'index'.
+            cell->bindCell( index );
 
-        if ( p - nparticles_in_cell > Generator::GetRandomNumber() ) { ++nparticles_in_cell; }
+            // Calculate a density.
+            const float  average_scalar = cell->averagedScalar();
+            size_t average_degree = static_cast<size_t>( ( average_scalar - min_value ) * normalize_factor );
+            average_degree = kvs::Math::Clamp<size_t>( average_degree, 0, max_range );
+            const float  density = density_map[ average_degree ];
 
-        // Generate a set of particles in this cell represented by v0,...,v3 and s0,...,s3.
-        for ( size_t particle = 0; particle < nparticles_in_cell; ++particle )
-        {
-            // Calculate a coord.
-            const kvs::Vector3f coord = cell->randomSampling();
-
-            // Calculate a color.
-            const float scalar = cell->scalar();
-            const kvs::RGBColor color( color_map.at( scalar ) );
-
-            // Calculate a normal.
-            /* NOTE: The gradient vector of the cell is reversed for shading on the rendering process.
-             */
-            const Vector3f normal( -cell->gradient() );
-
-            // set coord, color, and normal to point object( this ).
-            vertex_coords.push_back( coord.x() );
-            vertex_coords.push_back( coord.y() );
-            vertex_coords.push_back( coord.z() );
-
-            vertex_colors.push_back( color.r() );
-            vertex_colors.push_back( color.g() );
-            vertex_colors.push_back( color.b() );
-
-            vertex_normals.push_back( normal.x() );
-            vertex_normals.push_back( normal.y() );
-            vertex_normals.push_back( normal.z() );
-        } // end of 'paricle' for-loop
-    } // end of 'cell' for-loop
-
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( vertex_coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( vertex_colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( vertex_normals ) );
+            // Calculate a number of particles in this cell.
+            const float volume_of_cell = cell->volume();
+            const float p = density * volume_of_cell;
+            size_t nparticles_in_cell = static_cast<size_t>( p );
+
+            if ( p - nparticles_in_cell > count_random.rand() ) { ++nparticles_in_cell; }
+
+            if ( counting ) { nparticles += nparticles_in_cell; continue; }
+
+            // Generate a set of particles in this cell represented by v0,...,v3 and s0,...,s3.
+            for ( size_t particle = 0; particle < nparticles_in_cell; ++particle )
+            {
+                // Calculate a coord.
+                const kvs::Vector3f coord = cell->randomSampling();
+
+                // Calculate a color.
+                const float scalar = cell->scalar();
+                const kvs::RGBColor color( color_map.at( scalar ) );
+
+                // Calculate a normal.
+                /* NOTE: The gradient vector of the cell is reversed for shading on the rendering process.
+                 */
+                const Vector3f normal( -cell->gradient() );
+
+                // set coord, color, and normal to point object( this ).
+                *(coords++) = coord.x();
+                *(coords++) = coord.y();
+                *(coords++) = coord.z();
+
+                *(colors++) = color.r();
+                *(colors++) = color.g();
+                *(colors++) = color.b();
+
+                *(normals++) = normal.x();
+                *(normals++) = normal.y();
+                *(normals++) = normal.z();
+            } // end of 'paricle' for-loop
+        } // end of 'cell' for-loop
+    } // end of 'pass' for-loop
+
+    SuperClass::setCoords( vertex_coords );
+    SuperClass::setColors( vertex_colors );
+    SuperClass::setNormals( vertex_normals );
     SuperClass::setSize( 1.0f );
 
     delete cell;
@@ -46,6 +46,8 @@ private:
     float m_sampling_step; ///< sampling step in the object coordinate
     float m_object_depth; ///< object depth
     kvs::ValueArray<float> m_density_map; ///< density map
+    size_t m_number_of_threads; ///< number of threads for the particle generation
+    kvs::UInt32 m_seed; ///< seed of the random number generators
 
 public:
 
@@ -70,17 +72,20 @@ public:
     size_t subpixelLevel() const;
     float samplingStep() const;
     float objectDepth() const;
+    size_t numberOfThreads() const;
+    kvs::UInt32 seed() const;
 
     void attachCamera( const kvs::Camera* camera );
     void setSubpixelLevel( const size_t subpixel_level );
     void setSamplingStep( const float sampling_step );
     void setObjectDepth( const float object_depth );
+    void setNumberOfThreads( const size_t nthreads );
+    void setSeed( const kvs::UInt32 seed );
 
 private:
 
     void mapping( const kvs::Camera* camera, const kvs::StructuredVolumeObject* volume );
     void mapping( const kvs::Camera* camera, const kvs::UnstructuredVolumeObject* volume );
-    template <typename T> void generate_particles( const kvs::StructuredVolumeObject* volume );
     void generate_particles( const kvs::UnstructuredVolumeObject* volume );
 };
 
@@ -19,15 +19,132 @@
 #include <kvs/QuadraticHexahedralCell>
 #include <kvs/PyramidalCell>
 #include <kvs/PrismaticCell>
+#include <kvs/Thread>
+#include <kvs/MutexLocker>
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the value with two zero bits inserted between the bits.
+ *  @param  value [in] 10-bit value
+ *  @return 30-bit value
+ */
+/*===========================================================================*/
+kvs::UInt32 SpreadBits( kvs::UInt32 value )
+{
+    value &= 0x000003ff;
+    value = ( value ^ ( value << 16 ) ) & 0xff0000ff;
+    value = ( value ^ ( value <<  8 ) ) & 0x0300f00f;
+    value = ( value ^ ( value <<  4 ) ) & 0x030c30c3;
+    value = ( value ^ ( value <<  2 ) ) & 0x09249249;
+    return value;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the indices of the points sorted along the Morton curve.
+ *  @param  points [in] coordinates of the points
+ *  @param  npoints [in] number of the points
+ *  @return sorted indices
+ */
+/*===========================================================================*/
+std::vector<kvs::UInt32> MortonOrder( const kvs::Real32* points, const size_t npoints )
+{
+    kvs::Vec3 min_coord( points );
+    kvs::Vec3 max_coord( points );
+    for ( size_t i = 1; i < npoints; i++ )
+    {
+        const kvs::Vec3 p( points + 3 * i );
+        for ( int j = 0; j < 3; j++ )
+        {
+            min_coord[j] = kvs::Math::Min( min_coord[j], p[j] );
+            max_coord[j] = kvs::Math::Max( max_coord[j], p[j] );
+        }
+    }
+
+    kvs::Vec3 scale;
+    for ( int j = 0; j < 3; j++ )
+    {
+        const float range = max_coord[j] - min_coord[j];
+        scale[j] = range > 0.0f ? 1023.0f / range : 0.0f;
+    }
+
+    std::vector< std::pair<kvs::UInt32,kvs::UInt32> > keys( npoints );
+    for ( size_t i = 0; i < npoints; i++ )
+    {
+        kvs::UInt32 key = 0;
+        for ( int j = 0; j < 3; j++ )
+        {
+            const float q = kvs::Math::Clamp( ( points[ 3 * i + j ] - min_coord[j] ) * scale[j], 0.0f, 1023.0f );
+            key |= ::SpreadBits( static_cast<kvs::UInt32>( q ) ) << j;
+        }
+        keys[i] = std::make_pair( key, static_cast<kvs::UInt32>( i ) );
+    }
+    std::sort( keys.begin(), keys.end() );
+
+    std::vector<kvs::UInt32> indices( npoints );
+    for ( size_t i = 0; i < npoints; i++ ) { indices[i] = keys[i].second; }
+    return indices;
+}
+
+} // end of namespace
 
 
 namespace kvs
 {
 
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for locating a range of the points.
+ */
+/*===========================================================================*/
+class CellLocator::CellFinder : public kvs::Thread
+{
+private:
+
+    const kvs::CellLocator* m_locator; ///< cell locator
+    const kvs::Real32* m_points; ///< coordinates of the points
+    const kvs::UInt32* m_indices; ///< indices of the points to be located
+    size_t m_nindices; ///< number of the indices
+    int* m_cell_ids; ///< cell IDs of the points
+
+public:
+
+    CellFinder(): m_locator( NULL ), m_points( NULL ), m_indices( NULL ), m_nindices( 0 ), m_cell_ids( NULL ) {}
+
+    void setup(
+        const kvs::CellLocator* locator,
+        const kvs::Real32* points,
+        const kvs::UInt32* indices,
+        const size_t nindices,
+        int* cell_ids )
+    {
+        m_locator = locator;
+        m_points = points;
+        m_indices = indices;
+        m_nindices = nindices;
+        m_cell_ids = cell_ids;
+    }
+
+    void run()
+    {
+        if ( m_nindices > 0 ) { m_locator->find_cells( m_points, m_indices, m_nindices, m_cell_ids ); }
+    }
+};
+
+
 CellLocator::CellLocator():
     m_volume( NULL ),
     m_cell( NULL ),
-    m_cache_mode( CellLocator::CacheOff )
+    m_cache_mode( CellLocator::CacheOff ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_enable_query_sorting( true )
 {
 }
 
@@ -36,43 +153,60 @@ CellLocator::~CellLocator()
     if ( m_cell ) { delete m_cell; }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for the batched location (findCells).
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void CellLocator::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 void CellLocator::attachVolume( const kvs::UnstructuredVolumeObject* volume )
 {
     m_volume = volume;
 
     if ( m_cell ) { delete m_cell; }
+    m_cell = this->createCell();
+}
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns a new cell interpolator for the attached volume.
+ *  @return pointer to the cell interpolator (NULL if not supported)
+ *
+ *  The returned cell must be deleted by the caller.
+ */
+/*===========================================================================*/
+kvs::CellBase* CellLocator::createCell() const
+{
     switch ( m_volume->cellType() )
     {
     case kvs::UnstructuredVolumeObject::Tetrahedra:
     {
-        m_cell = new kvs::TetrahedralCell( m_volume );
-        break;
+        return new kvs::TetrahedralCell( m_volume );
     }
     case kvs::UnstructuredVolumeObject::Hexahedra:
     {
-        m_cell = new kvs::HexahedralCell( m_volume );
-        break;
+        return new kvs::HexahedralCell( m_volume );
     }
     case kvs::UnstructuredVolumeObject::QuadraticTetrahedra:
     {
-        m_cell = new kvs::QuadraticTetrahedralCell( m_volume );
-        break;
+        return new kvs::QuadraticTetrahedralCell( m_volume );
     }
     case kvs::UnstructuredVolumeObject::QuadraticHexahedra:
     {
-        m_cell = new kvs::QuadraticHexahedralCell( m_volume );
-        break;
+        return new kvs::QuadraticHexahedralCell( m_volume );
     }
     case kvs::UnstructuredVolumeObject::Pyramid:
     {
-        m_cell = new kvs::PyramidalCell( m_volume );
-        break;
+        return new kvs::PyramidalCell( m_volume );
     }
     case kvs::UnstructuredVolumeObject::Prism:
     {
-        m_cell = new kvs::PrismaticCell( m_volume );
-        break;
+        return new kvs::PrismaticCell( m_volume );
     }
     default:
     {
@@ -80,6 +214,93 @@ void CellLocator::attachVolume( const kvs::UnstructuredVolumeObject* volume )
         break;
     }
     }
+
+    return NULL;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Finds the cells containing the points.
+ *  @param  points [in] coordinates of the points (x0, y0, z0, x1, y1, z1, ...)
+ *  @param  npoints [in] number of the points
+ *  @param  cell_ids [out] cell IDs of the points (-1 if not found)
+ *
+ *  Unlike findCell, this method does not modify the locator, so that it can
+ *  be called from several threads at the same time. The scratch data (the
+ *  cell interpolator and the cache of the traversal) are kept in each call.
+ *  The points are located in the order along the Morton curve if the query
+ *  sorting is enabled, so that the consecutive queries hit the cached nodes
+ *  and cells, and they are divided into contiguous ranges for the threads.
+ */
+/*===========================================================================*/
+void CellLocator::findCells( const kvs::Real32* points, const size_t npoints, int* cell_ids ) const
+{
+    if ( npoints == 0 ) { return; }
+
+    std::vector<kvs::UInt32> indices;
+    if ( m_enable_query_sorting )
+    {
+        indices = ::MortonOrder( points, npoints );
+    }
+    else
+    {
+        indices.resize( npoints );
+        for ( size_t i = 0; i < npoints; i++ ) { indices[i] = static_cast<kvs::UInt32>( i ); }
+    }
+
+    const size_t min_points_per_thread = 1024;
+    const size_t max_nthreads = npoints / min_points_per_thread + 1;
+    const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, max_nthreads ) );
+    std::vector<CellFinder> finders( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        const size_t begin = npoints * i / nthreads;
+        const size_t end = npoints * ( i + 1 ) / nthreads;
+        finders[i].setup( this, points, &indices[0] + begin, end - begin, cell_ids );
+    }
+
+    kvs::Thread::Run( &finders[0], nthreads );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Finds the cells containing the points specified by the indices.
+ *  @param  points [in] coordinates of the points
+ *  @param  indices [in] indices of the points to be located
+ *  @param  nindices [in] number of the indices
+ *  @param  cell_ids [out] cell IDs of the points
+ *
+ *  This default implementation locates the points one by one with findCell
+ *  while holding the lock, so the calls from the threads are serialized. The
+ *  cell interpolator is replaced by a new one during the call, so the cell
+ *  bound by the last findCell is kept. Derived classes should override this
+ *  method to locate the points in parallel.
+ */
+/*===========================================================================*/
+void CellLocator::find_cells(
+    const kvs::Real32* points,
+    const kvs::UInt32* indices,
+    const size_t nindices,
+    int* cell_ids ) const
+{
+    kvs::CellBase* cell = this->createCell();
+    if ( !cell )
+    {
+        for ( size_t i = 0; i < nindices; i++ ) { cell_ids[ indices[i] ] = -1; }
+        return;
+    }
+
+    kvs::MutexLocker locker( &m_mutex );
+    CellLocator* locator = const_cast<CellLocator*>( this );
+    std::swap( locator->m_cell, cell );
+    for ( size_t i = 0; i < nindices; i++ )
+    {
+        const kvs::UInt32 index = indices[i];
+        cell_ids[ index ] = locator->findCell( kvs::Vec3( points + 3 * index ) );
+    }
+    std::swap( locator->m_cell, cell );
+
+    delete cell;
 }
 
 } // end of namespace kvs
@@ -16,6 +16,7 @@
 #include <kvs/CellBase>
 #include <kvs/UnstructuredVolumeObject>
 #include <kvs/Vector>
+#include <kvs/Mutex>
 
 
 namespace kvs
@@ -42,6 +43,9 @@ private:
     const kvs::UnstructuredVolumeObject* m_volume; ///< reference volume
     kvs::CellBase* m_cell; ///< cell interpolator
     CacheMode m_cache_mode; ///< cache mode
+    size_t m_number_of_threads; ///< number of threads for the batched location
+    bool m_enable_query_sorting; ///< flag for sorting the queries along the Morton curve
+    mutable kvs::Mutex m_mutex; ///< mutex for the default batched location
 
 public:
 
@@ -54,15 +58,34 @@ public:
     void setCacheModeToOff() { m_cache_mode = CacheOff; }
     void setCacheModeToHalf() { m_cache_mode = CacheHalf; }
     void setCacheModeToFull() { m_cache_mode = CacheFull; }
+    void setNumberOfThreads( const size_t nthreads );
+    void setEnabledQuerySorting( const bool enable ) { m_enable_query_sorting = enable; }
+    void enableQuerySorting() { this->setEnabledQuerySorting( true ); }
+    void disableQuerySorting() { this->setEnabledQuerySorting( false ); }
     void attachVolume( const kvs::UnstructuredVolumeObject* volume );
 
     const kvs::UnstructuredVolumeObject* volume() const { return m_volume; }
     kvs::CellBase* const cell() const { return m_cell; }
     CacheMode cacheMode() const { return m_cache_mode; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    bool isEnabledQuerySorting() const { return m_enable_query_sorting; }
+
+    kvs::CellBase* createCell() const;
+    void findCells( const kvs::Real32* points, const size_t npoints, int* cell_ids ) const;
 
     virtual void build() = 0;
     virtual int findCell( const kvs::Vec3 p ) = 0;
     virtual void clearCache() = 0;
+
+protected:
+
+    class CellFinder;
+
+    virtual void find_cells(
+        const kvs::Real32* points,
+        const kvs::UInt32* indices,
+        const size_t nindices,
+        int* cell_ids ) const;
 };
 
 } // end of namespace kvs
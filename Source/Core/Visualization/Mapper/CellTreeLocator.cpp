@@ -84,13 +84,62 @@ bool CellContains( const kvs::CellBase* cell, const kvs::Vec3& p )
     }
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cell ID containing the point.
+ *  @param  tree [in] cell tree
+ *  @param  cell [in] cell interpolator used for the inside test
+ *  @param  p [in] point
+ *  @param  hint [in/out] index of the node where the traversal starts (NULL: from root)
+ *  @return cell ID (-1 if not found)
+ */
+/*===========================================================================*/
+int FindCell( const kvs::CellTree& tree, kvs::CellBase* cell, const kvs::Vec3& p, kvs::UInt32* hint )
+{
+    if ( hint )
+    {
+        kvs::CellTree::PreTraversalCached pt( tree, p.data(), *hint );
+        while ( const kvs::CellTree::Node* n = pt.next() )
+        {
+            const unsigned int* begin = &( tree.leaves[ n->start ] );
+            const unsigned int* end = begin + n->size;
+            for ( ; begin != end; ++begin )
+            {
+                cell->bindCell( *begin );
+                if ( ::CellContains( cell, p ) )
+                {
+                    *hint = *pt.sp();
+                    return *begin;
+                }
+            }
+        }
+    }
+    else
+    {
+        kvs::CellTree::PreTraversal pt( tree, p.data() );
+        while ( const kvs::CellTree::Node* n = pt.next() )
+        {
+            const unsigned int* begin = &( tree.leaves[ n->start ] );
+            const unsigned int* end = begin + n->size;
+            for ( ; begin != end; ++begin )
+            {
+                cell->bindCell( *begin );
+                if ( ::CellContains( cell, p ) ) { return *begin; }
+            }
+        }
+    }
+
+    return -1;
+}
+
 } // end of namespace
 
 
 namespace kvs
 {
 
-CellTreeLocator::CellTreeLocator()
+CellTreeLocator::CellTreeLocator():
+    m_cell_tree( NULL )
 {
     m_enable_mthreading = false;
     this->clearCache();
@@ -98,7 +147,8 @@ CellTreeLocator::CellTreeLocator()
 
 CellTreeLocator::CellTreeLocator(
     const kvs::UnstructuredVolumeObject* volume,
-    const bool enable_mthreading )
+    const bool enable_mthreading ):
+    m_cell_tree( NULL )
 {
     BaseClass::attachVolume( volume );
     this->clearCache();
@@ -114,6 +164,7 @@ CellTreeLocator::~CellTreeLocator()
 void CellTreeLocator::build()
 {
     KVS_ASSERT( BaseClass::volume() );
+    if ( m_cell_tree ) { delete m_cell_tree; }
     m_cell_tree = new kvs::CellTree( BaseClass::volume(), m_enable_mthreading );
 }
 
@@ -123,40 +174,11 @@ int CellTreeLocator::findCell( const kvs::Vec3 p )
     {
     case CacheOff:
     {
-        CellTree::PreTraversal pt( *m_cell_tree, p.data() );
-        while ( const CellTree::Node* n = pt.next() )
-        {
-            // pt.next() brings us to a series of leaves that may contain p
-            const unsigned int* begin = &(m_cell_tree->leaves[ n->start ]);
-            const unsigned int* end = begin + n->size;
-            for ( ; begin != end; ++begin )
-            {
-                BaseClass::cell()->bindCell( *begin );
-                if ( ::CellContains( BaseClass::cell(), p ) ) { return *begin; }
-            }
-        }
-        break;
+        return ::FindCell( *m_cell_tree, BaseClass::cell(), p, NULL );
     }
     case CacheHalf:
     {
-        CellTree::PreTraversalCached pt( *m_cell_tree, p.data(), m_cache1[0] );
-        while ( const CellTree::Node* n = pt.next() )
-        {
-            // pt.next() brings us to a series of leaves that may contain p
-            const unsigned int* begin = &(this->m_cell_tree->leaves[ n->start ]);
-            const unsigned int* end = begin + n->size;
-            for ( ; begin != end; ++begin )
-            {
-                BaseClass::cell()->bindCell( *begin );
-                if ( ::CellContains( BaseClass::cell(), p ) )
-                {
-                    const unsigned int* sp = pt.sp();
-                    m_cache1[0] = *sp;
-                    return *begin;
-                }
-            }
-        }
-        break;
+        return ::FindCell( *m_cell_tree, BaseClass::cell(), p, &m_cache1[0] );
     }
     case CacheFull:
     {
@@ -204,4 +226,44 @@ void CellTreeLocator::clearCache()
     m_cp2 = m_cache2;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Finds the cells containing the points without modifying the locator.
+ *  @param  points [in] coordinates of the points
+ *  @param  indices [in] indices of the points to be located in this order
+ *  @param  nindices [in] number of the indices
+ *  @param  cell_ids [out] cell IDs of the points
+ *
+ *  The cell interpolator and the node cache are local to this call. Except in
+ *  CacheOff mode, the traversal starts from the leaf node of the previous
+ *  point, as with CacheHalf mode of findCell.
+ */
+/*===========================================================================*/
+void CellTreeLocator::find_cells(
+    const kvs::Real32* points,
+    const kvs::UInt32* indices,
+    const size_t nindices,
+    int* cell_ids ) const
+{
+    KVS_ASSERT( m_cell_tree );
+
+    kvs::CellBase* cell = BaseClass::createCell();
+    if ( !cell )
+    {
+        for ( size_t i = 0; i < nindices; i++ ) { cell_ids[ indices[i] ] = -1; }
+        return;
+    }
+
+    kvs::UInt32 cache = 0;
+    kvs::UInt32* hint = BaseClass::cacheMode() == CacheOff ? NULL : &cache;
+    for ( size_t i = 0; i < nindices; i++ )
+    {
+        const kvs::UInt32 index = indices[i];
+        const kvs::Vec3 p( points + 3 * index );
+        cell_ids[ index ] = ::FindCell( *m_cell_tree, cell, p, hint );
+    }
+
+    delete cell;
+}
+
 } // end of namespace kvs
@@ -63,6 +63,14 @@ public:
     void build();
     int findCell( const kvs::Vec3 p );
     void clearCache();
+
+protected:
+
+    void find_cells(
+        const kvs::Real32* points,
+        const kvs::UInt32* indices,
+        const size_t nindices,
+        int* cell_ids ) const;
 };
 
 } // end of namespace kvs
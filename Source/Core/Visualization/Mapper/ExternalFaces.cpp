@@ -19,7 +19,11 @@
 #include <kvs/TransferFunction>
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/Timer>
-#include <map>
+#include <kvs/Thread>
+#include <kvs/Value>
+#include <kvs/Math>
+#include <vector>
+#include <algorithm>
 #include <cstring>
 
 
@@ -82,573 +86,258 @@ inline void GetColorIndices(
 
 /*===========================================================================*/
 /**
- *  @brief  Triangle face class.
- */
-/*===========================================================================*/
-class TriangleFace
-{
-private:
-
-    kvs::UInt32 m_id[3]; ///< vertex IDs
-
-public:
-
-    TriangleFace( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 );
-
-public:
-
-    const kvs::UInt32 id( const size_t index ) const;
-
-    void set( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 );
-
-    friend const bool operator == ( const TriangleFace& f0, const TriangleFace& f1 );
-};
-
-/*===========================================================================*/
-/**
- *  @brief  Constructs a new TriangleFace class.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- *  @return <ReturnValue>
+ *  @brief  Local faces of the cells.
+ *
+ *  Each face is given by the local vertex indices of the cell. The quadratic
+ *  tetrahedral cell is divided into 16 triangles, and the quadratic nodes of
+ *  the quadratic hexahedral cell are ignored.
  */
 /*===========================================================================*/
-inline TriangleFace::TriangleFace( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 )
-{
-    this->set( id0, id1, id2 );
-}
+const size_t TetrahedraFaces[4][3] = {
+    { 0, 1, 2 }, { 0, 2, 3 }, { 0, 3, 1 }, { 1, 3, 2 } };
 
-/*===========================================================================*/
-/**
- *  @brief  Returns a vertex ID.
- *  @param  index [in] index (0-2)
- *  @return vertex ID
- */
-/*===========================================================================*/
-inline const kvs::UInt32 TriangleFace::id( const size_t index ) const
-{
-    return m_id[ index ];
-}
+const size_t QuadraticTetrahedraFaces[16][3] = {
+    { 0, 4, 5 }, { 4, 1, 7 }, { 5, 7, 2 }, { 7, 5, 4 },
+    { 0, 5, 6 }, { 5, 2, 8 }, { 6, 8, 3 }, { 8, 6, 5 },
+    { 0, 6, 4 }, { 6, 3, 9 }, { 4, 9, 1 }, { 9, 4, 6 },
+    { 1, 9, 7 }, { 9, 3, 8 }, { 7, 8, 2 }, { 8, 7, 9 } };
 
-/*===========================================================================*/
-/**
- *  @brief  Sets vertex IDs.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- */
-/*===========================================================================*/
-inline void TriangleFace::set( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 )
-{
-    m_id[0] = id0;
-    m_id[1] = id1;
-    m_id[2] = id2;
-}
+const size_t HexahedraFaces[6][4] = {
+    { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 0, 3, 7, 4 },
+    { 3, 2, 6, 7 }, { 1, 2, 6, 5 }, { 0, 1, 5, 4 } };
 
 /*===========================================================================*/
 /**
- *  @brief  '==' operator for the TriangleFace class.
- *  @param  f0 [in] face 0
- *  @param  f1 [in] face 1
- *  @return true, if the face 0 is equal to the face 1
+ *  @brief  Face table of the unstructured volume object.
  */
 /*===========================================================================*/
-inline const bool operator == ( const TriangleFace& f0, const TriangleFace& f1 )
+template <size_t N>
+struct FaceTable
 {
-    for ( size_t i = 0; i < 3; i++ )
+    const kvs::UInt32* connections; ///< connections of the volume
+    size_t nnodes_per_cell; ///< number of nodes per cell
+    size_t nfaces_per_cell; ///< number of faces per cell
+    const size_t (*faces)[N]; ///< local faces of the cell
+
+    /*
+     *  Returns the vertex IDs of the face given by the face index
+     *  (cell index * number of faces per cell + local face index).
+     */
+    void vertices( const size_t face_index, kvs::UInt32 (*id)[N] ) const
     {
-        bool flag = false;
-        for ( size_t j = 0; j < 3; j++ )
-        {
-            if ( f0.id(i) == f1.id(j) ) { flag = true; continue; }
-        }
-        if ( !flag ) return false;
+        const size_t cell_index = face_index / nfaces_per_cell;
+        const size_t* local = faces[ face_index % nfaces_per_cell ];
+        const kvs::UInt32* connection = connections + cell_index * nnodes_per_cell;
+        for ( size_t i = 0; i < N; i++ ) { (*id)[i] = connection[ local[i] ]; }
     }
-
-    return true;
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Quadrangle face class.
- */
-/*===========================================================================*/
-class QuadrangleFace
-{
-private:
-
-    kvs::UInt32 m_id[4]; ///< vertex IDs
-
-public:
-
-    QuadrangleFace( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 );
-
-public:
-
-    const kvs::UInt32 id( const size_t index ) const;
-
-    void set( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 );
-
-    friend const bool operator == ( const QuadrangleFace& f0, const QuadrangleFace& f1 );
 };
 
 /*===========================================================================*/
 /**
- *  @brief  Constructs a new QuadrangleFace class.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- *  @param  id3 [in] ID 3
- */
-/*===========================================================================*/
-inline QuadrangleFace::QuadrangleFace( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 )
-{
-    this->set( id0, id1, id2, id3 );
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns a vertex ID.
- *  @param  index [in] index (0-3)
- *  @return vertex ID
+ *  @brief  Face key for matching the faces shared by two cells.
+ *
+ *  The key consists of the vertex IDs sorted in ascending order and the face
+ *  index. The faces with the same vertices are adjacent after sorting the keys.
  */
 /*===========================================================================*/
-inline const kvs::UInt32 QuadrangleFace::id( const size_t index ) const
+template <size_t N>
+struct FaceKey
 {
-    return m_id[ index ];
-}
+    kvs::UInt32 id[N]; ///< sorted vertex IDs
+    kvs::UInt32 index; ///< face index
 
-/*===========================================================================*/
-/**
- *  @brief  Sets vertex IDs.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- */
-/*===========================================================================*/
-inline void QuadrangleFace::set( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 )
-{
-    m_id[0] = id0;
-    m_id[1] = id1;
-    m_id[2] = id2;
-    m_id[3] = id3;
-}
+    bool isSameFace( const FaceKey& other ) const
+    {
+        for ( size_t i = 0; i < N; i++ ) { if ( id[i] != other.id[i] ) return false; }
+        return true;
+    }
 
-/*===========================================================================*/
-/**
- *  @brief  '==' operator for the TriangleFace class.
- *  @param  f0 [in] face 0
- *  @param  f1 [in] face 1
- *  @return true, if the face 0 is equal to the face 1
- */
-/*===========================================================================*/
-inline const bool operator == ( const QuadrangleFace& f0, const QuadrangleFace& f1 )
-{
-    for ( size_t i = 0; i < 4; i++ )
+    friend bool operator <( const FaceKey& lhs, const FaceKey& rhs )
     {
-        bool flag = false;
-        for ( size_t j = 0; j < 4; j++ )
+        for ( size_t i = 0; i < N; i++ )
         {
-            if ( f0.id(i) == f1.id(j) ) { flag = true; continue; }
+            if ( lhs.id[i] != rhs.id[i] ) return lhs.id[i] < rhs.id[i];
         }
-        if ( !flag ) return false;
+        return lhs.index < rhs.index;
     }
-
-    return true;
-}
+};
 
 /*===========================================================================*/
 /**
- *  @brief  TriangleFace map class.
+ *  @brief  Thread for creating and sorting the face keys.
+ *
+ *  In the first step, the keys of the faces in a range of the cells are
+ *  created and sorted. In the following steps, two sorted ranges are merged.
  */
 /*===========================================================================*/
-class TriangleFaceMap
+template <size_t N>
+class FaceKeySorter : public kvs::Thread
 {
-public:
-
-    typedef kvs::UInt32 Key;
-    typedef TriangleFace Value;
-    typedef std::multimap<Key,Value> Bucket;
-
 private:
 
-    size_t m_nvertices; ///< number of vertices of the original data
-    Bucket m_bucket; ///< bucket for the edge data
-
-public:
-
-    TriangleFaceMap( const size_t nvertices );
+    const FaceTable<N>* m_table; ///< face table (NULL: merging step)
+    FaceKey<N>* m_first; ///< first key
+    FaceKey<N>* m_middle; ///< end of the first sorted range (merging step)
+    FaceKey<N>* m_last; ///< last key + 1
 
 public:
 
-    const Bucket& bucket() const;
-
-    void insert( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 );
-
-private:
+    FaceKeySorter(): m_table( NULL ), m_first( NULL ), m_middle( NULL ), m_last( NULL ) {}
 
-    const Key get_key( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 );
-};
-
-/*===========================================================================*/
-/**
- *  @brief  Constructs a new TriangleFaceMap class.
- *  @param  nvertices [in] number of vertices
- */
-/*===========================================================================*/
-inline TriangleFaceMap::TriangleFaceMap( const size_t nvertices ):
-    m_nvertices( nvertices )
-{
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns a bucket for the face.
- *  @return bucket
- */
-/*===========================================================================*/
-inline const TriangleFaceMap::Bucket& TriangleFaceMap::bucket() const
-{
-    return m_bucket;
-}
+    void initSort( const FaceTable<N>* table, FaceKey<N>* first, FaceKey<N>* last )
+    {
+        m_table = table;
+        m_first = first;
+        m_middle = NULL;
+        m_last = last;
+    }
 
-/*===========================================================================*/
-/**
- *  @brief  Inserts a face indicated by the given IDs.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- */
-/*===========================================================================*/
-inline void TriangleFaceMap::insert( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 )
-{
-    const Key key( this->get_key( id0, id1, id2 ) );
-    const Value value( id0, id1, id2 );
+    void initMerge( FaceKey<N>* first, FaceKey<N>* middle, FaceKey<N>* last )
+    {
+        m_table = NULL;
+        m_first = first;
+        m_middle = middle;
+        m_last = last;
+    }
 
-    Bucket::iterator f = m_bucket.find( key );
-    Bucket::const_iterator last = m_bucket.end();
-    if ( f != last )
+    void run()
     {
-        Bucket::const_iterator upper = m_bucket.upper_bound( key );
-        do
+        if ( m_table )
         {
-            if ( f->second == value )
+            // The keys are assigned to the faces in the order of the cells.
+            for ( FaceKey<N>* key = m_first; key != m_last; ++key )
             {
-                // The edge has been already inserted in the bucket.
-                m_bucket.erase( f );
-                return;
+                kvs::UInt32 id[N];
+                m_table->vertices( key->index, &id );
+                std::sort( id, id + N );
+                std::copy( id, id + N, key->id );
             }
-            f++;
-        } while ( f != upper );
+            std::sort( m_first, m_last );
+        }
+        else
+        {
+            std::inplace_merge( m_first, m_middle, m_last );
+        }
     }
-
-    m_bucket.insert( std::make_pair( key, value ) );
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns a key for searching the face.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- *  @return key
- */
-/*===========================================================================*/
-inline const TriangleFaceMap::Key TriangleFaceMap::get_key( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2 )
-{
-    const kvs::UInt32 sum = id0 + id1 + id2;
-    return sum % kvs::UInt32( m_nvertices );
-}
-
-/*===========================================================================*/
-/**
- *  @brief  QuadrangleFace map class.
- */
-/*===========================================================================*/
-class QuadrangleFaceMap
-{
-public:
-
-    typedef kvs::UInt32 Key;
-    typedef QuadrangleFace Value;
-    typedef std::multimap<Key,Value> Bucket;
-
-private:
-
-    size_t m_nvertices; ///< number of vertices of the original data
-    Bucket m_bucket; ///< bucket for the edge data
-
-public:
-
-    QuadrangleFaceMap( const size_t nvertices );
-
-public:
-
-    const Bucket& bucket() const;
-
-    void insert( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 );
-
-private:
-
-    const Key get_key( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 );
 };
 
 /*===========================================================================*/
 /**
- *  @brief  Constructs a new QuadrangleFaceMap class.
- *  @param  nvertices [in] number of vertices
- */
-/*===========================================================================*/
-inline QuadrangleFaceMap::QuadrangleFaceMap( const size_t nvertices ):
-    m_nvertices( nvertices )
-{
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns a bucket for the face.
- *  @return bucket
+ *  @brief  Finds the external faces.
+ *  @param  table [in] face table
+ *  @param  nfaces [in] total number of the faces of the cells
+ *  @param  nthreads [in] number of threads
+ *  @return face indices of the external faces in the order of the cells
+ *
+ *  A face is external when it is not shared by an even number of faces. If a
+ *  face appears an odd number of times, the last one in the cell order is
+ *  taken as the external face.
  */
 /*===========================================================================*/
-inline const QuadrangleFaceMap::Bucket& QuadrangleFaceMap::bucket() const
+template <size_t N>
+std::vector<kvs::UInt32> FindExternalFaces(
+    const FaceTable<N>& table,
+    const size_t nfaces,
+    const size_t nthreads )
 {
-    return m_bucket;
-}
+    std::vector< FaceKey<N> > keys( nfaces );
+    for ( size_t i = 0; i < nfaces; i++ ) { keys[i].index = static_cast<kvs::UInt32>( i ); }
 
-/*===========================================================================*/
-/**
- *  @brief  Inserts a face indicated by the given IDs.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- *  @param  id3 [in] ID 3
- */
-/*===========================================================================*/
-inline void QuadrangleFaceMap::insert( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 )
-{
-    const Key key( this->get_key( id0, id1, id2, id3 ) );
-    const Value value( id0, id1, id2, id3 );
+    // Create and sort the keys in each range, and then merge the sorted ranges.
+    const size_t nranges = kvs::Math::Max( size_t(1), kvs::Math::Min( nthreads, nfaces ) );
+    std::vector<size_t> bounds( nranges + 1 );
+    for ( size_t i = 0; i <= nranges; i++ ) { bounds[i] = nfaces * i / nranges; }
 
-    Bucket::iterator f = m_bucket.find( key );
-    Bucket::const_iterator last = m_bucket.end();
-    if ( f != last )
+    std::vector< FaceKeySorter<N> > sorters( nranges );
+    for ( size_t i = 0; i < nranges; i++ )
     {
-        Bucket::const_iterator upper = m_bucket.upper_bound( key );
-        do
-        {
-            if ( f->second == value )
-            {
-                // The edge has been already inserted in the bucket.
-                m_bucket.erase( f );
-                return;
-            }
-            f++;
-        } while ( f != upper );
+        sorters[i].initSort( &table, &keys[0] + bounds[i], &keys[0] + bounds[i+1] );
     }
+    if ( nfaces > 0 ) { kvs::Thread::Run( &sorters[0], nranges ); }
 
-    m_bucket.insert( std::make_pair( key, value ) );
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Returns a key for searching the face.
- *  @param  id0 [in] ID 0
- *  @param  id1 [in] ID 1
- *  @param  id2 [in] ID 2
- *  @param  id3 [in] ID 3
- *  @return key
- */
-/*===========================================================================*/
-inline const QuadrangleFaceMap::Key QuadrangleFaceMap::get_key( const kvs::UInt32 id0, const kvs::UInt32 id1, const kvs::UInt32 id2, const kvs::UInt32 id3 )
-{
-    const kvs::UInt32 sum = id0 + id1 + id2 + id3;
-    return sum % kvs::UInt32( m_nvertices );
-}
-
-/*===========================================================================*/
-/**
- *  @brief  Creates a face map for the tetrahedral cells.
- *  @param  volume [in] pointer to the unstructured volume object
- *  @param  face_map [out] pointer to the face map
- */
-/*===========================================================================*/
-inline void CreateTetrahedraFaceMap(
-    const kvs::UnstructuredVolumeObject* volume,
-    TriangleFaceMap* face_map )
-{
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
+    for ( size_t width = 1; width < nranges; width *= 2 )
     {
-        // Local vertices of the tetrahedral cell.
-        const kvs::UInt32 v0 = connections[ connection_index     ];
-        const kvs::UInt32 v1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 v2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 v3 = connections[ connection_index + 3 ];
-        connection_index += 4;
-
-        // Local faces of the cell (4 triangle meshes).
-        face_map->insert( v0, v1, v2 );
-        face_map->insert( v0, v2, v3 );
-        face_map->insert( v0, v3, v1 );
-        face_map->insert( v1, v3, v2 );
+        size_t nmerges = 0;
+        for ( size_t i = 0; i + width < nranges; i += 2 * width, nmerges++ )
+        {
+            const size_t last = kvs::Math::Min( i + 2 * width, nranges );
+            sorters[ nmerges ].initMerge( &keys[0] + bounds[i], &keys[0] + bounds[ i + width ], &keys[0] + bounds[ last ] );
+        }
+        kvs::Thread::Run( &sorters[0], nmerges );
     }
-}
 
-/*===========================================================================*/
-/**
- *  @brief  Creates a face map for the quadratic tetrahedral cells.
- *  @param  volume [in] pointer to the unstructured volume object
- *  @param  face_map [out] pointer to the face map
- */
-/*===========================================================================*/
-inline void CreateQuadraticTetrahedraFaceMap(
-    const kvs::UnstructuredVolumeObject* volume,
-    TriangleFaceMap* face_map )
-{
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
+    // Take the faces which appear an odd number of times.
+    std::vector<kvs::UInt32> external_faces;
+    for ( size_t i = 0; i < nfaces; )
     {
-        // Local vertices of the quadratic tetrahedral cell.
-        const kvs::UInt32 v0 = connections[ connection_index     ];
-        const kvs::UInt32 v1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 v2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 v3 = connections[ connection_index + 3 ];
-        const kvs::UInt32 v4 = connections[ connection_index + 4 ];
-        const kvs::UInt32 v5 = connections[ connection_index + 5 ];
-        const kvs::UInt32 v6 = connections[ connection_index + 6 ];
-        const kvs::UInt32 v7 = connections[ connection_index + 7 ];
-        const kvs::UInt32 v8 = connections[ connection_index + 8 ];
-        const kvs::UInt32 v9 = connections[ connection_index + 9 ];
-        connection_index += 10;
-
-        // Local faces of the cell (16 triangle meshes).
-        face_map->insert( v0, v4, v5 );
-        face_map->insert( v4, v1, v7 );
-        face_map->insert( v5, v7, v2 );
-        face_map->insert( v7, v5, v4 );
-
-        face_map->insert( v0, v5, v6 );
-        face_map->insert( v5, v2, v8 );
-        face_map->insert( v6, v8, v3 );
-        face_map->insert( v8, v6, v5 );
-
-        face_map->insert( v0, v6, v4 );
-        face_map->insert( v6, v3, v9 );
-        face_map->insert( v4, v9, v1 );
-        face_map->insert( v9, v4, v6 );
-
-        face_map->insert( v1, v9, v7 );
-        face_map->insert( v9, v3, v8 );
-        face_map->insert( v7, v8, v2 );
-        face_map->insert( v8, v7, v9 );
+        size_t j = i + 1;
+        while ( j < nfaces && keys[j].isSameFace( keys[i] ) ) { j++; }
+        if ( ( j - i ) % 2 == 1 ) { external_faces.push_back( keys[ j - 1 ].index ); }
+        i = j;
     }
+
+    std::sort( external_faces.begin(), external_faces.end() );
+    return external_faces;
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Creates a face map for the hexahedral cells.
- *  @param  volume [in] pointer to the unstructured volume object
- *  @param  face_map [out] pointer to the face map
+ *  @brief  Compares the faces in the order of the previous implementation.
+ *
+ *  The faces were stored in a multimap with the key of the sum of the vertex
+ *  IDs modulo the number of nodes, and the faces with the same key were kept
+ *  in the insertion order.
  */
 /*===========================================================================*/
-inline void CreateHexahedraFaceMap(
-    const kvs::UnstructuredVolumeObject* volume,
-    QuadrangleFaceMap* face_map )
+template <size_t N>
+class HashOrderLess
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
+private:
+
+    const FaceTable<N>* m_table; ///< face table
+    kvs::UInt32 m_nnodes; ///< number of nodes
+
+public:
+
+    HashOrderLess( const FaceTable<N>* table, const size_t nnodes ):
+        m_table( table ),
+        m_nnodes( static_cast<kvs::UInt32>( nnodes ) ) {}
+
+    kvs::UInt32 key( const kvs::UInt32 index ) const
     {
-        // Local vertices of the quadratic tetrahedral cell.
-        const kvs::UInt32 v0 = connections[ connection_index     ];
-        const kvs::UInt32 v1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 v2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 v3 = connections[ connection_index + 3 ];
-        const kvs::UInt32 v4 = connections[ connection_index + 4 ];
-        const kvs::UInt32 v5 = connections[ connection_index + 5 ];
-        const kvs::UInt32 v6 = connections[ connection_index + 6 ];
-        const kvs::UInt32 v7 = connections[ connection_index + 7 ];
-        connection_index += 8;
-
-        // Local faces of the cell (6 quadrangle meshes).
-        face_map->insert( v0, v1, v2, v3 );
-        face_map->insert( v4, v5, v6, v7 );
-        face_map->insert( v0, v3, v7, v4 );
-        face_map->insert( v3, v2, v6, v7 );
-        face_map->insert( v1, v2, v6, v5 );
-        face_map->insert( v0, v1, v5, v4 );
+        kvs::UInt32 id[N];
+        m_table->vertices( index, &id );
+        kvs::UInt32 sum = 0;
+        for ( size_t i = 0; i < N; i++ ) { sum += id[i]; }
+        return sum % m_nnodes;
     }
-}
 
-/*===========================================================================*/
-/**
- *  @brief  Creates a face map for the quadratic hexahedral cells.
- *  @param  volume [in] pointer to the unstructured volume object
- *  @param  face_map [out] pointer to the face map
- */
-/*===========================================================================*/
-inline void CreateQuadraticHexahedraFaceMap(
-    const kvs::UnstructuredVolumeObject* volume,
-    QuadrangleFaceMap* face_map )
-{
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
+    bool operator ()( const kvs::UInt32 lhs, const kvs::UInt32 rhs ) const
     {
-        // Local vertices of the quadratic tetrahedral cell.
-        const kvs::UInt32 v0  = connections[ connection_index      ];
-        const kvs::UInt32 v1  = connections[ connection_index +  1 ];
-        const kvs::UInt32 v2  = connections[ connection_index +  2 ];
-        const kvs::UInt32 v3  = connections[ connection_index +  3 ];
-        const kvs::UInt32 v4  = connections[ connection_index +  4 ];
-        const kvs::UInt32 v5  = connections[ connection_index +  5 ];
-        const kvs::UInt32 v6  = connections[ connection_index +  6 ];
-        const kvs::UInt32 v7  = connections[ connection_index +  7 ];
-        // TO DO: Ingore the quadratic nodes...
-        /*
-        const kvs::UInt32 v8  = connections[ connection_index +  8 ];
-        const kvs::UInt32 v9  = connections[ connection_index +  9 ];
-        const kvs::UInt32 v10 = connections[ connection_index + 10 ];
-        const kvs::UInt32 v11 = connections[ connection_index + 11 ];
-        const kvs::UInt32 v12 = connections[ connection_index + 12 ];
-        const kvs::UInt32 v13 = connections[ connection_index + 13 ];
-        const kvs::UInt32 v14 = connections[ connection_index + 14 ];
-        const kvs::UInt32 v15 = connections[ connection_index + 15 ];
-        const kvs::UInt32 v16 = connections[ connection_index + 16 ];
-        const kvs::UInt32 v17 = connections[ connection_index + 17 ];
-        const kvs::UInt32 v18 = connections[ connection_index + 18 ];
-        const kvs::UInt32 v19 = connections[ connection_index + 19 ];
-        */
-        connection_index += 20;
-
-        // Local faces of the cell (6 quadrangle meshes).
-        face_map->insert( v0, v1, v2, v3 );
-        face_map->insert( v4, v5, v6, v7 );
-        face_map->insert( v0, v3, v7, v4 );
-        face_map->insert( v3, v2, v6, v7 );
-        face_map->insert( v1, v2, v6, v5 );
-        face_map->insert( v0, v1, v5, v4 );
+        const kvs::UInt32 lhs_key = this->key( lhs );
+        const kvs::UInt32 rhs_key = this->key( rhs );
+        return lhs_key != rhs_key ? lhs_key < rhs_key : lhs < rhs;
     }
-}
+};
 
 /*===========================================================================*/
 /**
- *  @brief  Calculates external faces using the face map.
+ *  @brief  Calculates external faces.
  *  @param  volume [in] pointer to the unstructured volume object
  *  @param  cmap [in] color map
- *  @param  face_map [in] face map
+ *  @param  table [in] face table
+ *  @param  faces [in] face indices of the external faces
  *  @param  coords [out] pointer to the coordinate value array
  *  @param  colors [out] pointer to the color value array
  *  @param  normals [out] pointer to the normal vector array
  */
 /*===========================================================================*/
-template <typename T>
+template <typename T, size_t N>
 void CalculateFaces(
     const kvs::UnstructuredVolumeObject* volume,
     const kvs::ColorMap cmap,
-    const TriangleFaceMap& face_map,
+    const FaceTable<N>& table,
+    const std::vector<kvs::UInt32>& faces,
     kvs::ValueArray<kvs::Real32>* coords,
     kvs::ValueArray<kvs::UInt8>* colors,
     kvs::ValueArray<kvs::Real32>* normals )
@@ -660,8 +349,8 @@ void CalculateFaces(
     const size_t veclen = volume->veclen();
     const T* value = reinterpret_cast<const T*>( volume->values().data() );
 
-    const size_t nfaces = face_map.bucket().size();
-    const size_t nvertices = nfaces * 3;
+    const size_t nfaces = faces.size();
+    const size_t nvertices = nfaces * N;
     const kvs::Real32* volume_coord = volume->coords().data();
 
     coords->allocate( nvertices * 3 );
@@ -671,154 +360,74 @@ void CalculateFaces(
     kvs::UInt8* color = colors->data();
     kvs::Real32* normal = normals->data();
 
-    kvs::UInt32 node_index[3] = { 0, 0, 0 };
-    kvs::UInt32 color_level[3] = { 0, 0, 0 };
-
-    TriangleFaceMap::Bucket::const_iterator f = face_map.bucket().begin();
-    TriangleFaceMap::Bucket::const_iterator last = face_map.bucket().end();
-    while ( f != last )
+    kvs::UInt32 node_index[N];
+    kvs::UInt32 color_level[N];
+    for ( size_t face = 0; face < nfaces; face++ )
     {
-        node_index[0] = f->second.id(0);
-        node_index[1] = f->second.id(1);
-        node_index[2] = f->second.id(2);
+        table.vertices( faces[ face ], &node_index );
+
+        for ( size_t i = 0; i < N; i++ )
+        {
+            const kvs::Real32* v = volume_coord + 3 * node_index[i];
+            *( coord++ ) = v[0];
+            *( coord++ ) = v[1];
+            *( coord++ ) = v[2];
+        }
+
+        GetColorIndices<N>( value, min_value, max_value, veclen, cmap.resolution(), node_index, &color_level );
+        for ( size_t i = 0; i < N; i++ )
+        {
+            *( color++ ) = cmap[ color_level[i] ].red();
+            *( color++ ) = cmap[ color_level[i] ].green();
+            *( color++ ) = cmap[ color_level[i] ].blue();
+        }
 
         const kvs::Vector3f v0( volume_coord + 3 * node_index[0] );
         const kvs::Vector3f v1( volume_coord + 3 * node_index[1] );
         const kvs::Vector3f v2( volume_coord + 3 * node_index[2] );
-        // v0
-        *( coord++ ) = v0.x();
-        *( coord++ ) = v0.y();
-        *( coord++ ) = v0.z();
-        // v1
-        *( coord++ ) = v1.x();
-        *( coord++ ) = v1.y();
-        *( coord++ ) = v1.z();
-        // v2
-        *( coord++ ) = v2.x();
-        *( coord++ ) = v2.y();
-        *( coord++ ) = v2.z();
-
-        GetColorIndices<3>( value, min_value, max_value, veclen, cmap.resolution(), node_index, &color_level );
-        // c0
-        *( color++ ) = cmap[ color_level[0] ].red();
-        *( color++ ) = cmap[ color_level[0] ].green();
-        *( color++ ) = cmap[ color_level[0] ].blue();
-        // c1
-        *( color++ ) = cmap[ color_level[1] ].red();
-        *( color++ ) = cmap[ color_level[1] ].green();
-        *( color++ ) = cmap[ color_level[1] ].blue();
-        // c2
-        *( color++ ) = cmap[ color_level[2] ].red();
-        *( color++ ) = cmap[ color_level[2] ].green();
-        *( color++ ) = cmap[ color_level[2] ].blue();
-
         const kvs::Vector3f n( ( v1 - v0 ).cross( v2 - v0 ) );
-        // n0
         *( normal++ ) = n.x();
         *( normal++ ) = n.y();
         *( normal++ ) = n.z();
-
-        f++;
     }
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Calculates external faces using the face map.
+ *  @brief  Extracts external faces.
  *  @param  volume [in] pointer to the unstructured volume object
  *  @param  cmap [in] color map
- *  @param  face_map [in] face map
+ *  @param  table [in] face table
+ *  @param  hash_order [in] if true, the faces are sorted in the hash order
+ *  @param  nthreads [in] number of threads
  *  @param  coords [out] pointer to the coordinate value array
  *  @param  colors [out] pointer to the color value array
  *  @param  normals [out] pointer to the normal vector array
+ *  @return false, if the number of faces exceeds the range of the face index
  */
 /*===========================================================================*/
-template <typename T>
-void CalculateFaces(
+template <typename T, size_t N>
+bool ExtractExternalFaces(
     const kvs::UnstructuredVolumeObject* volume,
     const kvs::ColorMap cmap,
-    const QuadrangleFaceMap& face_map,
+    const FaceTable<N>& table,
+    const bool hash_order,
+    const size_t nthreads,
     kvs::ValueArray<kvs::Real32>* coords,
     kvs::ValueArray<kvs::UInt8>* colors,
     kvs::ValueArray<kvs::Real32>* normals )
 {
-    // Parameters of the volume data.
-    if ( !volume->hasMinMaxValues() ) { volume->updateMinMaxValues(); }
-    const kvs::Real64 min_value = volume->minValue();
-    const kvs::Real64 max_value = volume->maxValue();
-    const size_t veclen = volume->veclen();
-    const T* value = reinterpret_cast<const T*>( volume->values().data() );
-
-    const size_t nfaces = face_map.bucket().size();
-    const size_t nvertices = nfaces * 4;
-    const kvs::Real32* volume_coord = volume->coords().data();
-
-    coords->allocate( nvertices * 3 );
-    colors->allocate( nvertices * 3 );
-    normals->allocate( nfaces * 3 );
-    kvs::Real32* coord = coords->data();
-    kvs::UInt8* color = colors->data();
-    kvs::Real32* normal = normals->data();
-
-    kvs::UInt32 node_index[4] = { 0, 0, 0, 0 };
-    kvs::UInt32 color_level[4] = { 0, 0, 0, 0 };
+    const size_t nfaces = volume->numberOfCells() * table.nfaces_per_cell;
+    if ( nfaces > size_t( kvs::Value<kvs::UInt32>::Max() ) ) { return false; }
 
-    QuadrangleFaceMap::Bucket::const_iterator f = face_map.bucket().begin();
-    QuadrangleFaceMap::Bucket::const_iterator last = face_map.bucket().end();
-    while ( f != last )
+    std::vector<kvs::UInt32> faces = FindExternalFaces<N>( table, nfaces, nthreads );
+    if ( hash_order )
     {
-        node_index[0] = f->second.id(0);
-        node_index[1] = f->second.id(1);
-        node_index[2] = f->second.id(2);
-        node_index[3] = f->second.id(3);
-
-        const kvs::Vector3f v0( volume_coord + 3 * node_index[0] );
-        const kvs::Vector3f v1( volume_coord + 3 * node_index[1] );
-        const kvs::Vector3f v2( volume_coord + 3 * node_index[2] );
-        const kvs::Vector3f v3( volume_coord + 3 * node_index[3] );
-        // v0
-        *( coord++ ) = v0.x();
-        *( coord++ ) = v0.y();
-        *( coord++ ) = v0.z();
-        // v1
-        *( coord++ ) = v1.x();
-        *( coord++ ) = v1.y();
-        *( coord++ ) = v1.z();
-        // v2
-        *( coord++ ) = v2.x();
-        *( coord++ ) = v2.y();
-        *( coord++ ) = v2.z();
-        // v3
-        *( coord++ ) = v3.x();
-        *( coord++ ) = v3.y();
-        *( coord++ ) = v3.z();
-
-        GetColorIndices<4>( value, min_value, max_value, veclen, cmap.resolution(), node_index, &color_level );
-        // c0
-        *( color++ ) = cmap[ color_level[0] ].red();
-        *( color++ ) = cmap[ color_level[0] ].green();
-        *( color++ ) = cmap[ color_level[0] ].blue();
-        // c1
-        *( color++ ) = cmap[ color_level[1] ].red();
-        *( color++ ) = cmap[ color_level[1] ].green();
-        *( color++ ) = cmap[ color_level[1] ].blue();
-        // c2
-        *( color++ ) = cmap[ color_level[2] ].red();
-        *( color++ ) = cmap[ color_level[2] ].green();
-        *( color++ ) = cmap[ color_level[2] ].blue();
-        // c3
-        *( color++ ) = cmap[ color_level[3] ].red();
-        *( color++ ) = cmap[ color_level[3] ].green();
-        *( color++ ) = cmap[ color_level[3] ].blue();
-
-        const kvs::Vector3f n( ( v1 - v0 ).cross( v2 - v0 ) );
-        // n0
-        *( normal++ ) = n.x();
-        *( normal++ ) = n.y();
-        *( normal++ ) = n.z();
-
-        f++;
+        std::sort( faces.begin(), faces.end(), HashOrderLess<N>( &table, volume->numberOfNodes() ) );
     }
+
+    CalculateFaces<T,N>( volume, cmap, table, faces, coords, colors, normals );
+    return true;
 }
 
 } // end of namespace
@@ -834,7 +443,9 @@ namespace kvs
 /*===========================================================================*/
 ExternalFaces::ExternalFaces():
     kvs::MapperBase(),
-    kvs::PolygonObject()
+    kvs::PolygonObject(),
+    m_face_order( CellOrder ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
 }
 
@@ -846,7 +457,9 @@ ExternalFaces::ExternalFaces():
 /*===========================================================================*/
 ExternalFaces::ExternalFaces( const kvs::VolumeObjectBase* volume ):
     kvs::MapperBase(),
-    kvs::PolygonObject()
+    kvs::PolygonObject(),
+    m_face_order( CellOrder ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     this->exec( volume );
 }
@@ -862,7 +475,9 @@ ExternalFaces::ExternalFaces(
     const kvs::VolumeObjectBase* volume,
     const kvs::TransferFunction& transfer_function ):
     kvs::MapperBase( transfer_function ),
-    kvs::PolygonObject()
+    kvs::PolygonObject(),
+    m_face_order( CellOrder ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     this->exec( volume );
 }
@@ -876,6 +491,17 @@ ExternalFaces::~ExternalFaces()
 {
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for finding the external faces.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void ExternalFaces::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the edge extraction.
@@ -1801,13 +1427,21 @@ void ExternalFaces::mapping( const kvs::UnstructuredVolumeObject* volume )
 template <typename T>
 void ExternalFaces::calculate_tetrahedral_faces( const kvs::UnstructuredVolumeObject* volume )
 {
-    ::TriangleFaceMap face_map( volume->numberOfNodes() );
-    CreateTetrahedraFaceMap( volume, &face_map );
+    ::FaceTable<3> table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 4;
+    table.nfaces_per_cell = 4;
+    table.faces = ::TetrahedraFaces;
 
     kvs::ValueArray<kvs::Real32> coords;
     kvs::ValueArray<kvs::UInt8> colors;
     kvs::ValueArray<kvs::Real32> normals;
-    ::CalculateFaces<T>( volume, BaseClass::colorMap(), face_map, &coords, &colors, &normals );
+    if ( !::ExtractExternalFaces<T>( volume, BaseClass::colorMap(), table, m_face_order == HashOrder, m_number_of_threads, &coords, &colors, &normals ) )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Too many faces.");
+        return;
+    }
 
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setCoords( coords );
@@ -1824,13 +1458,21 @@ void ExternalFaces::calculate_tetrahedral_faces( const kvs::UnstructuredVolumeOb
 template <typename T>
 void ExternalFaces::calculate_quadratic_tetrahedral_faces( const kvs::UnstructuredVolumeObject* volume )
 {
-    ::TriangleFaceMap face_map( volume->numberOfNodes() );
-    CreateQuadraticTetrahedraFaceMap( volume, &face_map );
+    ::FaceTable<3> table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 10;
+    table.nfaces_per_cell = 16;
+    table.faces = ::QuadraticTetrahedraFaces;
 
     kvs::ValueArray<kvs::Real32> coords;
     kvs::ValueArray<kvs::UInt8> colors;
     kvs::ValueArray<kvs::Real32> normals;
-    ::CalculateFaces<T>( volume, BaseClass::colorMap(), face_map, &coords, &colors, &normals );
+    if ( !::ExtractExternalFaces<T>( volume, BaseClass::colorMap(), table, m_face_order == HashOrder, m_number_of_threads, &coords, &colors, &normals ) )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Too many faces.");
+        return;
+    }
 
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setCoords( coords );
@@ -1847,13 +1489,21 @@ void ExternalFaces::calculate_quadratic_tetrahedral_faces( const kvs::Unstructur
 template <typename T>
 void ExternalFaces::calculate_hexahedral_faces( const kvs::UnstructuredVolumeObject* volume )
 {
-    ::QuadrangleFaceMap face_map( volume->numberOfNodes() );
-    CreateHexahedraFaceMap( volume, &face_map );
+    ::FaceTable<4> table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 8;
+    table.nfaces_per_cell = 6;
+    table.faces = ::HexahedraFaces;
 
     kvs::ValueArray<kvs::Real32> coords;
     kvs::ValueArray<kvs::UInt8> colors;
     kvs::ValueArray<kvs::Real32> normals;
-    ::CalculateFaces<T>( volume, BaseClass::colorMap(), face_map, &coords, &colors, &normals );
+    if ( !::ExtractExternalFaces<T>( volume, BaseClass::colorMap(), table, m_face_order == HashOrder, m_number_of_threads, &coords, &colors, &normals ) )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Too many faces.");
+        return;
+    }
 
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setCoords( coords );
@@ -1870,13 +1520,22 @@ void ExternalFaces::calculate_hexahedral_faces( const kvs::UnstructuredVolumeObj
 template <typename T>
 void ExternalFaces::calculate_quadratic_hexahedral_faces( const kvs::UnstructuredVolumeObject* volume )
 {
-    ::QuadrangleFaceMap face_map( volume->numberOfNodes() );
-    CreateQuadraticHexahedraFaceMap( volume, &face_map );
+    // TO DO: Ingore the quadratic nodes...
+    ::FaceTable<4> table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 20;
+    table.nfaces_per_cell = 6;
+    table.faces = ::HexahedraFaces;
 
     kvs::ValueArray<kvs::Real32> coords;
     kvs::ValueArray<kvs::UInt8> colors;
     kvs::ValueArray<kvs::Real32> normals;
-    ::CalculateFaces<T>( volume, BaseClass::colorMap(), face_map, &coords, &colors, &normals );
+    if ( !::ExtractExternalFaces<T>( volume, BaseClass::colorMap(), table, m_face_order == HashOrder, m_number_of_threads, &coords, &colors, &normals ) )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Too many faces.");
+        return;
+    }
 
     SuperClass::setPolygonType( kvs::PolygonObject::Quadrangle );
     SuperClass::setCoords( coords );
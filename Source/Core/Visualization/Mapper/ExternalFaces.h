@@ -39,6 +39,19 @@ class ExternalFaces : public kvs::MapperBase, public kvs::PolygonObject
     kvsModuleBaseClass( kvs::MapperBase );
     kvsModuleSuperClass( kvs::PolygonObject );
 
+public:
+
+    enum FaceOrder
+    {
+        CellOrder, ///< external faces in the order of the cells
+        HashOrder ///< external faces in the order of the previous multimap-based implementation
+    };
+
+private:
+
+    FaceOrder m_face_order; ///< order of the external faces of the unstructured volume
+    size_t m_number_of_threads; ///< number of threads for finding the external faces
+
 public:
 
     ExternalFaces();
@@ -46,6 +59,11 @@ public:
     ExternalFaces( const kvs::VolumeObjectBase* volume, const kvs::TransferFunction& transfer_function );
     virtual ~ExternalFaces();
 
+    FaceOrder faceOrder() const { return m_face_order; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    void setFaceOrder( const FaceOrder order ) { m_face_order = order; }
+    void setNumberOfThreads( const size_t nthreads );
+
     SuperClass* exec( const kvs::ObjectBase* object );
 
 private:
@@ -19,7 +19,10 @@
 #include <kvs/TransferFunction>
 #include <kvs/IgnoreUnusedVariable>
 #include <kvs/Timer>
-#include <map>
+#include <kvs/Thread>
+#include <kvs/Math>
+#include <vector>
+#include <algorithm>
 
 
 namespace
@@ -27,95 +30,287 @@ namespace
 
 /*===========================================================================*/
 /**
- *  @brief  Edge map class (hash map table for the edge data).
+ *  @brief  Local edges of the cells.
+ *
+ *  Each edge is given by the local vertex indices of the cell. The edges of
+ *  the quadratic cells are divided at the quadratic nodes.
+ */
+/*===========================================================================*/
+const size_t TetrahedraEdges[6][2] = {
+    { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 2, 3 }, { 3, 1 } };
+
+const size_t HexahedraEdges[12][2] = {
+    { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+    { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+
+const size_t QuadraticTetrahedraEdges[12][2] = {
+    { 0, 4 }, { 4, 1 }, { 0, 5 }, { 5, 2 }, { 0, 6 }, { 6, 3 },
+    { 1, 7 }, { 7, 2 }, { 2, 8 }, { 8, 3 }, { 3, 9 }, { 9, 1 } };
+
+const size_t QuadraticHexahedraEdges[24][2] = {
+    { 0,  8 }, {  8, 1 }, { 1,  9 }, {  9, 2 }, { 2, 10 }, { 10, 3 },
+    { 3, 11 }, { 11, 0 }, { 4, 12 }, { 12, 5 }, { 5, 13 }, { 13, 6 },
+    { 6, 14 }, { 14, 7 }, { 7, 15 }, { 15, 4 }, { 0, 16 }, { 16, 4 },
+    { 1, 17 }, { 17, 5 }, { 2, 18 }, { 18, 6 }, { 3, 19 }, { 19, 7 } };
+
+const size_t PrismEdges[9][2] = {
+    { 0, 1 }, { 1, 2 }, { 2, 0 }, { 3, 4 }, { 4, 5 }, { 5, 3 },
+    { 0, 3 }, { 1, 4 }, { 2, 5 } };
+
+/*===========================================================================*/
+/**
+ *  @brief  Edge table of the unstructured volume object.
+ */
+/*===========================================================================*/
+struct EdgeTable
+{
+    const kvs::UInt32* connections; ///< connections of the volume
+    size_t nnodes_per_cell; ///< number of nodes per cell
+    size_t nedges_per_cell; ///< number of edges per cell
+    const size_t (*edges)[2]; ///< local edges of the cell
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for the edge deduplication.
+ *
+ *  An edge is represented by a 64-bit key with the smaller vertex ID in the
+ *  upper bits and the larger one in the lower bits, so that the same edges
+ *  have the same key. The keys are sorted with the LSD radix sort, in which
+ *  each thread counts and scatters the digits of its own range of the keys.
  */
 /*===========================================================================*/
-class EdgeMap
+class EdgeSorter : public kvs::Thread
 {
 public:
 
-    typedef kvs::UInt32 Key;
-    typedef std::pair<kvs::UInt32,kvs::UInt32> Value;
-    typedef std::multimap<Key,Value> Bucket;
+    enum { RadixBits = 11, RadixSize = 1 << RadixBits };
+
+    enum Task
+    {
+        MakeKeys,
+        CountDigits,
+        ScatterKeys,
+        CountEdges,
+        WriteEdges
+    };
 
 private:
 
-    size_t m_nvertices; ///< number of vertices of the original data
-    Bucket m_bucket; ///< bucket for the edge data
+    Task m_task; ///< task of the thread
+    const EdgeTable* m_table; ///< edge table
+    size_t m_nbits; ///< number of bits for each vertex ID in the key
+    size_t m_begin; ///< first index of the range (cell or key)
+    size_t m_end; ///< last index of the range (cell or key)
+    const kvs::UInt64* m_src; ///< source keys
+    kvs::UInt64* m_dst; ///< destination keys
+    size_t m_shift; ///< bit shift of the digit
+    size_t m_count[ RadixSize ]; ///< number of keys (or the offset) of each digit
+    size_t m_nedges; ///< number of unique edges (or the offset) of the range
+    kvs::UInt32* m_connections; ///< connections of the line object
 
 public:
 
-    EdgeMap( const size_t nvertices );
+    EdgeSorter():
+        m_task( MakeKeys ),
+        m_table( NULL ),
+        m_nbits( 0 ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_src( NULL ),
+        m_dst( NULL ),
+        m_shift( 0 ),
+        m_nedges( 0 ),
+        m_connections( NULL ) {}
+
+    size_t* count() { return m_count; }
+    size_t& nedges() { return m_nedges; }
+
+    void setRange( const size_t begin, const size_t end, const size_t nbits )
+    {
+        m_begin = begin;
+        m_end = end;
+        m_nbits = nbits;
+    }
 
-public:
+    void setTask( const Task task ) { m_task = task; }
+    void setTable( const EdgeTable* table ) { m_table = table; }
+    void setKeys( const kvs::UInt64* src, kvs::UInt64* dst ) { m_src = src; m_dst = dst; }
+    void setShift( const size_t shift ) { m_shift = shift; }
+    void setConnections( kvs::UInt32* connections ) { m_connections = connections; }
 
-    void insert( const kvs::UInt32 v0, const kvs::UInt32 v1 );
+    void run()
+    {
+        switch ( m_task )
+        {
+        case MakeKeys: this->make_keys(); break;
+        case CountDigits: this->count_digits(); break;
+        case ScatterKeys: this->scatter_keys(); break;
+        case CountEdges: this->count_edges(); break;
+        case WriteEdges: this->write_edges(); break;
+        default: break;
+        }
+    }
 
-    const kvs::ValueArray<kvs::UInt32> serialize();
+private:
+
+    void make_keys()
+    {
+        const size_t nnodes_per_cell = m_table->nnodes_per_cell;
+        const size_t nedges_per_cell = m_table->nedges_per_cell;
+        kvs::UInt64* key = m_dst + m_begin * nedges_per_cell;
+        for ( size_t cell = m_begin; cell < m_end; cell++ )
+        {
+            const kvs::UInt32* id = m_table->connections + cell * nnodes_per_cell;
+            for ( size_t i = 0; i < nedges_per_cell; i++ )
+            {
+                const kvs::UInt64 v0 = id[ m_table->edges[i][0] ];
+                const kvs::UInt64 v1 = id[ m_table->edges[i][1] ];
+                *( key++ ) = v0 < v1 ? ( v0 << m_nbits ) | v1 : ( v1 << m_nbits ) | v0;
+            }
+        }
+    }
+
+    void count_digits()
+    {
+        std::fill( m_count, m_count + RadixSize, 0 );
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            m_count[ ( m_src[i] >> m_shift ) & ( RadixSize - 1 ) ]++;
+        }
+    }
+
+    void scatter_keys()
+    {
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            m_dst[ m_count[ ( m_src[i] >> m_shift ) & ( RadixSize - 1 ) ]++ ] = m_src[i];
+        }
+    }
+
+    void count_edges()
+    {
+        m_nedges = 0;
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            if ( i == 0 || m_src[i] != m_src[ i - 1 ] ) { m_nedges++; }
+        }
+    }
+
+    void write_edges()
+    {
+        const kvs::UInt64 mask = ( kvs::UInt64(1) << m_nbits ) - 1;
+        kvs::UInt32* connection = m_connections + 2 * m_nedges;
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            if ( i == 0 || m_src[i] != m_src[ i - 1 ] )
+            {
+                *( connection++ ) = static_cast<kvs::UInt32>( m_src[i] >> m_nbits );
+                *( connection++ ) = static_cast<kvs::UInt32>( m_src[i] & mask );
+            }
+        }
+    }
 };
 
 /*===========================================================================*/
 /**
- *  @brief  Constructs a new EdgeMap class.
- *  @param  nvertices [in] number of vertices of the orignal volume data
+ *  @brief  Runs the given task with the threads.
+ *  @param  sorters [in/out] threads
+ *  @param  task [in] task
  */
 /*===========================================================================*/
-EdgeMap::EdgeMap( const size_t nvertices ):
-    m_nvertices( nvertices )
+void Run( std::vector<EdgeSorter>& sorters, const EdgeSorter::Task task )
 {
+    const size_t nthreads = sorters.size();
+    for ( size_t i = 0; i < nthreads; i++ ) { sorters[i].setTask( task ); }
+    kvs::Thread::Run( &sorters[0], nthreads );
 }
 
 /*===========================================================================*/
 /**
- *  @brief  Inserts an edge information (both end vertex)
- *  @param  v0 [in] vertex id 0
- *  @param  v1 [in] vertex id 1
+ *  @brief  Extracts the unique edges of the cells.
+ *  @param  table [in] edge table
+ *  @param  ncells [in] number of cells
+ *  @param  nnodes [in] number of nodes
+ *  @param  nthreads [in] number of threads
+ *  @return connections of the unique edges in ascending order of the keys
  */
 /*===========================================================================*/
-void EdgeMap::insert( const kvs::UInt32 v0, const kvs::UInt32 v1 )
+kvs::ValueArray<kvs::UInt32> ExtractUniqueEdges(
+    const EdgeTable& table,
+    const size_t ncells,
+    const size_t nnodes,
+    const size_t nthreads )
 {
-    const Key key = ( v0 + v1 ) % kvs::UInt32( m_nvertices );
+    const size_t nkeys = ncells * table.nedges_per_cell;
+    if ( nkeys == 0 ) { return kvs::ValueArray<kvs::UInt32>(); }
+
+    // Number of bits for each vertex ID in the key.
+    size_t nbits = 1;
+    while ( nbits < 32 && ( kvs::UInt64(1) << nbits ) < kvs::UInt64( nnodes ) ) { nbits++; }
+
+    const size_t nranges = kvs::Math::Max( size_t(1), kvs::Math::Min( nthreads, ncells ) );
+    std::vector<EdgeSorter> sorters( nranges );
+
+    // Keys of the edges of each range of the cells.
+    kvs::ValueArray<kvs::UInt64> keys( nkeys );
+    kvs::ValueArray<kvs::UInt64> work( nkeys );
+    for ( size_t i = 0; i < nranges; i++ )
+    {
+        sorters[i].setRange( ncells * i / nranges, ncells * ( i + 1 ) / nranges, nbits );
+        sorters[i].setTable( &table );
+        sorters[i].setKeys( NULL, keys.data() );
+    }
+    ::Run( sorters, EdgeSorter::MakeKeys );
 
-    Bucket::iterator e = m_bucket.find( key );
-    Bucket::const_iterator last = m_bucket.end();
-    if ( e != last )
+    // LSD radix sort of the keys, in which each thread takes a range of the keys.
+    for ( size_t i = 0; i < nranges; i++ )
     {
-        Bucket::const_iterator upper = m_bucket.upper_bound( key );
-        while ( e != upper )
+        sorters[i].setRange( nkeys * i / nranges, nkeys * ( i + 1 ) / nranges, nbits );
+    }
+    kvs::UInt64* src = keys.data();
+    kvs::UInt64* dst = work.data();
+    for ( size_t shift = 0; shift < 2 * nbits; shift += EdgeSorter::RadixBits )
+    {
+        for ( size_t i = 0; i < nranges; i++ )
         {
-            if ( ( e->second.first == v0 && e->second.second == v1 ) ||
-                 ( e->second.first == v1 && e->second.second == v0 ) )
+            sorters[i].setKeys( src, dst );
+            sorters[i].setShift( shift );
+        }
+        ::Run( sorters, EdgeSorter::CountDigits );
+
+        // Offset of each digit for each thread, in the order of (digit, thread).
+        size_t offset = 0;
+        for ( size_t digit = 0; digit < EdgeSorter::RadixSize; digit++ )
+        {
+            for ( size_t i = 0; i < nranges; i++ )
             {
-                // The edge has been already inserted in the bucket.
-                return;
+                const size_t count = sorters[i].count()[ digit ];
+                sorters[i].count()[ digit ] = offset;
+                offset += count;
             }
-            e++;
         }
+        ::Run( sorters, EdgeSorter::ScatterKeys );
+        std::swap( src, dst );
     }
 
-    m_bucket.insert( std::make_pair( key, std::make_pair( v0, v1 ) ) );
-}
+    // Unique edges.
+    for ( size_t i = 0; i < nranges; i++ ) { sorters[i].setKeys( src, NULL ); }
+    ::Run( sorters, EdgeSorter::CountEdges );
 
-/*===========================================================================*/
-/**
- *  @brief  Serializes the edge map.
- *  @return serialized indices of the end vertices of the edges in the edge map
- */
-/*===========================================================================*/
-const kvs::ValueArray<kvs::UInt32> EdgeMap::serialize()
-{
-    kvs::ValueArray<kvs::UInt32> connections( 2 * m_bucket.size() );
-
-    Bucket::const_iterator e = m_bucket.begin();
-    Bucket::const_iterator last = m_bucket.end();
-    size_t connection_index = 0;
-    while ( e != last )
+    size_t nedges = 0;
+    for ( size_t i = 0; i < nranges; i++ )
     {
-        connections[ connection_index++ ] = e->second.first;
-        connections[ connection_index++ ] = e->second.second;
-        e++;
+        const size_t count = sorters[i].nedges();
+        sorters[i].nedges() = nedges;
+        nedges += count;
     }
 
+    kvs::ValueArray<kvs::UInt32> connections( 2 * nedges );
+    for ( size_t i = 0; i < nranges; i++ ) { sorters[i].setConnections( connections.data() ); }
+    ::Run( sorters, EdgeSorter::WriteEdges );
+
     return connections;
 }
 
@@ -132,7 +327,8 @@ namespace kvs
 /*===========================================================================*/
 ExtractEdges::ExtractEdges():
     kvs::MapperBase(),
-    kvs::LineObject()
+    kvs::LineObject(),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
 }
 
@@ -144,7 +340,8 @@ ExtractEdges::ExtractEdges():
 /*===========================================================================*/
 ExtractEdges::ExtractEdges( const kvs::VolumeObjectBase* volume ):
     kvs::MapperBase(),
-    kvs::LineObject()
+    kvs::LineObject(),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     this->exec( volume );
 }
@@ -160,7 +357,8 @@ ExtractEdges::ExtractEdges(
     const kvs::VolumeObjectBase* volume,
     const kvs::TransferFunction& transfer_function ):
     kvs::MapperBase( transfer_function ),
-    kvs::LineObject()
+    kvs::LineObject(),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     this->exec( volume );
 }
@@ -174,6 +372,17 @@ ExtractEdges::~ExtractEdges()
 {
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for extracting the edges.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void ExtractEdges::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the edge extraction.
@@ -463,28 +672,14 @@ void ExtractEdges::calculate_connections( const kvs::UnstructuredVolumeObject* v
 void ExtractEdges::calculate_tetrahedra_connections(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    const size_t nnodes = volume->numberOfNodes();
-
-    ::EdgeMap edge_map( nnodes );
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
-    {
-        const kvs::UInt32 local_vertex0 = connections[ connection_index     ];
-        const kvs::UInt32 local_vertex1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 local_vertex2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 local_vertex3 = connections[ connection_index + 3 ];
-        connection_index += 4;
-
-        edge_map.insert( local_vertex0, local_vertex1 );
-        edge_map.insert( local_vertex0, local_vertex2 );
-        edge_map.insert( local_vertex0, local_vertex3 );
-        edge_map.insert( local_vertex1, local_vertex2 );
-        edge_map.insert( local_vertex2, local_vertex3 );
-        edge_map.insert( local_vertex3, local_vertex1 );
-    }
-
-    SuperClass::setConnections( edge_map.serialize() );
+    ::EdgeTable table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 4;
+    table.nedges_per_cell = 6;
+    table.edges = ::TetrahedraEdges;
+
+    SuperClass::setConnections( ::ExtractUniqueEdges(
+        table, volume->numberOfCells(), volume->numberOfNodes(), m_number_of_threads ) );
 }
 
 /*===========================================================================*/
@@ -496,38 +691,14 @@ void ExtractEdges::calculate_tetrahedra_connections(
 void ExtractEdges::calculate_hexahedra_connections(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    const size_t nnodes = volume->numberOfNodes();
-
-    ::EdgeMap edge_map( nnodes );
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
-    {
-        const kvs::UInt32 local_vertex0 = connections[ connection_index     ];
-        const kvs::UInt32 local_vertex1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 local_vertex2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 local_vertex3 = connections[ connection_index + 3 ];
-        const kvs::UInt32 local_vertex4 = connections[ connection_index + 4 ];
-        const kvs::UInt32 local_vertex5 = connections[ connection_index + 5 ];
-        const kvs::UInt32 local_vertex6 = connections[ connection_index + 6 ];
-        const kvs::UInt32 local_vertex7 = connections[ connection_index + 7 ];
-        connection_index += 8;
-
-        edge_map.insert( local_vertex0, local_vertex1 );
-        edge_map.insert( local_vertex1, local_vertex2 );
-        edge_map.insert( local_vertex2, local_vertex3 );
-        edge_map.insert( local_vertex3, local_vertex0 );
-        edge_map.insert( local_vertex4, local_vertex5 );
-        edge_map.insert( local_vertex5, local_vertex6 );
-        edge_map.insert( local_vertex6, local_vertex7 );
-        edge_map.insert( local_vertex7, local_vertex4 );
-        edge_map.insert( local_vertex0, local_vertex4 );
-        edge_map.insert( local_vertex1, local_vertex5 );
-        edge_map.insert( local_vertex2, local_vertex6 );
-        edge_map.insert( local_vertex3, local_vertex7 );
-    }
-
-    SuperClass::setConnections( edge_map.serialize() );
+    ::EdgeTable table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 8;
+    table.nedges_per_cell = 12;
+    table.edges = ::HexahedraEdges;
+
+    SuperClass::setConnections( ::ExtractUniqueEdges(
+        table, volume->numberOfCells(), volume->numberOfNodes(), m_number_of_threads ) );
 }
 
 /*===========================================================================*/
@@ -539,40 +710,14 @@ void ExtractEdges::calculate_hexahedra_connections(
 void ExtractEdges::calculate_quadratic_tetrahedra_connections(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    const size_t nnodes = volume->numberOfNodes();
-
-    ::EdgeMap edge_map( nnodes );
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
-    {
-        const kvs::UInt32 local_vertex0 = connections[ connection_index     ];
-        const kvs::UInt32 local_vertex1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 local_vertex2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 local_vertex3 = connections[ connection_index + 3 ];
-        const kvs::UInt32 local_vertex4 = connections[ connection_index + 4 ];
-        const kvs::UInt32 local_vertex5 = connections[ connection_index + 5 ];
-        const kvs::UInt32 local_vertex6 = connections[ connection_index + 6 ];
-        const kvs::UInt32 local_vertex7 = connections[ connection_index + 7 ];
-        const kvs::UInt32 local_vertex8 = connections[ connection_index + 8 ];
-        const kvs::UInt32 local_vertex9 = connections[ connection_index + 9 ];
-        connection_index += 10;
-
-        edge_map.insert( local_vertex0, local_vertex4 );
-        edge_map.insert( local_vertex4, local_vertex1 );
-        edge_map.insert( local_vertex0, local_vertex5 );
-        edge_map.insert( local_vertex5, local_vertex2 );
-        edge_map.insert( local_vertex0, local_vertex6 );
-        edge_map.insert( local_vertex6, local_vertex3 );
-        edge_map.insert( local_vertex1, local_vertex7 );
-        edge_map.insert( local_vertex7, local_vertex2 );
-        edge_map.insert( local_vertex2, local_vertex8 );
-        edge_map.insert( local_vertex8, local_vertex3 );
-        edge_map.insert( local_vertex3, local_vertex9 );
-        edge_map.insert( local_vertex9, local_vertex1 );
-    }
-
-    SuperClass::setConnections( edge_map.serialize() );
+    ::EdgeTable table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 10;
+    table.nedges_per_cell = 12;
+    table.edges = ::QuadraticTetrahedraEdges;
+
+    SuperClass::setConnections( ::ExtractUniqueEdges(
+        table, volume->numberOfCells(), volume->numberOfNodes(), m_number_of_threads ) );
 }
 
 /*===========================================================================*/
@@ -584,93 +729,33 @@ void ExtractEdges::calculate_quadratic_tetrahedra_connections(
 void ExtractEdges::calculate_quadratic_hexahedra_connections(
     const kvs::UnstructuredVolumeObject* volume )
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    const size_t nnodes = volume->numberOfNodes();
-
-    ::EdgeMap edge_map( nnodes );
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
-    {
-        const kvs::UInt32 local_vertex0  = connections[ connection_index      ];
-        const kvs::UInt32 local_vertex1  = connections[ connection_index +  1 ];
-        const kvs::UInt32 local_vertex2  = connections[ connection_index +  2 ];
-        const kvs::UInt32 local_vertex3  = connections[ connection_index +  3 ];
-        const kvs::UInt32 local_vertex4  = connections[ connection_index +  4 ];
-        const kvs::UInt32 local_vertex5  = connections[ connection_index +  5 ];
-        const kvs::UInt32 local_vertex6  = connections[ connection_index +  6 ];
-        const kvs::UInt32 local_vertex7  = connections[ connection_index +  7 ];
-        const kvs::UInt32 local_vertex8  = connections[ connection_index +  8 ];
-        const kvs::UInt32 local_vertex9  = connections[ connection_index +  9 ];
-        const kvs::UInt32 local_vertex10 = connections[ connection_index + 10 ];
-        const kvs::UInt32 local_vertex11 = connections[ connection_index + 11 ];
-        const kvs::UInt32 local_vertex12 = connections[ connection_index + 12 ];
-        const kvs::UInt32 local_vertex13 = connections[ connection_index + 13 ];
-        const kvs::UInt32 local_vertex14 = connections[ connection_index + 14 ];
-        const kvs::UInt32 local_vertex15 = connections[ connection_index + 15 ];
-        const kvs::UInt32 local_vertex16 = connections[ connection_index + 16 ];
-        const kvs::UInt32 local_vertex17 = connections[ connection_index + 17 ];
-        const kvs::UInt32 local_vertex18 = connections[ connection_index + 18 ];
-        const kvs::UInt32 local_vertex19 = connections[ connection_index + 19 ];
-        connection_index += 20;
-
-        edge_map.insert( local_vertex0,  local_vertex8  );
-        edge_map.insert( local_vertex8,  local_vertex1  );
-        edge_map.insert( local_vertex1,  local_vertex9  );
-        edge_map.insert( local_vertex9,  local_vertex2  );
-        edge_map.insert( local_vertex2,  local_vertex10 );
-        edge_map.insert( local_vertex10, local_vertex3  );
-        edge_map.insert( local_vertex3,  local_vertex11 );
-        edge_map.insert( local_vertex11, local_vertex0  );
-        edge_map.insert( local_vertex4,  local_vertex12 );
-        edge_map.insert( local_vertex12, local_vertex5  );
-        edge_map.insert( local_vertex5,  local_vertex13 );
-        edge_map.insert( local_vertex13, local_vertex6  );
-        edge_map.insert( local_vertex6,  local_vertex14 );
-        edge_map.insert( local_vertex14, local_vertex7  );
-        edge_map.insert( local_vertex7,  local_vertex15 );
-        edge_map.insert( local_vertex15, local_vertex4  );
-        edge_map.insert( local_vertex0,  local_vertex16 );
-        edge_map.insert( local_vertex16, local_vertex4  );
-        edge_map.insert( local_vertex1,  local_vertex17 );
-        edge_map.insert( local_vertex17, local_vertex5  );
-        edge_map.insert( local_vertex2,  local_vertex18 );
-        edge_map.insert( local_vertex18, local_vertex6  );
-        edge_map.insert( local_vertex3,  local_vertex19 );
-        edge_map.insert( local_vertex19, local_vertex7  );
-    }
-
-    SuperClass::setConnections( edge_map.serialize() );
+    ::EdgeTable table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 20;
+    table.nedges_per_cell = 24;
+    table.edges = ::QuadraticHexahedraEdges;
+
+    SuperClass::setConnections( ::ExtractUniqueEdges(
+        table, volume->numberOfCells(), volume->numberOfNodes(), m_number_of_threads ) );
 }
 
-void ExtractEdges::calculate_prism_connections( const kvs::UnstructuredVolumeObject* volume )
+/*===========================================================================*/
+/**
+ *  @brief  Calculates connection values for the prism cells.
+ *  @param  volume [in] pointer to the unstructured volume object
+ */
+/*===========================================================================*/
+void ExtractEdges::calculate_prism_connections(
+    const kvs::UnstructuredVolumeObject* volume )
 {
-    const kvs::UInt32* connections = volume->connections().data();
-    const size_t ncells = volume->numberOfCells();
-    const size_t nnodes = volume->numberOfNodes();
-
-    ::EdgeMap edge_map( nnodes );
-    for ( size_t cell_index = 0, connection_index = 0; cell_index < ncells; cell_index++ )
-    {
-        const kvs::UInt32 local_vertex0 = connections[ connection_index     ];
-        const kvs::UInt32 local_vertex1 = connections[ connection_index + 1 ];
-        const kvs::UInt32 local_vertex2 = connections[ connection_index + 2 ];
-        const kvs::UInt32 local_vertex3 = connections[ connection_index + 3 ];
-        const kvs::UInt32 local_vertex4 = connections[ connection_index + 4 ];
-        const kvs::UInt32 local_vertex5 = connections[ connection_index + 5 ];
-        connection_index += 6;
-
-        edge_map.insert( local_vertex0, local_vertex1 );
-        edge_map.insert( local_vertex1, local_vertex2 );
-        edge_map.insert( local_vertex2, local_vertex0 );
-        edge_map.insert( local_vertex3, local_vertex4 );
-        edge_map.insert( local_vertex4, local_vertex5 );
-        edge_map.insert( local_vertex5, local_vertex3 );
-        edge_map.insert( local_vertex0, local_vertex3 );
-        edge_map.insert( local_vertex1, local_vertex4 );
-        edge_map.insert( local_vertex2, local_vertex5 );
-    }
-
-    SuperClass::setConnections( edge_map.serialize() );
+    ::EdgeTable table;
+    table.connections = volume->connections().data();
+    table.nnodes_per_cell = 6;
+    table.nedges_per_cell = 9;
+    table.edges = ::PrismEdges;
+
+    SuperClass::setConnections( ::ExtractUniqueEdges(
+        table, volume->numberOfCells(), volume->numberOfNodes(), m_number_of_threads ) );
 }
 
 /*===========================================================================*/
@@ -39,6 +39,10 @@ class ExtractEdges : public kvs::MapperBase, public kvs::LineObject
     kvsModuleBaseClass( kvs::MapperBase );
     kvsModuleSuperClass( kvs::LineObject );
 
+private:
+
+    size_t m_number_of_threads; ///< number of threads for extracting the edges
+
 public:
 
     ExtractEdges();
@@ -46,6 +50,9 @@ public:
     ExtractEdges( const kvs::VolumeObjectBase* volume, const kvs::TransferFunction& transfer_function );
     virtual ~ExtractEdges();
 
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    void setNumberOfThreads( const size_t nthreads );
+
     SuperClass* exec( const kvs::ObjectBase* object );
 
 private:
@@ -231,9 +231,9 @@ void HitAndMissSampling::generate_particles( const kvs::StructuredVolumeObject*
         } // end of j-loop
     } // end of k-loop
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
     SuperClass::setSize( 1.0f );
 }
 
@@ -20,6 +20,43 @@
 #include <kvs/MarchingPyramid>
 
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Extracts the isosurfaces with the given mapper.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  isolevel [in] isolevel
+ *  @param  normal_type [in] normal vector type
+ *  @param  duplication [in] duplication flag
+ *  @param  transfer_function [in] transfer function
+ *  @param  index [in] pointer to the min/max block index (NULL: not used)
+ *  @return pointer to the extracted polygon object
+ */
+/*===========================================================================*/
+template <typename Mapper>
+kvs::PolygonObject* CreateIsosurfaces(
+    const kvs::VolumeObjectBase* volume,
+    const double isolevel,
+    const kvs::PolygonObject::NormalType normal_type,
+    const bool duplication,
+    const kvs::TransferFunction& transfer_function,
+    kvs::MinMaxBlockIndex* index )
+{
+    Mapper* mapper = new Mapper();
+    mapper->setIsolevel( isolevel );
+    mapper->setNormalType( normal_type );
+    mapper->setDuplication( duplication );
+    mapper->setTransferFunction( transfer_function );
+    mapper->attachBlockIndex( index );
+    mapper->exec( volume );
+    return mapper;
+}
+
+} // end of namespace
+
+
 namespace kvs
 {
 
@@ -32,7 +69,8 @@ Isosurface::Isosurface():
     kvs::MapperBase(),
     kvs::PolygonObject(),
     m_isolevel( 0 ),
-    m_duplication( true )
+    m_duplication( true ),
+    m_block_index( NULL )
 {
 }
 
@@ -51,7 +89,8 @@ Isosurface::Isosurface(
     kvs::MapperBase(),
     kvs::PolygonObject(),
     m_isolevel( isolevel ),
-    m_duplication( true )
+    m_duplication( true ),
+    m_block_index( NULL )
 {
     SuperClass::setNormalType( normal_type );
 
@@ -84,7 +123,8 @@ Isosurface::Isosurface(
     kvs::MapperBase( transfer_function ),
     kvs::PolygonObject(),
     m_isolevel( isolevel ),
-    m_duplication( duplication )
+    m_duplication( duplication ),
+    m_block_index( NULL )
 {
     SuperClass::setNormalType( normal_type );
 
@@ -163,42 +203,17 @@ void Isosurface::mapping( const kvs::VolumeObjectBase* volume )
         return;
     }
 
+    // The block index is built at the first extraction and reused afterwards.
+    kvs::PolygonObject* polygon = NULL;
     if ( volume->volumeType() == kvs::VolumeObjectBase::Structured )
     {
-        const kvs::StructuredVolumeObject* structured_volume =
-            kvs::StructuredVolumeObject::DownCast( volume );
-
-        kvs::PolygonObject* polygon = new kvs::MarchingCubes(
-            structured_volume,
+        polygon = ::CreateIsosurfaces<kvs::MarchingCubes>(
+            volume,
             m_isolevel,
             SuperClass::normalType(),
             m_duplication,
-            BaseClass::transferFunction() );
-        if ( !polygon )
-        {
-            BaseClass::setSuccess( false );
-            kvsMessageError("Cannot create isosurfaces.");
-            return;
-        }
-
-        // Shallow copy.
-        SuperClass::setCoords( polygon->coords() );
-        SuperClass::setColors( polygon->colors() );
-        SuperClass::setNormals( polygon->normals() );
-        SuperClass::setConnections( polygon->connections() );
-        SuperClass::setOpacities( polygon->opacities() );
-        SuperClass::setPolygonType( polygon->polygonType() );
-        SuperClass::setColorType( polygon->colorType() );
-        SuperClass::setNormalType( polygon->normalType() );
-
-        SuperClass::setMinMaxObjectCoords(
-            polygon->minObjectCoord(),
-            polygon->maxObjectCoord() );
-        SuperClass::setMinMaxExternalCoords(
-            polygon->minExternalCoord(),
-            polygon->maxExternalCoord() );
-
-        delete polygon;
+            BaseClass::transferFunction(),
+            m_block_index );
     }
     else // volume->volumeType() == kvs::VolumeObjectBase::Unstructured
     {
@@ -208,113 +223,61 @@ void Isosurface::mapping( const kvs::VolumeObjectBase* volume )
         switch ( unstructured_volume->cellType() )
         {
         case kvs::UnstructuredVolumeObject::Tetrahedra:
-        {
-            kvs::PolygonObject* polygon = new kvs::MarchingTetrahedra(
-                unstructured_volume,
+            polygon = ::CreateIsosurfaces<kvs::MarchingTetrahedra>(
+                volume,
                 m_isolevel,
                 SuperClass::normalType(),
                 m_duplication,
-                BaseClass::transferFunction() );
-            if ( !polygon )
-            {
-                BaseClass::setSuccess( false );
-                kvsMessageError("Cannot create isosurfaces.");
-                return;
-            }
-
-            // Shallow copy.
-            SuperClass::setCoords( polygon->coords() );
-            SuperClass::setColors( polygon->colors() );
-            SuperClass::setNormals( polygon->normals() );
-            SuperClass::setConnections( polygon->connections() );
-            SuperClass::setOpacities( polygon->opacities() );
-            SuperClass::setPolygonType( polygon->polygonType() );
-            SuperClass::setColorType( polygon->colorType() );
-            SuperClass::setNormalType( polygon->normalType() );
-
-            SuperClass::setMinMaxObjectCoords(
-                polygon->minObjectCoord(),
-                polygon->maxObjectCoord() );
-            SuperClass::setMinMaxExternalCoords(
-                polygon->minExternalCoord(),
-                polygon->maxExternalCoord() );
-
-            delete polygon;
+                BaseClass::transferFunction(),
+                m_block_index );
             break;
-        }
         case kvs::UnstructuredVolumeObject::Hexahedra:
-        {
-            kvs::PolygonObject* polygon = new kvs::MarchingHexahedra(
-                unstructured_volume,
+            polygon = ::CreateIsosurfaces<kvs::MarchingHexahedra>(
+                volume,
                 m_isolevel,
                 SuperClass::normalType(),
                 m_duplication,
-                BaseClass::transferFunction() );
-            if ( !polygon )
-            {
-                kvsMessageError("Cannot create isosurfaces.");
-                return;
-            }
-
-            // Shallow copy.
-            SuperClass::setCoords( polygon->coords() );
-            SuperClass::setColors( polygon->colors() );
-            SuperClass::setNormals( polygon->normals() );
-            SuperClass::setConnections( polygon->connections() );
-            SuperClass::setOpacities( polygon->opacities() );
-            SuperClass::setPolygonType( polygon->polygonType() );
-            SuperClass::setColorType( polygon->colorType() );
-            SuperClass::setNormalType( polygon->normalType() );
-
-            SuperClass::setMinMaxObjectCoords(
-                polygon->minObjectCoord(),
-                polygon->maxObjectCoord() );
-            SuperClass::setMinMaxExternalCoords(
-                polygon->minExternalCoord(),
-                polygon->maxExternalCoord() );
-
-            delete polygon;
-
+                BaseClass::transferFunction(),
+                m_block_index );
             break;
-        }
         case kvs::UnstructuredVolumeObject::Pyramid:
-        {
-            kvs::PolygonObject* polygon = new kvs::MarchingPyramid(
-                unstructured_volume,
+            polygon = ::CreateIsosurfaces<kvs::MarchingPyramid>(
+                volume,
                 m_isolevel,
                 SuperClass::normalType(),
                 m_duplication,
-                BaseClass::transferFunction() );
-            if ( !polygon )
-            {
-                BaseClass::setSuccess( false );
-                kvsMessageError("Cannot create isosurfaces.");
-                return;
-            }
-
-            // Shallow copy.
-            SuperClass::setCoords( polygon->coords() );
-            SuperClass::setColors( polygon->colors() );
-            SuperClass::setNormals( polygon->normals() );
-            SuperClass::setConnections( polygon->connections() );
-            SuperClass::setOpacities( polygon->opacities() );
-            SuperClass::setPolygonType( polygon->polygonType() );
-            SuperClass::setColorType( polygon->colorType() );
-            SuperClass::setNormalType( polygon->normalType() );
-
-            SuperClass::setMinMaxObjectCoords(
-                polygon->minObjectCoord(),
-                polygon->maxObjectCoord() );
-            SuperClass::setMinMaxExternalCoords(
-                polygon->minExternalCoord(),
-                polygon->maxExternalCoord() );
-
-            delete polygon;
+                BaseClass::transferFunction(),
+                m_block_index );
             break;
-        }
-        default: break;
+        default: return;
         }
     }
+
+    if ( !polygon )
+    {
+        BaseClass::setSuccess( false );
+        kvsMessageError("Cannot create isosurfaces.");
+        return;
+    }
+
+    // Shallow copy.
+    SuperClass::setCoords( polygon->coords() );
+    SuperClass::setColors( polygon->colors() );
+    SuperClass::setNormals( polygon->normals() );
+    SuperClass::setConnections( polygon->connections() );
+    SuperClass::setOpacities( polygon->opacities() );
+    SuperClass::setPolygonType( polygon->polygonType() );
+    SuperClass::setColorType( polygon->colorType() );
+    SuperClass::setNormalType( polygon->normalType() );
+
+    SuperClass::setMinMaxObjectCoords(
+        polygon->minObjectCoord(),
+        polygon->maxObjectCoord() );
+    SuperClass::setMinMaxExternalCoords(
+        polygon->minExternalCoord(),
+        polygon->maxExternalCoord() );
+
+    delete polygon;
 }
 
 } // end of namespace kvs
@@ -19,6 +19,7 @@
 #include <kvs/VolumeObjectBase>
 #include <kvs/MapperBase>
 #include <kvs/Module>
+#include <kvs/MinMaxBlockIndex>
 
 
 namespace kvs
@@ -39,6 +40,7 @@ private:
 
     double m_isolevel; ///< isosurface level
     bool m_duplication; ///< duplication flag
+    kvs::MinMaxBlockIndex* m_block_index; ///< pointer to the min/max block index (not allocated)
 
 public:
 
@@ -56,6 +58,8 @@ public:
     virtual ~Isosurface();
 
     void setIsolevel( const double isolevel );
+    void setDuplication( const bool duplication ) { m_duplication = duplication; }
+    void attachBlockIndex( kvs::MinMaxBlockIndex* index ) { m_block_index = index; }
 
     SuperClass* exec( const kvs::ObjectBase* object );
 
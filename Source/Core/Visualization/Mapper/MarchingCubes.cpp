@@ -14,7 +14,427 @@
 /****************************************************************************/
 #include "MarchingCubes.h"
 #include "MarchingCubesTable.h"
-#include <cstring>
+#include <kvs/Thread>
+#include <kvs/Math>
+#include <vector>
+#include <algorithm>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Flag of the vertex index which refers to the next slab.
+ */
+/*===========================================================================*/
+const kvs::UInt32 ForeignVertex = 0x80000000;
+
+/*===========================================================================*/
+/**
+ *  @brief  Slab extractor class.
+ *
+ *  The cells of the volume are divided into slabs along the z-axis, and each
+ *  thread extracts the surfaces in its own slab. In the welded extraction,
+ *  the isopoints on the edges are numbered in the order of the nodes, and a
+ *  slab owns the isopoints on the edges starting from its own node layers.
+ *  The isopoints are cached in the edge-vertex maps of the bottom and top
+ *  node layers of the current cell layer. The isopoints on the top node
+ *  layer of the slab belong to the next slab, so that they are referred with
+ *  the ForeignVertex flag and stitched after all the slabs are extracted.
+ */
+/*===========================================================================*/
+template <typename T>
+class SlabExtractor : public kvs::Thread
+{
+private:
+
+    const T* m_values; ///< node values
+    kvs::Vector3ui m_resolution; ///< resolution of the volume
+    size_t m_line_size; ///< number of nodes per line
+    size_t m_slice_size; ///< number of nodes per slice
+    double m_isolevel; ///< isolevel
+    bool m_duplication; ///< duplication flag
+    bool m_vertex_normal; ///< true if the normal vectors are calculated on the vertices
+    size_t m_z0; ///< first cell layer of the slab
+    size_t m_z1; ///< last cell layer of the slab (not included)
+    bool m_last; ///< true if the slab is the last one
+    bool m_stitch; ///< true if the extracted surfaces are stitched in the output
+    const kvs::UInt8* m_active; ///< candidate flags of the blocks (NULL: all the cells are visited)
+    size_t m_block_size; ///< number of cells along each edge of the block
+    kvs::Vector3ui m_block_resolution; ///< number of blocks in each direction
+
+    std::vector<kvs::UInt32> m_map[2]; ///< edge-vertex maps of the bottom and top node layers
+    std::vector<kvs::Real32> m_coords; ///< coordinates of the isopoints owned by the slab
+    std::vector<kvs::Real32> m_normals; ///< normal vectors
+    std::vector<kvs::UInt32> m_connections; ///< connections
+    std::vector<kvs::Real32> m_foreign_coords; ///< coordinates of the isopoints of the next slab
+    std::vector<kvs::Real32> m_foreign_normals; ///< normal vectors of the isopoints of the next slab
+
+    // Output.
+    kvs::Real32* m_out_coords; ///< pointer to the coordinates of the slab
+    kvs::Real32* m_out_normals; ///< pointer to the normal vectors of the slab
+    kvs::UInt32* m_out_connections; ///< pointer to the connections of the slab
+    kvs::UInt32 m_vertex_offset; ///< index of the first vertex of the slab
+    kvs::UInt32 m_next_offset; ///< index of the first vertex of the next slab
+
+public:
+
+    SlabExtractor():
+        m_values( NULL ),
+        m_line_size( 0 ),
+        m_slice_size( 0 ),
+        m_isolevel( 0 ),
+        m_duplication( true ),
+        m_vertex_normal( false ),
+        m_z0( 0 ),
+        m_z1( 0 ),
+        m_last( false ),
+        m_stitch( false ),
+        m_active( NULL ),
+        m_block_size( 0 ),
+        m_out_coords( NULL ),
+        m_out_normals( NULL ),
+        m_out_connections( NULL ),
+        m_vertex_offset( 0 ),
+        m_next_offset( 0 ) {}
+
+    void init(
+        const kvs::StructuredVolumeObject* volume,
+        const double isolevel,
+        const bool duplication,
+        const bool vertex_normal,
+        const size_t z0,
+        const size_t z1,
+        const bool last )
+    {
+        m_values = static_cast<const T*>( volume->values().data() );
+        m_resolution = volume->resolution();
+        m_line_size = volume->numberOfNodesPerLine();
+        m_slice_size = volume->numberOfNodesPerSlice();
+        m_isolevel = isolevel;
+        m_duplication = duplication;
+        m_vertex_normal = vertex_normal;
+        m_z0 = z0;
+        m_z1 = z1;
+        m_last = last;
+    }
+
+    void attachActiveBlocks( const kvs::UInt8* active, const kvs::MinMaxBlockIndex* index )
+    {
+        m_active = active;
+        m_block_size = index->blockSize();
+        m_block_resolution = index->resolution();
+    }
+
+    size_t numberOfCoords() const { return m_coords.size(); }
+    size_t numberOfNormals() const { return m_normals.size(); }
+    size_t numberOfConnections() const { return m_connections.size(); }
+    const std::vector<kvs::Real32>& foreignNormals() const { return m_foreign_normals; }
+
+    void attachOutput(
+        kvs::Real32* coords,
+        kvs::Real32* normals,
+        kvs::UInt32* connections,
+        const size_t vertex_offset,
+        const size_t next_offset )
+    {
+        m_stitch = true;
+        m_out_coords = coords;
+        m_out_normals = normals;
+        m_out_connections = connections;
+        m_vertex_offset = static_cast<kvs::UInt32>( vertex_offset );
+        m_next_offset = static_cast<kvs::UInt32>( next_offset );
+    }
+
+    void run()
+    {
+        if ( m_stitch ) { this->stitch(); }
+        else if ( m_duplication ) { this->extract_with_duplication(); }
+        else { this->extract_without_duplication(); }
+    }
+
+private:
+
+    bool is_active( const size_t x, const size_t y, const size_t z, const size_t nx, size_t* x_end ) const
+    {
+        // Run [x, x_end) of the cells (or the nodes) in the same block.
+        if ( !m_active ) { *x_end = nx; return true; }
+
+        const kvs::Vector3ui ncells( m_resolution - kvs::Vector3ui::All(1) );
+        const size_t bx = kvs::Math::Min( x, size_t( ncells.x() - 1 ) ) / m_block_size;
+        const size_t by = kvs::Math::Min( y, size_t( ncells.y() - 1 ) ) / m_block_size;
+        const size_t bz = kvs::Math::Min( z, size_t( ncells.z() - 1 ) ) / m_block_size;
+        *x_end = ( bx + 1 == m_block_resolution.x() ) ? nx : ( bx + 1 ) * m_block_size;
+
+        return m_active[ bx + m_block_resolution.x() * ( by + m_block_resolution.y() * bz ) ] != 0;
+    }
+
+    size_t table_index( const size_t index ) const
+    {
+        const size_t local_index[8] = {
+            index,
+            index + 1,
+            index + 1 + m_line_size,
+            index + m_line_size,
+            index + m_slice_size,
+            index + 1 + m_slice_size,
+            index + 1 + m_line_size + m_slice_size,
+            index + m_line_size + m_slice_size };
+
+        size_t table_index = 0;
+        for ( size_t i = 0; i < 8; i++ )
+        {
+            if ( static_cast<double>( m_values[ local_index[i] ] ) > m_isolevel ) { table_index |= size_t(1) << i; }
+        }
+
+        return table_index;
+    }
+
+    const kvs::Vector3f interpolate_vertex( const kvs::Vector3f& vertex0, const kvs::Vector3f& vertex1 ) const
+    {
+        const size_t v0_index = static_cast<size_t>( vertex0.x() ) +
+            static_cast<size_t>( vertex0.y() ) * m_line_size +
+            static_cast<size_t>( vertex0.z() ) * m_slice_size;
+        const size_t v1_index = static_cast<size_t>( vertex1.x() ) +
+            static_cast<size_t>( vertex1.y() ) * m_line_size +
+            static_cast<size_t>( vertex1.z() ) * m_slice_size;
+
+        const double v0 = static_cast<double>( m_values[ v0_index ] );
+        const double v1 = static_cast<double>( m_values[ v1_index ] );
+        const float ratio = static_cast<float>( kvs::Math::Abs( ( m_isolevel - v0 ) / ( v1 - v0 ) ) );
+
+        return ( 1.0f - ratio ) * vertex0 + ratio * vertex1;
+    }
+
+    void extract_with_duplication()
+    {
+        const kvs::Vector3ui ncells( m_resolution - kvs::Vector3ui::All(1) );
+        for ( size_t z = m_z0; z < m_z1; ++z )
+        {
+            for ( size_t y = 0; y < ncells.y(); ++y )
+            {
+                for ( size_t x = 0, x_end = 0; x < ncells.x(); x = x_end )
+                {
+                    if ( !this->is_active( x, y, z, ncells.x(), &x_end ) ) { continue; }
+                    for ( ; x < x_end; ++x ) { this->extract_triangles( x, y, z ); }
+                }
+            }
+        }
+    }
+
+    void extract_triangles( const size_t x, const size_t y, const size_t z )
+    {
+        const size_t table_index = this->table_index( x + y * m_line_size + z * m_slice_size );
+        if ( table_index == 0 ) return;
+        if ( table_index == 255 ) return;
+
+        const kvs::Vector3f origin(
+            static_cast<float>( x ),
+            static_cast<float>( y ),
+            static_cast<float>( z ) );
+
+        for ( size_t i = 0; kvs::MarchingCubesTable::TriangleID[ table_index ][i] != -1; i += 3 )
+        {
+            const int e[3] = {
+                kvs::MarchingCubesTable::TriangleID[ table_index ][i],
+                kvs::MarchingCubesTable::TriangleID[ table_index ][i+2],
+                kvs::MarchingCubesTable::TriangleID[ table_index ][i+1] };
+
+            kvs::Vector3f vertex[3];
+            for ( size_t j = 0; j < 3; j++ )
+            {
+                const int* v0 = kvs::MarchingCubesTable::VertexID[ e[j] ][0];
+                const int* v1 = kvs::MarchingCubesTable::VertexID[ e[j] ][1];
+                vertex[j] = this->interpolate_vertex(
+                    origin + kvs::Vector3f( float( v0[0] ), float( v0[1] ), float( v0[2] ) ),
+                    origin + kvs::Vector3f( float( v1[0] ), float( v1[1] ), float( v1[2] ) ) );
+                m_coords.push_back( vertex[j].x() );
+                m_coords.push_back( vertex[j].y() );
+                m_coords.push_back( vertex[j].z() );
+            }
+
+            const kvs::Vector3f normal( ( vertex[1] - vertex[0] ).cross( vertex[2] - vertex[0] ) );
+            m_normals.push_back( normal.x() );
+            m_normals.push_back( normal.y() );
+            m_normals.push_back( normal.z() );
+        }
+    }
+
+    void calculate_isopoints( const size_t z, std::vector<kvs::UInt32>& map, std::vector<kvs::Real32>& coords )
+    {
+        // The edges starting from the nodes in the inactive blocks are skipped,
+        // since all the cells sharing an intersected edge can be candidates.
+        for ( size_t y = 0; y < m_resolution.y(); ++y )
+        {
+            for ( size_t x = 0, x_end = 0; x < m_resolution.x(); x = x_end )
+            {
+                if ( !this->is_active( x, y, z, m_resolution.x(), &x_end ) ) { continue; }
+                for ( ; x < x_end; ++x ) { this->calculate_isopoints( x, y, z, map, coords ); }
+            }
+        }
+    }
+
+    void calculate_isopoints(
+        const size_t x,
+        const size_t y,
+        const size_t z,
+        std::vector<kvs::UInt32>& map,
+        std::vector<kvs::Real32>& coords )
+    {
+        const kvs::Vector3ui ncells( m_resolution - kvs::Vector3ui::All(1) );
+        const size_t index = x + y * m_line_size + z * m_slice_size;
+        const bool inside = static_cast<double>( m_values[ index ] ) > m_isolevel;
+        const kvs::Vector3f v0( static_cast<float>( x ), static_cast<float>( y ), static_cast<float>( z ) );
+        kvs::UInt32* edge = &map[ 3 * ( x + y * m_line_size ) ];
+
+        if ( x != ncells.x() &&
+             inside != ( static_cast<double>( m_values[ index + 1 ] ) > m_isolevel ) )
+        {
+            const kvs::Vector3f isopoint( this->interpolate_vertex( v0, v0 + kvs::Vector3f( 1, 0, 0 ) ) );
+            edge[0] = static_cast<kvs::UInt32>( coords.size() / 3 );
+            coords.push_back( isopoint.x() );
+            coords.push_back( isopoint.y() );
+            coords.push_back( isopoint.z() );
+        }
+
+        if ( y != ncells.y() &&
+             inside != ( static_cast<double>( m_values[ index + m_line_size ] ) > m_isolevel ) )
+        {
+            const kvs::Vector3f isopoint( this->interpolate_vertex( v0, v0 + kvs::Vector3f( 0, 1, 0 ) ) );
+            edge[1] = static_cast<kvs::UInt32>( coords.size() / 3 );
+            coords.push_back( isopoint.x() );
+            coords.push_back( isopoint.y() );
+            coords.push_back( isopoint.z() );
+        }
+
+        if ( z != ncells.z() &&
+             inside != ( static_cast<double>( m_values[ index + m_slice_size ] ) > m_isolevel ) )
+        {
+            const kvs::Vector3f isopoint( this->interpolate_vertex( v0, v0 + kvs::Vector3f( 0, 0, 1 ) ) );
+            edge[2] = static_cast<kvs::UInt32>( coords.size() / 3 );
+            coords.push_back( isopoint.x() );
+            coords.push_back( isopoint.y() );
+            coords.push_back( isopoint.z() );
+        }
+    }
+
+    const kvs::Vector3f coord( const kvs::UInt32 id ) const
+    {
+        return ( id & ForeignVertex ) ?
+            kvs::Vector3f( &m_foreign_coords[ 3 * ( id & ~ForeignVertex ) ] ) :
+            kvs::Vector3f( &m_coords[ 3 * id ] );
+    }
+
+    void add_normal( const kvs::UInt32 id, const kvs::Vector3f& normal )
+    {
+        kvs::Real32* n = ( id & ForeignVertex ) ?
+            &m_foreign_normals[ 3 * ( id & ~ForeignVertex ) ] :
+            &m_normals[ 3 * id ];
+        n[0] += normal.x();
+        n[1] += normal.y();
+        n[2] += normal.z();
+    }
+
+    void extract_without_duplication()
+    {
+        const kvs::Vector3ui ncells( m_resolution - kvs::Vector3ui::All(1) );
+        const size_t map_size = 3 * m_slice_size;
+        m_map[0].resize( map_size );
+        m_map[1].resize( map_size );
+
+        this->calculate_isopoints( m_z0, m_map[0], m_coords );
+        for ( size_t z = m_z0; z < m_z1; ++z )
+        {
+            // The isopoints on the top node layer of the slab belong to the next slab.
+            const bool foreign = ( z + 1 == m_z1 ) && !m_last;
+            this->calculate_isopoints( z + 1, m_map[1], foreign ? m_foreign_coords : m_coords );
+            if ( m_vertex_normal )
+            {
+                m_normals.resize( m_coords.size(), 0.0f );
+                m_foreign_normals.resize( m_foreign_coords.size(), 0.0f );
+            }
+
+            const kvs::UInt32 top_flag = foreign ? ForeignVertex : 0;
+
+            for ( size_t y = 0; y < ncells.y(); ++y )
+            {
+                for ( size_t x = 0, x_end = 0; x < ncells.x(); x = x_end )
+                {
+                    if ( !this->is_active( x, y, z, ncells.x(), &x_end ) ) { continue; }
+                    for ( ; x < x_end; ++x ) { this->connect_isopoints( x, y, z, top_flag ); }
+                }
+            }
+
+            std::swap( m_map[0], m_map[1] );
+        }
+
+        if ( m_vertex_normal ) { m_normals.resize( m_coords.size(), 0.0f ); }
+
+        m_map[0].clear();
+        m_map[1].clear();
+    }
+
+    void connect_isopoints( const size_t x, const size_t y, const size_t z, const kvs::UInt32 top_flag )
+    {
+        const size_t table_index = this->table_index( x + y * m_line_size + z * m_slice_size );
+        if ( table_index == 0 ) return;
+        if ( table_index == 255 ) return;
+
+        const kvs::UInt32* bottom = &m_map[0][ 3 * ( x + y * m_line_size ) ];
+        const kvs::UInt32* top = &m_map[1][ 3 * ( x + y * m_line_size ) ];
+        const size_t line = 3 * m_line_size;
+        const kvs::UInt32 local_vertex[12] = {
+            bottom[0], bottom[3+1], bottom[line], bottom[1],
+            top[0] | top_flag, top[3+1] | top_flag, top[line] | top_flag, top[1] | top_flag,
+            bottom[2], bottom[3+2], bottom[3+line+2], bottom[line+2] };
+
+        for ( size_t i = 0; kvs::MarchingCubesTable::TriangleID[ table_index ][i] != -1; i += 3 )
+        {
+            const kvs::UInt32 id0 = local_vertex[ kvs::MarchingCubesTable::TriangleID[ table_index ][i]   ];
+            const kvs::UInt32 id1 = local_vertex[ kvs::MarchingCubesTable::TriangleID[ table_index ][i+2] ];
+            const kvs::UInt32 id2 = local_vertex[ kvs::MarchingCubesTable::TriangleID[ table_index ][i+1] ];
+            m_connections.push_back( id0 );
+            m_connections.push_back( id1 );
+            m_connections.push_back( id2 );
+
+            const kvs::Vector3f v0( this->coord( id0 ) );
+            const kvs::Vector3f normal( ( this->coord( id1 ) - v0 ).cross( this->coord( id2 ) - v0 ) );
+            if ( m_vertex_normal )
+            {
+                this->add_normal( id0, normal );
+                this->add_normal( id1, normal );
+                this->add_normal( id2, normal );
+            }
+            else
+            {
+                m_normals.push_back( normal.x() );
+                m_normals.push_back( normal.y() );
+                m_normals.push_back( normal.z() );
+            }
+        }
+    }
+
+    void stitch()
+    {
+        std::copy( m_coords.begin(), m_coords.end(), m_out_coords );
+        std::copy( m_normals.begin(), m_normals.end(), m_out_normals );
+        for ( size_t i = 0; i < m_connections.size(); i++ )
+        {
+            const kvs::UInt32 id = m_connections[i];
+            m_out_connections[i] = ( id & ForeignVertex ) ?
+                m_next_offset + ( id & ~ForeignVertex ) :
+                m_vertex_offset + id;
+        }
+
+        std::vector<kvs::Real32>().swap( m_coords );
+        std::vector<kvs::Real32>().swap( m_normals );
+        std::vector<kvs::UInt32>().swap( m_connections );
+        std::vector<kvs::Real32>().swap( m_foreign_coords );
+    }
+};
+
+} // end of namespace
 
 
 namespace kvs
@@ -29,7 +449,9 @@ MarchingCubes::MarchingCubes():
     kvs::MapperBase(),
     kvs::PolygonObject(),
     m_isolevel( 0 ),
-    m_duplication( true )
+    m_duplication( true ),
+    m_block_index( NULL ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
 }
 
@@ -51,7 +473,9 @@ MarchingCubes::MarchingCubes(
     const kvs::TransferFunction&       transfer_function ):
     kvs::MapperBase( transfer_function ),
     kvs::PolygonObject(),
-    m_duplication( duplication )
+    m_duplication( duplication ),
+    m_block_index( NULL ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     SuperClass::setNormalType( normal_type );
 
@@ -81,6 +505,17 @@ void MarchingCubes::setIsolevel( const double isolevel )
     m_isolevel = isolevel;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for extracting the surfaces.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void MarchingCubes::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the mapper process.
@@ -165,246 +600,83 @@ void MarchingCubes::mapping( const kvs::StructuredVolumeObject* volume )
 template <typename T>
 void MarchingCubes::extract_surfaces( const kvs::StructuredVolumeObject* volume )
 {
-    if ( m_duplication ) this->extract_surfaces_with_duplication<T>( volume );
-    else                 this->extract_surfaces_without_duplication<T>( volume );
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Extracts the surfaces with duplication.
- *  @param  volume [in] pointer to the structured volume object
- */
-/*==========================================================================*/
-template <typename T>
-void MarchingCubes::extract_surfaces_with_duplication(
-    const kvs::StructuredVolumeObject* volume )
-{
-    // Calculated the coordinate data array and the normal vector array.
-    std::vector<kvs::Real32> coords;
-    std::vector<kvs::Real32> normals;
-
-    const kvs::Vector3ui ncells( volume->resolution() - kvs::Vector3ui::All(1) );
-    const kvs::UInt32    line_size( volume->numberOfNodesPerLine() );
-    const kvs::UInt32    slice_size( volume->numberOfNodesPerSlice() );
-
-    // Extract surfaces.
-    size_t index = 0;
-    size_t local_index[8];
-    for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
+    // Slabs of the cell layers along the z-axis.
+    const size_t ncells = volume->resolution().z() - 1;
+    const size_t nslabs = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, ncells ) );
+    const bool vertex_normal = SuperClass::normalType() == kvs::PolygonObject::VertexNormal;
+
+    // Blocks which can contain the isosurfaces.
+    std::vector<kvs::UInt8> active;
+    if ( m_block_index && ( m_block_index->isBuilt( volume ) || m_block_index->build( volume ) ) )
     {
-        for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
-        {
-            for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
-            {
-                // Calculate the indices of the target cell.
-                local_index[0] = index;
-                local_index[1] = local_index[0] + 1;
-                local_index[2] = local_index[1] + line_size;
-                local_index[3] = local_index[0] + line_size;
-                local_index[4] = local_index[0] + slice_size;
-                local_index[5] = local_index[1] + slice_size;
-                local_index[6] = local_index[2] + slice_size;
-                local_index[7] = local_index[3] + slice_size;
-                index++;
-
-                // Calculate the index of the reference table.
-                const size_t table_index = this->calculate_table_index<T>( local_index );
-                if ( table_index == 0 ) continue;
-                if ( table_index == 255 ) continue;
-
-                // Calculate the triangle polygons.
-                for ( size_t i = 0; MarchingCubesTable::TriangleID[ table_index ][i] != -1; i += 3 )
-                {
-                    // Refer the edge IDs from the TriangleTable by using the table_index.
-                    const int e0 = MarchingCubesTable::TriangleID[table_index][i];
-                    const int e1 = MarchingCubesTable::TriangleID[table_index][i+2];
-                    const int e2 = MarchingCubesTable::TriangleID[table_index][i+1];
-
-                    // Determine vertices for each edge.
-                    const kvs::Vector3f v0(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e0][0][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e0][0][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e0][0][2] ) );
-
-                    const kvs::Vector3f v1(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e0][1][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e0][1][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e0][1][2] ) );
-
-                    const kvs::Vector3f v2(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e1][0][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e1][0][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e1][0][2] ) );
-
-                    const kvs::Vector3f v3(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e1][1][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e1][1][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e1][1][2] ) );
-
-                    const kvs::Vector3f v4(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e2][0][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e2][0][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e2][0][2] ) );
-
-                    const kvs::Vector3f v5(
-                        static_cast<float>( x + MarchingCubesTable::VertexID[e2][1][0] ),
-                        static_cast<float>( y + MarchingCubesTable::VertexID[e2][1][1] ),
-                        static_cast<float>( z + MarchingCubesTable::VertexID[e2][1][2] ) );
-
-                    // Calculate coordinates of the vertices which are composed
-                    // of the triangle polygon.
-                    const kvs::Vector3f vertex0( this->interpolate_vertex<T>( v0, v1 ) );
-                    coords.push_back( vertex0.x() );
-                    coords.push_back( vertex0.y() );
-                    coords.push_back( vertex0.z() );
-
-                    const kvs::Vector3f vertex1( this->interpolate_vertex<T>( v2, v3 ) );
-                    coords.push_back( vertex1.x() );
-                    coords.push_back( vertex1.y() );
-                    coords.push_back( vertex1.z() );
-
-                    const kvs::Vector3f vertex2( this->interpolate_vertex<T>( v4, v5 ) );
-                    coords.push_back( vertex2.x() );
-                    coords.push_back( vertex2.y() );
-                    coords.push_back( vertex2.z() );
-
-                    // Calculate a normal vector for the triangle polygon.
-                    const kvs::Vector3f normal( ( vertex1 - vertex0 ).cross( vertex2 - vertex0 ) );
-                    normals.push_back( normal.x() );
-                    normals.push_back( normal.y() );
-                    normals.push_back( normal.z() );
-                } // end of loop-triangle
-            } // end of loop-x
-            ++index;
-        } // end of loop-y
-        index += line_size;
-    } // end of loop-z
-
-    // Calculate the polygon color for the isolevel.
-    const kvs::RGBColor color = this->calculate_color<T>();
-
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColor( color );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
-    SuperClass::setOpacity( 255 );
-    SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
-    SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
-    SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal );
-}
+        const std::vector<kvs::UInt32> blocks = m_block_index->find( m_isolevel );
+        active.resize( m_block_index->numberOfBlocks(), 0 );
+        for ( size_t i = 0; i < blocks.size(); i++ ) { active[ blocks[i] ] = 1; }
+    }
 
-/*==========================================================================*/
-/**
- *  @brief  Extracts the surfaces without duplication.
- *  @param  volume [in] pointer to the structured volume object
- */
-/*==========================================================================*/
-template <typename T>
-void MarchingCubes::extract_surfaces_without_duplication(
-    const kvs::StructuredVolumeObject* volume )
-{
-    const size_t volume_size = volume->numberOfNodes();
-    const size_t byte_size   = sizeof( kvs::UInt32 ) * 3 * volume_size;
-    kvs::UInt32* vertex_map = static_cast<kvs::UInt32*>( malloc( byte_size ) );
-    if ( !vertex_map )
+    std::vector< ::SlabExtractor<T> > extractors( nslabs );
+    for ( size_t i = 0; i < nslabs; i++ )
     {
-        kvsMessageError("Cannot allocate memory for the vertex map.");
-        return;
+        const size_t z0 = ncells * i / nslabs;
+        const size_t z1 = ncells * ( i + 1 ) / nslabs;
+        extractors[i].init( volume, m_isolevel, m_duplication, vertex_normal, z0, z1, i == nslabs - 1 );
+        if ( !active.empty() ) { extractors[i].attachActiveBlocks( &active[0], m_block_index ); }
     }
-    memset( vertex_map, 0, byte_size );
 
-    std::vector<kvs::Real32> coords;
-    this->calculate_isopoints<T>( vertex_map, coords );
+    kvs::Thread::Run( &extractors[0], nslabs );
 
-    std::vector<kvs::UInt32> connections;
-    this->connect_isopoints<T>( vertex_map, connections );
-
-    free( vertex_map );
+    // Stitch the surfaces of the slabs.
+    size_t ncoords = 0;
+    size_t nnormals = 0;
+    size_t nconnections = 0;
+    for ( size_t i = 0; i < nslabs; i++ )
+    {
+        ncoords += extractors[i].numberOfCoords();
+        nnormals += extractors[i].numberOfNormals();
+        nconnections += extractors[i].numberOfConnections();
+    }
 
-    std::vector<kvs::Real32> normals;
-    if ( SuperClass::normalType() == kvs::PolygonObject::PolygonNormal )
+    kvs::ValueArray<kvs::Real32> coords( ncoords );
+    kvs::ValueArray<kvs::Real32> normals( nnormals );
+    kvs::ValueArray<kvs::UInt32> connections( nconnections );
+    std::vector<size_t> vertex_offsets( nslabs + 1, 0 );
+    for ( size_t i = 0, normal_offset = 0, connection_offset = 0; i < nslabs; i++ )
     {
-        this->calculate_normals_on_polygon( coords, connections, normals );
+        vertex_offsets[ i + 1 ] = vertex_offsets[i] + extractors[i].numberOfCoords() / 3;
+        extractors[i].attachOutput(
+            coords.data() + 3 * vertex_offsets[i],
+            normals.data() + normal_offset,
+            connections.data() + connection_offset,
+            vertex_offsets[i],
+            vertex_offsets[ i + 1 ] );
+        normal_offset += extractors[i].numberOfNormals();
+        connection_offset += extractors[i].numberOfConnections();
     }
-    else
+
+    kvs::Thread::Run( &extractors[0], nslabs );
+
+    // Normal vectors on the isopoints shared with the next slab.
+    if ( !m_duplication && vertex_normal )
     {
-        this->calculate_normals_on_vertex( coords, connections, normals );
+        for ( size_t i = 0; i + 1 < nslabs; i++ )
+        {
+            const std::vector<kvs::Real32>& foreign_normals = extractors[i].foreignNormals();
+            kvs::Real32* normal = normals.data() + 3 * vertex_offsets[ i + 1 ];
+            for ( size_t j = 0; j < foreign_normals.size(); j++ ) { normal[j] += foreign_normals[j]; }
+        }
     }
 
     // Calculate the polygon color for the isolevel.
     const kvs::RGBColor color = this->calculate_color<T>();
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
+    SuperClass::setCoords( coords );
+    if ( !m_duplication ) { SuperClass::setConnections( connections ); }
     SuperClass::setColor( color );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setNormals( normals );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Calculate a index of the marching cubes table.
- *  @param  local_index [in] indices of the cell
- *  @return table index
- */
-/*==========================================================================*/
-template <typename T>
-size_t MarchingCubes::calculate_table_index( const size_t* local_index ) const
-{
-    const T* const values = static_cast<const T*>( BaseClass::volume()->values().data() );
-    const double isolevel = m_isolevel;
-
-    size_t table_index = 0;
-    if ( static_cast<double>( values[ local_index[0] ] ) > isolevel ) { table_index |=   1; }
-    if ( static_cast<double>( values[ local_index[1] ] ) > isolevel ) { table_index |=   2; }
-    if ( static_cast<double>( values[ local_index[2] ] ) > isolevel ) { table_index |=   4; }
-    if ( static_cast<double>( values[ local_index[3] ] ) > isolevel ) { table_index |=   8; }
-    if ( static_cast<double>( values[ local_index[4] ] ) > isolevel ) { table_index |=  16; }
-    if ( static_cast<double>( values[ local_index[5] ] ) > isolevel ) { table_index |=  32; }
-    if ( static_cast<double>( values[ local_index[6] ] ) > isolevel ) { table_index |=  64; }
-    if ( static_cast<double>( values[ local_index[7] ] ) > isolevel ) { table_index |= 128; }
-
-    return table_index;
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Interpolates a coordinate value of the intersected vertex.
- *  @param  vertex0 [in] vertex coordinate of the end point #0
- *  @param  vertex1 [in] vertex coordinate of the end point #1
- *  @return interpolated vertex coordinate
- */
-/*==========================================================================*/
-template <typename T>
-const kvs::Vector3f MarchingCubes::interpolate_vertex(
-    const kvs::Vector3f& vertex0,
-    const kvs::Vector3f& vertex1 ) const
-{
-    const T* const values = static_cast<const T*>( BaseClass::volume()->values().data() );
-    const kvs::StructuredVolumeObject* volume =
-        reinterpret_cast<const kvs::StructuredVolumeObject*>( BaseClass::volume() );
-
-    const double x0 = vertex0.x();
-    const double y0 = vertex0.y();
-    const double z0 = vertex0.z();
-    const double x1 = vertex1.x();
-    const double y1 = vertex1.y();
-    const double z1 = vertex1.z();
-    const kvs::UInt32 line_size  = volume->numberOfNodesPerLine();
-    const kvs::UInt32 slice_size = volume->numberOfNodesPerSlice();
-    const size_t v0_index = static_cast<size_t>( x0 + y0 * line_size + z0 * slice_size );
-    const size_t v1_index = static_cast<size_t>( x1 + y1 * line_size + z1 * slice_size );
-
-    const double v0 = static_cast<double>( values[ v0_index ] );
-    const double v1 = static_cast<double>( values[ v1_index ] );
-    const float ratio = static_cast<float>( kvs::Math::Abs( ( m_isolevel - v0 ) / ( v1 - v0 ) ) );
-
-    const float x = ( 1.0f - ratio ) * vertex0.x() + ratio * vertex1.x();
-    const float y = ( 1.0f - ratio ) * vertex0.y() + ratio * vertex1.y();
-    const float z = ( 1.0f - ratio ) * vertex0.z() + ratio * vertex1.z();
-
-    return kvs::Vector3f( x, y, z );
+    if ( m_duplication ) { SuperClass::setNormalType( kvs::PolygonObject::PolygonNormal ); }
 }
 
 /*==========================================================================*/
@@ -430,256 +702,4 @@ const kvs::RGBColor MarchingCubes::calculate_color()
     return BaseClass::transferFunction().colorMap()[ index ];
 }
 
-/*==========================================================================*/
-/**
- *  @brief  Calculates the coordinates on the surfaces.
- *  @param  vertex_map [in/out] pointer to the vertex map
- *  @param  coords [in/out] coordinate array
- */
-/*==========================================================================*/
-template <typename T>
-void MarchingCubes::calculate_isopoints(
-    kvs::UInt32*&             vertex_map,
-    std::vector<kvs::Real32>& coords )
-{
-    const T* const values = static_cast<const T*>( BaseClass::volume()->values().data() );
-    const kvs::StructuredVolumeObject* volume =
-        reinterpret_cast<const kvs::StructuredVolumeObject*>( BaseClass::volume() );
-
-    const kvs::Vector3ui resolution( volume->resolution() );
-    const kvs::Vector3ui ncells( resolution - kvs::Vector3ui::All(1) );
-    const kvs::UInt32    line_size( volume->numberOfNodesPerLine() );
-    const kvs::UInt32    slice_size( volume->numberOfNodesPerSlice() );
-    const double         isolevel = m_isolevel;
-
-    kvs::UInt32 nisopoints = 0;
-    size_t      index = 0;
-    for ( kvs::UInt32 z = 0; z < resolution.z(); ++z )
-    {
-        for ( kvs::UInt32 y = 0; y < resolution.y(); ++y )
-        {
-            for ( kvs::UInt32 x = 0; x < resolution.x(); ++x )
-            {
-                const size_t id0 = index;
-                const size_t id1 = id0 + 1;
-                const size_t id2 = id0 + line_size;
-                const size_t id3 = id0 + slice_size;
-
-                if ( x != ncells.x() )
-                {
-                    if ( ( static_cast<double>( values[id0] ) > isolevel ) !=
-                         ( static_cast<double>( values[id1] ) > isolevel ) )
-                    {
-                        const kvs::Vector3f v1( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
-                        const kvs::Vector3f v2( static_cast<float>(x+1), static_cast<float>(y), static_cast<float>(z) );
-                        const kvs::Vector3f isopoint( this->interpolate_vertex<T>( v1, v2 ) );
-
-                        coords.push_back( isopoint.x() );
-                        coords.push_back( isopoint.y() );
-                        coords.push_back( isopoint.z() );
-
-                        vertex_map[ 3 * index ] = nisopoints++;
-                    }
-                }
-
-                if ( y != ncells.y() )
-                {
-                    if ( ( static_cast<double>( values[id0] ) > isolevel ) !=
-                         ( static_cast<double>( values[id2] ) > isolevel ) )
-                    {
-                        const kvs::Vector3f v1( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
-                        const kvs::Vector3f v2( static_cast<float>(x), static_cast<float>(y+1), static_cast<float>(z) );
-                        const kvs::Vector3f isopoint( this->interpolate_vertex<T>( v1, v2 ) );
-
-                        coords.push_back( isopoint.x() );
-                        coords.push_back( isopoint.y() );
-                        coords.push_back( isopoint.z() );
-
-                        vertex_map[ 3 * index + 1 ] = nisopoints++;
-                    }
-                }
-
-                if ( z != ncells.z() )
-                {
-                    if ( ( static_cast<double>( values[id0] ) > isolevel ) !=
-                         ( static_cast<double>( values[id3] ) > isolevel ) )
-                    {
-                        const kvs::Vector3f v1( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) );
-                        const kvs::Vector3f v2( static_cast<float>(x), static_cast<float>(y), static_cast<float>(z+1) );
-                        const kvs::Vector3f isopoint( this->interpolate_vertex<T>( v1, v2 ) );
-
-                        coords.push_back( isopoint.x() );
-                        coords.push_back( isopoint.y() );
-                        coords.push_back( isopoint.z() );
-
-                        vertex_map[ 3 * index + 2 ] = nisopoints++;
-                    }
-                }
-                ++index;
-            } // x
-        } // y
-    } // z
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Connects the coordinates.
- *  @param  vertex_map [in/out] pointer to the vertex map
- *  @param  connections [in/out] connection array
- */
-/*==========================================================================*/
-template <typename T>
-void MarchingCubes::connect_isopoints(
-    kvs::UInt32*&             vertex_map,
-    std::vector<kvs::UInt32>& connections )
-{
-    const kvs::StructuredVolumeObject* volume =
-        reinterpret_cast<const kvs::StructuredVolumeObject*>( BaseClass::volume() );
-
-    const kvs::Vector3ui resolution( volume->resolution() );
-    const kvs::Vector3ui ncells( resolution - kvs::Vector3ui::All(1) );
-    const kvs::UInt32    line_size( volume->numberOfNodesPerLine() );
-    const kvs::UInt32    slice_size( volume->numberOfNodesPerSlice() );
-
-    size_t index = 0;
-    size_t local_index[8];
-    size_t local_edge[12];
-    for ( kvs::UInt32 z = 0; z < ncells.z(); ++z )
-    {
-        for ( kvs::UInt32 y = 0; y < ncells.y(); ++y )
-        {
-            for ( kvs::UInt32 x = 0; x < ncells.x(); ++x )
-            {
-                // Calculate the indices of the target cell.
-                local_index[0] = index;
-                local_index[1] = local_index[0] + 1;
-                local_index[2] = local_index[1] + line_size;
-                local_index[3] = local_index[0] + line_size;
-                local_index[4] = local_index[0] + slice_size;
-                local_index[5] = local_index[1] + slice_size;
-                local_index[6] = local_index[2] + slice_size;
-                local_index[7] = local_index[3] + slice_size;
-                index++;
-
-                // Calculate the index of the reference table.
-                const size_t table_index = this->calculate_table_index<T>( local_index );
-                if ( table_index == 0 ) continue;
-                if ( table_index == 255 ) continue;
-
-                local_edge[ 0] = 3 * local_index[0];
-                local_edge[ 1] = local_edge[0] + 3 + 1;
-                local_edge[ 2] = local_edge[0] + 3 * line_size;
-                local_edge[ 3] = local_edge[0] + 1;
-                local_edge[ 4] = local_edge[0] + 3 * slice_size;
-                local_edge[ 5] = local_edge[1] + 3 * slice_size;
-                local_edge[ 6] = local_edge[2] + 3 * slice_size;
-                local_edge[ 7] = local_edge[3] + 3 * slice_size;
-                local_edge[ 8] = local_edge[0] + 2;
-                local_edge[ 9] = local_edge[8] + 3;
-                local_edge[10] = local_edge[8] + 3 + 3 * line_size;
-                local_edge[11] = local_edge[8] + 3 * line_size;
-
-                for ( size_t i = 0; MarchingCubesTable::TriangleID[table_index][i] != -1; i += 3 )
-                {
-                    const int e0 = local_edge[ MarchingCubesTable::TriangleID[table_index][i]   ];
-                    const int e1 = local_edge[ MarchingCubesTable::TriangleID[table_index][i+2] ];
-                    const int e2 = local_edge[ MarchingCubesTable::TriangleID[table_index][i+1] ];
-
-                    connections.push_back( vertex_map[e0] );
-                    connections.push_back( vertex_map[e1] );
-                    connections.push_back( vertex_map[e2] );
-                }
-            } // x
-            ++index;
-        } // y
-        index += line_size;
-    } // z
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Calculates a normal vector array on the polygon.
- *  @param  coords [in] coordinate array
- *  @param  connections [in] connection array
- *  @param  normals [out] normal vector array
- */
-/*==========================================================================*/
-void MarchingCubes::calculate_normals_on_polygon(
-    const std::vector<kvs::Real32>& coords,
-    const std::vector<kvs::UInt32>& connections,
-    std::vector<kvs::Real32>&       normals )
-{
-    if ( coords.empty() ) return;
-
-    normals.resize( connections.size() );
-    std::fill( normals.begin(), normals.end(), 0.0f );
-
-    const kvs::Real32* const coords_ptr = &coords[ 0 ];
-
-    const size_t size = connections.size();
-    for ( kvs::UInt32 index = 0; index < size; index += 3 )
-    {
-        const kvs::UInt32 coord0_index = 3 * connections[ index     ];
-        const kvs::UInt32 coord1_index = 3 * connections[ index + 1 ];
-        const kvs::UInt32 coord2_index = 3 * connections[ index + 2 ];
-
-        const kvs::Vector3f v0( coords_ptr + coord0_index );
-        const kvs::Vector3f v1( coords_ptr + coord1_index );
-        const kvs::Vector3f v2( coords_ptr + coord2_index );
-
-        const kvs::Vector3f normal( ( v1 - v0 ).cross( v2 - v0 ) );
-
-        normals[ index     ] = normal.x();
-        normals[ index + 1 ] = normal.y();
-        normals[ index + 2 ] = normal.z();
-    }
-}
-
-/*==========================================================================*/
-/**
- *  @brief  Calculates a normal vector array on the vertex.
- *  @param  coords [in] coordinate array
- *  @param  connections [in] connection array
- *  @param  normals [out] normal vector array
- */
-/*==========================================================================*/
-void MarchingCubes::calculate_normals_on_vertex(
-    const std::vector<kvs::Real32>& coords,
-    const std::vector<kvs::UInt32>& connections,
-    std::vector<kvs::Real32>&       normals )
-{
-    if ( coords.empty() ) return;
-
-    normals.resize( coords.size() );
-    std::fill( normals.begin(), normals.end(), 0.0f );
-
-    const kvs::Real32* const coords_ptr = &coords[ 0 ];
-
-    const size_t size = connections.size();
-    for ( kvs::UInt32 index = 0; index < size; index += 3 )
-    {
-        const kvs::UInt32 coord0_index = 3 * connections[ index     ];
-        const kvs::UInt32 coord1_index = 3 * connections[ index + 1 ];
-        const kvs::UInt32 coord2_index = 3 * connections[ index + 2 ];
-
-        const kvs::Vector3f v0( coords_ptr + coord0_index );
-        const kvs::Vector3f v1( coords_ptr + coord1_index );
-        const kvs::Vector3f v2( coords_ptr + coord2_index );
-
-        const kvs::Vector3f normal( ( v1 - v0 ).cross( v2 - v0 ) );
-
-        normals[ coord0_index     ] += normal.x();
-        normals[ coord0_index + 1 ] += normal.y();
-        normals[ coord0_index + 2 ] += normal.z();
-
-        normals[ coord1_index     ] += normal.x();
-        normals[ coord1_index + 1 ] += normal.y();
-        normals[ coord1_index + 2 ] += normal.z();
-
-        normals[ coord2_index     ] += normal.x();
-        normals[ coord2_index + 1 ] += normal.y();
-        normals[ coord2_index + 2 ] += normal.z();
-    }
-}
-
 } // end of namesapce kvs
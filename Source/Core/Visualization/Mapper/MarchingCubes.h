@@ -19,6 +19,7 @@
 #include <kvs/StructuredVolumeObject>
 #include <kvs/MapperBase>
 #include <kvs/Module>
+#include <kvs/MinMaxBlockIndex>
 
 
 namespace kvs
@@ -39,6 +40,8 @@ private:
 
     double m_isolevel; ///< isosurface level
     bool m_duplication; ///< duplication flag
+    kvs::MinMaxBlockIndex* m_block_index; ///< pointer to the min/max block index (not allocated)
+    size_t m_number_of_threads; ///< number of threads for extracting the surfaces
 
 public:
 
@@ -51,7 +54,11 @@ public:
         const kvs::TransferFunction& transfer_function );
     virtual ~MarchingCubes();
 
+    size_t numberOfThreads() const { return m_number_of_threads; }
     void setIsolevel( const double isolevel );
+    void setDuplication( const bool duplication ) { m_duplication = duplication; }
+    void attachBlockIndex( kvs::MinMaxBlockIndex* index ) { m_block_index = index; }
+    void setNumberOfThreads( const size_t nthreads );
 
     SuperClass* exec( const kvs::ObjectBase* object );
 
@@ -59,21 +66,7 @@ private:
 
     void mapping( const kvs::StructuredVolumeObject* volume );
     template <typename T> void extract_surfaces( const kvs::StructuredVolumeObject* volume );
-    template <typename T> void extract_surfaces_with_duplication( const kvs::StructuredVolumeObject* volume );
-    template <typename T> void extract_surfaces_without_duplication( const kvs::StructuredVolumeObject* volume );
-    template <typename T> size_t calculate_table_index( const size_t* local_index ) const;
-    template <typename T> const kvs::Vector3f interpolate_vertex( const kvs::Vector3f& vertex0, const kvs::Vector3f& vertex1 ) const;
     template <typename T> const kvs::RGBColor calculate_color();
-    template <typename T> void calculate_isopoints( kvs::UInt32*& vertex_map, std::vector<kvs::Real32>& coords );
-    template <typename T> void connect_isopoints( kvs::UInt32*& vertex_map, std::vector<kvs::UInt32>& connections );
-    void calculate_normals_on_polygon(
-        const std::vector<kvs::Real32>& coords,
-        const std::vector<kvs::UInt32>& connections,
-        std::vector<kvs::Real32>& normals );
-    void calculate_normals_on_vertex(
-        const std::vector<kvs::Real32>& coords,
-        const std::vector<kvs::UInt32>& connections,
-        std::vector<kvs::Real32>& normals );
 };
 
 } // end of namespace kvs
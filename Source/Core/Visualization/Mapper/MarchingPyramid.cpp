@@ -28,7 +28,8 @@ MarchingPyramid::MarchingPyramid():
     kvs::MapperBase(),
     kvs::PolygonObject(),
     m_isolevel( 0 ),
-    m_duplication( true )
+    m_duplication( true ),
+    m_block_index( NULL )
 {
 }
 
@@ -50,7 +51,8 @@ MarchingPyramid::MarchingPyramid(
     const kvs::TransferFunction&       transfer_function ):
     kvs::MapperBase( transfer_function ),
     kvs::PolygonObject(),
-    m_duplication( duplication )
+    m_duplication( duplication ),
+    m_block_index( NULL )
 {
     SuperClass::setNormalType( normal_type );
 
@@ -186,76 +188,88 @@ void MarchingPyramid::extract_surfaces_with_duplication(
     const kvs::UInt32* connections =
         static_cast<const kvs::UInt32*>( volume->connections().data() );
 
+    // Ranges of the cells which can contain the isosurfaces.
+    std::vector<size_t> ranges( 1, 0 );
+    ranges.push_back( ncells );
+    if ( m_block_index && ( m_block_index->isBuilt( volume ) || m_block_index->build( volume ) ) )
+    {
+        ranges = m_block_index->findCellRanges( m_isolevel );
+    }
+
     // Extract surfaces.
-    size_t index = 0;
     size_t local_index[5];
-    for ( kvs::UInt32 cell = 0; cell < ncells; ++cell, index += 5 )
+    for ( size_t range = 0; range < ranges.size(); range += 2 )
     {
-        // Calculate the indices of the target cell.
-        local_index[0] = connections[ index + 0 ];
-        local_index[1] = connections[ index + 1 ];
-        local_index[2] = connections[ index + 2 ];
-        local_index[3] = connections[ index + 3 ];
-        local_index[4] = connections[ index + 4 ];
-
-        // Calculate the index of the reference table.
-        size_t table_index = this->calculate_table_index<T>( local_index );
-        if ( table_index == 0 ) continue;
-        if ( table_index == 10 || table_index == 11 || table_index == 20 || table_index == 21 ){
-            table_index = this->calculate_special_table_index<T>( local_index, table_index );
-        }
-        if ( table_index == 36 ) continue;
-
-        // Calculate the triangle polygons.
-        for ( size_t i = 0; MarchingPyramidTable::TriangleID[ table_index ][i] != -1; i += 3 )
+        for ( size_t cell = ranges[ range ]; cell < ranges[ range + 1 ]; ++cell )
         {
-            // Refer the edge IDs from the TriangleTable by using the table_index.
-            const int e0 = MarchingPyramidTable::TriangleID[table_index][i];
-            const int e1 = MarchingPyramidTable::TriangleID[table_index][i+2];
-            const int e2 = MarchingPyramidTable::TriangleID[table_index][i+1];
-
-            // Determine vertices for each edge.
-            const int v0 = local_index[MarchingPyramidTable::VertexID[e0][0]];
-            const int v1 = local_index[MarchingPyramidTable::VertexID[e0][1]];
-
-            const int v2 = local_index[MarchingPyramidTable::VertexID[e1][0]];
-            const int v3 = local_index[MarchingPyramidTable::VertexID[e1][1]];
-
-            const int v4 = local_index[MarchingPyramidTable::VertexID[e2][0]];
-            const int v5 = local_index[MarchingPyramidTable::VertexID[e2][1]];
-
-            // Calculate coordinates of the vertices which are composed
-            // of the triangle polygon.
-            const kvs::Vector3f vertex0( this->interpolate_vertex<T>( v0, v1 ) );
-            coords.push_back( vertex0.x() );
-            coords.push_back( vertex0.y() );
-            coords.push_back( vertex0.z() );
-
-            const kvs::Vector3f vertex1( this->interpolate_vertex<T>( v2, v3 ) );
-            coords.push_back( vertex1.x() );
-            coords.push_back( vertex1.y() );
-            coords.push_back( vertex1.z() );
-
-            const kvs::Vector3f vertex2( this->interpolate_vertex<T>( v4, v5 ) );
-            coords.push_back( vertex2.x() );
-            coords.push_back( vertex2.y() );
-            coords.push_back( vertex2.z() );
-
-            // Calculate a normal vector for the triangle polygon.
-            const kvs::Vector3f normal( ( vertex1 - vertex0 ).cross( vertex2 - vertex0 ) );
-            normals.push_back( normal.x() );
-            normals.push_back( normal.y() );
-            normals.push_back( normal.z() );
-        } // end of loop-triangle
-    } // end of loop-cell
+            const size_t index = 5 * cell;
+
+            // Calculate the indices of the target cell.
+            local_index[0] = connections[ index + 0 ];
+            local_index[1] = connections[ index + 1 ];
+            local_index[2] = connections[ index + 2 ];
+            local_index[3] = connections[ index + 3 ];
+            local_index[4] = connections[ index + 4 ];
+
+            // Calculate the index of the reference table.
+            size_t table_index = this->calculate_table_index<T>( local_index );
+            if ( table_index == 0 ) continue;
+            if ( table_index == 10 || table_index == 11 || table_index == 20 || table_index == 21 ){
+                table_index = this->calculate_special_table_index<T>( local_index, table_index );
+            }
+            if ( table_index == 36 ) continue;
+
+            // Calculate the triangle polygons.
+            for ( size_t i = 0; MarchingPyramidTable::TriangleID[ table_index ][i] != -1; i += 3 )
+            {
+                // Refer the edge IDs from the TriangleTable by using the table_index.
+                const int e0 = MarchingPyramidTable::TriangleID[table_index][i];
+                const int e1 = MarchingPyramidTable::TriangleID[table_index][i+2];
+                const int e2 = MarchingPyramidTable::TriangleID[table_index][i+1];
+
+                // Determine vertices for each edge.
+                const int v0 = local_index[MarchingPyramidTable::VertexID[e0][0]];
+                const int v1 = local_index[MarchingPyramidTable::VertexID[e0][1]];
+
+                const int v2 = local_index[MarchingPyramidTable::VertexID[e1][0]];
+                const int v3 = local_index[MarchingPyramidTable::VertexID[e1][1]];
+
+                const int v4 = local_index[MarchingPyramidTable::VertexID[e2][0]];
+                const int v5 = local_index[MarchingPyramidTable::VertexID[e2][1]];
+
+                // Calculate coordinates of the vertices which are composed
+                // of the triangle polygon.
+                const kvs::Vector3f vertex0( this->interpolate_vertex<T>( v0, v1 ) );
+                coords.push_back( vertex0.x() );
+                coords.push_back( vertex0.y() );
+                coords.push_back( vertex0.z() );
+
+                const kvs::Vector3f vertex1( this->interpolate_vertex<T>( v2, v3 ) );
+                coords.push_back( vertex1.x() );
+                coords.push_back( vertex1.y() );
+                coords.push_back( vertex1.z() );
+
+                const kvs::Vector3f vertex2( this->interpolate_vertex<T>( v4, v5 ) );
+                coords.push_back( vertex2.x() );
+                coords.push_back( vertex2.y() );
+                coords.push_back( vertex2.z() );
+
+                // Calculate a normal vector for the triangle polygon.
+                const kvs::Vector3f normal( ( vertex1 - vertex0 ).cross( vertex2 - vertex0 ) );
+                normals.push_back( normal.x() );
+                normals.push_back( normal.y() );
+                normals.push_back( normal.z() );
+            } // end of loop-triangle
+        } // end of loop-cell
+    } // end of loop-range
 
     // Calculate the polygon color for the isolevel.
     const kvs::RGBColor color = this->calculate_color<T>();
 
     if( coords.size() > 0 ){
-        SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
+        SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
         SuperClass::setColor( color );
-        SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+        SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
         SuperClass::setOpacity( 255 );
         SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
         SuperClass::setColorType( kvs::PolygonObject::PolygonColor );
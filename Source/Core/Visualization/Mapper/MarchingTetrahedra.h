@@ -19,6 +19,7 @@
 #include <kvs/UnstructuredVolumeObject>
 #include <kvs/MapperBase>
 #include <kvs/Module>
+#include <kvs/MinMaxBlockIndex>
 
 
 namespace kvs
@@ -39,6 +40,7 @@ private:
 
     double m_isolevel; ///< isosurface level
     bool m_duplication; ///< duplication flag
+    kvs::MinMaxBlockIndex* m_block_index; ///< pointer to the min/max block index (not allocated)
 
 public:
 
@@ -51,6 +53,10 @@ public:
         const kvs::TransferFunction& transfer_function );
     virtual ~MarchingTetrahedra();
 
+    void setIsolevel( const double isolevel ) { m_isolevel = isolevel; }
+    void setDuplication( const bool duplication ) { m_duplication = duplication; }
+    void attachBlockIndex( kvs::MinMaxBlockIndex* index ) { m_block_index = index; }
+
     SuperClass* exec( const kvs::ObjectBase* object );
 
 protected:
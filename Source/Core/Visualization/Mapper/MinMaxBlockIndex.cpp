@@ -0,0 +1,390 @@
+/****************************************************************************/
+/**
+ *  @file   MinMaxBlockIndex.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#include "MinMaxBlockIndex.h"
+#include <algorithm>
+#include <kvs/StructuredVolumeObject>
+#include <kvs/UnstructuredVolumeObject>
+#include <kvs/Math>
+#include <kvs/Message>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the min. and max. node values of each brick.
+ *  @param  volume [in] pointer to the structured volume object
+ *  @param  block_size [in] number of cells along each edge of the brick
+ *  @param  resolution [in] number of bricks in each direction
+ *  @param  min_values [out] min. node values of the bricks
+ *  @param  max_values [out] max. node values of the bricks
+ */
+/*===========================================================================*/
+template <typename T>
+void CalculateMinMaxValues(
+    const kvs::StructuredVolumeObject* volume,
+    const size_t block_size,
+    const kvs::Vector3ui& resolution,
+    kvs::Real64* min_values,
+    kvs::Real64* max_values )
+{
+    const T* const values = reinterpret_cast<const T*>( volume->values().data() );
+    const kvs::Vector3ui nnodes = volume->resolution();
+    const size_t line_size = volume->numberOfNodesPerLine();
+    const size_t slice_size = volume->numberOfNodesPerSlice();
+
+    size_t index = 0;
+    for ( size_t bk = 0; bk < resolution.z(); bk++ )
+    {
+        // The bricks share the nodes on their boundaries.
+        const size_t k0 = bk * block_size;
+        const size_t k1 = kvs::Math::Min( k0 + block_size, size_t( nnodes.z() - 1 ) );
+        for ( size_t bj = 0; bj < resolution.y(); bj++ )
+        {
+            const size_t j0 = bj * block_size;
+            const size_t j1 = kvs::Math::Min( j0 + block_size, size_t( nnodes.y() - 1 ) );
+            for ( size_t bi = 0; bi < resolution.x(); bi++, index++ )
+            {
+                const size_t i0 = bi * block_size;
+                const size_t i1 = kvs::Math::Min( i0 + block_size, size_t( nnodes.x() - 1 ) );
+
+                T min_value = values[ i0 + j0 * line_size + k0 * slice_size ];
+                T max_value = min_value;
+                for ( size_t k = k0; k <= k1; k++ )
+                {
+                    for ( size_t j = j0; j <= j1; j++ )
+                    {
+                        const T* line = values + j * line_size + k * slice_size;
+                        for ( size_t i = i0; i <= i1; i++ )
+                        {
+                            min_value = kvs::Math::Min( min_value, line[i] );
+                            max_value = kvs::Math::Max( max_value, line[i] );
+                        }
+                    }
+                }
+
+                min_values[ index ] = static_cast<kvs::Real64>( min_value );
+                max_values[ index ] = static_cast<kvs::Real64>( max_value );
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the min. and max. node values of each run of the cells.
+ *  @param  volume [in] pointer to the unstructured volume object
+ *  @param  ncells_per_block [in] number of cells in the block
+ *  @param  min_values [out] min. node values of the blocks
+ *  @param  max_values [out] max. node values of the blocks
+ */
+/*===========================================================================*/
+template <typename T>
+void CalculateMinMaxValues(
+    const kvs::UnstructuredVolumeObject* volume,
+    const size_t ncells_per_block,
+    kvs::Real64* min_values,
+    kvs::Real64* max_values )
+{
+    const T* const values = reinterpret_cast<const T*>( volume->values().data() );
+    const kvs::UInt32* connections = volume->connections().data();
+    const size_t ncells = volume->numberOfCells();
+    const size_t nnodes_per_cell = volume->numberOfCellNodes();
+
+    for ( size_t cell0 = 0, index = 0; cell0 < ncells; cell0 += ncells_per_block, index++ )
+    {
+        const size_t cell1 = kvs::Math::Min( cell0 + ncells_per_block, ncells );
+        const kvs::UInt32* id = connections + cell0 * nnodes_per_cell;
+        const kvs::UInt32* const end = connections + cell1 * nnodes_per_cell;
+
+        T min_value = values[ *id ];
+        T max_value = min_value;
+        for ( ; id < end; ++id )
+        {
+            min_value = kvs::Math::Min( min_value, values[ *id ] );
+            max_value = kvs::Math::Max( max_value, values[ *id ] );
+        }
+
+        min_values[ index ] = static_cast<kvs::Real64>( min_value );
+        max_values[ index ] = static_cast<kvs::Real64>( max_value );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Compares the blocks by the min. or max. values.
+ */
+/*===========================================================================*/
+class ValueLess
+{
+private:
+
+    const kvs::Real64* m_values; ///< min. or max. values of the blocks
+
+public:
+
+    ValueLess( const kvs::Real64* values ): m_values( values ) {}
+
+    bool operator ()( const kvs::UInt32 lhs, const kvs::UInt32 rhs ) const
+    {
+        return m_values[ lhs ] < m_values[ rhs ];
+    }
+
+    bool operator ()( const double isolevel, const kvs::UInt32 block ) const
+    {
+        return isolevel < m_values[ block ];
+    }
+};
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new MinMaxBlockIndex class.
+ */
+/*===========================================================================*/
+MinMaxBlockIndex::MinMaxBlockIndex():
+    m_version( 0 ),
+    m_block_size( 0 ),
+    m_ncells( 0 ),
+    m_resolution( 0, 0, 0 )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the index has been built for the given volume.
+ *  @param  volume [in] pointer to the volume object
+ *  @return true, if the index has been built for the volume
+ *
+ *  The index is regarded as built for the volume when the volume has the
+ *  same version as the volume used for the build.
+ */
+/*===========================================================================*/
+bool MinMaxBlockIndex::isBuilt( const kvs::VolumeObjectBase* volume ) const
+{
+    return m_block_size > 0 && m_version == volume->version();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the index has been built for the given volume.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  block_size [in] number of cells along each edge of the block
+ *  @return true, if the index has been built for the volume
+ */
+/*===========================================================================*/
+bool MinMaxBlockIndex::isBuilt( const kvs::VolumeObjectBase* volume, const size_t block_size ) const
+{
+    return this->isBuilt( volume ) && m_block_size == block_size;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Builds the min/max block index.
+ *  @param  volume [in] pointer to the volume object
+ *  @param  block_size [in] number of cells along each edge of the block
+ *  @return true, if the index is built successfully
+ */
+/*===========================================================================*/
+bool MinMaxBlockIndex::build( const kvs::VolumeObjectBase* volume, const size_t block_size )
+{
+    this->release();
+
+    if ( volume->veclen() != 1 || block_size == 0 )
+    {
+        kvsMessageError( "Cannot build the index for the vector volume." );
+        return false;
+    }
+
+    const std::type_info& type = volume->values().typeInfo()->type();
+    if ( volume->volumeType() == kvs::VolumeObjectBase::Structured )
+    {
+        const kvs::StructuredVolumeObject* structured_volume = kvs::StructuredVolumeObject::DownCast( volume );
+        const kvs::Vector3ui nnodes = structured_volume->resolution();
+        if ( nnodes.x() < 2 || nnodes.y() < 2 || nnodes.z() < 2 ) { return false; }
+
+        m_resolution.set(
+            static_cast<kvs::UInt32>( ( nnodes.x() - 2 ) / block_size + 1 ),
+            static_cast<kvs::UInt32>( ( nnodes.y() - 2 ) / block_size + 1 ),
+            static_cast<kvs::UInt32>( ( nnodes.z() - 2 ) / block_size + 1 ) );
+
+        const size_t nblocks = m_resolution.x() * m_resolution.y() * m_resolution.z();
+        m_min_values.allocate( nblocks );
+        m_max_values.allocate( nblocks );
+
+        kvs::Real64* min_values = m_min_values.data();
+        kvs::Real64* max_values = m_max_values.data();
+        if (      type == typeid( kvs::Int8   ) ) ::CalculateMinMaxValues<kvs::Int8>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::Int16  ) ) ::CalculateMinMaxValues<kvs::Int16>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::Int32  ) ) ::CalculateMinMaxValues<kvs::Int32>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::Int64  ) ) ::CalculateMinMaxValues<kvs::Int64>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::UInt8  ) ) ::CalculateMinMaxValues<kvs::UInt8>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::UInt16 ) ) ::CalculateMinMaxValues<kvs::UInt16>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::UInt32 ) ) ::CalculateMinMaxValues<kvs::UInt32>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::UInt64 ) ) ::CalculateMinMaxValues<kvs::UInt64>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::Real32 ) ) ::CalculateMinMaxValues<kvs::Real32>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else if ( type == typeid( kvs::Real64 ) ) ::CalculateMinMaxValues<kvs::Real64>( structured_volume, block_size, m_resolution, min_values, max_values );
+        else
+        {
+            kvsMessageError( "Not supported data type '%s'.", volume->values().typeInfo()->typeName() );
+            this->release();
+            return false;
+        }
+    }
+    else // volume->volumeType() == kvs::VolumeObjectBase::Unstructured
+    {
+        const kvs::UnstructuredVolumeObject* unstructured_volume = kvs::UnstructuredVolumeObject::DownCast( volume );
+        const size_t ncells = unstructured_volume->numberOfCells();
+        const size_t ncells_per_block = block_size * block_size * block_size;
+        if ( ncells == 0 ) { return false; }
+
+        m_ncells = ncells;
+        const size_t nblocks = ( ncells - 1 ) / ncells_per_block + 1;
+        m_resolution.set( static_cast<kvs::UInt32>( nblocks ), 1, 1 );
+        m_min_values.allocate( nblocks );
+        m_max_values.allocate( nblocks );
+
+        kvs::Real64* min_values = m_min_values.data();
+        kvs::Real64* max_values = m_max_values.data();
+        if (      type == typeid( kvs::Int8   ) ) ::CalculateMinMaxValues<kvs::Int8>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::Int16  ) ) ::CalculateMinMaxValues<kvs::Int16>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::Int32  ) ) ::CalculateMinMaxValues<kvs::Int32>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::Int64  ) ) ::CalculateMinMaxValues<kvs::Int64>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::UInt8  ) ) ::CalculateMinMaxValues<kvs::UInt8>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::UInt16 ) ) ::CalculateMinMaxValues<kvs::UInt16>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::UInt32 ) ) ::CalculateMinMaxValues<kvs::UInt32>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::UInt64 ) ) ::CalculateMinMaxValues<kvs::UInt64>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::Real32 ) ) ::CalculateMinMaxValues<kvs::Real32>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else if ( type == typeid( kvs::Real64 ) ) ::CalculateMinMaxValues<kvs::Real64>( unstructured_volume, ncells_per_block, min_values, max_values );
+        else
+        {
+            kvsMessageError( "Not supported data type '%s'.", volume->values().typeInfo()->typeName() );
+            this->release();
+            return false;
+        }
+    }
+
+    // Blocks sorted by the min. values and by the max. values.
+    const size_t nblocks = m_min_values.size();
+    m_min_sorted_blocks.allocate( nblocks );
+    for ( size_t i = 0; i < nblocks; i++ ) { m_min_sorted_blocks[i] = static_cast<kvs::UInt32>( i ); }
+    m_max_sorted_blocks = m_min_sorted_blocks.clone();
+    std::sort( m_min_sorted_blocks.begin(), m_min_sorted_blocks.end(), ::ValueLess( m_min_values.data() ) );
+    std::sort( m_max_sorted_blocks.begin(), m_max_sorted_blocks.end(), ::ValueLess( m_max_values.data() ) );
+
+    m_version = volume->version();
+    m_block_size = block_size;
+
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the index.
+ */
+/*===========================================================================*/
+void MinMaxBlockIndex::release()
+{
+    m_version = 0;
+    m_block_size = 0;
+    m_ncells = 0;
+    m_resolution.set( 0, 0, 0 );
+    m_min_values.release();
+    m_max_values.release();
+    m_min_sorted_blocks.release();
+    m_max_sorted_blocks.release();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Finds the blocks which can contain the isosurface.
+ *  @param  isolevel [in] isolevel
+ *  @return indices of the candidate blocks in ascending order
+ *
+ *  The cell is intersected by the isosurface when some of its node values
+ *  are greater than the isolevel and the others are not, so that the block
+ *  is a candidate only if min <= isolevel < max. The blocks satisfying
+ *  min <= isolevel are a prefix of the min-sorted blocks and the blocks
+ *  satisfying isolevel < max are a suffix of the max-sorted blocks, so that
+ *  only the shorter of the two is filtered by the other condition.
+ */
+/*===========================================================================*/
+std::vector<kvs::UInt32> MinMaxBlockIndex::find( const double isolevel ) const
+{
+    std::vector<kvs::UInt32> blocks;
+
+    const size_t nblocks = m_min_sorted_blocks.size();
+    const kvs::UInt32* min_first = m_min_sorted_blocks.data();
+    const kvs::UInt32* min_last = std::upper_bound(
+        min_first, min_first + nblocks, isolevel, ::ValueLess( m_min_values.data() ) );
+    const kvs::UInt32* max_first = std::upper_bound(
+        m_max_sorted_blocks.data(), m_max_sorted_blocks.data() + nblocks, isolevel, ::ValueLess( m_max_values.data() ) );
+    const kvs::UInt32* max_last = m_max_sorted_blocks.data() + nblocks;
+
+    if ( min_last - min_first <= max_last - max_first )
+    {
+        for ( const kvs::UInt32* block = min_first; block != min_last; ++block )
+        {
+            if ( m_max_values[ *block ] > isolevel ) { blocks.push_back( *block ); }
+        }
+    }
+    else
+    {
+        for ( const kvs::UInt32* block = max_first; block != max_last; ++block )
+        {
+            if ( m_min_values[ *block ] <= isolevel ) { blocks.push_back( *block ); }
+        }
+    }
+
+    std::sort( blocks.begin(), blocks.end() );
+    return blocks;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Finds the ranges of the cells which can contain the isosurface.
+ *  @param  isolevel [in] isolevel
+ *  @return first and last (not included) cell indices of the ranges
+ *
+ *  This is for the unstructured volume, in which a block is a run of the
+ *  consecutive cells. The adjacent candidate blocks are merged into a range.
+ */
+/*===========================================================================*/
+std::vector<size_t> MinMaxBlockIndex::findCellRanges( const double isolevel ) const
+{
+    std::vector<size_t> ranges;
+    if ( m_ncells == 0 ) { return ranges; }
+
+    const size_t ncells = m_ncells;
+    const size_t ncells_per_block = this->numberOfCellsPerBlock();
+    const std::vector<kvs::UInt32> blocks = this->find( isolevel );
+    for ( size_t i = 0; i < blocks.size(); i++ )
+    {
+        const size_t first = blocks[i] * ncells_per_block;
+        const size_t last = kvs::Math::Min( first + ncells_per_block, ncells );
+        if ( !ranges.empty() && ranges.back() == first ) { ranges.back() = last; }
+        else { ranges.push_back( first ); ranges.push_back( last ); }
+    }
+
+    return ranges;
+}
+
+} // end of namespace kvs
@@ -0,0 +1,81 @@
+/****************************************************************************/
+/**
+ *  @file   MinMaxBlockIndex.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#ifndef KVS__MIN_MAX_BLOCK_INDEX_H_INCLUDE
+#define KVS__MIN_MAX_BLOCK_INDEX_H_INCLUDE
+
+#include <vector>
+#include <kvs/ValueArray>
+#include <kvs/Vector3>
+#include <kvs/Type>
+#include <kvs/VolumeObjectBase>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Min/max block index for the isosurface extraction.
+ *
+ *  The cells of the volume are grouped into blocks, and the min. and max.
+ *  node values of each block are stored. For the structured volume, a block
+ *  is a brick of block_size^3 cells. For the unstructured volume, a block is
+ *  a run of block_size^3 consecutive cells. A block can contain the
+ *  isosurface only if min <= isolevel < max. The blocks are kept sorted by
+ *  the min. values and by the max. values, and the candidates are found by
+ *  filtering the shorter of the two sorted runs that satisfy one of the
+ *  conditions. The index is built once for the volume and reused for the
+ *  repeated isolevels.
+ *
+ *  The index records the version of the volume it was built for, see
+ *  kvs::ObjectBase::version(). When the node values of the volume are
+ *  modified in place, call updateVersion() of the volume or release() of
+ *  the index so that the index is rebuilt.
+ */
+/*===========================================================================*/
+class MinMaxBlockIndex
+{
+private:
+
+    kvs::UInt64 m_version; ///< version of the volume used for the build
+    size_t m_block_size; ///< number of cells along each edge of the block
+    size_t m_ncells; ///< number of cells of the unstructured volume (0 for the structured volume)
+    kvs::Vector3ui m_resolution; ///< number of blocks in each direction
+    kvs::ValueArray<kvs::Real64> m_min_values; ///< min. node value of each block
+    kvs::ValueArray<kvs::Real64> m_max_values; ///< max. node value of each block
+    kvs::ValueArray<kvs::UInt32> m_min_sorted_blocks; ///< blocks sorted by the min. values
+    kvs::ValueArray<kvs::UInt32> m_max_sorted_blocks; ///< blocks sorted by the max. values
+
+public:
+
+    MinMaxBlockIndex();
+
+    size_t blockSize() const { return m_block_size; }
+    const kvs::Vector3ui& resolution() const { return m_resolution; }
+    size_t numberOfBlocks() const { return m_min_values.size(); }
+    size_t numberOfCellsPerBlock() const { return m_block_size * m_block_size * m_block_size; }
+    bool isBuilt( const kvs::VolumeObjectBase* volume ) const;
+    bool isBuilt( const kvs::VolumeObjectBase* volume, const size_t block_size ) const;
+
+    bool build( const kvs::VolumeObjectBase* volume, const size_t block_size = 8 );
+    void release();
+
+    std::vector<kvs::UInt32> find( const double isolevel ) const;
+    std::vector<size_t> findCellRanges( const double isolevel ) const;
+};
+
+} // end of namespace kvs
+
+#endif // KVS__MIN_MAX_BLOCK_INDEX_H_INCLUDE
@@ -333,9 +333,9 @@ void SlicePlane::extract_plane(
         index += line_size;
     } // end of loop-z
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::VertexColor );
@@ -494,9 +494,9 @@ void SlicePlane::extract_tetrahedra_plane(
         } // end of loop-triangle
     } // end of loop-cell
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::VertexColor );
@@ -629,9 +629,9 @@ void SlicePlane::extract_hexahedra_plane(
         } // end of loop-triangle
     } // end of loop-cell
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::VertexColor );
@@ -761,9 +761,9 @@ void SlicePlane::extract_pyramid_plane(
         } // end of loop-triangle
     } // end of loop-cell
 
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
-    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>( normals ) );
+    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>::Adopt( colors ) );
+    SuperClass::setNormals( kvs::ValueArray<kvs::Real32>::Adopt( normals ) );
     SuperClass::setOpacity( 255 );
     SuperClass::setPolygonType( kvs::PolygonObject::Triangle );
     SuperClass::setColorType( kvs::PolygonObject::VertexColor );
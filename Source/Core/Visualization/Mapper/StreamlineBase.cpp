@@ -16,11 +16,114 @@
 #include <kvs/DebugNew>
 #include <kvs/Type>
 #include <kvs/IgnoreUnusedVariable>
+#include <kvs/Thread>
+#include <kvs/Mutex>
+#include <kvs/MutexLocker>
+#include <kvs/Math>
+#include <cstring>
+#include <cmath>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Streamlines calculated from a chunk of the seed points.
+ */
+/*===========================================================================*/
+struct Lines
+{
+    std::vector<kvs::Real32> coords; ///< coordinate values
+    std::vector<kvs::UInt8> colors; ///< color values
+    std::vector<kvs::UInt32> nvertices; ///< number of vertices of each line
+};
+
+} // end of namespace
 
 
 namespace kvs
 {
 
+/*===========================================================================*/
+/**
+ *  @brief  Thread class for calculating the streamlines.
+ *
+ *  The seed points are divided into chunks, and each thread takes the next
+ *  chunk when it finishes the current one (dynamic scheduling), since the
+ *  streamlines have very different lengths. The lines of each chunk are
+ *  stored in its own buffer, so that they can be concatenated in the order
+ *  of the seed points.
+ */
+/*===========================================================================*/
+class StreamlineBase::LineTracer : public kvs::Thread
+{
+private:
+
+    kvs::StreamlineBase* m_mapper; ///< streamline mapper
+    kvs::Mutex* m_mutex; ///< mutex for the chunk counter
+    size_t* m_next_chunk; ///< index of the next chunk
+    size_t m_chunk_size; ///< number of seed points per chunk
+    size_t m_npoints; ///< number of seed points
+    std::vector< ::Lines>* m_lines; ///< lines of the chunks
+
+public:
+
+    LineTracer():
+        m_mapper( NULL ),
+        m_mutex( NULL ),
+        m_next_chunk( NULL ),
+        m_chunk_size( 0 ),
+        m_npoints( 0 ),
+        m_lines( NULL ) {}
+
+    void setup(
+        kvs::StreamlineBase* mapper,
+        kvs::Mutex* mutex,
+        size_t* next_chunk,
+        const size_t chunk_size,
+        const size_t npoints,
+        std::vector< ::Lines>* lines )
+    {
+        m_mapper = mapper;
+        m_mutex = mutex;
+        m_next_chunk = next_chunk;
+        m_chunk_size = chunk_size;
+        m_npoints = npoints;
+        m_lines = lines;
+    }
+
+    void run()
+    {
+        std::vector<kvs::Real32> line_coords;
+        std::vector<kvs::UInt8> line_colors;
+        for ( ; ; )
+        {
+            size_t chunk = 0;
+            {
+                kvs::MutexLocker locker( m_mutex );
+                chunk = ( *m_next_chunk )++;
+            }
+            if ( chunk >= m_lines->size() ) { break; }
+
+            ::Lines& lines = ( *m_lines )[ chunk ];
+            const size_t begin = chunk * m_chunk_size;
+            const size_t end = kvs::Math::Min( begin + m_chunk_size, m_npoints );
+            for ( size_t index = begin; index < end; index++ )
+            {
+                line_coords.clear();
+                line_colors.clear();
+                if ( !m_mapper->calculate_line( &line_coords, &line_colors, index ) ) continue;
+                if ( !m_mapper->check_for_acceptance( line_coords ) ) continue;
+
+                lines.coords.insert( lines.coords.end(), line_coords.begin(), line_coords.end() );
+                lines.colors.insert( lines.colors.end(), line_colors.begin(), line_colors.end() );
+                lines.nvertices.push_back( static_cast<kvs::UInt32>( line_coords.size() / 3 ) );
+            }
+        }
+    }
+};
+
 /*===========================================================================*/
 /**
  *  @brief  Constructs a new streamline class.
@@ -32,11 +135,15 @@ StreamlineBase::StreamlineBase():
     m_integration_method( Streamline::RungeKutta2nd ),
     m_integration_direction( Streamline::ForwardDirection ),
     m_integration_interval( 0.35f ),
+    m_min_integration_interval( 0.01f ),
+    m_max_integration_interval( 2.0f ),
+    m_error_tolerance( 0.001f ),
     m_vector_length_threshold( 0.000001f ),
     m_integration_times_threshold( 256 ),
     m_enable_boundary_condition( true ),
     m_enable_vector_length_condition( true ),
-    m_enable_integration_times_condition( true )
+    m_enable_integration_times_condition( true ),
+    m_number_of_threads( 1 )
 {
 }
 
@@ -67,6 +174,21 @@ void StreamlineBase::setSeedPoints( const kvs::PointObject* seed_points )
     m_seed_points->setSize( 1 );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for calculating the streamlines.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ *
+ *  The streamlines are calculated by a single thread by default. The derived
+ *  classes must be thread-safe to use several threads, that is, the virtual
+ *  functions must not modify the mapper.
+ */
+/*===========================================================================*/
+void StreamlineBase::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Calculates the streamlines.
@@ -99,46 +221,66 @@ void StreamlineBase::extract_lines(
 {
     kvs::IgnoreUnusedVariable( volume );
 
-    // Calculated data arrays.
-    std::vector<kvs::Real32> coords;
-    std::vector<kvs::UInt32> connections;
-    std::vector<kvs::UInt8>  colors;
-
     // Calculate streamline for each seed point.
     const size_t npoints = m_seed_points->numberOfVertices();
-    for ( size_t index = 0; index < npoints; index++ )
+    const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, npoints ) );
+    const size_t chunk_size = kvs::Math::Max( size_t(1), kvs::Math::Min( size_t(64), npoints / ( nthreads * 16 ) ) );
+    const size_t nchunks = ( npoints + chunk_size - 1 ) / chunk_size;
+
+    kvs::Mutex mutex;
+    size_t next_chunk = 0;
+    std::vector< ::Lines> lines( nchunks );
+    std::vector<LineTracer> tracers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
     {
-        std::vector<kvs::Real32> line_coords;
-        std::vector<kvs::UInt8> line_colors;
+        tracers[i].setup( this, &mutex, &next_chunk, chunk_size, npoints, &lines );
+    }
 
-        if ( this->calculate_line( &line_coords, &line_colors, index ) )
-        {
-            if ( !this->check_for_acceptance( line_coords ) ) continue;
+    kvs::Thread::Run( &tracers[0], nthreads );
+
+    // Concatenate the lines in the order of the seed points.
+    size_t ncoords = 0;
+    size_t nlines = 0;
+    for ( size_t i = 0; i < nchunks; i++ )
+    {
+        ncoords += lines[i].coords.size();
+        nlines += lines[i].nvertices.size();
+    }
 
-            // Set the first vertex ID to the connections.
-            const size_t dimension = 3;
-            const size_t start_id = coords.size() / dimension;
-            connections.push_back( static_cast<kvs::UInt32>( start_id ) );
+    kvs::ValueArray<kvs::Real32> coords( ncoords );
+    kvs::ValueArray<kvs::UInt8> colors( ncoords );
+    kvs::ValueArray<kvs::UInt32> connections( nlines * 2 );
+    size_t coord_offset = 0;
+    size_t connection_offset = 0;
+    for ( size_t i = 0; i < nchunks; i++ )
+    {
+        const ::Lines& chunk = lines[i];
+        if ( chunk.coords.empty() && chunk.nvertices.empty() ) continue;
 
-            // Set the line coordinate and color value array to the coords and colors, respectively.
-            const size_t ncoords = line_coords.size();
-            for( size_t i = 0; i < ncoords; i++ )
-            {
-                coords.push_back( line_coords[i] );
-                colors.push_back( line_colors[i] );
-            }
+        if ( !chunk.coords.empty() )
+        {
+            memcpy( coords.data() + coord_offset, &chunk.coords[0], sizeof( kvs::Real32 ) * chunk.coords.size() );
+            memcpy( colors.data() + coord_offset, &chunk.colors[0], sizeof( kvs::UInt8 ) * chunk.colors.size() );
+        }
 
-            // Set the last vertex ID to the connections.
-            const size_t last_id = coords.size() / dimension - 1;
-            connections.push_back( static_cast<kvs::UInt32>( last_id ) );
+        // Set the first and last vertex IDs to the connections.
+        size_t start_id = coord_offset / 3;
+        for ( size_t j = 0; j < chunk.nvertices.size(); j++ )
+        {
+            const size_t last_id = start_id + chunk.nvertices[j] - 1;
+            connections[ connection_offset++ ] = static_cast<kvs::UInt32>( start_id );
+            connections[ connection_offset++ ] = static_cast<kvs::UInt32>( last_id );
+            start_id = last_id + 1;
         }
+
+        coord_offset += chunk.coords.size();
     }
 
     SuperClass::setLineType( kvs::LineObject::Polyline );
     SuperClass::setColorType( kvs::LineObject::VertexColor );
-    SuperClass::setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    SuperClass::setConnections( kvs::ValueArray<kvs::UInt32>( connections ) );
-    SuperClass::setColors( kvs::ValueArray<kvs::UInt8>( colors ) );
+    SuperClass::setCoords( coords );
+    SuperClass::setConnections( connections );
+    SuperClass::setColors( colors );
     SuperClass::setSize( 1.0f );
 }
 
@@ -165,8 +307,7 @@ bool StreamlineBase::calculate_line(
         // Forward direction.
         std::vector<kvs::Real32> tmp_coords1;
         std::vector<kvs::UInt8> tmp_colors1;
-        m_integration_direction = StreamlineBase::ForwardDirection;
-        if ( !this->calculate_one_side( &tmp_coords1, &tmp_colors1, seed_point, seed_vector ) )
+        if ( !this->calculate_one_side( &tmp_coords1, &tmp_colors1, seed_point, seed_vector, StreamlineBase::ForwardDirection ) )
         {
             return false;
         }
@@ -174,14 +315,11 @@ bool StreamlineBase::calculate_line(
         // backward direction.
         std::vector<kvs::Real32> tmp_coords2;
         std::vector<kvs::UInt8> tmp_colors2;
-        m_integration_direction = StreamlineBase::BackwardDirection;
-        if ( !this->calculate_one_side( &tmp_coords2, &tmp_colors2, seed_point, seed_vector ) )
+        if ( !this->calculate_one_side( &tmp_coords2, &tmp_colors2, seed_point, seed_vector, StreamlineBase::BackwardDirection ) )
         {
             return false;
         }
 
-        m_integration_direction = StreamlineBase::BothDirections;
-
         const size_t nvertices1 = tmp_coords1.size() / 3;
         for( size_t i = 0; i < nvertices1; i++ )
         {
@@ -212,7 +350,7 @@ bool StreamlineBase::calculate_line(
     else
     {
         // Forward or backword direction.
-        return this->calculate_one_side( &(*coords), &(*colors), seed_point, seed_vector );
+        return this->calculate_one_side( &(*coords), &(*colors), seed_point, seed_vector, m_integration_direction );
     }
 
 
@@ -226,6 +364,7 @@ bool StreamlineBase::calculate_line(
  *  @param  colors [out] pointer to the color data array
  *  @param  seed_point [in] seed point
  *  @param  seed_vector [in] seed vector
+ *  @param  side [in] integration direction of the side (forward or backward)
  *  @return 
  */
 /*===========================================================================*/
@@ -233,7 +372,8 @@ bool StreamlineBase::calculate_one_side(
     std::vector<kvs::Real32>* coords,
     std::vector<kvs::UInt8>* colors,
     const kvs::Vec3& seed_point,
-    const kvs::Vec3& seed_vector )
+    const kvs::Vec3& seed_vector,
+    const IntegrationDirection side )
 {
     // Register the seed point.
     kvs::Vec3 current_vertex = seed_point;
@@ -245,6 +385,11 @@ bool StreamlineBase::calculate_one_side(
 
     // Register the vector on the seed point.
     kvs::Vec3 current_vector = seed_vector;
+
+    // Integration interval, which is adapted along the line by the adaptive
+    // integration, and the vector at the next vertex evaluated by it.
+    float interval = m_integration_interval;
+    kvs::Vec3 next_vector = seed_vector;
     kvs::Vec3 previous_vector = seed_vector;
 
     // Set the color of seed point.
@@ -261,7 +406,10 @@ bool StreamlineBase::calculate_one_side(
         if ( !this->calculate_next_vertex(
                  current_vertex,
                  current_vector,
-                 &next_vertex ) )
+                 side,
+                 &interval,
+                 &next_vertex,
+                 &next_vector ) )
         {
             return true;
         }
@@ -284,8 +432,10 @@ bool StreamlineBase::calculate_one_side(
         coords->push_back( current_vertex.y() );
         coords->push_back( current_vertex.z() );
 
-        // Interpolate vector from vertex of cell.
-        current_vector = this->interpolate_vector( current_vertex, previous_vector );
+        // Interpolate vector from vertex of cell. The Dormand-Prince integration
+        // has evaluated it at the last stage (first same as last).
+        if ( m_integration_method == StreamlineBase::DormandPrince ) { current_vector = next_vector; }
+        else { current_vector = this->interpolate_vector( current_vertex, previous_vector ); }
 
         // Set color of vertex.
         kvs::RGBColor col = this->calculate_color( current_vector );
@@ -303,23 +453,31 @@ bool StreamlineBase::calculate_one_side(
  *  @brief  Calculate a next vertex.
  *  @param  current_vertex [in] current vertex
  *  @param  current_direction [in] current direction vector
+ *  @param  side [in] integration direction of the side (forward or backward)
+ *  @param  interval [in/out] integration interval of the adaptive integration
  *  @param  next_vertex [in] next vertex
+ *  @param  next_vector [out] vector at the next vertex (adaptive integration only)
  *  @return 
  */
 /*===========================================================================*/
 bool StreamlineBase::calculate_next_vertex(
     const kvs::Vec3& current_vertex,
     const kvs::Vec3& current_direction,
-    kvs::Vec3* next_vertex )
+    const IntegrationDirection side,
+    float* interval,
+    kvs::Vec3* next_vertex,
+    kvs::Vec3* next_vector )
 {
     switch( m_integration_method )
     {
     case StreamlineBase::Euler:
-        return this->integrate_by_euler( current_vertex, current_direction, &(*next_vertex) );
+        return this->integrate_by_euler( current_vertex, current_direction, side, &(*next_vertex) );
     case StreamlineBase::RungeKutta2nd:
-        return this->integrate_by_runge_kutta_2nd( current_vertex, current_direction, &(*next_vertex) );
+        return this->integrate_by_runge_kutta_2nd( current_vertex, current_direction, side, &(*next_vertex) );
     case StreamlineBase::RungeKutta4th:
-        return this->integrate_by_runge_kutta_4th( current_vertex, current_direction, &(*next_vertex) );
+        return this->integrate_by_runge_kutta_4th( current_vertex, current_direction, side, &(*next_vertex) );
+    case StreamlineBase::DormandPrince:
+        return this->integrate_by_dormand_prince( current_vertex, current_direction, side, interval, &(*next_vertex), next_vector );
     default: break;
     }
 
@@ -332,6 +490,7 @@ bool StreamlineBase::calculate_next_vertex(
  *  @brief  Integrate by Eular.
  *  @param  current_vertex [in] current vertex
  *  @param  current_direction [in] current direction vector
+ *  @param  side [in] integration direction of the side (forward or backward)
  *  @param  next_vertex [in] next vertex
  *  @return 
  */
@@ -339,6 +498,7 @@ bool StreamlineBase::calculate_next_vertex(
 bool StreamlineBase::integrate_by_euler(
     const kvs::Vec3& current_vertex,
     const kvs::Vec3& current_direction,
+    const IntegrationDirection side,
     kvs::Vec3* next_vertex )
 {
     if ( m_enable_boundary_condition )
@@ -346,7 +506,7 @@ bool StreamlineBase::integrate_by_euler(
         if ( !this->check_for_inside_volume( current_vertex ) ) return false;
     }
 
-    const float integration_direction = static_cast<float>( m_integration_direction );
+    const float integration_direction = static_cast<float>( side );
     const kvs::Vec3 k1 = current_direction.normalized() * integration_direction;
     *next_vertex = current_vertex + m_integration_interval * k1;
 
@@ -358,6 +518,7 @@ bool StreamlineBase::integrate_by_euler(
  *  @brief  Integrate by Runge-Kutta 2nd.
  *  @param  current_vertex [in] current vertex
  *  @param  current_direction [in] current direction vector
+ *  @param  side [in] integration direction of the side (forward or backward)
  *  @param  next_vertex [in] next vertex
  *  @return 
  */
@@ -365,6 +526,7 @@ bool StreamlineBase::integrate_by_euler(
 bool StreamlineBase::integrate_by_runge_kutta_2nd(
     const kvs::Vec3& current_vertex,
     const kvs::Vec3& current_direction,
+    const IntegrationDirection side,
     kvs::Vec3* next_vertex )
 {
     if ( m_enable_boundary_condition )
@@ -372,7 +534,7 @@ bool StreamlineBase::integrate_by_runge_kutta_2nd(
         if ( !this->check_for_inside_volume( current_vertex ) ) return false;
     }
 
-    const float integration_direction = static_cast<float>( m_integration_direction );
+    const float integration_direction = static_cast<float>( side );
     const kvs::Vec3 k1 = current_direction.normalized() * integration_direction;
     // Interpolate vector from vertex of cell.
     const kvs::Vec3 vertex = current_vertex + 0.5f * m_integration_interval * k1;
@@ -394,6 +556,7 @@ bool StreamlineBase::integrate_by_runge_kutta_2nd(
  *  @brief  Integrate by Runge-Kutta 4th.
  *  @param  current_vertex [in] current vertex
  *  @param  current_direction [in] current direction vector
+ *  @param  side [in] integration direction of the side (forward or backward)
  *  @param  next_vertex [in] next vertex
  *  @return 
  */
@@ -401,6 +564,7 @@ bool StreamlineBase::integrate_by_runge_kutta_2nd(
 bool StreamlineBase::integrate_by_runge_kutta_4th(
     const kvs::Vec3& current_vertex,
     const kvs::Vec3& current_direction,
+    const IntegrationDirection side,
     kvs::Vec3* next_vertex )
 {
     if ( m_enable_boundary_condition )
@@ -410,7 +574,7 @@ bool StreamlineBase::integrate_by_runge_kutta_4th(
 
     // Calculate integration interval.
 
-    const float integration_direction = static_cast<float>( m_integration_direction );
+    const float integration_direction = static_cast<float>( side );
     const kvs::Vec3 k1 = current_direction.normalized() * integration_direction;
 
     // Interpolate vector from vertex of cell.
@@ -446,7 +610,118 @@ bool StreamlineBase::integrate_by_runge_kutta_4th(
     const kvs::Vec3 direction4 = this->interpolate_vector( vertex4, current_direction );
     const kvs::Vec3 k4 = direction4.normalized() * integration_direction;
 
-    *next_vertex = current_vertex + integration_direction * ( k1 + 2.0f * ( k2 + k3 ) + k4 ) / 6.0f;
+    *next_vertex = current_vertex + m_integration_interval * ( k1 + 2.0f * ( k2 + k3 ) + k4 ) / 6.0f;
+
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Integrate by the adaptive Runge-Kutta 4(5) of Dormand-Prince.
+ *  @param  current_vertex [in] current vertex
+ *  @param  current_direction [in] current direction vector
+ *  @param  side [in] integration direction of the side (forward or backward)
+ *  @param  interval [in/out] integration interval (the next one on return)
+ *  @param  next_vertex [in] next vertex
+ *  @param  next_vector [out] vector at the next vertex
+ *  @return true, if the next vertex is calculated
+ *
+ *  The local error is estimated by the difference between the embedded 4th
+ *  and 5th order solutions. The step is retried with a smaller interval until
+ *  the error is within the tolerance, and the next interval is predicted from
+ *  the error, so that the interval is reused along the line. The interval is
+ *  limited to [min. integration interval, max. integration interval]. The last
+ *  stage is evaluated at the next vertex, and the vector there is returned so
+ *  that it is used as the first stage of the next step.
+ */
+/*===========================================================================*/
+bool StreamlineBase::integrate_by_dormand_prince(
+    const kvs::Vec3& current_vertex,
+    const kvs::Vec3& current_direction,
+    const IntegrationDirection side,
+    float* interval,
+    kvs::Vec3* next_vertex,
+    kvs::Vec3* next_vector )
+{
+    if ( m_enable_boundary_condition )
+    {
+        if ( !this->check_for_inside_volume( current_vertex ) ) return false;
+    }
+
+    // Butcher tableau.
+    const float a21 = 1.0f / 5.0f;
+    const float a31 = 3.0f / 40.0f, a32 = 9.0f / 40.0f;
+    const float a41 = 44.0f / 45.0f, a42 = -56.0f / 15.0f, a43 = 32.0f / 9.0f;
+    const float a51 = 19372.0f / 6561.0f, a52 = -25360.0f / 2187.0f, a53 = 64448.0f / 6561.0f, a54 = -212.0f / 729.0f;
+    const float a61 = 9017.0f / 3168.0f, a62 = -355.0f / 33.0f, a63 = 46732.0f / 5247.0f, a64 = 49.0f / 176.0f, a65 = -5103.0f / 18656.0f;
+    const float b1 = 35.0f / 384.0f, b3 = 500.0f / 1113.0f, b4 = 125.0f / 192.0f, b5 = -2187.0f / 6784.0f, b6 = 11.0f / 84.0f;
+    const float e1 = 71.0f / 57600.0f, e3 = -71.0f / 16695.0f, e4 = 71.0f / 1920.0f, e5 = -17253.0f / 339200.0f, e6 = 22.0f / 525.0f, e7 = -1.0f / 40.0f;
+
+    const float min_interval = m_min_integration_interval;
+    const float max_interval = kvs::Math::Max( m_min_integration_interval, m_max_integration_interval );
+    const float sign = static_cast<float>( side );
+    const kvs::Vec3 k1 = current_direction.normalized() * sign;
+
+    float h = kvs::Math::Clamp( *interval, min_interval, max_interval );
+    for ( ; ; )
+    {
+        kvs::Vec3 k2, k3, k4, k5, k6, k7, v7;
+        const bool inside =
+            this->calculate_slope( current_vertex + h * ( a21 * k1 ), current_direction, sign, &k2 ) &&
+            this->calculate_slope( current_vertex + h * ( a31 * k1 + a32 * k2 ), current_direction, sign, &k3 ) &&
+            this->calculate_slope( current_vertex + h * ( a41 * k1 + a42 * k2 + a43 * k3 ), current_direction, sign, &k4 ) &&
+            this->calculate_slope( current_vertex + h * ( a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4 ), current_direction, sign, &k5 ) &&
+            this->calculate_slope( current_vertex + h * ( a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5 ), current_direction, sign, &k6 ) &&
+            this->calculate_slope( current_vertex + h * ( b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6 ), current_direction, sign, &k7, &v7 );
+
+        if ( !inside )
+        {
+            // Retry with the half interval near the boundary.
+            if ( h <= min_interval ) return false;
+            h = kvs::Math::Max( min_interval, 0.5f * h );
+            continue;
+        }
+
+        const float error = ( h * ( e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7 ) ).length();
+        const float scale = error > 0.0f ? 0.9f * std::pow( m_error_tolerance / error, 0.2f ) : 5.0f;
+        if ( error <= m_error_tolerance || h <= min_interval )
+        {
+            *next_vertex = current_vertex + h * ( b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6 );
+            *interval = kvs::Math::Clamp( h * kvs::Math::Clamp( scale, 0.2f, 5.0f ), min_interval, max_interval );
+            *next_vector = v7;
+            return true;
+        }
+
+        h = kvs::Math::Max( min_interval, h * kvs::Math::Max( scale, 0.2f ) );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the unit direction vector of the integration.
+ *  @param  vertex [in] vertex
+ *  @param  current_direction [in] current direction vector
+ *  @param  sign [in] sign of the integration direction
+ *  @param  slope [out] unit direction vector
+ *  @param  vector [out] interpolated vector (not returned if NULL)
+ *  @return true, if the vertex is inside the volume (or the boundary condition is disabled)
+ */
+/*===========================================================================*/
+bool StreamlineBase::calculate_slope(
+    const kvs::Vec3& vertex,
+    const kvs::Vec3& current_direction,
+    const float sign,
+    kvs::Vec3* slope,
+    kvs::Vec3* vector )
+{
+    if ( m_enable_boundary_condition )
+    {
+        if ( !this->check_for_inside_volume( vertex ) ) return false;
+    }
+
+    const kvs::Vec3 direction = this->interpolate_vector( vertex, current_direction );
+    *slope = direction.normalized() * sign;
+    if ( vector ) { *vector = direction; }
 
     return true;
 }
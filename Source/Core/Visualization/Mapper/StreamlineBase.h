@@ -42,7 +42,8 @@ public:
     {
         Euler = 0,
         RungeKutta2nd = 1,
-        RungeKutta4th = 2
+        RungeKutta4th = 2,
+        DormandPrince = 3 ///< adaptive Runge-Kutta 4(5) by Dormand-Prince
     };
 
     enum IntegrationDirection
@@ -58,11 +59,15 @@ protected:
     IntegrationMethod m_integration_method; ///< integtration method
     IntegrationDirection m_integration_direction; ///< integration direction
     float m_integration_interval; ///< integration interval in the object coordinate
+    float m_min_integration_interval; ///< min. integration interval for the adaptive integration
+    float m_max_integration_interval; ///< max. integration interval for the adaptive integration
+    float m_error_tolerance; ///< tolerance of the local error for the adaptive integration
     float m_vector_length_threshold; ///< threshold of the vector length
     size_t m_integration_times_threshold; ///< threshold of the integration times
     bool m_enable_boundary_condition; ///< flag for the boundray condition
     bool m_enable_vector_length_condition; ///< flag for the vector length condition
     bool m_enable_integration_times_condition; ///< flag for the integration times
+    size_t m_number_of_threads; ///< number of threads for integrating the streamlines
 
 public:
 
@@ -73,16 +78,24 @@ public:
     void setIntegrationMethod( const IntegrationMethod method ) { m_integration_method = method; }
     void setIntegrationDirection( const IntegrationDirection direction ) { m_integration_direction = direction; }
     void setIntegrationInterval( const float interval ) { m_integration_interval = interval; }
+    void setMinIntegrationInterval( const float interval ) { m_min_integration_interval = interval; }
+    void setMaxIntegrationInterval( const float interval ) { m_max_integration_interval = interval; }
+    void setErrorTolerance( const float tolerance ) { m_error_tolerance = tolerance; }
     void setVectorLengthThreshold( const float length ) { m_vector_length_threshold = length; }
     void setIntegrationTimesThreshold( const size_t times ) { m_integration_times_threshold = times; }
     void setEnableBoundaryCondition( const bool enabled ) { m_enable_boundary_condition = enabled; }
     void setEnableVectorLengthCondition( const bool enabled ) { m_enable_vector_length_condition = enabled; }
     void setEnableIntegrationTimesCondition( const bool enabled ) { m_enable_integration_times_condition = enabled; }
 
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    void setNumberOfThreads( const size_t nthreads );
+
     virtual kvs::ObjectBase* exec( const kvs::ObjectBase* object ) = 0;
 
 protected:
 
+    class LineTracer;
+
     virtual bool check_for_acceptance( const std::vector<kvs::Real32>& vertices ) = 0;
     virtual bool check_for_termination(
         const kvs::Vec3& current_vertex,
@@ -101,23 +114,43 @@ protected:
         std::vector<kvs::Real32>* coords,
         std::vector<kvs::UInt8>* colors,
         const kvs::Vec3& seed_point,
-        const kvs::Vec3& seed_vector );
+        const kvs::Vec3& seed_vector,
+        const IntegrationDirection side );
     bool calculate_next_vertex(
         const kvs::Vec3& current_vertex,
         const kvs::Vec3& current_direction,
-        kvs::Vec3* next_vertex );
+        const IntegrationDirection side,
+        float* interval,
+        kvs::Vec3* next_vertex,
+        kvs::Vec3* next_vector );
     bool integrate_by_euler(
         const kvs::Vec3& current_vertex,
         const kvs::Vec3& current_direction,
+        const IntegrationDirection side,
         kvs::Vec3* next_vertex );
     bool integrate_by_runge_kutta_2nd(
         const kvs::Vec3& current_vertex,
         const kvs::Vec3& current_direction,
+        const IntegrationDirection side,
         kvs::Vec3* next_vertex );
     bool integrate_by_runge_kutta_4th(
         const kvs::Vec3& current_vertex,
         const kvs::Vec3& current_direction,
+        const IntegrationDirection side,
         kvs::Vec3* next_vertex );
+    bool integrate_by_dormand_prince(
+        const kvs::Vec3& current_vertex,
+        const kvs::Vec3& current_direction,
+        const IntegrationDirection side,
+        float* interval,
+        kvs::Vec3* next_vertex,
+        kvs::Vec3* next_vector );
+    bool calculate_slope(
+        const kvs::Vec3& vertex,
+        const kvs::Vec3& current_direction,
+        const float sign,
+        kvs::Vec3* slope,
+        kvs::Vec3* vector = NULL );
 
     bool check_for_inside_volume( const kvs::Vec3& seed );
     bool check_for_vector_length( const kvs::Vec3& direction );
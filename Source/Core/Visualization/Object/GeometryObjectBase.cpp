@@ -87,6 +87,17 @@ void GeometryObjectBase::print( std::ostream& os, const kvs::Indent& indent ) co
     os << indent << "Number of normal vectors : " << this->numberOfNormals() << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t GeometryObjectBase::byteSize() const
+{
+    return m_coords.byteSize() + m_colors.byteSize() + m_normals.byteSize();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Sets a color value.
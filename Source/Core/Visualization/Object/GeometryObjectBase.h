@@ -65,10 +65,11 @@ public:
     void deepCopy( const GeometryObjectBase& object );
     void clear();
     virtual void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    virtual size_t byteSize() const;
 
-    void setCoords( const kvs::ValueArray<kvs::Real32>& coords ) {  m_coords = coords; }
-    void setColors( const kvs::ValueArray<kvs::UInt8>& colors ) { m_colors = colors; }
-    void setNormals( const kvs::ValueArray<kvs::Real32>& normals ) { m_normals = normals; }
+    void setCoords( const kvs::ValueArray<kvs::Real32>& coords ) { m_coords = coords; this->updateVersion(); }
+    void setColors( const kvs::ValueArray<kvs::UInt8>& colors ) { m_colors = colors; this->updateVersion(); }
+    void setNormals( const kvs::ValueArray<kvs::Real32>& normals ) { m_normals = normals; this->updateVersion(); }
     void setColor( const kvs::RGBColor& color );
 
     GeometryType geometryType() const { return m_geometry_type; }
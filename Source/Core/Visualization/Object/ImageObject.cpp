@@ -122,6 +122,17 @@ void ImageObject::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Pixel type : " << ::GetPixelTypeName( this->pixelType() ) << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t ImageObject::byteSize() const
+{
+    return m_pixels.byteSize();
+}
+
 /*==========================================================================*/
 /**
  *  @brief  Returns the number of color channels.
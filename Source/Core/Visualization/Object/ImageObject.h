@@ -67,6 +67,7 @@ public:
     void shallowCopy( const ImageObject& object );
     void deepCopy( const ImageObject& object );
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
 
     PixelType pixelType() const { return m_type; }
     size_t width() const { return m_width; }
@@ -76,8 +77,8 @@ public:
     size_t bytesPerPixel() const { return m_type >> 3; }
     size_t numberOfChannels() const;
 
-    void setSize( const size_t width, const size_t height ) { m_width = width; m_height = height; }
-    void setPixels( const kvs::ValueArray<kvs::UInt8>& pixels, const PixelType type = Color24 ) { m_pixels = pixels; m_type = type; }
+    void setSize( const size_t width, const size_t height ) { m_width = width; m_height = height; this->updateVersion(); }
+    void setPixels( const kvs::ValueArray<kvs::UInt8>& pixels, const PixelType type = Color24 ) { m_pixels = pixels; m_type = type; this->updateVersion(); }
 
 public:
     KVS_DEPRECATED( const kvs::ValueArray<kvs::UInt8>& data() const ) { return this->pixels(); }
@@ -305,6 +305,17 @@ void LineObject::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Color type : " << ::GetColorTypeName( this->colorType() ) << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t LineObject::byteSize() const
+{
+    return BaseClass::byteSize() + this->connections().byteSize() + this->sizes().byteSize();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Sets a color value.
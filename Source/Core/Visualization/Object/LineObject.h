@@ -74,6 +74,7 @@ public:
     void deepCopy( const LineObject& object );
     void clear();
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
 
     void setLineType( const LineType line_type ) { m_line_type = line_type; }
     void setLineTypeToStrip() { this->setLineType( Strip ); }
@@ -83,8 +84,8 @@ public:
     void setColorType( const ColorType color_type ) { m_color_type = color_type; }
     void setColorTypeToVertex() { this->setColorType( VertexColor ); }
     void setColorTypeToLine() { this->setColorType( LineColor ); }
-    void setConnections( const kvs::ValueArray<kvs::UInt32>& connections ) { m_connections = connections; }
-    void setSizes( const kvs::ValueArray<kvs::Real32>& sizes ) { m_sizes = sizes; }
+    void setConnections( const kvs::ValueArray<kvs::UInt32>& connections ) { m_connections = connections; this->updateVersion(); }
+    void setSizes( const kvs::ValueArray<kvs::Real32>& sizes ) { m_sizes = sizes; this->updateVersion(); }
     void setColor( const kvs::RGBColor& color );
     void setSize( const kvs::Real32 size );
 
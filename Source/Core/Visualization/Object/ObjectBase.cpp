@@ -17,6 +17,51 @@
 #include <kvs/Camera>
 #include <kvs/Math>
 #include <kvs/OpenGL>
+#include <kvs/Platform>
+#include <kvs/Compiler>
+#if defined ( KVS_COMPILER_VC )
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+
+size_t VersionCounter = 0; ///< last version number issued in the process
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds the value to the counter atomically.
+ *  @param  counter [in/out] counter
+ *  @param  value [in] value
+ *  @return counter after the addition
+ */
+/*===========================================================================*/
+inline size_t AtomicAdd( size_t* counter, const size_t value )
+{
+#if defined ( KVS_COMPILER_VC )
+#if defined ( KVS_PLATFORM_CPU_64 )
+    return static_cast<size_t>( _InterlockedExchangeAdd64( reinterpret_cast<volatile __int64*>( counter ), value ) ) + value;
+#else
+    return static_cast<size_t>( _InterlockedExchangeAdd( reinterpret_cast<volatile long*>( counter ), value ) ) + value;
+#endif
+#else
+    return __sync_add_and_fetch( counter, value );
+#endif
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a new version number unique in the process.
+ *  @return version number
+ */
+/*===========================================================================*/
+kvs::UInt64 NewVersion()
+{
+    return static_cast<kvs::UInt64>( ::AtomicAdd( &VersionCounter, 1 ) );
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -37,7 +82,8 @@ ObjectBase::ObjectBase():
     m_max_external_coord( kvs::Vec3::All(  3.0 ) ),
     m_has_min_max_object_coords( false ),
     m_has_min_max_external_coords( false ),
-    m_show_flag( true )
+    m_show_flag( true ),
+    m_version( ::NewVersion() )
 {
 }
 
@@ -70,6 +116,7 @@ ObjectBase& ObjectBase::operator = ( const ObjectBase& object )
     m_external_center = object.m_external_center;
     m_normalize = object.m_normalize;
     m_show_flag = object.m_show_flag;
+    m_version = object.m_version;
 
     return *this;
 }
@@ -133,6 +180,31 @@ void ObjectBase::print( std::ostream& os, const kvs::Indent& indent ) const
     os.flags( flags );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size (0 for the object without the data arrays)
+ */
+/*===========================================================================*/
+size_t ObjectBase::byteSize() const
+{
+    return 0;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Gives the object a new version number.
+ *
+ *  The version changes whenever the data arrays are replaced with the setters.
+ *  Call this method after modifying the data arrays in place, so that the
+ *  results derived from the old data (e.g. cached indices) are not reused.
+ */
+/*===========================================================================*/
+void ObjectBase::updateVersion()
+{
+    m_version = ::NewVersion();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Updates the normalize parameters.
@@ -23,6 +23,7 @@
 #include <kvs/Module>
 #include <kvs/Indent>
 #include <kvs/Deprecated>
+#include <kvs/Type>
 
 
 namespace kvs
@@ -65,6 +66,7 @@ private:
     kvs::Vec3 m_external_center; ///< center of the object in external object coordinate system
     kvs::Vec3 m_normalize; ///< normalize parameter
     bool m_show_flag; ///< flag for showing object
+    kvs::UInt64 m_version; ///< version of the object data
 
 public:
 
@@ -79,6 +81,7 @@ public:
     void show() { m_show_flag = true; }
     void hide() { m_show_flag = false; }
     virtual void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    virtual size_t byteSize() const;
 
     ObjectType objectType() const { return m_object_type; }
     const std::string& name() const { return m_name; }
@@ -93,8 +96,10 @@ public:
     const kvs::Vec3& normalize() const { return m_normalize; }
     const kvs::Mat4 modelingMatrix() const { return this->xform().toMatrix(); }
     bool isShown() const { return m_show_flag; }
+    kvs::UInt64 version() const { return m_version; }
 
     void updateNormalizeParameters();
+    void updateVersion();
     virtual void updateMinMaxCoords(){};
 
 protected:
@@ -115,6 +120,7 @@ public:
         m_has_min_max_object_coords = false;
         m_has_min_max_external_coords = false;
         m_show_flag = true;
+        this->updateVersion();
 
         this->setXform( kvs::Xform( translation, scaling, rotation ) );
         this->saveXform();
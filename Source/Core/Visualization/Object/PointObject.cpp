@@ -401,6 +401,17 @@ void PointObject::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Number of sizes : " << this->numberOfSizes() << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t PointObject::byteSize() const
+{
+    return BaseClass::byteSize() + this->sizes().byteSize();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Sets a size value.
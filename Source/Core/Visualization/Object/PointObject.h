@@ -57,8 +57,9 @@ public:
     void deepCopy( const PointObject& other );
     void clear();
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
 
-    void setSizes( const kvs::ValueArray<kvs::Real32>& sizes ) { m_sizes = sizes; }
+    void setSizes( const kvs::ValueArray<kvs::Real32>& sizes ) { m_sizes = sizes; this->updateVersion(); }
     void setSize( const kvs::Real32 size );
 
     size_t numberOfSizes() const { return m_sizes.size(); }
@@ -151,6 +151,17 @@ void PolygonObject::print( std::ostream& os, const kvs::Indent& indent ) const
     os << indent << "Normal type : " << ::GetNormalTypeName( this->normalType() ) << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t PolygonObject::byteSize() const
+{
+    return BaseClass::byteSize() + this->connections().byteSize() + this->opacities().byteSize();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Sets a color value.
@@ -80,6 +80,7 @@ public:
     void deepCopy( const PolygonObject& object );
     void clear();
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
 
     void setPolygonType( const PolygonType polygon_type ) { m_polygon_type = polygon_type; }
     void setPolygonTypeToTriangle() { this->setPolygonType( Triangle ); }
@@ -90,8 +91,8 @@ public:
     void setNormalType( const NormalType normal_type ) { m_normal_type = normal_type; }
     void setNormalTypeToVertex() { this->setNormalType( VertexNormal ); }
     void setNormalTypeToPolygon() { this->setNormalType( PolygonNormal ); }
-    void setConnections( const kvs::ValueArray<kvs::UInt32>& connections ) { m_connections = connections; }
-    void setOpacities( const kvs::ValueArray<kvs::UInt8>& opacities ) { m_opacities = opacities; }
+    void setConnections( const kvs::ValueArray<kvs::UInt32>& connections ) { m_connections = connections; this->updateVersion(); }
+    void setOpacities( const kvs::ValueArray<kvs::UInt8>& opacities ) { m_opacities = opacities; this->updateVersion(); }
     void setColor( const kvs::RGBColor& color );
     void setOpacity( const kvs::UInt8 opacity );
 
@@ -62,7 +62,7 @@ public:
     void setGridTypeToUniform() { this->setGridType( Uniform ); }
     void setGridTypeToRectilinear() { this->setGridType( Rectilinear ); }
     void setGridTypeToCurvilinear() { this->setGridType( Curvilinear ); }
-    void setResolution( const kvs::Vec3ui& resolution ) { m_resolution = resolution; }
+    void setResolution( const kvs::Vec3ui& resolution ) { m_resolution = resolution; this->updateVersion(); }
 
     GridType gridType() const { return m_grid_type; }
     const kvs::Vec3ui& resolution() const { return m_resolution; }
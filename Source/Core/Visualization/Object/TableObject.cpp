@@ -104,6 +104,20 @@ void TableObject::print( std::ostream& os, const kvs::Indent& indent ) const
     for ( size_t i = 0; i < this->maxRanges().size(); i++ ) os << this->maxRanges()[i] << ", "; os << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t TableObject::byteSize() const
+{
+    size_t byte_size = 0;
+    const Columns& columns = this->columns();
+    for ( size_t i = 0; i < columns.size(); i++ ) { byte_size += columns[i].byteSize(); }
+    return byte_size;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Adds a column.
@@ -118,6 +132,7 @@ void TableObject::addColumn( const kvs::AnyValueArray& array, const std::string&
 
     m_table.pushBackColumn( array );
     m_labels.push_back( label );
+    this->updateVersion();
 
     kvs::Real64 min_value = kvs::Value<kvs::Real64>::Max();
     kvs::Real64 max_value = kvs::Value<kvs::Real64>::Min();
@@ -65,6 +65,7 @@ public:
     void shallowCopy( const TableObject& other );
     void deepCopy( const TableObject& other );
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
     void addColumn( const kvs::AnyValueArray& array, const std::string& label = "" );
     void setTable( const kvs::AnyValueTable& table, const Labels& lanels = Labels() );
     void setMinValue( const size_t column_index, const kvs::Real64 value );
@@ -110,6 +110,17 @@ void UnstructuredVolumeObject::print( std::ostream& os, const kvs::Indent& inden
     os << indent << "Max. value : " << this->maxValue() << std::endl;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t UnstructuredVolumeObject::byteSize() const
+{
+    return BaseClass::byteSize() + this->connections().byteSize();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Returns the number of cell nodes.
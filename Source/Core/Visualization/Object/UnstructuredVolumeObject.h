@@ -65,6 +65,7 @@ public:
     void shallowCopy( const UnstructuredVolumeObject& object );
     void deepCopy( const UnstructuredVolumeObject& object );
     void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    size_t byteSize() const;
 
     void setCellType( CellType cell_type ) { m_cell_type = cell_type; }
     void setCellTypeToTetrahedra() { this->setCellType( Tetrahedra ); }
@@ -74,9 +75,9 @@ public:
     void setCellTypeToPyramid() { this->setCellType( Pyramid ); }
     void setCellTypeToPoint() { this->setCellType( Point ); }
     void setCellTypeToPrism() { this->setCellType( Prism ); }
-    void setNumberOfNodes( const size_t nnodes ) { m_nnodes = nnodes; }
-    void setNumberOfCells( const size_t ncells ) { m_ncells = ncells; }
-    void setConnections( const Connections& connections ) { m_connections = connections; }
+    void setNumberOfNodes( const size_t nnodes ) { m_nnodes = nnodes; this->updateVersion(); }
+    void setNumberOfCells( const size_t ncells ) { m_ncells = ncells; this->updateVersion(); }
+    void setConnections( const Connections& connections ) { m_connections = connections; this->updateVersion(); }
 
     CellType cellType() const { return m_cell_type; }
     size_t numberOfNodes() const { return m_nnodes; }
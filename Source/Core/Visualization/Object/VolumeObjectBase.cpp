@@ -14,54 +14,226 @@
 /****************************************************************************/
 #include "VolumeObjectBase.h"
 #include <kvs/Range>
+#include <kvs/Thread>
+#include <vector>
+#include <cmath>
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define KVS_VOLUME_OBJECT_BASE_ENABLE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined( __SSE4_1__ )
+#define KVS_VOLUME_OBJECT_BASE_ENABLE_SSE4_1
+#include <smmintrin.h>
+#endif
 
 
 namespace
 {
 
-template<typename T>
-kvs::Range GetMinMaxValues( const kvs::VolumeObjectBase* volume )
+/*===========================================================================*/
+/**
+ *  @brief  Returns the number of threads for scanning the values.
+ *  @param  nvalues [in] number of values
+ *  @return number of threads
+ */
+/*===========================================================================*/
+size_t NumberOfThreads( const size_t nvalues )
 {
-    KVS_ASSERT( volume->values().size() != 0 );
-    KVS_ASSERT( volume->values().size() == volume->veclen() * volume->numberOfNodes() );
+    // Values less than this per thread are not worth a thread.
+    const size_t grain_size = 1 << 18;
+    const size_t nthreads = kvs::Thread::DefaultNumberOfThreads();
+    return kvs::Math::Max( size_t(1), kvs::Math::Min( nthreads, nvalues / grain_size ) );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Scans the values with SIMD instructions.
+ *
+ *  The values in [value, end) are scanned as many as a multiple of the SIMD
+ *  width, and the pointer to the first unscanned value is returned. The
+ *  generic version scans nothing; the specializations below are provided for
+ *  the types which have packed min/max instructions.
+ */
+/*===========================================================================*/
+template <typename T>
+struct SIMDMinMax
+{
+    static const T* Scan( const T* value, const T* /* end */, T* /* min_value */, T* /* max_value */ )
+    {
+        return value;
+    }
+};
+
+#if defined( KVS_VOLUME_OBJECT_BASE_ENABLE_SSE2 )
+#define KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( type, vtype, width, load, min, max, store )    \
+template <>                                                                                 \
+struct SIMDMinMax<type>                                                                     \
+{                                                                                           \
+    static const type* Scan( const type* value, const type* end, type* min_value, type* max_value ) \
+    {                                                                                       \
+        if ( end - value < 2 * width ) { return value; }                                    \
+        vtype vmin = load( value );                                                         \
+        vtype vmax = vmin;                                                                  \
+        for ( value += width; end - value >= width; value += width )                        \
+        {                                                                                   \
+            const vtype v = load( value );                                                  \
+            vmin = min( vmin, v );                                                          \
+            vmax = max( vmax, v );                                                          \
+        }                                                                                   \
+        type mins[ width ]; store( mins, vmin );                                            \
+        type maxs[ width ]; store( maxs, vmax );                                            \
+        for ( int i = 0; i < width; i++ )                                                   \
+        {                                                                                   \
+            *min_value = kvs::Math::Min( mins[i], *min_value );                             \
+            *max_value = kvs::Math::Max( maxs[i], *max_value );                             \
+        }                                                                                   \
+        return value;                                                                       \
+    }                                                                                       \
+};
+
+inline __m128 LoadReal32( const kvs::Real32* p ) { return _mm_loadu_ps( p ); }
+inline __m128d LoadReal64( const kvs::Real64* p ) { return _mm_loadu_pd( p ); }
+inline __m128i LoadInteger( const void* p ) { return _mm_loadu_si128( static_cast<const __m128i*>( p ) ); }
+inline void StoreReal32( kvs::Real32* p, const __m128 v ) { _mm_storeu_ps( p, v ); }
+inline void StoreReal64( kvs::Real64* p, const __m128d v ) { _mm_storeu_pd( p, v ); }
+inline void StoreInteger( void* p, const __m128i v ) { _mm_storeu_si128( static_cast<__m128i*>( p ), v ); }
+
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::Real32, __m128, 4, LoadReal32, _mm_min_ps, _mm_max_ps, StoreReal32 )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::Real64, __m128d, 2, LoadReal64, _mm_min_pd, _mm_max_pd, StoreReal64 )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::UInt8, __m128i, 16, LoadInteger, _mm_min_epu8, _mm_max_epu8, StoreInteger )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::Int16, __m128i, 8, LoadInteger, _mm_min_epi16, _mm_max_epi16, StoreInteger )
+#if defined( KVS_VOLUME_OBJECT_BASE_ENABLE_SSE4_1 )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::Int8, __m128i, 16, LoadInteger, _mm_min_epi8, _mm_max_epi8, StoreInteger )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::UInt16, __m128i, 8, LoadInteger, _mm_min_epu16, _mm_max_epu16, StoreInteger )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::Int32, __m128i, 4, LoadInteger, _mm_min_epi32, _mm_max_epi32, StoreInteger )
+KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX( kvs::UInt32, __m128i, 4, LoadInteger, _mm_min_epu32, _mm_max_epu32, StoreInteger )
+#endif
+#undef KVS_VOLUME_OBJECT_BASE_SIMD_MIN_MAX
+#endif
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread for scanning the min/max values in a range of the nodes.
+ *
+ *  For veclen = 1, the min/max values are returned as they are. Otherwise,
+ *  the min/max squared magnitudes of the vectors are returned.
+ */
+/*===========================================================================*/
+template <typename T>
+class MinMaxScanner : public kvs::Thread
+{
+private:
+
+    const T* m_begin; ///< first value
+    const T* m_end; ///< last value + 1
+    size_t m_veclen; ///< vector length
+    kvs::Real64 m_min_value; ///< min. value (or squared magnitude)
+    kvs::Real64 m_max_value; ///< max. value (or squared magnitude)
+
+public:
+
+    MinMaxScanner() {}
+    ~MinMaxScanner() {}
 
-    const T* value = reinterpret_cast<const T*>( volume->values().data() );
-    const T* const end = value + volume->numberOfNodes() * volume->veclen();
+    void init( const T* begin, const T* end, const size_t veclen )
+    {
+        m_begin = begin;
+        m_end = end;
+        m_veclen = veclen;
+    }
+
+    kvs::Real64 minValue() const { return m_min_value; }
+    kvs::Real64 maxValue() const { return m_max_value; }
+
+    void run()
+    {
+        if ( m_veclen == 1 ) { this->scan_values(); }
+        else { this->scan_magnitudes(); }
+    }
+
+private:
 
-    if ( volume->veclen() == 1 )
+    void scan_values()
     {
-        T min_value = *value;
-        T max_value = *value;
+        T min_value = *m_begin;
+        T max_value = *m_begin;
 
-        while ( value < end )
+        const T* value = SIMDMinMax<T>::Scan( m_begin, m_end, &min_value, &max_value );
+        while ( value < m_end )
         {
             min_value = kvs::Math::Min( *value, min_value );
             max_value = kvs::Math::Max( *value, max_value );
             ++value;
         }
 
-        return kvs::Range( static_cast<double>( min_value ), static_cast<double>( max_value ) );
+        m_min_value = static_cast<kvs::Real64>( min_value );
+        m_max_value = static_cast<kvs::Real64>( max_value );
     }
-    else
+
+    void scan_magnitudes()
     {
         kvs::Real64 min_value = kvs::Value<kvs::Real64>::Max();
         kvs::Real64 max_value = kvs::Value<kvs::Real64>::Min();
 
-        const size_t veclen = volume->veclen();
-
-        while ( value < end )
+        const size_t veclen = m_veclen;
+        const T* value = m_begin;
+        while ( value < m_end )
         {
             kvs::Real64 magnitude = 0.0;
             for ( size_t i = 0; i < veclen; ++i )
             {
-                magnitude += static_cast<kvs::Real64>( ( *value ) * ( *value ) );
-                ++value;
+                const kvs::Real64 v = static_cast<kvs::Real64>( value[i] );
+                magnitude += v * v;
             }
+            value += veclen;
 
             min_value = kvs::Math::Min( magnitude, min_value );
             max_value = kvs::Math::Max( magnitude, max_value );
         }
 
+        m_min_value = min_value;
+        m_max_value = max_value;
+    }
+};
+
+template<typename T>
+kvs::Range GetMinMaxValues( const kvs::VolumeObjectBase* volume )
+{
+    KVS_ASSERT( volume->values().size() != 0 );
+    KVS_ASSERT( volume->values().size() == volume->veclen() * volume->numberOfNodes() );
+
+    const T* const values = reinterpret_cast<const T*>( volume->values().data() );
+    const size_t veclen = volume->veclen();
+    const size_t nnodes = volume->numberOfNodes();
+
+    // Divide the nodes into contiguous ranges, one for each thread.
+    const size_t nthreads = ::NumberOfThreads( nnodes * veclen );
+    std::vector< MinMaxScanner<T> > scanners( nthreads );
+    for ( size_t i = 0; i < nthreads; ++i )
+    {
+        const size_t begin = nnodes * i / nthreads;
+        const size_t end = nnodes * ( i + 1 ) / nthreads;
+        scanners[i].init( values + begin * veclen, values + end * veclen, veclen );
+    }
+
+    kvs::Thread::Run( &scanners[0], nthreads );
+
+    kvs::Real64 min_value = scanners[0].minValue();
+    kvs::Real64 max_value = scanners[0].maxValue();
+    for ( size_t i = 1; i < nthreads; ++i )
+    {
+        min_value = kvs::Math::Min( scanners[i].minValue(), min_value );
+        max_value = kvs::Math::Max( scanners[i].maxValue(), max_value );
+    }
+
+    if ( veclen == 1 )
+    {
+        return kvs::Range( min_value, max_value );
+    }
+    else
+    {
         return kvs::Range( std::sqrt( min_value ), std::sqrt( max_value ) );
     }
 }
@@ -188,6 +360,17 @@ void VolumeObjectBase::print( std::ostream& os, const kvs::Indent& indent ) cons
     os.flags( flags );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the byte size of the data arrays.
+ *  @return byte size
+ */
+/*===========================================================================*/
+size_t VolumeObjectBase::byteSize() const
+{
+    return m_coords.byteSize() + m_values.byteSize();
+}
+
 std::ostream& operator << ( std::ostream& os, const kvs::VolumeObjectBase& object )
 {
 #ifdef KVS_COMPILER_VC
@@ -72,12 +72,13 @@ public:
     void shallowCopy( const VolumeObjectBase& object );
     void deepCopy( const VolumeObjectBase& object );
     virtual void print( std::ostream& os, const kvs::Indent& indent = kvs::Indent(0) ) const;
+    virtual size_t byteSize() const;
 
     void setLabel( const std::string& label ) { m_label = label; }
     void setUnit( const std::string& unit ) { m_unit = unit; }
-    void setVeclen( const size_t veclen ) { m_veclen = veclen; }
-    void setCoords( const Coords& coords ) { m_coords = coords; }
-    void setValues( const Values& values ) { m_values = values; }
+    void setVeclen( const size_t veclen ) { m_veclen = veclen; this->updateVersion(); }
+    void setCoords( const Coords& coords ) { m_coords = coords; this->updateVersion(); }
+    void setValues( const Values& values ) { m_values = values; this->updateVersion(); }
     void setMinMaxValues( const kvs::Real64 min_value, const kvs::Real64 max_value ) const;
 
     const std::string& label() const { return m_label; }
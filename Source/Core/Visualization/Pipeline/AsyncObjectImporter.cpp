@@ -0,0 +1,136 @@
+/****************************************************************************/
+/**
+ *  @file   AsyncObjectImporter.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#include "AsyncObjectImporter.h"
+#include <kvs/ObjectImporter>
+#include <kvs/Thread>
+#include <kvs/MutexLocker>
+#include <kvs/Message>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Loader thread of the asynchronous object importer.
+ */
+/*===========================================================================*/
+class AsyncObjectImporter::Loader : public kvs::Thread
+{
+private:
+
+    kvs::AsyncObjectImporter* m_importer; ///< pointer to the importer
+
+public:
+
+    Loader( kvs::AsyncObjectImporter* importer ): m_importer( importer ) {}
+
+    void run()
+    {
+        kvs::ObjectImporter importer( m_importer->m_filename );
+        kvs::ObjectBase* object = importer.import();
+
+        kvs::MutexLocker locker( &m_importer->m_mutex );
+        m_importer->m_object = object;
+        m_importer->m_is_ready = true;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new AsyncObjectImporter class and starts importing.
+ *  @param  filename [in] filename
+ */
+/*===========================================================================*/
+AsyncObjectImporter::AsyncObjectImporter( const std::string& filename ):
+    m_filename( filename ),
+    m_object( NULL ),
+    m_is_ready( false ),
+    m_is_joined( false ),
+    m_loader( NULL )
+{
+    m_loader = new Loader( this );
+    if ( !m_loader->start() )
+    {
+        kvsMessageError( "Cannot start importing '%s'.", m_filename.c_str() );
+        m_is_ready = true;
+        m_is_joined = true;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Destroys the AsyncObjectImporter class.
+ *
+ *  The destructor waits for the import process, and the imported object is
+ *  deleted if it has not been taken by object().
+ */
+/*===========================================================================*/
+AsyncObjectImporter::~AsyncObjectImporter()
+{
+    this->wait();
+    delete m_loader;
+    if ( m_object ) { delete m_object; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the import process has been finished.
+ *  @return true, if the import process has been finished
+ */
+/*===========================================================================*/
+bool AsyncObjectImporter::isReady() const
+{
+    kvs::MutexLocker locker( &m_mutex );
+    return m_is_ready;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Waits for the import process.
+ *  @return true, if the object has been imported successfully
+ */
+/*===========================================================================*/
+bool AsyncObjectImporter::wait()
+{
+    if ( !m_is_joined )
+    {
+        m_loader->wait();
+        m_is_joined = true;
+    }
+
+    kvs::MutexLocker locker( &m_mutex );
+    return m_object != NULL;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the imported object after waiting for the import process.
+ *  @return pointer to the imported object (NULL if failed or already taken)
+ *
+ *  The ownership of the object is transferred to the caller.
+ */
+/*===========================================================================*/
+kvs::ObjectBase* AsyncObjectImporter::object()
+{
+    this->wait();
+
+    kvs::MutexLocker locker( &m_mutex );
+    kvs::ObjectBase* object = m_object;
+    m_object = NULL;
+    return object;
+}
+
+} // end of namespace kvs
@@ -0,0 +1,67 @@
+/****************************************************************************/
+/**
+ *  @file   AsyncObjectImporter.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#ifndef KVS__ASYNC_OBJECT_IMPORTER_H_INCLUDE
+#define KVS__ASYNC_OBJECT_IMPORTER_H_INCLUDE
+
+#include <string>
+#include <kvs/ObjectBase>
+#include <kvs/Mutex>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Asynchronous object importer class.
+ *
+ *  The file is imported with kvs::ObjectImporter on a background thread that
+ *  is started in the constructor. The instance works as a handle of the
+ *  result, and the imported object can be taken with object() when it is
+ *  ready.
+ */
+/*===========================================================================*/
+class AsyncObjectImporter
+{
+private:
+
+    class Loader;
+
+    std::string m_filename; ///< input filename
+    kvs::ObjectBase* m_object; ///< imported object (NULL if not ready or failed)
+    bool m_is_ready; ///< true if the import process has been finished
+    bool m_is_joined; ///< true if the loader thread has been joined
+    mutable kvs::Mutex m_mutex; ///< mutex for m_object and m_is_ready
+    Loader* m_loader; ///< loader thread
+
+public:
+
+    explicit AsyncObjectImporter( const std::string& filename );
+    ~AsyncObjectImporter();
+
+    const std::string& filename() const { return m_filename; }
+    bool isReady() const;
+    bool wait();
+    kvs::ObjectBase* object();
+
+private:
+
+    AsyncObjectImporter( const AsyncObjectImporter& );
+    AsyncObjectImporter& operator =( const AsyncObjectImporter& );
+};
+
+} // end of namespace kvs
+
+#endif // KVS__ASYNC_OBJECT_IMPORTER_H_INCLUDE
@@ -27,7 +27,8 @@ namespace kvs
 PipelineModule::PipelineModule():
     m_auto_delete( true ),
     m_counter( 0 ),
-    m_category( Empty )
+    m_category( Empty ),
+    m_cache_key( new std::string )
 {
     memset( &m_module, 0, sizeof( Module ) );
 }
@@ -41,7 +42,8 @@ PipelineModule::PipelineModule():
 PipelineModule::PipelineModule( const PipelineModule& module ):
     m_auto_delete( true ),
     m_counter( 0 ),
-    m_category( Empty )
+    m_category( Empty ),
+    m_cache_key( new std::string )
 {
     memset( &m_module, 0, sizeof( Module ) );
     this->shallow_copy( module );
@@ -131,6 +133,34 @@ bool PipelineModule::unique() const
     return m_counter ? m_counter->value() == 1 : true;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a parameter key of the module for the result cache.
+ *  @param  key [in] parameter key
+ *
+ *  The output of the module is cached by the visualization pipeline only when
+ *  the key is specified. The key must identify every parameter that affects
+ *  the output, for example "isolevel=100,normal=polygon", and it has to be
+ *  updated whenever the parameters of the module are changed. The key is
+ *  shared among the copies of this pipeline module.
+ */
+/*===========================================================================*/
+void PipelineModule::setCacheKey( const std::string& key )
+{
+    *m_cache_key = key;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the parameter key of the module for the result cache.
+ *  @return parameter key (empty if the output of the module is not cached)
+ */
+/*===========================================================================*/
+const std::string& PipelineModule::cacheKey() const
+{
+    return *m_cache_key;
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Disable function of the auto-delete.
@@ -177,6 +207,7 @@ void PipelineModule::shallow_copy( const PipelineModule& module )
     m_counter = module.m_counter;
     m_category = module.m_category;
     m_module = module.m_module;
+    m_cache_key = module.m_cache_key;
     this->ref();
 }
 
@@ -192,6 +223,7 @@ void PipelineModule::deep_copy( const PipelineModule& module )
     this->create_counter();
     m_category = module.m_category;
     m_module = module.m_module;
+    m_cache_key.reset( new std::string( module.cacheKey() ) );
 }
 
 /*===========================================================================*/
@@ -16,6 +16,7 @@
 #define KVS__PIPELINE_MODULE_H_INCLUDE
 
 #include <cstring>
+#include <string>
 #include <kvs/FilterBase>
 #include <kvs/MapperBase>
 #include <kvs/ObjectBase>
@@ -23,6 +24,7 @@
 #include <kvs/Module>
 #include <kvs/Assert>
 #include <kvs/ReferenceCounter>
+#include <kvs/SharedPointer>
 
 
 namespace kvs
@@ -62,6 +64,7 @@ protected:
     kvs::ReferenceCounter* m_counter;  ///< Reference counter.
     Category m_category; ///< module category
     Module m_module; ///< pointer to the module (SHARED)
+    kvs::SharedPointer<std::string> m_cache_key; ///< parameter key for the result cache (SHARED)
 
 public:
 
@@ -70,7 +73,8 @@ public:
     explicit PipelineModule( T* module ):
         m_auto_delete( true ),
         m_counter( 0 ),
-        m_category( Empty )
+        m_category( Empty ),
+        m_cache_key( new std::string )
     {
         memset( &m_module, 0, sizeof( Module ) );
         this->create_counter( 1 );
@@ -97,6 +101,9 @@ public:
     const char* name() const;
     bool unique() const;
 
+    void setCacheKey( const std::string& key );
+    const std::string& cacheKey() const;
+
 private:
 
     template <typename T>
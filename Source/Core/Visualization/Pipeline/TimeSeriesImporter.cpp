@@ -0,0 +1,373 @@
+/****************************************************************************/
+/**
+ *  @file   TimeSeriesImporter.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#include "TimeSeriesImporter.h"
+#include <algorithm>
+#include <kvs/ObjectImporter>
+#include <kvs/Thread>
+#include <kvs/MutexLocker>
+#include <kvs/Message>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Worker thread of the time-series importer.
+ */
+/*===========================================================================*/
+class TimeSeriesImporter::Worker : public kvs::Thread
+{
+private:
+
+    kvs::TimeSeriesImporter* m_importer; ///< pointer to the importer
+
+public:
+
+    Worker( kvs::TimeSeriesImporter* importer ): m_importer( importer ) {}
+
+    void run()
+    {
+        for ( ;; )
+        {
+            // Take the step of the highest priority.
+            size_t step = 0;
+            {
+                kvs::MutexLocker locker( &m_importer->m_mutex );
+                while ( !m_importer->m_quit && m_importer->m_queue.empty() )
+                {
+                    m_importer->m_queued.wait( &m_importer->m_mutex );
+                }
+                if ( m_importer->m_quit ) { return; }
+
+                step = m_importer->m_queue.front();
+                m_importer->m_queue.pop_front();
+                m_importer->m_slots[ step ].state = Loading;
+            }
+
+            kvs::ObjectImporter importer( m_importer->m_filenames[ step ] );
+            kvs::ObjectBase* object = importer.import();
+
+            {
+                kvs::MutexLocker locker( &m_importer->m_mutex );
+                Slots::iterator slot = m_importer->m_slots.find( step );
+                slot->second.state = Ready;
+                slot->second.object = object;
+                slot->second.byte_size = object ? object->byteSize() : 0;
+                m_importer->m_byte_size += slot->second.byte_size;
+                if ( slot->second.discarded ) { m_importer->release( slot ); }
+                else { m_importer->prefetch(); }
+            }
+
+            m_importer->m_loaded.wakeUpAll();
+            m_importer->m_queued.wakeUpAll();
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new TimeSeriesImporter class.
+ *  @param  filenames [in] filenames of the time steps
+ */
+/*===========================================================================*/
+TimeSeriesImporter::TimeSeriesImporter( const std::vector<std::string>& filenames ):
+    m_filenames( filenames ),
+    m_number_of_prefetches( 2 ),
+    m_memory_budget( size_t( 512 ) * 1024 * 1024 ),
+    m_number_of_threads( 1 ),
+    m_loop( false ),
+    m_current_step( 0 ),
+    m_byte_size( 0 ),
+    m_quit( false )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Destroys the TimeSeriesImporter class.
+ */
+/*===========================================================================*/
+TimeSeriesImporter::~TimeSeriesImporter()
+{
+    this->stop_workers();
+
+    Slots::iterator slot = m_slots.begin();
+    while ( slot != m_slots.end() )
+    {
+        if ( slot->second.object ) { delete slot->second.object; }
+        ++slot;
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of the steps read ahead after the imported step.
+ *  @param  nprefetches [in] number of prefetches
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::setNumberOfPrefetches( const size_t nprefetches )
+{
+    kvs::MutexLocker locker( &m_mutex );
+    m_number_of_prefetches = nprefetches;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a memory budget for the prefetched objects.
+ *  @param  byte_size [in] memory budget in bytes
+ *
+ *  No more steps are read ahead while the total size of the prefetched
+ *  objects exceeds the budget. Since the size of an object is known only after
+ *  it is imported, the budget can be exceeded by the objects being imported
+ *  on the worker threads.
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::setMemoryBudget( const size_t byte_size )
+{
+    kvs::MutexLocker locker( &m_mutex );
+    m_memory_budget = byte_size;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for importing the files.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::setNumberOfThreads( const size_t nthreads )
+{
+    this->stop_workers();
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+    if ( m_number_of_threads == 0 ) { m_number_of_threads = 1; }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the step has been prefetched.
+ *  @param  step [in] time step
+ *  @return true, if the object of the step can be returned without waiting
+ */
+/*===========================================================================*/
+bool TimeSeriesImporter::isReady( const size_t step ) const
+{
+    kvs::MutexLocker locker( &m_mutex );
+    Slots::const_iterator slot = m_slots.find( step );
+    return slot != m_slots.end() && slot->second.state == Ready;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Imports the object of the step.
+ *  @param  step [in] time step
+ *  @return pointer to the imported object (NULL if failed)
+ *
+ *  The method waits for the step if it has not been prefetched, and then the
+ *  following steps are read ahead. The ownership of the returned object is
+ *  transferred to the caller. This method should be called from one thread.
+ */
+/*===========================================================================*/
+kvs::ObjectBase* TimeSeriesImporter::import( const size_t step )
+{
+    if ( step >= m_filenames.size() )
+    {
+        kvsMessageError( "Step %d is out of range.", static_cast<int>( step ) );
+        return NULL;
+    }
+
+    if ( m_workers.empty() ) { this->start_workers(); }
+    if ( m_workers.empty() )
+    {
+        // Import synchronously since no worker thread can be started.
+        kvs::ObjectImporter importer( m_filenames[ step ] );
+        return importer.import();
+    }
+
+    kvs::ObjectBase* object = NULL;
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        this->update_window( step );
+        m_queued.wakeUpAll();
+
+        Slots::iterator slot = m_slots.find( step );
+        while ( slot->second.state != Ready )
+        {
+            m_loaded.wait( &m_mutex );
+            slot = m_slots.find( step );
+        }
+
+        object = slot->second.object;
+        m_byte_size -= slot->second.byte_size;
+        m_slots.erase( slot );
+        this->prefetch();
+    }
+    m_queued.wakeUpAll();
+
+    return object;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Starts the worker threads.
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::start_workers()
+{
+    m_quit = false;
+    for ( size_t i = 0; i < m_number_of_threads; i++ )
+    {
+        Worker* worker = new Worker( this );
+        if ( !worker->start() ) { delete worker; break; }
+        m_workers.push_back( worker );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Stops the worker threads after the current imports.
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::stop_workers()
+{
+    if ( m_workers.empty() ) { return; }
+
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        m_quit = true;
+    }
+    m_queued.wakeUpAll();
+
+    for ( size_t i = 0; i < m_workers.size(); i++ )
+    {
+        m_workers[i]->wait();
+        delete m_workers[i];
+    }
+    m_workers.clear();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the step is in the prefetch window.
+ *  @param  step [in] time step
+ *  @return true, if the step is the current step or one of the next steps
+ */
+/*===========================================================================*/
+bool TimeSeriesImporter::is_in_window( const size_t step ) const
+{
+    if ( step >= m_current_step ) { return step - m_current_step <= m_number_of_prefetches; }
+    if ( !m_loop ) { return false; }
+    return step + m_filenames.size() - m_current_step <= m_number_of_prefetches;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Moves the prefetch window to the step (the mutex must be locked).
+ *  @param  step [in] time step to be imported
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::update_window( const size_t step )
+{
+    m_current_step = step;
+
+    // Release the steps that are out of the window.
+    Slots::iterator slot = m_slots.begin();
+    while ( slot != m_slots.end() )
+    {
+        Slots::iterator next = slot; ++next;
+        if ( !this->is_in_window( slot->first ) ) { this->release( slot ); }
+        else { slot->second.discarded = false; }
+        slot = next;
+    }
+
+    // Queue the step with the highest priority.
+    slot = m_slots.find( step );
+    if ( slot == m_slots.end() )
+    {
+        Slot queued = { Queued, false, NULL, 0 };
+        m_slots.insert( std::make_pair( step, queued ) );
+        m_queue.push_front( step );
+    }
+    else if ( slot->second.state == Queued )
+    {
+        m_queue.erase( std::find( m_queue.begin(), m_queue.end(), step ) );
+        m_queue.push_front( step );
+    }
+
+    this->prefetch();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Queues the next steps within the memory budget (the mutex must be locked).
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::prefetch()
+{
+    const size_t nsteps = m_filenames.size();
+    for ( size_t i = 1; i <= m_number_of_prefetches; i++ )
+    {
+        if ( m_byte_size >= m_memory_budget ) { break; }
+
+        size_t step = m_current_step + i;
+        if ( step >= nsteps )
+        {
+            if ( !m_loop ) { break; }
+            step %= nsteps;
+            if ( step == m_current_step ) { break; }
+        }
+
+        if ( m_slots.find( step ) != m_slots.end() ) { continue; }
+
+        Slot queued = { Queued, false, NULL, 0 };
+        m_slots.insert( std::make_pair( step, queued ) );
+        m_queue.push_back( step );
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the step (the mutex must be locked).
+ *  @param  slot [in] slot of the step
+ *
+ *  The step being imported is released by the worker thread after importing.
+ */
+/*===========================================================================*/
+void TimeSeriesImporter::release( Slots::iterator slot )
+{
+    switch ( slot->second.state )
+    {
+    case Queued:
+    {
+        m_queue.erase( std::find( m_queue.begin(), m_queue.end(), slot->first ) );
+        m_slots.erase( slot );
+        break;
+    }
+    case Loading:
+    {
+        slot->second.discarded = true;
+        break;
+    }
+    case Ready:
+    {
+        if ( slot->second.object ) { delete slot->second.object; }
+        m_byte_size -= slot->second.byte_size;
+        m_slots.erase( slot );
+        break;
+    }
+    default: break;
+    }
+}
+
+} // end of namespace kvs
@@ -0,0 +1,115 @@
+/****************************************************************************/
+/**
+ *  @file   TimeSeriesImporter.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#ifndef KVS__TIME_SERIES_IMPORTER_H_INCLUDE
+#define KVS__TIME_SERIES_IMPORTER_H_INCLUDE
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <kvs/ObjectBase>
+#include <kvs/Mutex>
+#include <kvs/Condition>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Time-series object importer class.
+ *
+ *  The files of the time steps are imported with kvs::ObjectImporter on the
+ *  background threads. When a step is imported, the next steps (the number of
+ *  prefetches) are read ahead while the total size of the prefetched objects
+ *  is within the memory budget. The prefetched steps that go out of the window
+ *  after the current step are released.
+ */
+/*===========================================================================*/
+class TimeSeriesImporter
+{
+private:
+
+    class Worker;
+
+    enum State
+    {
+        Queued = 0, ///< waiting for a worker thread
+        Loading, ///< being imported by a worker thread
+        Ready ///< imported (the object is NULL if failed)
+    };
+
+    struct Slot
+    {
+        State state; ///< import state
+        bool discarded; ///< true if the object is released when it is loaded
+        kvs::ObjectBase* object; ///< imported object
+        size_t byte_size; ///< byte size of the imported object
+    };
+
+    typedef std::map<size_t,Slot> Slots;
+
+    std::vector<std::string> m_filenames; ///< filenames of the time steps
+    size_t m_number_of_prefetches; ///< number of the steps read ahead
+    size_t m_memory_budget; ///< memory budget in bytes for the prefetched objects
+    size_t m_number_of_threads; ///< number of the worker threads
+    bool m_loop; ///< true if the prefetch wraps around to the first step
+    size_t m_current_step; ///< step that is imported last
+    size_t m_byte_size; ///< total byte size of the prefetched objects
+    bool m_quit; ///< true if the worker threads are terminated
+    Slots m_slots; ///< slots of the queued, loading and prefetched steps
+    std::deque<size_t> m_queue; ///< queued steps in the order of priority
+    mutable kvs::Mutex m_mutex; ///< mutex for the slots and the queue
+    kvs::Condition m_queued; ///< condition signaled when a step is queued
+    kvs::Condition m_loaded; ///< condition signaled when a step is loaded
+    std::vector<Worker*> m_workers; ///< worker threads
+
+public:
+
+    explicit TimeSeriesImporter( const std::vector<std::string>& filenames );
+    ~TimeSeriesImporter();
+
+    size_t numberOfSteps() const { return m_filenames.size(); }
+    const std::string& filename( const size_t step ) const { return m_filenames[step]; }
+    size_t numberOfPrefetches() const { return m_number_of_prefetches; }
+    size_t memoryBudget() const { return m_memory_budget; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    bool isEnabledLoop() const { return m_loop; }
+
+    void setNumberOfPrefetches( const size_t nprefetches );
+    void setMemoryBudget( const size_t byte_size );
+    void setNumberOfThreads( const size_t nthreads );
+    void enableLoop() { m_loop = true; }
+    void disableLoop() { m_loop = false; }
+
+    bool isReady( const size_t step ) const;
+    kvs::ObjectBase* import( const size_t step );
+
+private:
+
+    void start_workers();
+    void stop_workers();
+    bool is_in_window( const size_t step ) const;
+    void update_window( const size_t step );
+    void prefetch();
+    void release( Slots::iterator slot );
+
+    TimeSeriesImporter( const TimeSeriesImporter& );
+    TimeSeriesImporter& operator =( const TimeSeriesImporter& );
+};
+
+} // end of namespace kvs
+
+#endif // KVS__TIME_SERIES_IMPORTER_H_INCLUDE
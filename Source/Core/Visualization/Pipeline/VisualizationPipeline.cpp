@@ -21,6 +21,24 @@
 #include <kvs/LineRenderer>
 #include <kvs/PolygonRenderer>
 #include <kvs/RayCastingRenderer>
+#include <kvs/PointObject>
+#include <kvs/LineObject>
+#include <kvs/PolygonObject>
+#include <kvs/StructuredVolumeObject>
+#include <kvs/UnstructuredVolumeObject>
+#include <kvs/ImageObject>
+#include <kvs/TableObject>
+#include <kvs/Platform>
+#include <kvs/Mutex>
+#include <kvs/MutexLocker>
+#include <list>
+#include <map>
+#include <sstream>
+#if defined ( KVS_PLATFORM_WINDOWS )
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
 
 
 // Static parameters.
@@ -50,6 +68,368 @@ void ExitFunction()
 } // end of namespace
 
 
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Concrete object classes that can be stored in the result cache.
+ */
+/*===========================================================================*/
+enum ObjectClass
+{
+    UnknownClass = 0,
+    PointClass,
+    LineClass,
+    PolygonClass,
+    StructuredVolumeClass,
+    UnstructuredVolumeClass,
+    ImageClass,
+    TableClass
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the concrete object class of the object.
+ *  @param  object [in] pointer to the object
+ *  @return object class
+ */
+/*===========================================================================*/
+ObjectClass ClassOf( const kvs::ObjectBase* object )
+{
+    switch ( object->objectType() )
+    {
+    case kvs::ObjectBase::Geometry:
+    {
+        switch ( kvs::GeometryObjectBase::DownCast( object )->geometryType() )
+        {
+        case kvs::GeometryObjectBase::Point: return PointClass;
+        case kvs::GeometryObjectBase::Line: return LineClass;
+        case kvs::GeometryObjectBase::Polygon: return PolygonClass;
+        default: break;
+        }
+        break;
+    }
+    case kvs::ObjectBase::Volume:
+    {
+        switch ( kvs::VolumeObjectBase::DownCast( object )->volumeType() )
+        {
+        case kvs::VolumeObjectBase::Structured: return StructuredVolumeClass;
+        case kvs::VolumeObjectBase::Unstructured: return UnstructuredVolumeClass;
+        default: break;
+        }
+        break;
+    }
+    case kvs::ObjectBase::Image: return ImageClass;
+    case kvs::ObjectBase::Table: return TableClass;
+    default: break;
+    }
+
+    return UnknownClass;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Shallow-copies the object to the object of the class T.
+ *  @param  dst [in/out] pointer to the destination object
+ *  @param  src [in] pointer to the source object
+ *  @return true, if both of the objects are the objects of the class T
+ */
+/*===========================================================================*/
+template <typename T>
+bool ShallowCopyAs( kvs::ObjectBase* dst, const kvs::ObjectBase* src )
+{
+    T* d = T::DownCast( dst );
+    const T* s = T::DownCast( src );
+    if ( !d || !s ) { return false; }
+
+    d->shallowCopy( *s );
+    return true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Shallow-copies the object to the existing object.
+ *  @param  dst [in/out] pointer to the destination object
+ *  @param  src [in] pointer to the source object
+ *  @return true, if the object is copied
+ */
+/*===========================================================================*/
+bool ShallowCopy( kvs::ObjectBase* dst, const kvs::ObjectBase* src )
+{
+    switch ( ::ClassOf( src ) )
+    {
+    case PointClass: return ::ShallowCopyAs<kvs::PointObject>( dst, src );
+    case LineClass: return ::ShallowCopyAs<kvs::LineObject>( dst, src );
+    case PolygonClass: return ::ShallowCopyAs<kvs::PolygonObject>( dst, src );
+    case StructuredVolumeClass: return ::ShallowCopyAs<kvs::StructuredVolumeObject>( dst, src );
+    case UnstructuredVolumeClass: return ::ShallowCopyAs<kvs::UnstructuredVolumeObject>( dst, src );
+    case ImageClass: return ::ShallowCopyAs<kvs::ImageObject>( dst, src );
+    case TableClass: return ::ShallowCopyAs<kvs::TableObject>( dst, src );
+    default: break;
+    }
+
+    return false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns a new object that is shallow-copied from the object.
+ *  @param  object [in] pointer to the object
+ *  @return pointer to the new object (NULL if the object cannot be copied)
+ */
+/*===========================================================================*/
+kvs::ObjectBase* Duplicate( const kvs::ObjectBase* object )
+{
+    kvs::ObjectBase* duplicate = NULL;
+    switch ( ::ClassOf( object ) )
+    {
+    case PointClass: duplicate = new kvs::PointObject(); break;
+    case LineClass: duplicate = new kvs::LineObject(); break;
+    case PolygonClass: duplicate = new kvs::PolygonObject(); break;
+    case StructuredVolumeClass: duplicate = new kvs::StructuredVolumeObject(); break;
+    case UnstructuredVolumeClass: duplicate = new kvs::UnstructuredVolumeObject(); break;
+    case ImageClass: duplicate = new kvs::ImageObject(); break;
+    case TableClass: duplicate = new kvs::TableObject(); break;
+    default: return NULL;
+    }
+
+    if ( !::ShallowCopy( duplicate, object ) )
+    {
+        delete duplicate;
+        return NULL;
+    }
+
+    return duplicate;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cache key of the input object.
+ *  @param  object [in] pointer to the object
+ *  @return cache key
+ *
+ *  The key is the version of the object, which is unique in the process and
+ *  changed when the data arrays of the object are replaced. When the data
+ *  arrays are modified in place, kvs::ObjectBase::updateVersion() has to be
+ *  called so that the cached results are not reused.
+ */
+/*===========================================================================*/
+std::string ObjectKey( const kvs::ObjectBase* object )
+{
+    std::ostringstream key;
+    key << "object:" << object->version();
+    return key.str();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the cache key of the input data file.
+ *  @param  filename [in] filename
+ *  @return cache key (empty if the file cannot be found)
+ *
+ *  The key consists of the absolute path, the file ID, the size and the last
+ *  modification time of the file in the finest resolution available, so that
+ *  the key is changed when the file is rewritten or replaced.
+ */
+/*===========================================================================*/
+std::string FileKey( const std::string& filename )
+{
+    std::ostringstream key;
+    key << "file:" << kvs::File( filename ).filePath( true );
+#if defined ( KVS_PLATFORM_WINDOWS )
+    HANDLE handle = CreateFileA(
+        filename.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL );
+    if ( handle == INVALID_HANDLE_VALUE ) { return ""; }
+    BY_HANDLE_FILE_INFORMATION info;
+    const BOOL succeeded = GetFileInformationByHandle( handle, &info );
+    CloseHandle( handle );
+    if ( !succeeded ) { return ""; }
+    key << ":" << info.nFileIndexHigh << ":" << info.nFileIndexLow;
+    key << ":" << info.nFileSizeHigh << ":" << info.nFileSizeLow;
+    key << ":" << info.ftLastWriteTime.dwHighDateTime << ":" << info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat filestat;
+    if ( stat( filename.c_str(), &filestat ) ) { return ""; }
+    key << ":" << filestat.st_dev << ":" << filestat.st_ino;
+    key << ":" << filestat.st_size << ":" << filestat.st_mtime;
+#if defined ( KVS_PLATFORM_MACOSX )
+    key << "." << filestat.st_mtimespec.tv_nsec;
+#elif defined ( KVS_PLATFORM_LINUX )
+    key << "." << filestat.st_mtim.tv_nsec;
+#endif
+#endif
+
+    return key.str();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the pointer to the module as an object.
+ *  @param  module [in] pipeline module
+ *  @return pointer to the object (NULL if the module is not an object)
+ *
+ *  Most of the filter and mapper modules are the output objects by themselves.
+ */
+/*===========================================================================*/
+kvs::ObjectBase* ModuleObject( const kvs::PipelineModule& module )
+{
+    switch ( module.category() )
+    {
+    case kvs::PipelineModule::Filter:
+        return dynamic_cast<kvs::ObjectBase*>( const_cast<kvs::FilterBase*>( module.filter() ) );
+    case kvs::PipelineModule::Mapper:
+        return dynamic_cast<kvs::ObjectBase*>( const_cast<kvs::MapperBase*>( module.mapper() ) );
+    default: break;
+    }
+
+    return NULL;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  LRU cache of the results of the visualization pipelines.
+ *
+ *  The cache holds the shallow copies of the results, that is, the data
+ *  arrays are shared with the objects that are handed out from the cache.
+ *  The cache is shared by the pipelines, so that the entries are accessed
+ *  with the mutex locked.
+ */
+/*===========================================================================*/
+class ResultCache
+{
+private:
+
+    struct Entry
+    {
+        std::string key; ///< cache key
+        kvs::ObjectBase* object; ///< cached object (allocated)
+        size_t byte_size; ///< byte size of the data arrays
+    };
+
+    typedef std::list<Entry> EntryList;
+    typedef std::map<std::string,EntryList::iterator> EntryMap;
+
+    EntryList m_entries; ///< entries in the order of the recent use
+    EntryMap m_map; ///< map from the key to the entry
+    size_t m_capacity; ///< capacity in bytes
+    size_t m_byte_size; ///< total byte size of the entries
+    mutable kvs::Mutex m_mutex; ///< mutex for the entries
+
+public:
+
+    ResultCache(): m_capacity( size_t( 512 ) * 1024 * 1024 ), m_byte_size( 0 ) {}
+    ~ResultCache() { this->clear(); }
+
+    size_t capacity() const
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        return m_capacity;
+    }
+
+    size_t byteSize() const
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        return m_byte_size;
+    }
+
+    void setCapacity( const size_t capacity )
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        m_capacity = capacity;
+        this->evict();
+    }
+
+    kvs::ObjectBase* duplicate( const std::string& key )
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        const kvs::ObjectBase* object = this->find( key );
+        return object ? ::Duplicate( object ) : NULL;
+    }
+
+    bool copyTo( const std::string& key, kvs::ObjectBase* object )
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        const kvs::ObjectBase* cached = this->find( key );
+        return cached ? ::ShallowCopy( object, cached ) : false;
+    }
+
+    void insert( const std::string& key, const kvs::ObjectBase* object )
+    {
+        kvs::ObjectBase* duplicate = ::Duplicate( object );
+        if ( !duplicate ) { return; }
+
+        kvs::MutexLocker locker( &m_mutex );
+        this->erase( key );
+
+        const size_t byte_size = duplicate->byteSize();
+        if ( m_capacity == 0 || byte_size > m_capacity ) { delete duplicate; return; }
+
+        Entry entry;
+        entry.key = key;
+        entry.object = duplicate;
+        entry.byte_size = byte_size;
+        m_entries.push_front( entry );
+        m_map[ key ] = m_entries.begin();
+        m_byte_size += byte_size;
+        this->evict();
+    }
+
+    void clear()
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        while ( !m_entries.empty() ) { this->erase( m_entries.back().key ); }
+    }
+
+private:
+
+    const kvs::ObjectBase* find( const std::string& key )
+    {
+        EntryMap::iterator found = m_map.find( key );
+        if ( found == m_map.end() ) { return NULL; }
+
+        // Move the entry to the front as the most recently used one.
+        m_entries.splice( m_entries.begin(), m_entries, found->second );
+        return found->second->object;
+    }
+
+    void erase( const std::string& key )
+    {
+        EntryMap::iterator found = m_map.find( key );
+        if ( found == m_map.end() ) { return; }
+
+        EntryList::iterator entry = found->second;
+        m_byte_size -= entry->byte_size;
+        delete entry->object;
+        m_map.erase( found );
+        m_entries.erase( entry );
+    }
+
+    void evict()
+    {
+        while ( m_byte_size > m_capacity && !m_entries.empty() )
+        {
+            this->erase( m_entries.back().key );
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the result cache shared by the visualization pipelines.
+ *  @return result cache
+ */
+/*===========================================================================*/
+ResultCache& Cache()
+{
+    static ResultCache cache;
+    return cache;
+}
+
+} // end of namespace
+
+
 namespace kvs
 {
 
@@ -61,7 +441,8 @@ namespace kvs
 VisualizationPipeline::VisualizationPipeline():
     m_id( ::Counter++ ),
     m_filename(""),
-    m_cache( true ),
+    m_cache( false ),
+    m_input( NULL ),
     m_object( NULL ),
     m_renderer( NULL )
 {
@@ -78,7 +459,8 @@ VisualizationPipeline::VisualizationPipeline():
 VisualizationPipeline::VisualizationPipeline( const std::string& filename ):
     m_id( ::Counter++ ),
     m_filename( filename ),
-    m_cache( true ),
+    m_cache( false ),
+    m_input( NULL ),
     m_object( NULL ),
     m_renderer( NULL )
 {
@@ -95,7 +477,8 @@ VisualizationPipeline::VisualizationPipeline( const std::string& filename ):
 VisualizationPipeline::VisualizationPipeline( kvs::ObjectBase* object ):
     m_id( ::Counter++ ),
     m_filename(""),
-    m_cache( true ),
+    m_cache( false ),
+    m_input( object ),
     m_object( object ),
     m_renderer( NULL )
 {
@@ -135,7 +518,7 @@ VisualizationPipeline& VisualizationPipeline::connect( kvs::PipelineModule& modu
 /*===========================================================================*/
 bool VisualizationPipeline::import()
 {
-    if ( !this->hasObject() )
+    if ( !m_input )
     {
         // Check filename.
         if ( m_filename.empty() )
@@ -144,18 +527,25 @@ bool VisualizationPipeline::import()
             return false;
         }
 
-        // Import object.
-        kvs::ObjectImporter importer( m_filename );
-        kvs::ObjectBase* object = importer.import();
+        // Import object, or duplicate the object imported from the same file.
+        m_input_key = ::FileKey( m_filename );
+        kvs::ObjectBase* object = ( m_cache && !m_input_key.empty() ) ? ::Cache().duplicate( m_input_key ) : NULL;
         if ( !object )
         {
-            kvsMessageError( "Cannot import an object." );
-            return false;
+            kvs::ObjectImporter importer( m_filename );
+            object = importer.import();
+            if ( !object )
+            {
+                kvsMessageError( "Cannot import an object." );
+                return false;
+            }
+
+            if ( m_cache && !m_input_key.empty() ) { ::Cache().insert( m_input_key, object ); }
         }
 
         // Attache the imported object.
+        m_input = object;
         m_object = object;
-
     }
 
     return true;
@@ -176,7 +566,13 @@ bool VisualizationPipeline::exec()
         return false;
     }
 
-    const kvs::ObjectBase* object = m_object;
+    // The modules are always executed from the input object, and the key of
+    // the result cache is extended with each module. The key is cleared when
+    // the module has no parameter key since its output cannot be identified.
+    const kvs::ObjectBase* object = m_input;
+    std::string key;
+    if ( m_cache ) { key = m_filename.empty() ? ::ObjectKey( m_input ) : m_input_key; }
+
     ModuleList::iterator module = m_module_list.begin();
     ModuleList::iterator last   = m_module_list.end();
 
@@ -186,7 +582,23 @@ bool VisualizationPipeline::exec()
     // Execute the filter or the mapper module.
     while ( module != last )
     {
-        object = module->exec( object );
+        if ( key.empty() || module->cacheKey().empty() ) { key.clear(); }
+        else { key += std::string(" >> ") + module->name() + "(" + module->cacheKey() + ")"; }
+
+        // The cached result is copied to the module itself, as the module
+        // returns itself when it is executed. The module which is not an object
+        // is always executed, since the pipeline cannot own a copy of the result.
+        kvs::ObjectBase* output = key.empty() ? NULL : ::ModuleObject( *module );
+        if ( output && ::Cache().copyTo( key, output ) )
+        {
+            object = output;
+        }
+        else
+        {
+            object = module->exec( object );
+            if ( object && output ) { ::Cache().insert( key, object ); }
+        }
+
         if ( !object )
         {
             kvsMessageError("Cannot execute '%s'.", module->name() );
@@ -227,7 +639,7 @@ bool VisualizationPipeline::exec()
 
 /*===========================================================================*/
 /**
- *  @brief  Check whether the cache mechanism is enable or disable. (currently N/A)
+ *  @brief  Check whether the cache mechanism is enable or disable.
  *  @return true, if the cache is enable.
  */
 /*===========================================================================*/
@@ -300,6 +712,53 @@ const kvs::RendererBase* VisualizationPipeline::renderer() const
     return m_renderer;
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a capacity of the result cache shared by the pipelines.
+ *  @param  byte_size [in] capacity in bytes
+ *
+ *  The least recently used results are released when the total size of the
+ *  cached results exceeds the capacity. The cache is disabled for all the
+ *  pipelines by setting 0.
+ */
+/*===========================================================================*/
+void VisualizationPipeline::SetCacheCapacity( const size_t byte_size )
+{
+    ::Cache().setCapacity( byte_size );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the capacity of the result cache.
+ *  @return capacity in bytes
+ */
+/*===========================================================================*/
+size_t VisualizationPipeline::CacheCapacity()
+{
+    return ::Cache().capacity();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the total size of the cached results.
+ *  @return size in bytes
+ */
+/*===========================================================================*/
+size_t VisualizationPipeline::CacheSize()
+{
+    return ::Cache().byteSize();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases all the cached results.
+ */
+/*===========================================================================*/
+void VisualizationPipeline::ClearCache()
+{
+    ::Cache().clear();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Prints the visualization pipeline as string.
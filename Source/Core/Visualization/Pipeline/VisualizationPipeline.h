@@ -32,6 +32,16 @@ namespace kvs
 /*==========================================================================*/
 /**
  *  Visualization pipeline class.
+ *
+ *  The cache is disabled by default and enabled with enableCache(). When the
+ *  cache is enabled, the imported object and the outputs of the filter and
+ *  mapper modules that have a parameter key (see PipelineModule::setCacheKey)
+ *  are memoized in a process-wide LRU cache. The output of a module is keyed
+ *  on the input data (the file name with its ID, size and modification time,
+ *  or the version of the input object), and on the names and parameter keys
+ *  of the module and all the upstream modules. Therefore, only the modules
+ *  downstream of a changed module are re-executed. When the data arrays of
+ *  the input object are modified in place, call ObjectBase::updateVersion().
  */
 /*==========================================================================*/
 class VisualizationPipeline
@@ -44,9 +54,11 @@ private:
 
     size_t m_id; ///< pipeline ID
     std::string m_filename; ///< filename
-    bool m_cache; ///< cache mode (DISABLE NOW)
+    bool m_cache; ///< cache mode
     ModuleList m_module_list; ///< pipeline module list
 
+    const kvs::ObjectBase* m_input; ///< pointer to the input object of the modules
+    std::string m_input_key; ///< cache key of the imported object
     const kvs::ObjectBase* m_object; ///< pointer to the object inserted to the manager
     const kvs::RendererBase* m_renderer; ///< pointer to the renderer inserted to the manager
 
@@ -73,6 +85,11 @@ public:
     const kvs::RendererBase* renderer() const;
     void print() const;
 
+    static void SetCacheCapacity( const size_t byte_size );
+    static size_t CacheCapacity();
+    static size_t CacheSize();
+    static void ClearCache();
+
     friend std::string& operator << ( std::string& str, const VisualizationPipeline& pipeline );
     friend std::ostream& operator << ( std::ostream& os, const VisualizationPipeline& pipeline );
 
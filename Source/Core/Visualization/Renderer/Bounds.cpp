@@ -386,8 +386,8 @@ kvs::LineObject* Bounds::output_box_bounds( const kvs::ObjectBase* object ) cons
     line_object->setMinMaxExternalCoords( object->minExternalCoord(), object->maxExternalCoord() );
     line_object->setLineType( kvs::LineObject::Segment );
     line_object->setColorType( kvs::LineObject::LineColor );
-    line_object->setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    line_object->setConnections( kvs::ValueArray<kvs::UInt32>( connects ) );
+    line_object->setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    line_object->setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connects ) );
     line_object->setColor( m_line_color );
     line_object->setSize( m_line_width );
 
@@ -504,8 +504,8 @@ kvs::LineObject* Bounds::output_corner_bounds( const kvs::ObjectBase* object ) c
     line_object->setMinMaxExternalCoords( object->minExternalCoord(), object->maxExternalCoord() );
     line_object->setLineType( kvs::LineObject::Segment );
     line_object->setColorType( kvs::LineObject::LineColor );
-    line_object->setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    line_object->setConnections( kvs::ValueArray<kvs::UInt32>( connects ) );
+    line_object->setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    line_object->setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connects ) );
     line_object->setColor( m_line_color );
     line_object->setSize( m_line_width );
 
@@ -626,8 +626,8 @@ kvs::LineObject* Bounds::output_circle_bounds( const kvs::ObjectBase* object ) c
     line_object->setMinMaxExternalCoords( object->minExternalCoord(), object->maxExternalCoord() );
     line_object->setLineType( kvs::LineObject::Polyline );
     line_object->setColorType( kvs::LineObject::LineColor );
-    line_object->setCoords( kvs::ValueArray<kvs::Real32>( coords ) );
-    line_object->setConnections( kvs::ValueArray<kvs::UInt32>( connects ) );
+    line_object->setCoords( kvs::ValueArray<kvs::Real32>::Adopt( coords ) );
+    line_object->setConnections( kvs::ValueArray<kvs::UInt32>::Adopt( connects ) );
     line_object->setColor( m_line_color );
     line_object->setSize( m_line_width );
 
@@ -0,0 +1,294 @@
+/****************************************************************************/
+/**
+ *  @file   MacroCellGrid.cpp
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#include "MacroCellGrid.h"
+#include <cfloat>
+#include <vector>
+#include <kvs/Math>
+#include <kvs/Message>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Calculates the min. and max. node values of each brick.
+ *  @param  volume [in] pointer to the structured volume object
+ *  @param  brick_size [in] number of cells along each edge of the brick
+ *  @param  resolution [in] number of bricks in each direction
+ *  @param  min_values [out] min. node values of the bricks
+ *  @param  max_values [out] max. node values of the bricks
+ */
+/*===========================================================================*/
+template <typename T>
+void CalculateMinMaxValues(
+    const kvs::StructuredVolumeObject* volume,
+    const size_t brick_size,
+    const kvs::Vector3ui& resolution,
+    kvs::Real32* min_values,
+    kvs::Real32* max_values )
+{
+    const T* const values = reinterpret_cast<const T*>( volume->values().data() );
+    const kvs::Vector3ui nnodes = volume->resolution();
+    const size_t line_size = volume->numberOfNodesPerLine();
+    const size_t slice_size = volume->numberOfNodesPerSlice();
+
+    size_t index = 0;
+    for ( size_t bk = 0; bk < resolution.z(); bk++ )
+    {
+        // The bricks share the nodes on their boundaries.
+        const size_t k0 = bk * brick_size;
+        const size_t k1 = kvs::Math::Min( k0 + brick_size, size_t( nnodes.z() - 1 ) );
+        for ( size_t bj = 0; bj < resolution.y(); bj++ )
+        {
+            const size_t j0 = bj * brick_size;
+            const size_t j1 = kvs::Math::Min( j0 + brick_size, size_t( nnodes.y() - 1 ) );
+            for ( size_t bi = 0; bi < resolution.x(); bi++, index++ )
+            {
+                const size_t i0 = bi * brick_size;
+                const size_t i1 = kvs::Math::Min( i0 + brick_size, size_t( nnodes.x() - 1 ) );
+
+                T min_value = values[ i0 + j0 * line_size + k0 * slice_size ];
+                T max_value = min_value;
+                for ( size_t k = k0; k <= k1; k++ )
+                {
+                    for ( size_t j = j0; j <= j1; j++ )
+                    {
+                        const T* line = values + j * line_size + k * slice_size;
+                        for ( size_t i = i0; i <= i1; i++ )
+                        {
+                            min_value = kvs::Math::Min( min_value, line[i] );
+                            max_value = kvs::Math::Max( max_value, line[i] );
+                        }
+                    }
+                }
+
+                min_values[ index ] = static_cast<kvs::Real32>( min_value );
+                max_values[ index ] = static_cast<kvs::Real32>( max_value );
+            }
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the index of the opacity table for the given value.
+ *  @param  omap [in] opacity map
+ *  @param  value [in] value
+ *  @return index of the lower entry of the table (may be out of the table)
+ */
+/*===========================================================================*/
+long TableIndex( const kvs::OpacityMap& omap, const float value )
+{
+    const float min_value = omap.minValue();
+    const float max_value = omap.maxValue();
+    if ( value <= min_value ) return 0;
+    if ( value >= max_value ) return static_cast<long>( omap.resolution() ) - 1;
+
+    const float r = static_cast<float>( omap.resolution() - 1 );
+    return static_cast<long>( ( value - min_value ) / ( max_value - min_value ) * r );
+}
+
+} // end of namespace
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Constructs a new MacroCellGrid class.
+ */
+/*===========================================================================*/
+MacroCellGrid::MacroCellGrid():
+    m_version( 0 ),
+    m_brick_size( 0 ),
+    m_resolution( 0, 0, 0 ),
+    m_is_classified( false )
+{
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Checks whether the grid has been built for the given volume.
+ *  @param  volume [in] pointer to the structured volume object
+ *  @param  brick_size [in] number of cells along each edge of the brick
+ *  @return true, if the grid has been built for the current data of the volume
+ */
+/*===========================================================================*/
+bool MacroCellGrid::isBuilt( const kvs::StructuredVolumeObject* volume, const size_t brick_size ) const
+{
+    return m_brick_size > 0 &&
+           m_brick_size == brick_size &&
+           m_version == volume->version();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Builds the min/max grid of the bricks.
+ *  @param  volume [in] pointer to the structured volume object
+ *  @param  brick_size [in] number of cells along each edge of the brick
+ */
+/*===========================================================================*/
+void MacroCellGrid::build( const kvs::StructuredVolumeObject* volume, const size_t brick_size )
+{
+    this->release();
+
+    const kvs::Vector3ui nnodes = volume->resolution();
+    if ( volume->veclen() != 1 || brick_size == 0 ||
+         nnodes.x() < 2 || nnodes.y() < 2 || nnodes.z() < 2 )
+    {
+        return;
+    }
+
+    m_resolution.set(
+        static_cast<kvs::UInt32>( ( nnodes.x() - 2 ) / brick_size + 1 ),
+        static_cast<kvs::UInt32>( ( nnodes.y() - 2 ) / brick_size + 1 ),
+        static_cast<kvs::UInt32>( ( nnodes.z() - 2 ) / brick_size + 1 ) );
+
+    const size_t nbricks = m_resolution.x() * m_resolution.y() * m_resolution.z();
+    m_min_values.allocate( nbricks );
+    m_max_values.allocate( nbricks );
+    m_transparent.allocate( nbricks );
+    m_transparent.fill( 0 );
+
+    const std::type_info& type = volume->values().typeInfo()->type();
+    if (      type == typeid( kvs::Int8   ) ) ::CalculateMinMaxValues<kvs::Int8>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::UInt8  ) ) ::CalculateMinMaxValues<kvs::UInt8>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::Int16  ) ) ::CalculateMinMaxValues<kvs::Int16>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::UInt16 ) ) ::CalculateMinMaxValues<kvs::UInt16>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::Int32  ) ) ::CalculateMinMaxValues<kvs::Int32>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::UInt32 ) ) ::CalculateMinMaxValues<kvs::UInt32>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::Real32 ) ) ::CalculateMinMaxValues<kvs::Real32>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else if ( type == typeid( kvs::Real64 ) ) ::CalculateMinMaxValues<kvs::Real64>( volume, brick_size, m_resolution, m_min_values.data(), m_max_values.data() );
+    else
+    {
+        kvsMessageError( "Not supported data type '%s'.", volume->values().typeInfo()->typeName() );
+        this->release();
+        return;
+    }
+
+    m_version = volume->version();
+    m_brick_size = brick_size;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Classifies the bricks against the opacity map.
+ *  @param  omap [in] opacity map
+ *
+ *  The classification is skipped when the opacity map is the same as the one
+ *  used for the previous classification.
+ */
+/*===========================================================================*/
+void MacroCellGrid::classify( const kvs::OpacityMap& omap )
+{
+    if ( m_transparent.empty() ) { return; }
+    if ( omap.resolution() == 0 || omap.table().size() != omap.resolution() )
+    {
+        m_is_classified = false;
+        return;
+    }
+
+    if ( m_is_classified &&
+         m_opacity_map.resolution() == omap.resolution() &&
+         m_opacity_map.minValue() == omap.minValue() &&
+         m_opacity_map.maxValue() == omap.maxValue() &&
+         m_opacity_map.table() == omap.table() )
+    {
+        return;
+    }
+
+    // Number of the non-zero entries in the table [0,i) for each i.
+    const kvs::OpacityMap::Table& table = omap.table();
+    const long resolution = static_cast<long>( omap.resolution() );
+    std::vector<size_t> nonzeros( resolution + 1, 0 );
+    for ( long i = 0; i < resolution; i++ )
+    {
+        nonzeros[ i + 1 ] = nonzeros[i] + ( kvs::Math::IsZero( table[i] ) ? 0 : 1 );
+    }
+
+    // The interpolated opacity in [min, max] is given by the entries from the
+    // lower entry of min to the upper entry of max. One extra entry on each
+    // side is included to be conservative against rounding errors.
+    const size_t nbricks = m_transparent.size();
+    for ( size_t index = 0; index < nbricks; index++ )
+    {
+        const long s0 = kvs::Math::Max( ::TableIndex( omap, m_min_values[ index ] ) - 1, 0L );
+        const long s1 = kvs::Math::Min( ::TableIndex( omap, m_max_values[ index ] ) + 2, resolution - 1 );
+        m_transparent[ index ] = ( nonzeros[ s1 + 1 ] == nonzeros[ s0 ] ) ? 1 : 0;
+    }
+
+    m_opacity_map = kvs::OpacityMap( table.clone(), omap.minValue(), omap.maxValue() );
+    m_is_classified = true;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Releases the grid.
+ */
+/*===========================================================================*/
+void MacroCellGrid::release()
+{
+    m_version = 0;
+    m_brick_size = 0;
+    m_resolution.set( 0, 0, 0 );
+    m_min_values.release();
+    m_max_values.release();
+    m_transparent.release();
+    m_is_classified = false;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the distance to leap over the transparent brick.
+ *  @param  point [in] point in the index coordinate of the volume
+ *  @param  direction [in] normalized direction of the ray
+ *  @return distance to the exit of the brick (0 if the brick is not transparent)
+ */
+/*===========================================================================*/
+float MacroCellGrid::leapDistance( const kvs::Vector3f& point, const kvs::Vector3f& direction ) const
+{
+    if ( !m_is_classified ) { return 0.0f; }
+
+    float distance = FLT_MAX;
+    size_t index = 0;
+    size_t stride = 1;
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        // Brick including the cell in which the point is.
+        const long ncells = static_cast<long>( m_resolution[ axis ] ) * static_cast<long>( m_brick_size );
+        const long cell = kvs::Math::Clamp( static_cast<long>( point[ axis ] ), 0L, ncells - 1 );
+        const long brick = cell / static_cast<long>( m_brick_size );
+        index += brick * stride;
+        stride *= m_resolution[ axis ];
+
+        if ( direction[ axis ] > 0.0f )
+        {
+            const float exit = static_cast<float>( ( brick + 1 ) * m_brick_size );
+            distance = kvs::Math::Min( distance, ( exit - point[ axis ] ) / direction[ axis ] );
+        }
+        else if ( direction[ axis ] < 0.0f )
+        {
+            const float exit = static_cast<float>( brick * m_brick_size );
+            distance = kvs::Math::Min( distance, ( exit - point[ axis ] ) / direction[ axis ] );
+        }
+    }
+
+    if ( !m_transparent[ index ] ) { return 0.0f; }
+    return kvs::Math::Max( distance, 0.0f );
+}
+
+} // end of namespace kvs
@@ -0,0 +1,70 @@
+/****************************************************************************/
+/**
+ *  @file   MacroCellGrid.h
+ *  @author Naohisa Sakamoto
+ */
+/*----------------------------------------------------------------------------
+ *
+ *  Copyright (c) Visualization Laboratory, Kyoto University.
+ *  All rights reserved.
+ *  See http://www.viz.media.kyoto-u.ac.jp/kvs/copyright/ for details.
+ *
+ *  $Id$
+ */
+/****************************************************************************/
+#ifndef KVS__MACRO_CELL_GRID_H_INCLUDE
+#define KVS__MACRO_CELL_GRID_H_INCLUDE
+
+#include <kvs/ValueArray>
+#include <kvs/Vector3>
+#include <kvs/Type>
+#include <kvs/StructuredVolumeObject>
+#include <kvs/OpacityMap>
+
+
+namespace kvs
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Min/max macro-cell grid for empty space skipping.
+ *
+ *  The cells of the structured volume are grouped into bricks of
+ *  brick_size^3 cells, and the min. and max. node values of each brick are
+ *  stored. The bricks are classified against an opacity map, and a brick is
+ *  transparent when the opacity map is zero over the whole [min, max] range
+ *  of the brick, that is, every trilinearly interpolated value in the brick
+ *  has zero opacity.
+ */
+/*===========================================================================*/
+class MacroCellGrid
+{
+private:
+
+    kvs::UInt64 m_version; ///< version of the volume used for the build
+    size_t m_brick_size; ///< number of cells along each edge of the brick
+    kvs::Vector3ui m_resolution; ///< number of bricks in each direction
+    kvs::ValueArray<kvs::Real32> m_min_values; ///< min. node value of each brick
+    kvs::ValueArray<kvs::Real32> m_max_values; ///< max. node value of each brick
+    kvs::ValueArray<kvs::UInt8> m_transparent; ///< transparent flag of each brick
+    kvs::OpacityMap m_opacity_map; ///< opacity map used for the classification
+    bool m_is_classified; ///< true if the bricks have been classified
+
+public:
+
+    MacroCellGrid();
+
+    size_t brickSize() const { return m_brick_size; }
+    const kvs::Vector3ui& resolution() const { return m_resolution; }
+    bool isBuilt( const kvs::StructuredVolumeObject* volume, const size_t brick_size ) const;
+
+    void build( const kvs::StructuredVolumeObject* volume, const size_t brick_size = 8 );
+    void classify( const kvs::OpacityMap& omap );
+    void release();
+
+    float leapDistance( const kvs::Vector3f& point, const kvs::Vector3f& direction ) const;
+};
+
+} // end of namespace kvs
+
+#endif // KVS__MACRO_CELL_GRID_H_INCLUDE
@@ -17,6 +17,113 @@
 #include <kvs/PointObject>
 #include <kvs/Camera>
 #include <kvs/Assert>
+#include <kvs/Thread>
+#include <kvs/Math>
+#include <vector>
+
+
+namespace
+{
+
+const size_t ChunkSize = 1 << 22; ///< max. number of particles projected at once
+const size_t MinParticlesPerThread = 1 << 16; ///< min. number of particles per thread
+
+/*===========================================================================*/
+/**
+ *  @brief  Thread for projecting the particles onto the particle buffer.
+ */
+/*===========================================================================*/
+class ParticleProjector : public kvs::Thread
+{
+private:
+
+    const float* m_t; ///< combined matrix
+    size_t m_w; ///< half of the window width
+    size_t m_h; ///< half of the window height
+    size_t m_bounds_width; ///< window width - 1
+    size_t m_bounds_height; ///< window height - 1
+    const kvs::ParticleBuffer* m_buffer; ///< particle buffer
+    const kvs::Real32* m_coords; ///< coordinates of the particles
+    size_t m_begin; ///< first particle of the range
+    size_t m_end; ///< last particle of the range (not included)
+    kvs::UInt32* m_subpixel_indices; ///< subpixel indices of the particles in the range
+    kvs::Real32* m_depths; ///< depth values of the particles in the range
+
+public:
+
+    ParticleProjector():
+        m_t( NULL ),
+        m_w( 0 ),
+        m_h( 0 ),
+        m_bounds_width( 0 ),
+        m_bounds_height( 0 ),
+        m_buffer( NULL ),
+        m_coords( NULL ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_subpixel_indices( NULL ),
+        m_depths( NULL ) {}
+
+    void setProjection(
+        const float* t,
+        const size_t w,
+        const size_t h,
+        const size_t bounds_width,
+        const size_t bounds_height,
+        const kvs::ParticleBuffer* buffer,
+        const kvs::Real32* coords )
+    {
+        m_t = t;
+        m_w = w;
+        m_h = h;
+        m_bounds_width = bounds_width;
+        m_bounds_height = bounds_height;
+        m_buffer = buffer;
+        m_coords = coords;
+    }
+
+    void setRange( const size_t begin, const size_t end, kvs::UInt32* subpixel_indices, kvs::Real32* depths )
+    {
+        m_begin = begin;
+        m_end = end;
+        m_subpixel_indices = subpixel_indices;
+        m_depths = depths;
+    }
+
+    void run()
+    {
+        const float* t = m_t;
+        const kvs::Real32* v = m_coords;
+        size_t index3 = 3 * m_begin;
+        for ( size_t index = m_begin, i = 0; index < m_end; index++, index3 += 3, i++ )
+        {
+            // Same as the serial projection in ParticleBasedRenderer::project_particle.
+            float p_tmp[4] = {
+                v[index3]*t[0] + v[index3+1]*t[4] + v[index3+2]*t[ 8] + t[12],
+                v[index3]*t[1] + v[index3+1]*t[5] + v[index3+2]*t[ 9] + t[13],
+                v[index3]*t[2] + v[index3+1]*t[6] + v[index3+2]*t[10] + t[14],
+                v[index3]*t[3] + v[index3+1]*t[7] + v[index3+2]*t[11] + t[15] };
+            p_tmp[3] = 1.0f / p_tmp[3];
+            p_tmp[0] *= p_tmp[3];
+            p_tmp[1] *= p_tmp[3];
+            p_tmp[2] *= p_tmp[3];
+
+            const float p_win_x = ( 1.0f + p_tmp[0] ) * m_w;
+            const float p_win_y = ( 1.0f + p_tmp[1] ) * m_h;
+            const float depth   = ( 1.0f + p_tmp[2] ) * 0.5f;
+
+            const bool inside =
+                ( 0 < p_win_x ) & ( 0 < p_win_y ) &
+                ( p_win_x < m_bounds_width ) & ( p_win_y < m_bounds_height );
+            m_subpixel_indices[i] = inside ?
+                m_buffer->subpixelIndex( p_win_x, p_win_y ) :
+                static_cast<kvs::UInt32>( kvs::ParticleBuffer::OutOfBuffer );
+            m_depths[i] = depth;
+        }
+    }
+};
+
+} // end of namespace
 
 
 namespace kvs
@@ -31,7 +138,8 @@ ParticleBasedRenderer::ParticleBasedRenderer():
     m_ref_point( NULL ),
     m_enable_rendering( true ),
     m_subpixel_level( 1 ),
-    m_buffer( NULL )
+    m_buffer( NULL ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     BaseClass::setShader( kvs::Shader::Lambert() );
 }
@@ -49,7 +157,8 @@ ParticleBasedRenderer::ParticleBasedRenderer(
     m_ref_point( NULL ),
     m_enable_rendering( true ),
     m_subpixel_level( 1 ),
-    m_buffer( NULL )
+    m_buffer( NULL ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() )
 {
     BaseClass::setShader( kvs::Shader::Lambert() );
     this->setSubpixelLevel( subpixel_level );
@@ -66,6 +175,18 @@ ParticleBasedRenderer::~ParticleBasedRenderer()
     this->deleteParticleBuffer();
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for projecting the particles and creating the image.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void ParticleBasedRenderer::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+    if ( m_buffer ) m_buffer->setNumberOfThreads( m_number_of_threads );
+}
+
 /*==========================================================================*/
 /**
  *  Rendering.
@@ -107,6 +228,8 @@ bool ParticleBasedRenderer::createParticleBuffer(
     m_buffer = new kvs::ParticleBuffer( width, height, subpixel_level );
     if ( !m_buffer ) return( false );
 
+    m_buffer->setNumberOfThreads( m_number_of_threads );
+
     return( true );
 }
 
@@ -197,37 +320,68 @@ void ParticleBasedRenderer::project_particle(
     const size_t nv = point->numberOfVertices();
     const kvs::Real32* v  = point->coords().data();
 
-    size_t index3 = 0;
     const size_t bounds_width = BaseClass::windowWidth() - 1;
     const size_t bounds_height = BaseClass::windowHeight() - 1;
-    for ( size_t index = 0; index < nv; index++, index3 += 3 )
+    const size_t nthreads = kvs::Math::Min( m_number_of_threads, kvs::Math::Max( nv / ::MinParticlesPerThread, size_t(1) ) );
+    if ( nthreads <= 1 )
     {
-        /* Calculate the projected point position in the window coordinate system.
-         * Ex.) Camera::projectObjectToWindow().
-         */
-        float p_tmp[4] = {
-            v[index3]*t[0] + v[index3+1]*t[4] + v[index3+2]*t[ 8] + t[12],
-            v[index3]*t[1] + v[index3+1]*t[5] + v[index3+2]*t[ 9] + t[13],
-            v[index3]*t[2] + v[index3+1]*t[6] + v[index3+2]*t[10] + t[14],
-            v[index3]*t[3] + v[index3+1]*t[7] + v[index3+2]*t[11] + t[15] };
-        p_tmp[3] = 1.0f / p_tmp[3];
-        p_tmp[0] *= p_tmp[3];
-        p_tmp[1] *= p_tmp[3];
-        p_tmp[2] *= p_tmp[3];
-
-        const float p_win_x = ( 1.0f + p_tmp[0] ) * w;
-        const float p_win_y = ( 1.0f + p_tmp[1] ) * h;
-        const float depth   = ( 1.0f + p_tmp[2] ) * 0.5f;
-
-        // Store the projected point in the point buffer.
-        if ( ( 0 < p_win_x ) & ( 0 < p_win_y ) )
+        size_t index3 = 0;
+        for ( size_t index = 0; index < nv; index++, index3 += 3 )
         {
-            if ( ( p_win_x < bounds_width ) & ( p_win_y < bounds_height ) )
+            /* Calculate the projected point position in the window coordinate system.
+             * Ex.) Camera::projectObjectToWindow().
+             */
+            float p_tmp[4] = {
+                v[index3]*t[0] + v[index3+1]*t[4] + v[index3+2]*t[ 8] + t[12],
+                v[index3]*t[1] + v[index3+1]*t[5] + v[index3+2]*t[ 9] + t[13],
+                v[index3]*t[2] + v[index3+1]*t[6] + v[index3+2]*t[10] + t[14],
+                v[index3]*t[3] + v[index3+1]*t[7] + v[index3+2]*t[11] + t[15] };
+            p_tmp[3] = 1.0f / p_tmp[3];
+            p_tmp[0] *= p_tmp[3];
+            p_tmp[1] *= p_tmp[3];
+            p_tmp[2] *= p_tmp[3];
+
+            const float p_win_x = ( 1.0f + p_tmp[0] ) * w;
+            const float p_win_y = ( 1.0f + p_tmp[1] ) * h;
+            const float depth   = ( 1.0f + p_tmp[2] ) * 0.5f;
+
+            // Store the projected point in the point buffer.
+            if ( ( 0 < p_win_x ) & ( 0 < p_win_y ) )
             {
-                m_buffer->add( p_win_x, p_win_y, depth, index );
+                if ( ( p_win_x < bounds_width ) & ( p_win_y < bounds_height ) )
+                {
+                    m_buffer->add( p_win_x, p_win_y, depth, index );
+                }
             }
         }
     }
+    else
+    {
+        // The particles are projected in parallel and stored in the buffer
+        // chunk by chunk, so that the working memory is bounded.
+        const size_t chunk_size = kvs::Math::Min( nv, ::ChunkSize );
+        std::vector<kvs::UInt32> subpixel_indices( chunk_size );
+        std::vector<kvs::Real32> depths( chunk_size );
+        std::vector< ::ParticleProjector> projectors( nthreads );
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            projectors[i].setProjection( t, w, h, bounds_width, bounds_height, m_buffer, v );
+        }
+
+        for ( size_t first = 0; first < nv; first += chunk_size )
+        {
+            const size_t n = kvs::Math::Min( chunk_size, nv - first );
+            for ( size_t i = 0; i < nthreads; i++ )
+            {
+                const size_t begin = n * i / nthreads;
+                const size_t end = n * ( i + 1 ) / nthreads;
+                projectors[i].setRange( first + begin, first + end, &subpixel_indices[ begin ], &depths[ begin ] );
+            }
+            kvs::Thread::Run( &projectors[0], nthreads );
+
+            m_buffer->add( &subpixel_indices[0], &depths[0], n, static_cast<kvs::UInt32>( first ) );
+        }
+    }
 
     // Shading calculation.
     if ( BaseClass::isEnabledShading() ) m_buffer->enableShading();
@@ -46,6 +46,7 @@ protected:
     bool m_enable_rendering; ///< rendering flag
     size_t m_subpixel_level; ///< number of divisions in a pixel
     kvs::ParticleBuffer* m_buffer; ///< particle buffer
+    size_t m_number_of_threads; ///< number of threads
 
 public:
 
@@ -58,6 +59,8 @@ public:
     void setSubpixelLevel( const size_t subpixel_level ) { m_subpixel_level = subpixel_level; }
     const kvs::ParticleBuffer* particleBuffer() const { return m_buffer; }
     size_t subpixelLevel() const { return m_subpixel_level; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    void setNumberOfThreads( const size_t nthreads );
     void enableRendering() { m_enable_rendering = true; }
     void disableRendering() { m_enable_rendering = false; }
 
@@ -66,10 +69,10 @@ protected:
     bool createParticleBuffer( const size_t width, const size_t height, const size_t subpixel_level );
     void cleanParticleBuffer();
     void deleteParticleBuffer();
+    void create_image( const kvs::PointObject* point, const kvs::Camera* camera, const kvs::Light* light );
 
 private:
 
-    void create_image( const kvs::PointObject* point, const kvs::Camera* camera, const kvs::Light* light );
     void project_particle( const kvs::PointObject* point, const kvs::Camera* camera, const kvs::Light* light );
 
 public:
@@ -16,6 +16,386 @@
 #include <kvs/Type>
 #include <kvs/Math>
 #include <kvs/PointObject>
+#include <kvs/Thread>
+#include <vector>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Resolves the subpixels of the rows [py0, py1) with shading.
+ *  @param  shade [in] shading kernel
+ *  @param  buffer [in] pointer to the particle buffer
+ *  @param  py0 [in] first row of the pixels
+ *  @param  py1 [in] last row of the pixels (not included)
+ *  @param  color [out] pointer to color data
+ *  @param  depth [out] pointer to depth data
+ */
+/*===========================================================================*/
+template <typename Kernel>
+void ResolveWithShading(
+    const Kernel& shade,
+    const kvs::ParticleBuffer* buffer,
+    const size_t py0,
+    const size_t py1,
+    kvs::ValueArray<kvs::UInt8>* color,
+    kvs::ValueArray<kvs::Real32>* depth )
+{
+    const kvs::PointObject* point = buffer->pointObject();
+    const kvs::Real32* point_coords = point->coords().data();
+    const kvs::UInt8* point_color = point->colors().data();
+    const kvs::Real32* point_normal = point->normals().data();
+    const kvs::Real32* depth_buffer = buffer->depthBuffer().data();
+    const kvs::UInt32* index_buffer = buffer->indexBuffer().data();
+
+    const size_t width = buffer->width();
+    const size_t subpixel_level = buffer->subpixelLevel();
+    const float inv_ssize = 1.0f / ( subpixel_level * subpixel_level );
+    const float normalize_alpha = 255.0f * inv_ssize;
+
+    size_t pindex = py0 * width;
+    size_t pindex4 = 4 * pindex;
+    size_t by_start = py0 * subpixel_level;
+    const size_t bw = width * subpixel_level;
+    for( size_t py = py0; py < py1; py++, by_start += subpixel_level )
+    {
+        size_t bx_start = 0;
+        for( size_t px = 0; px < width; px++, pindex++, pindex4 += 4, bx_start += subpixel_level )
+        {
+            float R = 0.0f;
+            float G = 0.0f;
+            float B = 0.0f;
+            float D = 0.0f;
+            size_t npoints = 0;
+            for( size_t by = by_start; by < by_start + subpixel_level; by++ )
+            {
+                const size_t bindex_start = bw * by;
+                for( size_t bx = bx_start; bx < bx_start + subpixel_level; bx++ )
+                {
+                    const size_t bindex = bindex_start + bx;
+                    if( depth_buffer[bindex] > 0.0f )
+                    {
+                        const size_t point_index3 = 3 * index_buffer[ bindex ];
+
+                        const kvs::Vector3f vertex( point_coords + point_index3 );
+                        const kvs::Vector3f normal( point_normal + point_index3 );
+                        kvs::RGBColor color( point_color + point_index3 );
+                        color = shade( color, vertex, normal );
+                        R += color.r();
+                        G += color.g();
+                        B += color.b();
+                        D = kvs::Math::Max( D, depth_buffer[ bindex ] );
+
+                        npoints++;
+                    }
+                }
+            }
+
+            R *= inv_ssize;
+            G *= inv_ssize;
+            B *= inv_ssize;
+
+            (*color)[ pindex4 + 0 ] = static_cast<kvs::UInt8>( kvs::Math::Min( R, 255.0f ) + 0.5f );
+            (*color)[ pindex4 + 1 ] = static_cast<kvs::UInt8>( kvs::Math::Min( G, 255.0f ) + 0.5f );
+            (*color)[ pindex4 + 2 ] = static_cast<kvs::UInt8>( kvs::Math::Min( B, 255.0f ) + 0.5f );
+            (*color)[ pindex4 + 3 ] = static_cast<kvs::UInt8>( npoints * normalize_alpha );
+            (*depth)[ pindex ] = ( npoints == 0 ) ? 1.0f : D;
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Resolves the subpixels of the rows [py0, py1) without shading.
+ *  @param  buffer [in] pointer to the particle buffer
+ *  @param  py0 [in] first row of the pixels
+ *  @param  py1 [in] last row of the pixels (not included)
+ *  @param  color [out] pointer to color data
+ *  @param  depth [out] pointer to depth data
+ */
+/*===========================================================================*/
+void ResolveWithoutShading(
+    const kvs::ParticleBuffer* buffer,
+    const size_t py0,
+    const size_t py1,
+    kvs::ValueArray<kvs::UInt8>* color,
+    kvs::ValueArray<kvs::Real32>* depth )
+{
+    const kvs::UInt8* point_color = buffer->pointObject()->colors().data();
+    const kvs::Real32* depth_buffer = buffer->depthBuffer().data();
+    const kvs::UInt32* index_buffer = buffer->indexBuffer().data();
+
+    const size_t width = buffer->width();
+    const size_t subpixel_level = buffer->subpixelLevel();
+    const float inv_ssize = 1.0f / ( subpixel_level * subpixel_level );
+    const float normalize_alpha = 255.0f * inv_ssize;
+
+    size_t pindex = py0 * width;
+    size_t pindex4 = 4 * pindex;
+    size_t by_start = py0 * subpixel_level;
+    const size_t bw = width * subpixel_level;
+    for( size_t py = py0; py < py1; py++, by_start += subpixel_level )
+    {
+        size_t bx_start = 0;
+        for( size_t px = 0; px < width; px++, pindex++, pindex4 += 4, bx_start += subpixel_level )
+        {
+            float R = 0.0f;
+            float G = 0.0f;
+            float B = 0.0f;
+            float D = 0.0f;
+            size_t npoints = 0;
+            for( size_t by = by_start; by < by_start + subpixel_level; by++ )
+            {
+                const size_t bindex_start = bw * by;
+                for( size_t bx = bx_start; bx < bx_start + subpixel_level; bx++ )
+                {
+                    const size_t bindex = bindex_start + bx;
+                    if( depth_buffer[bindex] > 0.0f )
+                    {
+                        const size_t point_index3 = 3 * index_buffer[ bindex ];
+
+                        R += point_color[ point_index3 + 0 ];
+                        G += point_color[ point_index3 + 1 ];
+                        B += point_color[ point_index3 + 2 ];
+                        D = kvs::Math::Max( D, depth_buffer[ bindex ] );
+                        npoints++;
+                    }
+                }
+            }
+
+            R *= inv_ssize;
+            G *= inv_ssize;
+            B *= inv_ssize;
+
+            (*color)[ pindex4 + 0 ] = static_cast<kvs::UInt8>(R);
+            (*color)[ pindex4 + 1 ] = static_cast<kvs::UInt8>(G);
+            (*color)[ pindex4 + 2 ] = static_cast<kvs::UInt8>(B);
+            (*color)[ pindex4 + 3 ] = static_cast<kvs::UInt8>( npoints * normalize_alpha );
+            (*depth)[ pindex ] = ( npoints == 0 ) ? 1.0f : D;
+        }
+    }
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Worker thread for the particle buffer.
+ *
+ *  The projected particles are binned into the bands of the subpixels with
+ *  a counting sort (CountBands and ScatterParticles), which keeps the order
+ *  of the particles in each band. Each band is then stored by one thread
+ *  (StoreParticles), so the result is the same as the serial addition.
+ */
+/*===========================================================================*/
+class ParticleBufferWorker : public kvs::Thread
+{
+public:
+
+    enum Task
+    {
+        CountBands,
+        ScatterParticles,
+        StoreParticles,
+        ResolveWithShading,
+        ResolveWithoutShading
+    };
+
+private:
+
+    Task m_task; ///< task of the thread
+    size_t m_begin; ///< first index of the range (particle, sorted particle or pixel row)
+    size_t m_end; ///< last index of the range (not included)
+    size_t m_band_size; ///< number of subpixels in each band
+    std::vector<size_t> m_count; ///< number of particles (or the offset) of each band
+    size_t m_nstored; ///< number of stored particles
+
+    // Projected particles.
+    const kvs::UInt32* m_subpixel_indices; ///< subpixel indices
+    const kvs::Real32* m_depths; ///< depth values
+    kvs::UInt32 m_first_index; ///< index of the first particle
+
+    // Particles sorted by the bands.
+    kvs::UInt32* m_sorted_subpixel_indices; ///< subpixel indices
+    kvs::Real32* m_sorted_depths; ///< depth values
+    kvs::UInt32* m_sorted_indices; ///< particle indices
+
+    // Particle buffer and image.
+    const kvs::ParticleBuffer* m_buffer; ///< particle buffer
+    kvs::Real32* m_depth_buffer; ///< depth buffer
+    kvs::UInt32* m_index_buffer; ///< index buffer
+    kvs::ValueArray<kvs::UInt8>* m_color; ///< color data
+    kvs::ValueArray<kvs::Real32>* m_depth; ///< depth data
+
+public:
+
+    ParticleBufferWorker():
+        m_task( CountBands ),
+        m_begin( 0 ),
+        m_end( 0 ),
+        m_band_size( 0 ),
+        m_nstored( 0 ),
+        m_subpixel_indices( NULL ),
+        m_depths( NULL ),
+        m_first_index( 0 ),
+        m_sorted_subpixel_indices( NULL ),
+        m_sorted_depths( NULL ),
+        m_sorted_indices( NULL ),
+        m_buffer( NULL ),
+        m_depth_buffer( NULL ),
+        m_index_buffer( NULL ),
+        m_color( NULL ),
+        m_depth( NULL ) {}
+
+    std::vector<size_t>& count() { return m_count; }
+    size_t nstored() const { return m_nstored; }
+
+    void setTask( const Task task ) { m_task = task; }
+    void setRange( const size_t begin, const size_t end ) { m_begin = begin; m_end = end; }
+
+    void setParticles(
+        const kvs::UInt32* subpixel_indices,
+        const kvs::Real32* depths,
+        const kvs::UInt32 first_index,
+        const size_t band_size,
+        const size_t nbands )
+    {
+        m_subpixel_indices = subpixel_indices;
+        m_depths = depths;
+        m_first_index = first_index;
+        m_band_size = band_size;
+        m_count.assign( nbands, 0 );
+    }
+
+    void setSortedParticles( kvs::UInt32* subpixel_indices, kvs::Real32* depths, kvs::UInt32* indices )
+    {
+        m_sorted_subpixel_indices = subpixel_indices;
+        m_sorted_depths = depths;
+        m_sorted_indices = indices;
+    }
+
+    void setBuffer(
+        const kvs::ParticleBuffer* buffer,
+        kvs::Real32* depth_buffer,
+        kvs::UInt32* index_buffer )
+    {
+        m_buffer = buffer;
+        m_depth_buffer = depth_buffer;
+        m_index_buffer = index_buffer;
+    }
+
+    void setImage( kvs::ValueArray<kvs::UInt8>* color, kvs::ValueArray<kvs::Real32>* depth )
+    {
+        m_color = color;
+        m_depth = depth;
+    }
+
+    void run()
+    {
+        switch ( m_task )
+        {
+        case CountBands: this->count_bands(); break;
+        case ScatterParticles: this->scatter_particles(); break;
+        case StoreParticles: this->store_particles(); break;
+        case ResolveWithShading: this->resolve_with_shading(); break;
+        case ResolveWithoutShading: ::ResolveWithoutShading( m_buffer, m_begin, m_end, m_color, m_depth ); break;
+        default: break;
+        }
+    }
+
+private:
+
+    void resolve_with_shading()
+    {
+        // The kernel is instantiated for each built-in shading model.
+        typedef kvs::Shader Shader;
+        const Shader::ShadingModel& shader = *m_buffer->shader();
+        switch ( Shader::KernelType( &shader ) )
+        {
+        case Shader::LambertShading:
+            ::ResolveWithShading( Shader::Kernel<Shader::Lambert>( shader ), m_buffer, m_begin, m_end, m_color, m_depth );
+            break;
+        case Shader::PhongShading:
+            ::ResolveWithShading( Shader::Kernel<Shader::Phong>( shader ), m_buffer, m_begin, m_end, m_color, m_depth );
+            break;
+        case Shader::BlinnPhongShading:
+            ::ResolveWithShading( Shader::Kernel<Shader::BlinnPhong>( shader ), m_buffer, m_begin, m_end, m_color, m_depth );
+            break;
+        default:
+            ::ResolveWithShading( Shader::Kernel<Shader::Base>( shader ), m_buffer, m_begin, m_end, m_color, m_depth );
+            break;
+        }
+    }
+
+    void count_bands()
+    {
+        std::fill( m_count.begin(), m_count.end(), 0 );
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt32 subpixel_index = m_subpixel_indices[i];
+            if ( subpixel_index == kvs::ParticleBuffer::OutOfBuffer ) { continue; }
+            m_count[ subpixel_index / m_band_size ]++;
+        }
+    }
+
+    void scatter_particles()
+    {
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const kvs::UInt32 subpixel_index = m_subpixel_indices[i];
+            if ( subpixel_index == kvs::ParticleBuffer::OutOfBuffer ) { continue; }
+            const size_t j = m_count[ subpixel_index / m_band_size ]++;
+            m_sorted_subpixel_indices[j] = subpixel_index;
+            m_sorted_depths[j] = m_depths[i];
+            m_sorted_indices[j] = static_cast<kvs::UInt32>( m_first_index + i );
+        }
+    }
+
+    void store_particles()
+    {
+        // Same as ParticleBuffer::add for each particle.
+        for ( size_t i = m_begin; i < m_end; i++ )
+        {
+            const size_t index = m_sorted_subpixel_indices[i];
+            const kvs::Real32 depth = m_sorted_depths[i];
+            if ( m_depth_buffer[index] > 0.0f && !( m_depth_buffer[index] > depth ) ) { continue; }
+            m_depth_buffer[index] = depth;
+            m_index_buffer[index] = m_sorted_indices[i];
+        }
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Creates the rendering image by resolving the rows of the pixels in parallel.
+ *  @param  buffer [in] pointer to the particle buffer
+ *  @param  task [in] resolving task (with or without shading)
+ *  @param  nthreads [in] number of threads
+ *  @param  color [out] pointer to color data
+ *  @param  depth [out] pointer to depth data
+ */
+/*===========================================================================*/
+void CreateImage(
+    const kvs::ParticleBuffer* buffer,
+    const ParticleBufferWorker::Task task,
+    const size_t nthreads,
+    kvs::ValueArray<kvs::UInt8>* color,
+    kvs::ValueArray<kvs::Real32>* depth )
+{
+    const size_t height = buffer->height();
+    const size_t nworkers = kvs::Math::Max( kvs::Math::Min( nthreads, height ), size_t(1) );
+    std::vector<ParticleBufferWorker> workers( nworkers );
+    for ( size_t i = 0; i < nworkers; i++ )
+    {
+        workers[i].setTask( task );
+        workers[i].setRange( height * i / nworkers, height * ( i + 1 ) / nworkers );
+        workers[i].setBuffer( buffer, NULL, NULL );
+        workers[i].setImage( color, depth );
+    }
+    kvs::Thread::Run( &workers[0], nworkers );
+}
+
+} // end of namespace
 
 
 namespace kvs
@@ -27,6 +407,7 @@ namespace kvs
  */
 /*===========================================================================*/
 ParticleBuffer::ParticleBuffer():
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
     m_ref_shader( NULL ),
     m_ref_point_object( NULL )
 {
@@ -44,6 +425,7 @@ ParticleBuffer::ParticleBuffer(
     const size_t width,
     const size_t height,
     const size_t subpixel_level ):
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
     m_ref_shader( NULL )
 {
     this->create( width, height, subpixel_level );
@@ -125,6 +507,103 @@ void ParticleBuffer::clear()
     m_depth_buffer.release();
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for storing the particles and creating the image.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void ParticleBuffer::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Adds the projected particles to the buffer.
+ *  @param  subpixel_indices [in] subpixel indices (OutOfBuffer: not added)
+ *  @param  depths [in] depth values
+ *  @param  nparticles [in] number of the particles
+ *  @param  first_index [in] index of the first particle in the point object
+ *
+ *  The result is the same as adding the particles one by one in order.
+ */
+/*===========================================================================*/
+void ParticleBuffer::add(
+    const kvs::UInt32* subpixel_indices,
+    const kvs::Real32* depths,
+    const size_t nparticles,
+    const kvs::UInt32 first_index )
+{
+    const size_t nsubpixels = m_depth_buffer.size();
+    const size_t nthreads = kvs::Math::Min( m_number_of_threads, m_height * m_subpixel_level );
+    if ( nthreads <= 1 || nsubpixels == 0 )
+    {
+        for ( size_t i = 0; i < nparticles; i++ )
+        {
+            if ( subpixel_indices[i] == OutOfBuffer ) { continue; }
+
+            const size_t index = subpixel_indices[i];
+            m_num_of_projected_particles++;
+            if ( m_depth_buffer[index] > 0.0f && !( m_depth_buffer[index] > depths[i] ) ) { continue; }
+            m_depth_buffer[index] = depths[i];
+            m_index_buffer[index] = static_cast<kvs::UInt32>( first_index + i );
+        }
+        return;
+    }
+
+    // Each thread stores the particles in a band of the subpixels.
+    const size_t nbands = nthreads;
+    const size_t band_size = ( nsubpixels + nbands - 1 ) / nbands;
+    std::vector< ::ParticleBufferWorker> workers( nthreads );
+    for ( size_t i = 0; i < nthreads; i++ )
+    {
+        workers[i].setTask( ::ParticleBufferWorker::CountBands );
+        workers[i].setRange( nparticles * i / nthreads, nparticles * ( i + 1 ) / nthreads );
+        workers[i].setParticles( subpixel_indices, depths, first_index, band_size, nbands );
+    }
+    kvs::Thread::Run( &workers[0], nthreads );
+
+    // Offsets of the particles of each thread in each band.
+    std::vector<size_t> band_offsets( nbands + 1, 0 );
+    size_t offset = 0;
+    for ( size_t band = 0; band < nbands; band++ )
+    {
+        band_offsets[ band ] = offset;
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            const size_t count = workers[i].count()[ band ];
+            workers[i].count()[ band ] = offset;
+            offset += count;
+        }
+    }
+    band_offsets[ nbands ] = offset;
+
+    const size_t nadded = offset;
+    std::vector<kvs::UInt32> sorted_subpixel_indices( nadded );
+    std::vector<kvs::Real32> sorted_depths( nadded );
+    std::vector<kvs::UInt32> sorted_indices( nadded );
+    if ( nadded > 0 )
+    {
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            workers[i].setTask( ::ParticleBufferWorker::ScatterParticles );
+            workers[i].setSortedParticles( &sorted_subpixel_indices[0], &sorted_depths[0], &sorted_indices[0] );
+        }
+        kvs::Thread::Run( &workers[0], nthreads );
+
+        for ( size_t i = 0; i < nthreads; i++ )
+        {
+            workers[i].setTask( ::ParticleBufferWorker::StoreParticles );
+            workers[i].setRange( band_offsets[i], band_offsets[ i + 1 ] );
+            workers[i].setBuffer( this, m_depth_buffer.data(), m_index_buffer.data() );
+        }
+        kvs::Thread::Run( &workers[0], nthreads );
+    }
+
+    m_num_of_projected_particles += nadded;
+}
+
 /*==========================================================================*/
 /**
  *  Create the rendering image.
@@ -151,62 +630,7 @@ void ParticleBuffer::create_image_with_shading(
     kvs::ValueArray<kvs::UInt8>* color,
     kvs::ValueArray<kvs::Real32>* depth )
 {
-    const kvs::Real32* point_coords = m_ref_point_object->coords().data();
-    const kvs::UInt8* point_color = m_ref_point_object->colors().data();
-    const kvs::Real32* point_normal = m_ref_point_object->normals().data();
-
-    const float inv_ssize = 1.0f / ( m_subpixel_level * m_subpixel_level );
-    const float normalize_alpha = 255.0f * inv_ssize;
-
-    size_t pindex = 0;
-    size_t pindex4 = 0;
-    size_t by_start = 0;
-    const size_t bw = m_extended_width;
-    for( size_t py = 0; py < m_height; py++, by_start += m_subpixel_level )
-    {
-        size_t bx_start = 0;
-        for( size_t px = 0; px < m_width; px++, pindex++, pindex4 += 4, bx_start += m_subpixel_level )
-        {
-            float R = 0.0f;
-            float G = 0.0f;
-            float B = 0.0f;
-            float D = 0.0f;
-            size_t npoints = 0;
-            for( size_t by = by_start; by < by_start + m_subpixel_level; by++ )
-            {
-                const size_t bindex_start = bw * by;
-                for( size_t bx = bx_start; bx < bx_start + m_subpixel_level; bx++ )
-                {
-                    const size_t bindex = bindex_start + bx;
-                    if( m_depth_buffer[bindex] > 0.0f )
-                    {
-                        const size_t point_index3 = 3 * m_index_buffer[ bindex ];
-
-                        const kvs::Vector3f vertex( point_coords + point_index3 );
-                        const kvs::Vector3f normal( point_normal + point_index3 );
-                        kvs::RGBColor color( point_color + point_index3 );
-                        color = m_ref_shader->shadedColor( color, vertex, normal );
-                        R += color.r();
-                        G += color.g();
-                        B += color.b();
-                        D = kvs::Math::Max( D, m_depth_buffer[ bindex ] );
-
-                        npoints++;
-                    }
-                }
-            }
-
-            R *= inv_ssize;
-            G *= inv_ssize;
-            B *= inv_ssize;
-
-            (*color)[ pindex4 + 0 ] = static_cast<kvs::UInt8>( kvs::Math::Min( R, 255.0f ) + 0.5f );
-            (*color)[ pindex4 + 1 ] = static_cast<kvs::UInt8>( kvs::Math::Min( G, 255.0f ) + 0.5f );
-            (*color)[ pindex4 + 2 ] = static_cast<kvs::UInt8>( kvs::Math::Min( B, 255.0f ) + 0.5f );
-            (*color)[ pindex4 + 3 ] = static_cast<kvs::UInt8>( npoints * normalize_alpha );
-            (*depth)[ pindex ] = ( npoints == 0 ) ? 1.0f : D;
-        }
-    }
+    ::CreateImage( this, ::ParticleBufferWorker::ResolveWithShading, m_number_of_threads, color, depth );
 }
 
 /*===========================================================================*/
@@ -220,55 +644,7 @@ void ParticleBuffer::create_image_without_shading(
     kvs::ValueArray<kvs::UInt8>* color,
     kvs::ValueArray<kvs::Real32>* depth )
 {
-    const kvs::UInt8* point_color = m_ref_point_object->colors().data();
-
-    const float inv_ssize = 1.0f / ( m_subpixel_level * m_subpixel_level );
-    const float normalize_alpha = 255.0f * inv_ssize;
-
-    size_t pindex = 0;
-    size_t pindex4 = 0;
-    size_t by_start = 0;
-    const size_t bw = m_extended_width;
-    for( size_t py = 0; py < m_height; py++, by_start += m_subpixel_level )
-    {
-        size_t bx_start = 0;
-        for( size_t px = 0; px < m_width; px++, pindex++, pindex4 += 4, bx_start += m_subpixel_level )
-        {
-            float R = 0.0f;
-            float G = 0.0f;
-            float B = 0.0f;
-            float D = 0.0f;
-            size_t npoints = 0;
-            for( size_t by = by_start; by < by_start + m_subpixel_level; by++ )
-            {
-                const size_t bindex_start = bw * by;
-                for( size_t bx = bx_start; bx < bx_start + m_subpixel_level; bx++ )
-                {
-                    const size_t bindex = bindex_start + bx;
-                    if( m_depth_buffer[bindex] > 0.0f )
-                    {
-                        const size_t point_index3 = 3 * m_index_buffer[ bindex ];
-
-                        R += point_color[ point_index3 + 0 ];
-                        G += point_color[ point_index3 + 1 ];
-                        B += point_color[ point_index3 + 2 ];
-                        D = kvs::Math::Max( D, m_depth_buffer[ bindex ] );
-                        npoints++;
-                    }
-                }
-            }
-
-            R *= inv_ssize;
-            G *= inv_ssize;
-            B *= inv_ssize;
-
-            (*color)[ pindex4 + 0 ] = static_cast<kvs::UInt8>(R);
-            (*color)[ pindex4 + 1 ] = static_cast<kvs::UInt8>(G);
-            (*color)[ pindex4 + 2 ] = static_cast<kvs::UInt8>(B);
-            (*color)[ pindex4 + 3 ] = static_cast<kvs::UInt8>( npoints * normalize_alpha );
-            (*depth)[ pindex ] = ( npoints == 0 ) ? 1.0f : D;
-        }
-    }
+    ::CreateImage( this, ::ParticleBufferWorker::ResolveWithoutShading, m_number_of_threads, color, depth );
 }
 
 } // end of namesapce kvs
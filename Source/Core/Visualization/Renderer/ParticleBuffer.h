@@ -43,6 +43,7 @@ protected:
     size_t m_subpixel_level; ///< subpixel level
     bool m_enable_shading; ///< shading flag
     size_t m_extended_width; ///< m_width * m_subpixel_level
+    size_t m_number_of_threads; ///< number of threads
     kvs::ValueArray<kvs::UInt32> m_index_buffer; ///< index buffer
     kvs::ValueArray<kvs::Real32> m_depth_buffer; ///< depth buffer
 
@@ -50,6 +51,10 @@ protected:
     const kvs::Shader::ShadingModel* m_ref_shader;
     const kvs::PointObject* m_ref_point_object;
 
+public:
+
+    enum { OutOfBuffer = 0xffffffff }; ///< subpixel index of the particles outside the buffer
+
 public:
 
     ParticleBuffer();
@@ -67,13 +72,21 @@ public:
     const kvs::PointObject* pointObject() const { return m_ref_point_object; }
     size_t numberOfProjectedParticles() const { return m_num_of_projected_particles; }
     size_t numberOfStoredParticles() const { return m_num_of_stored_particles; }
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    kvs::UInt32 subpixelIndex( const float x, const float y ) const;
     void setSubpixelLevel( const size_t subpixel_level ) { m_subpixel_level = subpixel_level; }
     void attachShader( const kvs::Shader::ShadingModel* shader ) { m_ref_shader = shader; }
     void attachPointObject( const kvs::PointObject* point_object ) { m_ref_point_object = point_object; }
     void enableShading() { m_enable_shading = true; }
     void disableShading() { m_enable_shading = false; }
+    void setNumberOfThreads( const size_t nthreads );
 
     void add( const float x, const float y, const kvs::Real32 depth, const kvs::UInt32 index );
+    void add(
+        const kvs::UInt32* subpixel_indices,
+        const kvs::Real32* depths,
+        const size_t nparticles,
+        const kvs::UInt32 first_index );
     bool create( const size_t width, const size_t height, const size_t subpixel_level );
     void clean();
     void clear();
@@ -94,6 +107,23 @@ public:
     KVS_DEPRECATED( const size_t numOfStoredParticles() const ) { return this->numberOfStoredParticles(); }
 };
 
+/*===========================================================================*/
+/**
+ *  @brief  Returns the index of the subpixel including the given position.
+ *  @param  x [in] x coordinate value in the window
+ *  @param  y [in] y coordinate value in the window
+ *  @return subpixel index
+ */
+/*===========================================================================*/
+inline kvs::UInt32 ParticleBuffer::subpixelIndex( const float x, const float y ) const
+{
+    // Buffer coordinate value.
+    const size_t bx = static_cast<size_t>( x * m_subpixel_level );
+    const size_t by = static_cast<size_t>( y * m_subpixel_level );
+
+    return static_cast<kvs::UInt32>( m_extended_width * by + bx );
+}
+
 /*==========================================================================*/
 /**
  *  Add a point to the buffer.
@@ -109,11 +139,7 @@ inline void ParticleBuffer::add(
     const kvs::Real32 depth,
     const kvs::UInt32 voxel_index )
 {
-    // Buffer coordinate value.
-    const size_t bx = static_cast<size_t>( x * m_subpixel_level );
-    const size_t by = static_cast<size_t>( y * m_subpixel_level );
-
-    const size_t index = m_extended_width * by + bx;
+    const size_t index = this->subpixelIndex( x, y );
     m_num_of_projected_particles++;
 
     if( m_depth_buffer[index] > 0.0f )
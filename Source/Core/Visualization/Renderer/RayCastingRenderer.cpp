@@ -21,6 +21,285 @@
 #include <kvs/TrilinearInterpolator>
 #include <kvs/VolumeRayIntersector>
 #include <kvs/OpenGL>
+#include <kvs/Thread>
+#include <kvs/Mutex>
+#include <kvs/MutexLocker>
+#include <vector>
+#include <cmath>
+
+
+namespace
+{
+
+/*===========================================================================*/
+/**
+ *  @brief  Queue of the screen tiles shared by the ray casting threads.
+ *
+ *  Each thread takes the next unprocessed tile from the queue when it has
+ *  finished the previous one, so that the threads casting rays through the
+ *  empty or opaque regions of the screen pick up more tiles.
+ */
+/*===========================================================================*/
+class TileQueue
+{
+private:
+
+    kvs::Mutex m_mutex; ///< mutex for the tile counter
+    size_t m_next; ///< index of the next tile
+    size_t m_ntiles; ///< number of tiles
+
+public:
+
+    TileQueue( const size_t ntiles ): m_next( 0 ), m_ntiles( ntiles ) {}
+
+    bool pop( size_t* tile )
+    {
+        kvs::MutexLocker locker( &m_mutex );
+        if ( m_next >= m_ntiles ) { return false; }
+        *tile = m_next++;
+        return true;
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Ray casting thread for the screen tiles.
+ *
+ *  Each thread has its own interpolator and ray, and writes only the pixels in
+ *  the tiles taken from the queue. When the ray width is larger than one, a ray
+ *  is cast at the center of each ray_width x ray_width block in the tile and the
+ *  resulting color and depth are copied to the whole block.
+ */
+/*===========================================================================*/
+template <typename T>
+class RayCaster : public kvs::Thread
+{
+private:
+
+    const kvs::StructuredVolumeObject* m_volume; ///< input volume
+    const kvs::VolumeRayIntersector* m_ray; ///< ray in the object coordinate system
+    const kvs::Shader::ShadingModel* m_shader; ///< shading model
+    const kvs::ColorMap* m_cmap; ///< color map
+    const kvs::OpacityMap* m_omap; ///< opacity map
+    const kvs::MacroCellGrid* m_grid; ///< macro-cell grid (NULL: no skipping)
+    float m_step; ///< sampling step
+    float m_opaque; ///< opaque value for early ray termination
+    size_t m_width; ///< screen width
+    size_t m_height; ///< screen height
+    size_t m_ray_width; ///< ray width
+    size_t m_tile_size; ///< tile size in pixels
+    TileQueue* m_queue; ///< tile queue
+    kvs::UInt8* m_pixel_data; ///< color buffer
+    kvs::Real32* m_depth_data; ///< depth buffer
+
+public:
+
+    RayCaster() {}
+    ~RayCaster() {}
+
+public:
+
+    void init(
+        const kvs::StructuredVolumeObject* volume,
+        const kvs::VolumeRayIntersector* ray,
+        const kvs::Shader::ShadingModel* shader,
+        const kvs::ColorMap* cmap,
+        const kvs::OpacityMap* omap,
+        const kvs::MacroCellGrid* grid,
+        const float step,
+        const float opaque )
+    {
+        m_volume = volume;
+        m_ray = ray;
+        m_shader = shader;
+        m_cmap = cmap;
+        m_omap = omap;
+        m_grid = grid;
+        m_step = step;
+        m_opaque = opaque;
+    }
+
+    void attachScreen(
+        const size_t width,
+        const size_t height,
+        const size_t ray_width,
+        const size_t tile_size,
+        TileQueue* queue,
+        kvs::UInt8* pixel_data,
+        kvs::Real32* depth_data )
+    {
+        m_width = width;
+        m_height = height;
+        m_ray_width = ray_width;
+        m_tile_size = tile_size;
+        m_queue = queue;
+        m_pixel_data = pixel_data;
+        m_depth_data = depth_data;
+    }
+
+    void run()
+    {
+        // The inner loop is instantiated for each built-in shading model.
+        typedef kvs::Shader Shader;
+        switch ( Shader::KernelType( m_shader ) )
+        {
+        case Shader::LambertShading: this->cast_tiles( Shader::Kernel<Shader::Lambert>( *m_shader ) ); break;
+        case Shader::PhongShading: this->cast_tiles( Shader::Kernel<Shader::Phong>( *m_shader ) ); break;
+        case Shader::BlinnPhongShading: this->cast_tiles( Shader::Kernel<Shader::BlinnPhong>( *m_shader ) ); break;
+        default: this->cast_tiles( Shader::Kernel<Shader::Base>( *m_shader ) ); break;
+        }
+    }
+
+private:
+
+    template <typename Kernel>
+    void cast_tiles( const Kernel& shade )
+    {
+        kvs::TrilinearInterpolator interpolator( m_volume );
+        kvs::VolumeRayIntersector ray( *m_ray );
+
+        const size_t ntiles_x = ( m_width + m_tile_size - 1 ) / m_tile_size;
+        size_t tile = 0;
+        while ( m_queue->pop( &tile ) )
+        {
+            const size_t x0 = ( tile % ntiles_x ) * m_tile_size;
+            const size_t y0 = ( tile / ntiles_x ) * m_tile_size;
+            const size_t x1 = kvs::Math::Min( x0 + m_tile_size, m_width );
+            const size_t y1 = kvs::Math::Min( y0 + m_tile_size, m_height );
+            for ( size_t y = y0; y < y1; y += m_ray_width )
+            {
+                for ( size_t x = x0; x < x1; x += m_ray_width )
+                {
+                    this->cast( shade, interpolator, ray, x, y, x1, y1 );
+                }
+            }
+        }
+    }
+
+    template <typename Kernel>
+    void cast(
+        const Kernel& shade,
+        kvs::TrilinearInterpolator& interpolator,
+        kvs::VolumeRayIntersector& ray,
+        const size_t x,
+        const size_t y,
+        const size_t x_end,
+        const size_t y_end )
+    {
+        // Cast the ray at the center of the ray_width x ray_width block.
+        const size_t block_w = kvs::Math::Min( m_ray_width, x_end - x );
+        const size_t block_h = kvs::Math::Min( m_ray_width, y_end - y );
+        const size_t cx = x + block_w / 2;
+        const size_t cy = y + block_h / 2;
+        const size_t depth_index = cy * m_width + cx;
+        const size_t pixel_index = depth_index * 4;
+        ray.setOrigin( static_cast<int>( cx ), static_cast<int>( cy ) );
+
+        kvs::UInt8 pixel[4] = {
+            m_pixel_data[ pixel_index ],
+            m_pixel_data[ pixel_index + 1 ],
+            m_pixel_data[ pixel_index + 2 ],
+            m_pixel_data[ pixel_index + 3 ] };
+        kvs::Real32 pixel_depth = 1.0f;
+
+        // Intersection the ray with the bounding box.
+        if ( ray.isIntersected() )
+        {
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            float a = 0.0;
+
+            const float depth0 = m_depth_data[ depth_index ];
+            pixel_depth = ray.depth();
+
+            do
+            {
+                // Empty space skipping. The ray leaps over the transparent brick
+                // by a whole number of steps to keep the sampling positions.
+                if ( m_grid )
+                {
+                    const float distance = m_grid->leapDistance( ray.point(), ray.direction() );
+                    if ( distance > 0.0f )
+                    {
+                        ray.step( std::ceil( distance / m_step ) * m_step );
+                        if ( ray.depth() > depth0 )
+                        {
+                            const float current_alpha = 1.0f - a;
+                            r += current_alpha * pixel[0];
+                            g += current_alpha * pixel[1];
+                            b += current_alpha * pixel[2];
+                            a = 1.0f;
+                            break;
+                        }
+                        continue;
+                    }
+                }
+
+                // Interpolation.
+                interpolator.attachPoint( ray.point() );
+
+                // Classification.
+                const float s = interpolator.template scalar<T>();
+                const float opacity = m_omap->at(s);
+                if ( !kvs::Math::IsZero( opacity ) )
+                {
+                    // Shading.
+                    const kvs::Vec3 vertex = ray.point();
+                    const kvs::Vec3 normal = interpolator.template gradient<T>();
+                    const kvs::RGBColor color = shade( m_cmap->at(s), vertex, normal );
+
+                    // Front-to-back accumulation.
+                    const float current_alpha = ( 1.0f - a ) * opacity;
+                    r += current_alpha * color.r();
+                    g += current_alpha * color.g();
+                    b += current_alpha * color.b();
+                    a += current_alpha;
+                    if ( a > m_opaque )
+                    {
+                        a = 1.0f;
+                        break;
+                    }
+                }
+
+                const float depth = ray.depth();
+                if ( depth > depth0 )
+                {
+                    const float current_alpha = 1.0f - a;
+                    r += current_alpha * pixel[0];
+                    g += current_alpha * pixel[1];
+                    b += current_alpha * pixel[2];
+                    a = 1.0f;
+                    break;
+                }
+
+                ray.step( m_step );
+            } while ( ray.isInside() );
+
+            pixel[0] = static_cast<kvs::UInt8>( kvs::Math::Min( r, 255.0f ) + 0.5f );
+            pixel[1] = static_cast<kvs::UInt8>( kvs::Math::Min( g, 255.0f ) + 0.5f );
+            pixel[2] = static_cast<kvs::UInt8>( kvs::Math::Min( b, 255.0f ) + 0.5f );
+            pixel[3] = static_cast<kvs::UInt8>( kvs::Math::Round( a * 255.0f ) );
+        }
+
+        // Set pixel values in the block.
+        for ( size_t j = y; j < y + block_h; j++ )
+        {
+            for ( size_t i = x; i < x + block_w; i++ )
+            {
+                const size_t index = j * m_width + i;
+                const size_t index4 = index * 4;
+                m_pixel_data[ index4     ] = pixel[0];
+                m_pixel_data[ index4 + 1 ] = pixel[1];
+                m_pixel_data[ index4 + 2 ] = pixel[2];
+                m_pixel_data[ index4 + 3 ] = pixel[3];
+                m_depth_data[ index ] = pixel_depth;
+            }
+        }
+    }
+};
+
+} // end of namespace
 
 
 namespace kvs
@@ -35,7 +314,11 @@ RayCastingRenderer::RayCastingRenderer():
     m_step( 0.5f ),
     m_opaque( 0.97f ),
     m_ray_width( 1 ),
-    m_enable_lod( false )
+    m_enable_lod( false ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_tile_size( 32 ),
+    m_enable_skipping( true ),
+    m_brick_size( 8 )
 {
     BaseClass::setShader( kvs::Shader::Lambert() );
 }
@@ -50,7 +333,11 @@ RayCastingRenderer::RayCastingRenderer( const kvs::TransferFunction& tfunc ):
     m_step( 0.5f ),
     m_opaque( 0.97f ),
     m_ray_width( 1 ),
-    m_enable_lod( false )
+    m_enable_lod( false ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_tile_size( 32 ),
+    m_enable_skipping( true ),
+    m_brick_size( 8 )
 {
     BaseClass::setTransferFunction( tfunc );
     BaseClass::setShader( kvs::Shader::Lambert() );
@@ -67,11 +354,26 @@ RayCastingRenderer::RayCastingRenderer( const ShadingType shader ):
     m_step( 0.5f ),
     m_opaque( 0.97f ),
     m_ray_width( 1 ),
-    m_enable_lod( false )
+    m_enable_lod( false ),
+    m_number_of_threads( kvs::Thread::DefaultNumberOfThreads() ),
+    m_tile_size( 32 ),
+    m_enable_skipping( true ),
+    m_brick_size( 8 )
 {
     BaseClass::setShader( shader );
 }
 
+/*===========================================================================*/
+/**
+ *  @brief  Sets a number of threads for the ray casting.
+ *  @param  nthreads [in] number of threads (0: number of processors)
+ */
+/*===========================================================================*/
+void RayCastingRenderer::setNumberOfThreads( const size_t nthreads )
+{
+    m_number_of_threads = nthreads > 0 ? nthreads : kvs::Thread::DefaultNumberOfThreads();
+}
+
 /*===========================================================================*/
 /**
  *  @brief  Executes the rendering process.
@@ -184,138 +486,51 @@ void RayCastingRenderer::rasterize(
         memcpy( m_modelview, modelview, sizeof( modelview ) );
     }
 
-    // Set the trilinear interpolator.
-    kvs::TrilinearInterpolator interpolator( volume );
-
     // Calculate the ray in the object coordinate system.
     float modelview[16]; kvs::OpenGL::GetModelViewMatrix( static_cast<GLfloat*>( modelview ) );
     float projection[16]; kvs::OpenGL::GetProjectionMatrix( static_cast<GLfloat*>( projection ) );
     int viewport[4]; kvs::OpenGL::GetViewport( static_cast<GLint*>( viewport ) );
-    kvs::VolumeRayIntersector ray( volume, modelview, projection, viewport );
+    const kvs::VolumeRayIntersector ray( volume, modelview, projection, viewport );
 
-    // Execute ray casting.
+    // Divide the screen into tiles. The tile size is rounded up to a multiple
+    // of the ray width, so that no ray_width x ray_width block straddles tiles.
     const size_t height = BaseClass::windowHeight();
     const size_t width  = BaseClass::windowWidth();
-    const kvs::Shader::ShadingModel& shader = BaseClass::shader();
-    const kvs::ColorMap& cmap = BaseClass::transferFunction().colorMap();
-    const kvs::OpacityMap& omap = BaseClass::transferFunction().opacityMap();
-    const float step = m_step;
-    const float opaque = m_opaque;
-    size_t depth_index = 0;
-    size_t pixel_index = 0;
-    for ( size_t y = 0; y < height; y += ray_width )
+    const size_t tile_size = ( kvs::Math::Max( m_tile_size, ray_width ) + ray_width - 1 ) / ray_width * ray_width;
+    const size_t ntiles_x = ( width + tile_size - 1 ) / tile_size;
+    const size_t ntiles_y = ( height + tile_size - 1 ) / tile_size;
+    const size_t ntiles = ntiles_x * ntiles_y;
+    if ( ntiles == 0 ) { return; }
+    ::TileQueue queue( ntiles );
+
+    // Classify the bricks of the macro-cell grid with the current opacity map.
+    const kvs::MacroCellGrid* grid = NULL;
+    if ( m_enable_skipping )
     {
-        const size_t offset = y * width;
-        for ( size_t x = 0; x < width; x += ray_width, depth_index = offset + x, pixel_index = depth_index * 4 )
-        {
-            ray.setOrigin( x, y );
-
-            // Intersection the ray with the bounding box.
-            if ( ray.isIntersected() )
-            {
-                float r = 0.0f;
-                float g = 0.0f;
-                float b = 0.0f;
-                float a = 0.0;
-
-                const float depth0 = depth_data[ depth_index ];
-                depth_data[ depth_index ] = ray.depth();
-
-                do
-                {
-                    // Interpolation.
-                    interpolator.attachPoint( ray.point() );
-
-                    // Classification.
-                    const float s = interpolator.template scalar<T>();
-                    const float opacity = omap.at(s);
-                    if ( !kvs::Math::IsZero( opacity ) )
-                    {
-                        // Shading.
-                        const kvs::Vec3 vertex = ray.point();
-                        const kvs::Vec3 normal = interpolator.template gradient<T>();
-                        const kvs::RGBColor color = shader.shadedColor( cmap.at(s), vertex, normal );
-
-                        // Front-to-back accumulation.
-                        const float current_alpha = ( 1.0f - a ) * opacity;
-                        r += current_alpha * color.r();
-                        g += current_alpha * color.g();
-                        b += current_alpha * color.b();
-                        a += current_alpha;
-                        if ( a > opaque )
-                        {
-                            a = 1.0f;
-                            break;
-                        }
-                    }
-
-                    const float depth = ray.depth();
-                    if ( depth > depth0 )
-                    {
-                        const float current_alpha = 1.0f - a;
-                        r += current_alpha * pixel_data[ pixel_index ];
-                        g += current_alpha * pixel_data[ pixel_index + 1 ];
-                        b += current_alpha * pixel_data[ pixel_index + 2 ];
-                        a = 1.0f;
-                        break;
-                    }
-
-                    ray.step( step );
-                } while ( ray.isInside() );
-
-                // Set pixel value.
-                pixel_data[ pixel_index     ] = static_cast<kvs::UInt8>( kvs::Math::Min( r, 255.0f ) + 0.5f );
-                pixel_data[ pixel_index + 1 ] = static_cast<kvs::UInt8>( kvs::Math::Min( g, 255.0f ) + 0.5f );
-                pixel_data[ pixel_index + 2 ] = static_cast<kvs::UInt8>( kvs::Math::Min( b, 255.0f ) + 0.5f );
-                pixel_data[ pixel_index + 3 ] = static_cast<kvs::UInt8>( kvs::Math::Round( a * 255.0f ) );
-            }
-            else
-            {
-                depth_data[ depth_index ] = 1.0;
-            }
-        }
+        if ( !m_grid.isBuilt( volume, m_brick_size ) ) { m_grid.build( volume, m_brick_size ); }
+        m_grid.classify( BaseClass::transferFunction().opacityMap() );
+        grid = &m_grid;
     }
 
-    // Mosaicing by using ray_width x ray_width mask.
-    if ( ray_width > 1 )
+    // Execute ray casting.
+    const size_t nthreads = kvs::Math::Max( size_t(1), kvs::Math::Min( m_number_of_threads, ntiles ) );
+    std::vector< ::RayCaster<T> > casters( nthreads );
+    for ( size_t i = 0; i < nthreads; ++i )
     {
-        pixel_index = 0;
-        depth_index = 0;
-        for ( size_t y = 0; y < height; y += ray_width )
-        {
-            // Shift the y position of the mask by -ray_width/2.
-            const size_t Y = kvs::Math::Max( int( y - ray_width / 2 ), 0 );
-
-            const size_t offset = y * width;
-            for ( size_t x = 0; x < width; x += ray_width, depth_index = offset + x, pixel_index = depth_index * 4 )
-            {
-                // Shift the x position of the mask by -ray_width/2.
-                const size_t X = kvs::Math::Max( int( x - ray_width / 2 ), 0 );
-
-                const kvs::UInt8  r = pixel_data[ pixel_index ];
-                const kvs::UInt8  g = pixel_data[ pixel_index + 1 ];
-                const kvs::UInt8  b = pixel_data[ pixel_index + 2 ];
-                const kvs::UInt8  a = pixel_data[ pixel_index + 3 ];
-                const kvs::Real32 d = depth_data[ depth_index ];
-                for ( size_t j = 0; j < ray_width && Y + j < height; j++ )
-                {
-                    const size_t J = Y + j;
-                    for ( size_t i = 0; i < ray_width && X + i < width; i++ )
-                    {
-                        const size_t I = X + i;
-                        const size_t index = J * width + I;
-                        const size_t index4 = index * 4;
-                        pixel_data[ index4 ] = r;
-                        pixel_data[ index4 + 1 ] = g;
-                        pixel_data[ index4 + 2 ] = b;
-                        pixel_data[ index4 + 3 ] = a;
-                        depth_data[ index ] = d;
-                    }
-                }
-            }
-        }
+        casters[i].init(
+            volume,
+            &ray,
+            &BaseClass::shader(),
+            &BaseClass::transferFunction().colorMap(),
+            &BaseClass::transferFunction().opacityMap(),
+            grid,
+            m_step,
+            m_opaque );
+        casters[i].attachScreen( width, height, ray_width, tile_size, &queue, pixel_data, depth_data );
     }
 
+    kvs::Thread::Run( &casters[0], nthreads );
+
     kvs::OpenGL::Finish();
 }
 
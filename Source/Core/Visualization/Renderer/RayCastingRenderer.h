@@ -20,6 +20,8 @@
 #include <kvs/StructuredVolumeObject>
 #include <kvs/Module>
 #include <kvs/Deprecated>
+#include <kvs/Math>
+#include <kvs/MacroCellGrid>
 
 
 namespace kvs
@@ -42,6 +44,11 @@ private:
     size_t m_ray_width; ///< ray width
     bool m_enable_lod; ///< enable LOD rendering
     float m_modelview[16]; ///< modelview matrix
+    size_t m_number_of_threads; ///< number of threads for the ray casting
+    size_t m_tile_size; ///< size of the screen tile in pixels
+    bool m_enable_skipping; ///< enable empty space skipping
+    size_t m_brick_size; ///< brick size of the macro-cell grid
+    kvs::MacroCellGrid m_grid; ///< macro-cell grid for empty space skipping
 
 public:
 
@@ -50,11 +57,19 @@ public:
     template <typename ShadingType>
     RayCastingRenderer( const ShadingType shader );
 
+    size_t numberOfThreads() const { return m_number_of_threads; }
+    size_t tileSize() const { return m_tile_size; }
+    bool isEnabledEmptySpaceSkipping() const { return m_enable_skipping; }
+
     void exec( kvs::ObjectBase* object, kvs::Camera* camera, kvs::Light* light );
     void setSamplingStep( const float step ) { m_step = step; }
     void setOpaqueValue( const float opaque ) { m_opaque = opaque; }
     void enableLODControl( const size_t ray_width = 3 ) { m_enable_lod = true; m_ray_width = ray_width; }
     void disableLODControl() { m_enable_lod = false; m_ray_width = 1; }
+    void setNumberOfThreads( const size_t nthreads );
+    void setTileSize( const size_t tile_size ) { m_tile_size = kvs::Math::Max( tile_size, size_t(1) ); }
+    void enableEmptySpaceSkipping( const size_t brick_size = 8 ) { m_enable_skipping = true; m_brick_size = kvs::Math::Max( brick_size, size_t(1) ); }
+    void disableEmptySpaceSkipping() { m_enable_skipping = false; m_grid.release(); }
 
 private:
 
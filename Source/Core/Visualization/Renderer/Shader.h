@@ -15,7 +15,11 @@
 #ifndef KVS__SHADER_H_INCLUDE
 #define KVS__SHADER_H_INCLUDE
 
+#include <typeinfo>
+#include <cmath>
 #include <kvs/Vector3>
+#include <kvs/RGBColor>
+#include <kvs/Math>
 #include <kvs/Camera>
 #include <kvs/Light>
 #include <kvs/ObjectBase>
@@ -60,6 +64,19 @@ public:
             const kvs::Vector3f& vertex,
             const kvs::Vector3f& normal ) const = 0;
         virtual float attenuation( const kvs::Vector3f& vertex, const kvs::Vector3f& gradient ) const = 0;
+
+    protected:
+
+        static const kvs::RGBColor Shade( const kvs::RGBColor& color, const float Ia, const float Id, const float Is );
+        static float AmbientTerm( const float ka ) { return ka; }
+        static float DiffuseTerm( const float kd, const kvs::Vector3f& N, const kvs::Vector3f& L )
+        {
+            return kd * kvs::Math::Max( N.dot( L ), 0.0f );
+        }
+        static float SpecularTerm( const float ks, const float s, const kvs::Vector3f& R, const kvs::Vector3f& V )
+        {
+            return ks * std::pow( kvs::Math::Max( R.dot( V ), 0.0f ), s );
+        }
     };
 
 public:
@@ -113,8 +130,184 @@ public:
             const kvs::Vector3f& normal ) const;
         float attenuation( const kvs::Vector3f& vertex, const kvs::Vector3f& gradient ) const;
     };
+
+public:
+
+    /*=======================================================================*/
+    /**
+     *  @brief  Non-virtual shading kernel for the shading model.
+     *
+     *  The kernel calls shadedColor of the model without the virtual call, so
+     *  that the shading can be inlined in the inner loops of the renderers.
+     *  Kernel<Base> calls the virtual function for the other shading models.
+     */
+    /*=======================================================================*/
+    template <typename Model>
+    struct Kernel
+    {
+        const Model& model; ///< shading model
+
+        explicit Kernel( const Base& shader ): model( static_cast<const Model&>( shader ) ) {}
+
+        const kvs::RGBColor operator ()(
+            const kvs::RGBColor& color,
+            const kvs::Vector3f& vertex,
+            const kvs::Vector3f& normal ) const
+        {
+            return model.Model::shadedColor( color, vertex, normal );
+        }
+    };
+
+    static Shader::Type KernelType( const Base* shader );
 };
 
+/*===========================================================================*/
+/**
+ *  @brief  Kernel for the shading models other than the built-in ones.
+ */
+/*===========================================================================*/
+template <>
+struct Shader::Kernel<Shader::Base>
+{
+    const Base& model; ///< shading model
+
+    explicit Kernel( const Base& shader ): model( shader ) {}
+
+    const kvs::RGBColor operator ()(
+        const kvs::RGBColor& color,
+        const kvs::Vector3f& vertex,
+        const kvs::Vector3f& normal ) const
+    {
+        return model.shadedColor( color, vertex, normal );
+    }
+};
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the type of the kernel which can be used for the shading model.
+ *  @param  shader [in] pointer to the shading model
+ *  @return shading type (UnknownShading: Kernel<Base> must be used)
+ *
+ *  The built-in type is returned only if the shading model is exactly the
+ *  built-in one, since a derived class may override shadedColor.
+ */
+/*===========================================================================*/
+inline Shader::Type Shader::KernelType( const Base* shader )
+{
+    if ( !shader ) return Shader::UnknownShading;
+
+    const std::type_info& type = typeid( *shader );
+    if ( type == typeid( Shader::Lambert ) ) return Shader::LambertShading;
+    if ( type == typeid( Shader::Phong ) ) return Shader::PhongShading;
+    if ( type == typeid( Shader::BlinnPhong ) ) return Shader::BlinnPhongShading;
+    return Shader::UnknownShading;
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns the color shaded with the intensities.
+ *  @param  color [in] source color
+ *  @param  Ia [in] ambient term
+ *  @param  Id [in] diffuse term
+ *  @param  Is [in] specular term
+ *  @return shaded color
+ */
+/*===========================================================================*/
+inline const kvs::RGBColor Shader::Base::Shade(
+    const kvs::RGBColor& color,
+    const float Ia,
+    const float Id,
+    const float Is )
+{
+    const float I1 = Ia + Id;
+    const float I2 = Is * 255.0f;
+    const kvs::UInt8 r = static_cast<kvs::UInt8>( kvs::Math::Min( color.r() * I1 + I2, 255.0f ) + 0.5f );
+    const kvs::UInt8 g = static_cast<kvs::UInt8>( kvs::Math::Min( color.g() * I1 + I2, 255.0f ) + 0.5f );
+    const kvs::UInt8 b = static_cast<kvs::UInt8>( kvs::Math::Min( color.b() * I1 + I2, 255.0f ) + 0.5f );
+    return kvs::RGBColor( r, g, b );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns shaded color.
+ *  @param  color [in] source color
+ *  @param  vertex [in] vertex position
+ *  @param  normal [in] normal vector
+ *  @return shaded color
+ */
+/*===========================================================================*/
+inline const kvs::RGBColor Shader::Lambert::shadedColor(
+    const kvs::RGBColor& color,
+    const kvs::Vector3f& vertex,
+    const kvs::Vector3f& normal ) const
+{
+    // Light vector L and normal vector N.
+    const kvs::Vector3f L = ( light_position - vertex ).normalized();
+    const kvs::Vector3f N = normal.normalized();
+
+    // Intensity values.
+    const float Ia = AmbientTerm( Ka );
+    const float Id = DiffuseTerm( Kd, N, L );
+
+    return color * ( Ia + Id );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns shaded color.
+ *  @param  color [in] source color
+ *  @param  vertex [in] vertex position
+ *  @param  normal [in] normal vector
+ *  @return shaded color
+ */
+/*===========================================================================*/
+inline const kvs::RGBColor Shader::Phong::shadedColor(
+    const kvs::RGBColor& color,
+    const kvs::Vector3f& vertex,
+    const kvs::Vector3f& normal ) const
+{
+    // Light vector L, normal vector N and reflection vector R.
+    const kvs::Vector3f V = ( camera_position - vertex ).normalized();
+    const kvs::Vector3f L = ( light_position - vertex ).normalized();
+    const kvs::Vector3f N = normal.normalized();
+    const kvs::Vector3f R = 2.0f * N.dot( L ) * N - L;
+
+    // Intensity values.
+    const float Ia = AmbientTerm( Ka );
+    const float Id = DiffuseTerm( Kd, N, L );
+    const float Is = SpecularTerm( Ks, S, R, V );
+
+    return Shader::Base::Shade( color, Ia, Id, Is );
+}
+
+/*===========================================================================*/
+/**
+ *  @brief  Returns shaded color.
+ *  @param  color [in] source color
+ *  @param  vertex [in] vertex position
+ *  @param  normal [in] normal vector
+ *  @return shaded color
+ */
+/*===========================================================================*/
+inline const kvs::RGBColor Shader::BlinnPhong::shadedColor(
+    const kvs::RGBColor& color,
+    const kvs::Vector3f& vertex,
+    const kvs::Vector3f& normal ) const
+{
+    // Camera vector V, light vector L, halfway vector H and normal vector N.
+    const kvs::Vector3f V = ( camera_position - vertex ).normalized();
+    const kvs::Vector3f L = ( light_position - vertex ).normalized();
+    const kvs::Vector3f H = ( V + L ).normalized();
+    const kvs::Vector3f N = normal.normalized();
+
+    // Intensity values.
+    const float Ia = AmbientTerm( Ka );
+    const float Id = DiffuseTerm( Kd, N, L );
+    const float Is = SpecularTerm( Ks, S, H, N );
+
+    return Shader::Base::Shade( color, Ia, Id, Is );
+}
+
 } // end of namespace kvs
 
 #endif // KVS__SHADER_H_INCLUDE